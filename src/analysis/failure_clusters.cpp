@@ -0,0 +1,179 @@
+#include "analysis/failure_clusters.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <numeric>
+#include <unordered_map>
+
+#include "common/hash.h"
+#include "common/parallel.h"
+#include "judge/failure_cluster.h"
+#include "judge/source_normalizer.h"
+
+namespace codecoach::analysis {
+
+namespace {
+
+std::vector<std::string_view> tokenize(std::string_view text) {
+  std::vector<std::string_view> tokens;
+  std::size_t i = 0;
+  while (i < text.size()) {
+    const auto c = static_cast<unsigned char>(text[i]);
+    if (std::isspace(c)) {
+      ++i;
+      continue;
+    }
+    const std::size_t start = i;
+    if (std::isalnum(c) || c == '_') {
+      while (i < text.size() &&
+             (std::isalnum(static_cast<unsigned char>(text[i])) ||
+              text[i] == '_')) {
+        ++i;
+      }
+    } else {
+      ++i;
+    }
+    tokens.push_back(text.substr(start, i - start));
+  }
+  return tokens;
+}
+
+// A distinct failure signature and the submissions that have it.
+struct Unit {
+  Bitset signature;
+  std::size_t ones = 0;
+  std::size_t first = 0;  // Lowest submission index; breaks ties.
+  std::vector<std::size_t> members;
+  std::uint64_t fingerprint = 0;
+};
+
+}  // namespace
+
+std::uint64_t code_fingerprint(std::string_view source) {
+  const std::string normal = judge::normalize_source(source);
+  const auto tokens = tokenize(normal);
+  std::array<std::int64_t, 64> votes{};
+  // Sources shorter than a trigram still get one (shorter) gram.
+  const std::size_t grams =
+      tokens.size() < 3 ? std::min<std::size_t>(tokens.size(), 1)
+                        : tokens.size() - 2;
+  for (std::size_t i = 0; i < grams; ++i) {
+    DigestBuilder gram;
+    for (std::size_t k = i; k < std::min(i + 3, tokens.size()); ++k) {
+      gram.add(tokens[k]);
+    }
+    const std::uint64_t hash = gram.finish().lo;
+    for (int b = 0; b < 64; ++b) votes[b] += (hash >> b) & 1 ? 1 : -1;
+  }
+  std::uint64_t fingerprint = 0;
+  for (int b = 0; b < 64; ++b) {
+    if (votes[b] > 0) fingerprint |= std::uint64_t{1} << b;
+  }
+  return fingerprint;
+}
+
+Clustering cluster_failures(std::span<const WrongSubmission> submissions,
+                            const ClusterOptions& options) {
+  std::vector<Unit> units;
+  std::unordered_multimap<std::uint64_t, std::size_t> by_hash;
+  for (std::size_t s = 0; s < submissions.size(); ++s) {
+    const Bitset& signature = submissions[s].failed;
+    const std::uint64_t hash = judge::signature_hash(signature);
+    std::size_t unit = units.size();
+    const auto [begin, end] = by_hash.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+      if (units[it->second].signature == signature) unit = it->second;
+    }
+    if (unit == units.size()) {
+      units.push_back({signature, signature.count(), s, {}, 0});
+      by_hash.emplace(hash, unit);
+    }
+    units[unit].members.push_back(s);
+  }
+
+  for (Unit& unit : units) {
+    std::array<std::size_t, 64> ones{};
+    for (const std::size_t s : unit.members) {
+      for (int b = 0; b < 64; ++b) {
+        ones[b] += (submissions[s].code_fingerprint >> b) & 1;
+      }
+    }
+    for (int b = 0; b < 64; ++b) {
+      if (2 * ones[b] > unit.members.size()) {
+        unit.fingerprint |= std::uint64_t{1} << b;
+      }
+    }
+  }
+  std::sort(units.begin(), units.end(), [](const Unit& a, const Unit& b) {
+    return a.members.size() != b.members.size()
+               ? a.members.size() > b.members.size()
+               : a.first < b.first;
+  });
+
+  const auto similarity = [&](const Unit& a, const Unit& b) {
+    const std::size_t both = a.signature.count_and(b.signature);
+    const std::size_t either = a.ones + b.ones - both;
+    const double jaccard =
+        either == 0 ? 1.0 : static_cast<double>(both) / either;
+    const double code =
+        1.0 - std::popcount(a.fingerprint ^ b.fingerprint) / 64.0;
+    return (1 - options.code_weight) * jaccard + options.code_weight * code;
+  };
+  // neighbours[i]: later (less common) units similar enough to unit i.
+  std::vector<std::vector<std::uint32_t>> neighbours(units.size());
+  parallel_for(units.size(), options.parallelism, [&](std::size_t i) {
+    for (std::size_t j = i + 1; j < units.size(); ++j) {
+      if (similarity(units[i], units[j]) >= options.threshold) {
+        neighbours[i].push_back(static_cast<std::uint32_t>(j));
+      }
+    }
+  });
+
+  constexpr auto kUnplaced = UINT32_MAX;
+  std::vector<std::uint32_t> unit_cluster(units.size(), kUnplaced);
+  Clustering result;
+  for (std::size_t i = 0; i < units.size(); ++i) {
+    if (unit_cluster[i] != kUnplaced) continue;
+    const auto id = static_cast<std::uint32_t>(result.clusters.size());
+    FailureCluster cluster{units[i].signature, 0, 0};
+    const auto place = [&](std::size_t u) {
+      unit_cluster[u] = id;
+      cluster.submissions += units[u].members.size();
+      ++cluster.signatures;
+    };
+    place(i);
+    for (const std::uint32_t j : neighbours[i]) {
+      if (unit_cluster[j] == kUnplaced) place(j);
+    }
+    result.clusters.push_back(std::move(cluster));
+  }
+
+  // Renumber largest first.
+  std::vector<std::uint32_t> order(result.clusters.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::uint32_t a, std::uint32_t b) {
+                     return result.clusters[a].submissions >
+                            result.clusters[b].submissions;
+                   });
+  std::vector<std::uint32_t> renumber(order.size());
+  std::vector<FailureCluster> sorted;
+  sorted.reserve(order.size());
+  for (std::uint32_t rank = 0; rank < order.size(); ++rank) {
+    renumber[order[rank]] = rank;
+    sorted.push_back(std::move(result.clusters[order[rank]]));
+  }
+  result.clusters = std::move(sorted);
+
+  result.cluster_of.resize(submissions.size());
+  for (std::size_t u = 0; u < units.size(); ++u) {
+    const std::uint32_t id = renumber[unit_cluster[u]];
+    for (const std::size_t s : units[u].members) result.cluster_of[s] = id;
+    result.signature_clusters.emplace_back(std::move(units[u].signature), id);
+  }
+  return result;
+}
+
+}  // namespace codecoach::analysis
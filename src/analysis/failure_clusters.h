@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "common/bitset.h"
+
+namespace codecoach::analysis {
+
+struct WrongSubmission {
+  Bitset failed;  // Full-audit failure signature (judge::failure_signature).
+  std::uint64_t code_fingerprint = 0;
+};
+
+// 64-bit SimHash of the token trigrams of the normalized source: sources
+// that differ in a few places differ in a few bits, so the Hamming distance
+// approximates how much two submissions share.
+std::uint64_t code_fingerprint(std::string_view source);
+
+struct ClusterOptions {
+  // Minimum similarity to a cluster's center to join it.
+  double threshold = 0.75;
+  // Share of the similarity taken from code fingerprints; the rest is the
+  // Jaccard similarity of the failure signatures.
+  double code_weight = 0.25;
+  std::size_t parallelism = 1;
+};
+
+struct FailureCluster {
+  Bitset center;  // The cluster's most common signature.
+  std::size_t submissions = 0;
+  std::size_t signatures = 0;  // Distinct signatures merged in.
+};
+
+struct Clustering {
+  // Largest first; a cluster's id is its index.
+  std::vector<FailureCluster> clusters;
+  std::vector<std::uint32_t> cluster_of;  // Per submission.
+  // Every distinct signature seen, most common first, and its cluster, for
+  // the bundle's kFailureClusters table (judge::encode_cluster_table).
+  std::vector<std::pair<Bitset, std::uint32_t>> signature_clusters;
+};
+
+// Clusters wrong submissions of one problem. Identical signatures are
+// merged first, which typically leaves a few hundred distinct ones out of
+// many thousands of submissions; their pairwise similarities are computed
+// in parallel with word-wise popcounts. Signatures are then taken most
+// common first, and each one not yet placed becomes the center of a cluster
+// that absorbs every unplaced signature similar enough to it. A signature's
+// code fingerprint is the bitwise majority of its submissions'.
+Clustering cluster_failures(std::span<const WrongSubmission> submissions,
+                            const ClusterOptions& options);
+
+}  // namespace codecoach::analysis
@@ -0,0 +1,382 @@
+#include "analysis/judged_export.h"
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "storage/columnar.h"
+
+namespace codecoach::analysis {
+
+namespace {
+
+using storage::ColumnType;
+
+// The header, then a "layout\t<first>\t<end>\t<shard_jobs>" line with the
+// options that decide shard boundaries, then one
+// "<begin>\t<end>\t<records>" line per finished shard.
+constexpr std::string_view kLogHeader = "codecoach-export\t2";
+constexpr std::string_view kLogName = "EXPORT";
+
+enum Table : std::size_t {
+  kSubmissions,
+  kVerdicts,
+  kTestResults,
+  kCoachExchanges,
+  kTableCount
+};
+
+struct TableSpec {
+  std::string_view name;
+  storage::Schema schema;
+};
+
+const std::array<TableSpec, kTableCount>& tables() {
+  static const std::array<TableSpec, kTableCount> specs = {{
+      {"submissions",
+       {{"job_id", ColumnType::kU64},
+        {"tenant", ColumnType::kU32},
+        {"priority", ColumnType::kU8},
+        {"problem", ColumnType::kString},
+        {"language", ColumnType::kString},
+        {"source", ColumnType::kString}}},
+      {"verdicts",
+       {{"job_id", ColumnType::kU64},
+        {"overall", ColumnType::kU8},
+        {"tests", ColumnType::kU32},
+        {"compile_log", ColumnType::kString},
+        {"has_failure_cluster", ColumnType::kU8},
+        {"failure_cluster", ColumnType::kU32}}},
+      {"test_results",
+       {{"job_id", ColumnType::kU64},
+        {"test", ColumnType::kU32},
+        {"outcome", ColumnType::kU8},
+        {"time_ms", ColumnType::kU32},
+        {"memory_kb", ColumnType::kU32}}},
+      {"coach_exchanges",
+       {{"job_id", ColumnType::kU64},
+        {"turn", ColumnType::kU32},
+        {"source", ColumnType::kU8},
+        {"step", ColumnType::kU32},
+        {"failure_class", ColumnType::kString},
+        {"text", ColumnType::kString}}},
+  }};
+  return specs;
+}
+
+struct Shard {
+  JobId begin;
+  JobId end;
+};
+
+std::filesystem::path table_path(const std::filesystem::path& directory,
+                                 Table table, JobId begin) {
+  char name[64];
+  std::snprintf(name, sizeof(name), "%s-%016llx.ccol",
+                std::string(tables()[table].name).c_str(),
+                static_cast<unsigned long long>(begin));
+  return directory / name;
+}
+
+// What an export log was started with. Shard files are named by begin
+// only, so a resume with other boundaries would mix shards.
+struct Layout {
+  JobId first = 0;
+  JobId end = 0;
+  std::uint64_t shard_jobs = 0;
+
+  bool operator==(const Layout&) const = default;
+};
+
+std::string describe(const Layout& layout) {
+  return "first " + std::to_string(layout.first) + ", end " +
+         std::to_string(layout.end) + ", shard_jobs " +
+         std::to_string(layout.shard_jobs);
+}
+
+// Finished shards -> record counts, from the EXPORT log. `layout` is
+// empty if there is no complete log header.
+std::map<std::pair<JobId, JobId>, std::uint64_t> read_log(
+    const std::filesystem::path& path, std::optional<Layout>& layout,
+    bool& torn) {
+  std::map<std::pair<JobId, JobId>, std::uint64_t> done;
+  layout.reset();
+  torn = false;
+  std::ifstream in(path, std::ios::binary);
+  std::string line;
+  if (!in || !std::getline(in, line)) return done;
+  if (line != kLogHeader) {
+    if (in.eof() && kLogHeader.starts_with(line)) return done;  // Torn.
+    throw storage::CorruptionError(path.string() + ": bad header");
+  }
+  unsigned long long first, end, shard_jobs;
+  if (!std::getline(in, line) || in.eof() ||
+      std::sscanf(line.c_str(), "layout\t%llu\t%llu\t%llu", &first, &end,
+                  &shard_jobs) != 3) {
+    return done;  // Torn before any shard finished.
+  }
+  layout = Layout{first, end, shard_jobs};
+  while (std::getline(in, line)) {
+    unsigned long long begin, end, records;
+    if (std::sscanf(line.c_str(), "%llu\t%llu\t%llu", &begin, &end,
+                    &records) == 3) {
+      done[{begin, end}] = records;
+    }
+  }
+  in.clear();
+  in.seekg(-1, std::ios::end);
+  torn = in.get() != '\n';
+  return done;
+}
+
+void write_record(const JudgedRecord& record,
+                  std::array<std::unique_ptr<storage::ColumnarWriter>,
+                             kTableCount>& out) {
+  const JobId job = record.submission.job_id;
+  auto& submissions = *out[kSubmissions];
+  submissions.add(0, job);
+  submissions.add(1, record.submission.tenant);
+  submissions.add(2, static_cast<std::uint64_t>(record.submission.priority));
+  submissions.add(3, record.submission.problem);
+  submissions.add(4, record.submission.language);
+  submissions.add(5, record.submission.source);
+  submissions.end_row();
+
+  auto& verdicts = *out[kVerdicts];
+  verdicts.add(0, job);
+  verdicts.add(1, static_cast<std::uint64_t>(record.verdict.overall));
+  verdicts.add(2, record.verdict.tests.size());
+  verdicts.add(3, record.verdict.compile_log);
+  verdicts.add(4, record.failure_cluster ? 1 : 0);
+  verdicts.add(5, record.failure_cluster.value_or(0));
+  verdicts.end_row();
+
+  auto& tests = *out[kTestResults];
+  for (std::size_t t = 0; t < record.verdict.tests.size(); ++t) {
+    const judge::TestResult& result = record.verdict.tests[t];
+    tests.add(0, job);
+    tests.add(1, t);
+    tests.add(2, static_cast<std::uint64_t>(result.outcome));
+    tests.add(3, result.time_ms);
+    tests.add(4, result.memory_kb);
+    tests.end_row();
+  }
+
+  auto& coach = *out[kCoachExchanges];
+  for (std::size_t turn = 0; turn < record.hints.size(); ++turn) {
+    const coach::Hint& hint = record.hints[turn];
+    coach.add(0, job);
+    coach.add(1, turn);
+    coach.add(2, static_cast<std::uint64_t>(hint.source));
+    coach.add(3, hint.step);
+    coach.add(4, hint.failure_class);
+    coach.add(5, hint.text);
+    coach.end_row();
+  }
+}
+
+// Row cursor over a columnar file, holding one decoded chunk at a time.
+class Cursor {
+ public:
+  Cursor(const std::filesystem::path& path, const storage::Schema& schema)
+      : reader_(path) {
+    if (reader_.schema() != schema) {
+      throw storage::CorruptionError(path.string() + ": unexpected schema");
+    }
+    load();
+  }
+
+  bool valid() const { return chunk_index_ < reader_.chunk_count(); }
+  std::uint64_t u64(std::size_t column) const {
+    return chunk_.u64(column, row_);
+  }
+  std::string_view str(std::size_t column) const {
+    return chunk_.str(column, row_);
+  }
+  void next() {
+    if (++row_ >= chunk_.rows()) {
+      ++chunk_index_;
+      load();
+    }
+  }
+
+ private:
+  void load() {
+    row_ = 0;
+    while (valid()) {
+      chunk_ = reader_.chunk(chunk_index_);
+      if (chunk_.rows() > 0) return;
+      ++chunk_index_;
+    }
+  }
+
+  storage::ColumnarReader reader_;
+  std::size_t chunk_index_ = 0;
+  std::size_t row_ = 0;
+  storage::ColumnarReader::Chunk chunk_;
+};
+
+std::uint64_t import_shard(const std::filesystem::path& directory,
+                           JobId begin, JudgedDataSink& sink) {
+  std::array<std::unique_ptr<Cursor>, kTableCount> in;
+  for (std::size_t t = 0; t < kTableCount; ++t) {
+    in[t] = std::make_unique<Cursor>(
+        table_path(directory, static_cast<Table>(t), begin),
+        tables()[t].schema);
+  }
+  const auto fail = [&](const char* what) {
+    return storage::CorruptionError(
+        table_path(directory, kSubmissions, begin).string() + ": " + what);
+  };
+  Cursor& submissions = *in[kSubmissions];
+  Cursor& verdicts = *in[kVerdicts];
+  Cursor& tests = *in[kTestResults];
+  Cursor& coach = *in[kCoachExchanges];
+  std::uint64_t records = 0;
+  for (; submissions.valid(); submissions.next(), verdicts.next()) {
+    const JobId job = submissions.u64(0);
+    if (!verdicts.valid() || verdicts.u64(0) != job) {
+      throw fail("verdicts out of step with submissions");
+    }
+    JudgedRecord record;
+    record.submission.job_id = job;
+    record.submission.tenant = static_cast<TenantId>(submissions.u64(1));
+    record.submission.priority = static_cast<Priority>(submissions.u64(2));
+    record.submission.problem = submissions.str(3);
+    record.submission.language = submissions.str(4);
+    record.submission.source = submissions.str(5);
+
+    record.verdict.overall = static_cast<judge::Outcome>(verdicts.u64(1));
+    record.verdict.compile_log = verdicts.str(3);
+    if (verdicts.u64(4) != 0) {
+      record.failure_cluster = static_cast<std::uint32_t>(verdicts.u64(5));
+    }
+    for (; tests.valid() && tests.u64(0) == job; tests.next()) {
+      if (tests.u64(1) != record.verdict.tests.size()) {
+        throw fail("test results out of order");
+      }
+      record.verdict.tests.push_back(
+          {static_cast<judge::Outcome>(tests.u64(2)),
+           static_cast<std::uint32_t>(tests.u64(3)),
+           static_cast<std::uint32_t>(tests.u64(4))});
+    }
+    if (record.verdict.tests.size() != verdicts.u64(2)) {
+      throw fail("test results missing");
+    }
+    for (; coach.valid() && coach.u64(0) == job; coach.next()) {
+      coach::Hint hint;
+      hint.source = static_cast<coach::Hint::Source>(coach.u64(2));
+      hint.step = static_cast<std::size_t>(coach.u64(3));
+      hint.failure_class = coach.str(4);
+      hint.text = coach.str(5);
+      record.hints.push_back(std::move(hint));
+    }
+    sink.write(std::move(record));
+    ++records;
+  }
+  if (verdicts.valid() || tests.valid() || coach.valid()) {
+    throw fail("rows without a submission");
+  }
+  return records;
+}
+
+}  // namespace
+
+ExportSummary export_judged(JudgedDataSource& source,
+                            const std::filesystem::path& directory,
+                            const ExportOptions& options) {
+  if (options.shard_jobs == 0) {
+    throw std::invalid_argument("export_judged: shard_jobs is 0");
+  }
+  std::filesystem::create_directories(directory);
+  const auto log_path = directory / kLogName;
+  const Layout wanted{options.first, options.end, options.shard_jobs};
+  std::optional<Layout> layout;
+  bool torn = false;
+  const auto done = read_log(log_path, layout, torn);
+  if (layout && *layout != wanted) {
+    throw std::invalid_argument(
+        "export_judged: " + directory.string() + " holds an export with " +
+        describe(*layout) + "; refusing to resume it with " +
+        describe(wanted));
+  }
+  std::ofstream log(log_path, layout ? std::ios::app : std::ios::trunc);
+  if (!log) throw std::runtime_error("cannot open " + log_path.string());
+  if (!layout) {
+    log << kLogHeader << '\n'
+        << "layout\t" << wanted.first << '\t' << wanted.end << '\t'
+        << wanted.shard_jobs << '\n'
+        << std::flush;
+  }
+  if (torn) log << '\n' << std::flush;
+
+  std::vector<Shard> shards;
+  for (JobId begin = options.first; begin < options.end;) {
+    const JobId end = options.end - begin > options.shard_jobs
+                          ? begin + options.shard_jobs
+                          : options.end;
+    shards.push_back({begin, end});
+    begin = end;
+  }
+
+  ExportSummary summary;
+  summary.shards = shards.size();
+  std::atomic<std::size_t> resumed{0};
+  std::atomic<std::uint64_t> records{0};
+  std::mutex log_mu;
+  parallel_for(shards.size(), options.parallelism, [&](std::size_t i) {
+    const Shard shard = shards[i];
+    if (const auto it = done.find({shard.begin, shard.end});
+        it != done.end()) {
+      ++resumed;
+      records += it->second;
+      return;
+    }
+    std::array<std::unique_ptr<storage::ColumnarWriter>, kTableCount> out;
+    for (std::size_t t = 0; t < kTableCount; ++t) {
+      out[t] = std::make_unique<storage::ColumnarWriter>(
+          table_path(directory, static_cast<Table>(t), shard.begin),
+          tables()[t].schema, options.chunk_rows, options.chunk_bytes);
+    }
+    std::uint64_t count = 0;
+    source.scan(shard.begin, shard.end, [&](const JudgedRecord& record) {
+      write_record(record, out);
+      ++count;
+    });
+    for (auto& writer : out) writer->finish();
+    records += count;
+    std::lock_guard lock(log_mu);
+    log << shard.begin << '\t' << shard.end << '\t' << count << '\n'
+        << std::flush;
+    if (!log) throw std::runtime_error("cannot write " + log_path.string());
+  });
+  summary.resumed = resumed;
+  summary.records = records;
+  return summary;
+}
+
+std::uint64_t import_judged(const std::filesystem::path& directory,
+                            JudgedDataSink& sink, std::size_t parallelism) {
+  std::optional<Layout> layout;
+  bool torn = false;
+  const auto done = read_log(directory / kLogName, layout, torn);
+  if (!layout) {
+    throw storage::CorruptionError(directory.string() + ": no export log");
+  }
+  std::vector<JobId> shards;
+  for (const auto& [range, records] : done) shards.push_back(range.first);
+  std::atomic<std::uint64_t> records{0};
+  parallel_for(shards.size(), parallelism, [&](std::size_t i) {
+    records += import_shard(directory, shards[i], sink);
+  });
+  return records;
+}
+
+}  // namespace codecoach::analysis
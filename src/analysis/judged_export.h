@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "api/messages.h"
+#include "coach/coach.h"
+#include "common/parallel.h"
+#include "common/types.h"
+#include "judge/verdict.h"
+
+namespace codecoach::analysis {
+
+// A judged submission with what offline analytics and coach training use:
+// the request, its verdict and the hints served for it, in order.
+struct JudgedRecord {
+  api::SubmitRequest submission;
+  judge::Verdict verdict;
+  std::optional<std::uint32_t> failure_cluster;
+  std::vector<coach::Hint> hints;
+};
+
+// Where export reads records from, by job-id range so ranges can be read
+// in parallel.
+class JudgedDataSource {
+ public:
+  virtual ~JudgedDataSource() = default;
+  // Every record with begin <= job id < end, in job-id order. Called from
+  // several threads at once.
+  virtual void scan(JobId begin, JobId end,
+                    const std::function<void(const JudgedRecord&)>& fn) = 0;
+};
+
+// Where import writes records to. Called from several threads at once.
+class JudgedDataSink {
+ public:
+  virtual ~JudgedDataSink() = default;
+  virtual void write(JudgedRecord record) = 0;
+};
+
+struct ExportOptions {
+  JobId first = 0;
+  JobId end = 0;  // Exclusive.
+  // Job ids per shard; each shard is one set of files and the unit of
+  // parallelism and of resumption.
+  std::uint64_t shard_jobs = 1'000'000;
+  std::size_t parallelism = default_parallelism();
+  // Bound on buffered rows per open file (storage::ColumnarWriter).
+  std::size_t chunk_rows = 65536;
+  std::size_t chunk_bytes = 16u << 20;
+};
+
+struct ExportSummary {
+  std::size_t shards = 0;
+  std::size_t resumed = 0;  // Already complete, skipped.
+  std::uint64_t records = 0;
+};
+
+// Streams judged data into `directory` as storage/columnar files, one per
+// table and shard:
+//
+//   submissions-<shard>.ccol      job_id tenant priority problem language
+//                                 source
+//   verdicts-<shard>.ccol         job_id overall tests compile_log
+//                                 has_failure_cluster failure_cluster
+//   test_results-<shard>.ccol     job_id test outcome time_ms memory_kb
+//   coach_exchanges-<shard>.ccol  job_id turn source step failure_class
+//                                 text
+//
+// Shards run in parallel, each holding one chunk per table in memory.
+// A shard is appended to the EXPORT log once all its files are in place,
+// so a rerun after a crash skips finished shards and redoes the rest. The
+// log also records first, end and shard_jobs; a rerun with other values
+// throws std::invalid_argument rather than mixing shard layouts.
+ExportSummary export_judged(JudgedDataSource& source,
+                            const std::filesystem::path& directory,
+                            const ExportOptions& options);
+
+// Replays every completed shard of an export into `sink`, shards in
+// parallel, streaming chunk by chunk. Returns the number of records.
+// Throws storage::CorruptionError on damaged or inconsistent files.
+std::uint64_t import_judged(const std::filesystem::path& directory,
+                            JudgedDataSink& sink,
+                            std::size_t parallelism = default_parallelism());
+
+}  // namespace codecoach::analysis
@@ -0,0 +1,102 @@
+#include "analysis/mutation_benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "common/parallel.h"
+#include "harness/driver.h"
+#include "judge/local_runner.h"
+
+namespace codecoach::analysis {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::chrono::milliseconds since(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                               start);
+}
+
+}  // namespace
+
+MutationReport run_mutation_benchmark(const catalog::ProblemBundle& bundle,
+                                      std::string_view reference,
+                                      compile::Compiler& compiler,
+                                      const MutationOptions& options) {
+  MutationReport report;
+  report.mutants = generate_mutants(reference);
+  report.results.resize(report.mutants.size());
+  report.kills_per_test.assign(bundle.test_count(), 0);
+
+  std::vector<std::size_t> order;
+  for (std::size_t t = 0; t < bundle.test_count(); ++t) {
+    if (catalog::runs_in(bundle.test(t), options.mode)) order.push_back(t);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::size_t a, std::size_t b) {
+                     return bundle.test(a).input.size() <
+                            bundle.test(b).input.size();
+                   });
+  const auto limits = judge::RunLimits::of(bundle);
+
+  // Reference first: a mutation score is meaningless if it fails.
+  compiler.ensure_pch();
+  const auto baseline =
+      compiler.compile(harness::program_source(bundle, reference));
+  if (!baseline.ok) {
+    throw MutationError("reference does not compile:\n" + baseline.log);
+  }
+  std::atomic<bool> baseline_ok{true};
+  parallel_for(order.size(), options.parallelism, [&](std::size_t i) {
+    if (judge::run_test_locally(baseline.artifact, bundle.test(order[i]),
+                                limits)
+            .outcome != judge::Outcome::kAccepted) {
+      baseline_ok = false;
+    }
+  });
+  if (!baseline_ok) throw MutationError("reference fails its own tests");
+
+  auto start = Clock::now();
+  std::vector<compile::CompileResult> builds(report.mutants.size());
+  parallel_for(report.mutants.size(), options.parallelism, [&](std::size_t i) {
+    builds[i] = compiler.compile(
+        harness::program_source(bundle, report.mutants[i].source));
+  });
+  report.compile_time = since(start);
+
+  start = Clock::now();
+  parallel_for(report.mutants.size(), options.parallelism, [&](std::size_t i) {
+    auto& result = report.results[i];
+    if (!builds[i].ok) {
+      result.status = MutantStatus::kStillborn;
+      return;
+    }
+    result.status = MutantStatus::kSurvived;
+    for (const std::size_t t : order) {
+      const auto outcome =
+          judge::run_test_locally(builds[i].artifact, bundle.test(t), limits)
+              .outcome;
+      if (outcome != judge::Outcome::kAccepted) {
+        result = {MutantStatus::kKilled, t, outcome};
+        return;
+      }
+    }
+  });
+  report.run_time = since(start);
+
+  for (std::size_t i = 0; i < report.results.size(); ++i) {
+    report.cache_hits += builds[i].cache_hit;
+    switch (report.results[i].status) {
+      case MutantStatus::kStillborn: ++report.stillborn; break;
+      case MutantStatus::kSurvived: ++report.survived; break;
+      case MutantStatus::kKilled:
+        ++report.killed;
+        ++report.kills_per_test[report.results[i].killing_test];
+        break;
+    }
+  }
+  return report;
+}
+
+}  // namespace codecoach::analysis
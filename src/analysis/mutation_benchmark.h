@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "analysis/mutator.h"
+#include "catalog/problem_bundle.h"
+#include "compile/compiler.h"
+#include "judge/verdict.h"
+
+namespace codecoach::analysis {
+
+struct MutationOptions {
+  std::size_t parallelism = 1;
+  catalog::JudgeMode mode = catalog::JudgeMode::kFullAudit;
+};
+
+enum class MutantStatus {
+  kStillborn,  // Did not compile.
+  kKilled,     // Some test failed it.
+  kSurvived,   // Passed every test: the suite cannot tell it from correct.
+};
+
+struct MutantResult {
+  MutantStatus status = MutantStatus::kStillborn;
+  std::size_t killing_test = 0;  // Valid when killed.
+  judge::Outcome killing_outcome = judge::Outcome::kAccepted;
+};
+
+struct MutationReport {
+  std::vector<Mutant> mutants;
+  std::vector<MutantResult> results;  // Parallel to mutants.
+  std::vector<std::size_t> kills_per_test;
+  std::size_t stillborn = 0;
+  std::size_t killed = 0;
+  std::size_t survived = 0;
+  std::size_t cache_hits = 0;
+  std::chrono::milliseconds compile_time{0};
+  std::chrono::milliseconds run_time{0};
+
+  // Fraction of compilable mutants the suite kills. Surviving mutants may be
+  // equivalent to the reference, so 1.0 is not always reachable.
+  double score() const {
+    const auto live = killed + survived;
+    return live == 0 ? 1.0 : static_cast<double>(killed) / live;
+  }
+};
+
+class MutationError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Mutates `reference`, compiles every mutant in one parallel batch through
+// the compile cache (sharing the configuration's PCH), and runs the live
+// mutants against the bundle's tests. Each mutant stops at its first failing
+// test; tests run smallest input first, which kills most mutants cheaply.
+// Throws MutationError if the reference itself fails to compile or pass.
+MutationReport run_mutation_benchmark(const catalog::ProblemBundle& bundle,
+                                      std::string_view reference,
+                                      compile::Compiler& compiler,
+                                      const MutationOptions& options);
+
+}  // namespace codecoach::analysis
@@ -0,0 +1,237 @@
+#include "analysis/mutator.h"
+
+#include <cctype>
+
+namespace codecoach::analysis {
+
+namespace {
+
+enum class TokenKind { kIdentifier, kNumber, kPunct };
+
+struct Token {
+  TokenKind kind;
+  std::size_t offset;
+  std::size_t line;
+  std::string_view text;
+};
+
+bool is_ident_start(char c) {
+  return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+bool is_ident_char(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// Splits `source` into mutable tokens, dropping whitespace, comments,
+// literals and preprocessor lines.
+std::vector<Token> tokenize(std::string_view source) {
+  static constexpr std::string_view kPuncts[] = {
+      "<<=", ">>=", "<=", ">=", "==", "!=", "&&", "||", "<<", ">>", "::",
+      "->",  "++",  "--",
+  };
+  std::vector<Token> tokens;
+  std::size_t line = 1;
+  bool line_start = true;
+  std::size_t i = 0;
+  while (i < source.size()) {
+    const char c = source[i];
+    const char next = i + 1 < source.size() ? source[i + 1] : '\0';
+    if (c == '\n') {
+      ++line;
+      line_start = true;
+      ++i;
+    } else if (std::isspace(static_cast<unsigned char>(c))) {
+      ++i;
+    } else if (c == '#' && line_start) {
+      // Skip the directive, honouring line continuations.
+      while (i < source.size() && source[i] != '\n') {
+        if (source[i] == '\\' && i + 1 < source.size() &&
+            source[i + 1] == '\n') {
+          ++line;
+          ++i;
+        }
+        ++i;
+      }
+    } else if (c == '/' && next == '/') {
+      while (i < source.size() && source[i] != '\n') ++i;
+    } else if (c == '/' && next == '*') {
+      const auto end = source.find("*/", i + 2);
+      const auto stop = end == std::string_view::npos ? source.size() : end + 2;
+      for (; i < stop; ++i) line += source[i] == '\n';
+    } else if (c == '"' || c == '\'') {
+      ++i;
+      while (i < source.size() && source[i] != c && source[i] != '\n') {
+        i += source[i] == '\\' ? 2 : 1;
+      }
+      ++i;
+      line_start = false;
+    } else if (is_ident_start(c)) {
+      const std::size_t start = i;
+      while (i < source.size() && is_ident_char(source[i])) ++i;
+      tokens.push_back({TokenKind::kIdentifier, start, line,
+                        source.substr(start, i - start)});
+      line_start = false;
+    } else if (std::isdigit(static_cast<unsigned char>(c))) {
+      const std::size_t start = i;
+      while (i < source.size() &&
+             (is_ident_char(source[i]) || source[i] == '.' ||
+              source[i] == '\'')) {
+        ++i;
+      }
+      tokens.push_back({TokenKind::kNumber, start, line,
+                        source.substr(start, i - start)});
+      line_start = false;
+    } else {
+      std::size_t len = 1;
+      for (const auto punct : kPuncts) {
+        if (source.substr(i, punct.size()) == punct) {
+          len = punct.size();
+          break;
+        }
+      }
+      tokens.push_back({TokenKind::kPunct, i, line, source.substr(i, len)});
+      i += len;
+      line_start = false;
+    }
+  }
+  return tokens;
+}
+
+bool is_decimal_int(std::string_view text) {
+  for (const char c : text) {
+    if (!std::isdigit(static_cast<unsigned char>(c))) return false;
+  }
+  // A leading zero makes an octal literal; leave those alone.
+  return !text.empty() && text.size() < 10 &&
+         (text.size() == 1 || text[0] != '0');
+}
+
+bool is_comparison(std::string_view text) {
+  return text == "<" || text == "<=" || text == ">" || text == ">=" ||
+         text == "==" || text == "!=";
+}
+
+// Marks the `<` and `>` tokens that are template brackets: a `<` directly
+// after a known template name opens one, and the next `>` (or each half of
+// a `>>`) closes the innermost open one. Anything else is left for
+// mutation; the odd misread only makes a stillborn mutant.
+std::vector<bool> template_brackets(const std::vector<Token>& tokens) {
+  static constexpr std::string_view kTemplates[] = {
+      "vector", "pair",  "map",      "set",     "array", "tuple",
+      "queue",  "stack", "priority_queue", "deque", "unordered_map",
+      "unordered_set", "greater", "less", "function", "template",
+      "static_cast", "bitset", "multiset", "multimap", "numeric_limits",
+  };
+  std::vector<bool> brackets(tokens.size(), false);
+  std::size_t open = 0;
+  for (std::size_t i = 0; i < tokens.size(); ++i) {
+    const auto text = tokens[i].text;
+    if (text == "<" && i > 0) {
+      for (const auto name : kTemplates) {
+        if (tokens[i - 1].text == name) {
+          brackets[i] = true;
+          ++open;
+          break;
+        }
+      }
+    } else if (text == ">" && open > 0) {
+      brackets[i] = true;
+      --open;
+    } else if (text == ">>" && open > 0) {
+      brackets[i] = true;
+      open -= open >= 2 ? 2 : 1;
+    } else if (text == ";" || text == "{" || text == "}") {
+      open = 0;  // A bracket cannot stay open across these.
+    }
+  }
+  return brackets;
+}
+
+}  // namespace
+
+std::string_view to_string(MutationOperator op) {
+  switch (op) {
+    case MutationOperator::kRelational: return "relational";
+    case MutationOperator::kOffByOne: return "off-by-one";
+    case MutationOperator::kNarrowing: return "narrowing";
+    case MutationOperator::kLogical: return "logical";
+  }
+  return "?";
+}
+
+std::vector<Mutant> generate_mutants(std::string_view source) {
+  const auto tokens = tokenize(source);
+  const auto brackets = template_brackets(tokens);
+  std::vector<Mutant> mutants;
+
+  const auto emit = [&](MutationOperator op, const Token& tok,
+                        std::size_t length, std::string replacement) {
+    Mutant m;
+    m.op = op;
+    m.offset = tok.offset;
+    m.line = tok.line;
+    m.original = std::string(source.substr(tok.offset, length));
+    m.replacement = std::move(replacement);
+    m.source.reserve(source.size() + m.replacement.size());
+    m.source.append(source.substr(0, tok.offset));
+    m.source.append(m.replacement);
+    m.source.append(source.substr(tok.offset + length));
+    mutants.push_back(std::move(m));
+  };
+
+  for (std::size_t i = 0; i < tokens.size(); ++i) {
+    const Token& tok = tokens[i];
+    const auto prev = i > 0 ? tokens[i - 1].text : std::string_view();
+    const auto next =
+        i + 1 < tokens.size() ? tokens[i + 1].text : std::string_view();
+
+    if (tok.kind == TokenKind::kPunct) {
+      if (is_comparison(tok.text) && !brackets[i]) {
+        static constexpr std::pair<std::string_view, std::string_view>
+            kFlips[] = {{"<", "<="}, {"<=", "<"}, {">", ">="},
+                        {">=", ">"}, {"==", "!="}, {"!=", "=="}};
+        for (const auto& [from, to] : kFlips) {
+          if (tok.text == from) {
+            emit(MutationOperator::kRelational, tok, from.size(),
+                 std::string(to));
+          }
+        }
+      } else if (tok.text == "&&" || tok.text == "||") {
+        emit(MutationOperator::kLogical, tok, 2,
+             tok.text == "&&" ? "||" : "&&");
+      }
+    } else if (tok.kind == TokenKind::kNumber && is_decimal_int(tok.text)) {
+      // Bounds and indices: the literal sits next to a comparison, inside
+      // brackets, or is a loop start/step.
+      const bool bound = is_comparison(prev) || is_comparison(next) ||
+                         prev == "[" || next == "]" || prev == "=" ||
+                         prev == "+" || prev == "-";
+      if (bound) {
+        const long value = std::stol(std::string(tok.text));
+        emit(MutationOperator::kOffByOne, tok, tok.text.size(),
+             std::to_string(value + 1));
+        if (value > 0) {
+          emit(MutationOperator::kOffByOne, tok, tok.text.size(),
+               std::to_string(value - 1));
+        }
+      }
+    } else if (tok.kind == TokenKind::kIdentifier) {
+      if (tok.text == "long" && next == "long") {
+        const Token& second = tokens[i + 1];
+        const std::size_t length =
+            second.offset + second.text.size() - tok.offset;
+        // Keep `unsigned long long` unsigned.
+        emit(MutationOperator::kNarrowing, tok, length, "int");
+        ++i;
+      } else if (tok.text == "int64_t" || tok.text == "size_t") {
+        // `using ll = long long;` is covered by the rule above; a
+        // `#define ll long long` is a directive and left alone.
+        emit(MutationOperator::kNarrowing, tok, tok.text.size(),
+             tok.text == "size_t" ? "unsigned" : "int");
+      }
+    }
+  }
+  return mutants;
+}
+
+}  // namespace codecoach::analysis
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace codecoach::analysis {
+
+enum class MutationOperator {
+  kRelational,   // <  <=  >  >=  ==  != swapped for a near neighbour
+  kOffByOne,     // integer literal in a bound or index nudged by +-1
+  kNarrowing,    // long long / int64_t replaced by int
+  kLogical,      // && and || swapped
+};
+
+std::string_view to_string(MutationOperator op);
+
+struct Mutant {
+  MutationOperator op;
+  std::size_t offset = 0;  // Byte offset of the mutated token.
+  std::size_t line = 0;    // 1-based.
+  std::string original;
+  std::string replacement;
+  std::string source;  // The full mutated program.
+};
+
+// Generates single-point mutants of a reference solution. Comments, string
+// literals and preprocessor lines are never mutated. The lexing is
+// heuristic (it cannot always tell `a < b` from `vector<int>`), so some
+// mutants will not compile; callers treat those as stillborn.
+std::vector<Mutant> generate_mutants(std::string_view source);
+
+}  // namespace codecoach::analysis
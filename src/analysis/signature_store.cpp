@@ -0,0 +1,210 @@
+#include "analysis/signature_store.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#include "common/parallel.h"
+#include "common/simd_popcount.h"
+
+namespace codecoach::analysis {
+
+namespace {
+
+constexpr std::array<char, 8> kMagic = {'C', 'C', 'S', 'I', 'G', 'S', '\0',
+                                        '\0'};
+constexpr std::uint32_t kVersion = 1;
+
+struct FileHeader {
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  std::uint32_t reserved;
+  std::uint64_t test_count;
+  std::uint64_t size;
+};
+static_assert(sizeof(FileHeader) == 32);
+
+bool bit(const std::vector<std::uint64_t>& column, std::size_t i) {
+  return (column[i / 64] >> (i % 64)) & 1;
+}
+
+}  // namespace
+
+std::uint8_t usage_bucket(std::uint32_t value, std::uint32_t limit) {
+  if (limit == 0) return 15;
+  return static_cast<std::uint8_t>(
+      std::min<std::uint64_t>(15, std::uint64_t{value} * 15 / limit));
+}
+
+SignatureStore::SignatureStore(std::size_t test_count)
+    : test_count_(test_count), ran_(test_count), failed_(test_count) {}
+
+std::size_t SignatureStore::append(const judge::Verdict& verdict,
+                                   const judge::RunLimits& limits) {
+  if (!verdict.tests.empty() && verdict.tests.size() != test_count_) {
+    throw SignatureError("verdict has " +
+                         std::to_string(verdict.tests.size()) +
+                         " tests, store has " + std::to_string(test_count_));
+  }
+  const std::size_t s = size_++;
+  const std::uint64_t mask = std::uint64_t{1} << (s % 64);
+  if (s % 64 == 0) {
+    for (std::size_t t = 0; t < test_count_; ++t) {
+      ran_[t].push_back(0);
+      failed_[t].push_back(0);
+    }
+  }
+  buckets_.resize(buckets_.size() + test_count_, 0);
+  std::uint8_t* row = buckets_.data() + s * test_count_;
+  for (std::size_t t = 0; t < verdict.tests.size(); ++t) {
+    const auto& test = verdict.tests[t];
+    if (test.outcome == judge::Outcome::kSkipped) continue;
+    ran_[t].back() |= mask;
+    if (test.outcome != judge::Outcome::kAccepted) failed_[t].back() |= mask;
+    row[t] = static_cast<std::uint8_t>(
+        usage_bucket(test.time_ms, limits.time_limit_ms) |
+        usage_bucket(test.memory_kb, limits.memory_limit_kb) << 4);
+  }
+  return s;
+}
+
+bool SignatureStore::ran(std::size_t submission, std::size_t test) const {
+  return bit(ran_[test], submission);
+}
+
+bool SignatureStore::failed(std::size_t submission, std::size_t test) const {
+  return bit(failed_[test], submission);
+}
+
+std::uint8_t SignatureStore::time_bucket(std::size_t submission,
+                                         std::size_t test) const {
+  return buckets_[submission * test_count_ + test] & 0x0f;
+}
+
+std::uint8_t SignatureStore::memory_bucket(std::size_t submission,
+                                           std::size_t test) const {
+  return buckets_[submission * test_count_ + test] >> 4;
+}
+
+Bitset SignatureStore::failure_signature(std::size_t submission) const {
+  Bitset signature(test_count_);
+  for (std::size_t t = 0; t < test_count_; ++t) {
+    if (failed(submission, t)) signature.set(t);
+  }
+  return signature;
+}
+
+double SignatureStore::PairStats::correlation() const {
+  // 2x2 contingency table over the submissions that ran both tests.
+  const double n11 = static_cast<double>(both_failed);
+  const double n10 = static_cast<double>(a_failed - both_failed);
+  const double n01 = static_cast<double>(b_failed - both_failed);
+  const double n00 = static_cast<double>(both_ran) - n11 - n10 - n01;
+  const double denominator =
+      (n11 + n10) * (n01 + n00) * (n11 + n01) * (n10 + n00);
+  if (denominator <= 0) return 0;
+  return (n11 * n00 - n10 * n01) / std::sqrt(denominator);
+}
+
+SignatureStore::PairStats SignatureStore::pair_stats(std::size_t a,
+                                                     std::size_t b) const {
+  const std::size_t words = Bitset::word_count(size_);
+  return {
+      .both_ran = popcount_and(ran_[a].data(), ran_[b].data(), words),
+      .a_failed = popcount_and(failed_[a].data(), ran_[b].data(), words),
+      .b_failed = popcount_and(ran_[a].data(), failed_[b].data(), words),
+      .both_failed = popcount_and(failed_[a].data(), failed_[b].data(), words),
+  };
+}
+
+std::vector<SignatureStore::PairStats> SignatureStore::all_pair_stats(
+    std::size_t parallelism) const {
+  const std::size_t n = test_count_;
+  std::vector<PairStats> matrix(n * n);
+  parallel_for(n, parallelism, [&](std::size_t a) {
+    for (std::size_t b = a; b < n; ++b) matrix[a * n + b] = pair_stats(a, b);
+  });
+  for (std::size_t a = 0; a < n; ++a) {
+    for (std::size_t b = 0; b < a; ++b) {
+      const PairStats& upper = matrix[b * n + a];
+      matrix[a * n + b] = {upper.both_ran, upper.b_failed, upper.a_failed,
+                           upper.both_failed};
+    }
+  }
+  return matrix;
+}
+
+DetectionMatrix SignatureStore::detection_matrix() const {
+  DetectionMatrix detections;
+  detections.reserve(test_count_);
+  for (const auto& column : failed_) detections.emplace_back(size_, column);
+  return detections;
+}
+
+void SignatureStore::save(const std::filesystem::path& path) const {
+  auto tmp = path;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    const FileHeader header{kMagic, kVersion, 0, test_count_, size_};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (std::size_t t = 0; t < test_count_; ++t) {
+      for (const auto* column : {&ran_[t], &failed_[t]}) {
+        out.write(reinterpret_cast<const char*>(column->data()),
+                  static_cast<std::streamsize>(column->size() *
+                                               sizeof(std::uint64_t)));
+      }
+    }
+    out.write(reinterpret_cast<const char*>(buckets_.data()),
+              static_cast<std::streamsize>(buckets_.size()));
+    out.flush();
+    if (!out) throw SignatureError("write failed: " + tmp.string());
+  }
+  std::filesystem::rename(tmp, path);
+}
+
+SignatureStore SignatureStore::load(const std::filesystem::path& path) {
+  std::ifstream in(path, std::ios::binary);
+  const auto fail = [&](const char* what) {
+    return SignatureError(path.string() + ": " + what);
+  };
+  FileHeader header;
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+    throw fail("truncated");
+  }
+  if (header.magic != kMagic || header.version != kVersion) {
+    throw fail("not a signature store");
+  }
+  // Bounds first so the expected size cannot overflow.
+  if (header.test_count > UINT32_MAX ||
+      header.size > (std::uint64_t{1} << 40)) {
+    throw fail("implausible header");
+  }
+  const std::uint64_t words = Bitset::word_count(header.size);
+  const std::uint64_t expected =
+      sizeof(header) + header.test_count * (2 * words * sizeof(std::uint64_t) +
+                                            header.size);
+  std::error_code ec;
+  if (std::filesystem::file_size(path, ec) != expected) {
+    throw fail("size does not match header");
+  }
+
+  SignatureStore store(header.test_count);
+  store.size_ = header.size;
+  for (std::size_t t = 0; t < store.test_count_; ++t) {
+    for (auto* column : {&store.ran_[t], &store.failed_[t]}) {
+      column->resize(words);
+      in.read(reinterpret_cast<char*>(column->data()),
+              static_cast<std::streamsize>(words * sizeof(std::uint64_t)));
+    }
+  }
+  store.buckets_.resize(header.size * header.test_count);
+  in.read(reinterpret_cast<char*>(store.buckets_.data()),
+          static_cast<std::streamsize>(store.buckets_.size()));
+  if (!in) throw fail("truncated");
+  return store;
+}
+
+}  // namespace codecoach::analysis
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#include "analysis/test_coverage.h"
+#include "common/bitset.h"
+#include "judge/local_runner.h"
+#include "judge/verdict.h"
+
+namespace codecoach::analysis {
+
+class SignatureError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Resource use as a fraction of its limit in 16 steps: bucket b means
+// b/15 <= value/limit < (b+1)/15, and 15 means at or over the limit.
+std::uint8_t usage_bucket(std::uint32_t value, std::uint32_t limit);
+
+// Judged results of many submissions to one problem, packed for bulk
+// analytics. Per (submission, test) it keeps two bits (ran, failed) and a
+// time and a memory bucket (a nibble each): about 1.25 bytes against a
+// dozen for a TestResult.
+//
+// The ran/failed bits are stored test-major, one bit column per test over
+// all submissions, so questions like "which tests fail together" are SIMD
+// popcounts over a few columns instead of a walk over every verdict. Buckets
+// are stored submission-major since they are read per submission.
+class SignatureStore {
+ public:
+  explicit SignatureStore(std::size_t test_count);
+
+  std::size_t test_count() const { return test_count_; }
+  std::size_t size() const { return size_; }
+
+  // Appends a verdict and returns its index. A compile error (no tests)
+  // records every test as not run. Throws SignatureError if the verdict has
+  // a different number of tests.
+  std::size_t append(const judge::Verdict& verdict,
+                     const judge::RunLimits& limits);
+
+  bool ran(std::size_t submission, std::size_t test) const;
+  bool failed(std::size_t submission, std::size_t test) const;
+  std::uint8_t time_bucket(std::size_t submission, std::size_t test) const;
+  std::uint8_t memory_bucket(std::size_t submission, std::size_t test) const;
+
+  // Bit t set when test t failed (input to cluster_failures).
+  Bitset failure_signature(std::size_t submission) const;
+
+  // How often tests a and b fail together, counted over the submissions
+  // that ran both (judging stops at the first failure otherwise).
+  struct PairStats {
+    std::uint64_t both_ran = 0;
+    std::uint64_t a_failed = 0;
+    std::uint64_t b_failed = 0;
+    std::uint64_t both_failed = 0;
+
+    // Phi coefficient of the two failure indicators: 1 when the tests
+    // always fail together, 0 when independent, 0 if either is constant.
+    double correlation() const;
+  };
+  PairStats pair_stats(std::size_t a, std::size_t b) const;
+
+  // Stats for every pair, as a symmetric test_count x test_count matrix in
+  // row-major order; rows are computed in parallel.
+  std::vector<PairStats> all_pair_stats(std::size_t parallelism) const;
+
+  // Tests x submissions failure bits, the input to greedy_cover.
+  DetectionMatrix detection_matrix() const;
+
+  // Binary file, replaced atomically on save. load() throws SignatureError
+  // on a malformed file.
+  void save(const std::filesystem::path& path) const;
+  static SignatureStore load(const std::filesystem::path& path);
+
+ private:
+  std::size_t test_count_;
+  std::size_t size_ = 0;
+  // ran_[t] / failed_[t]: bit s is submission s.
+  std::vector<std::vector<std::uint64_t>> ran_;
+  std::vector<std::vector<std::uint64_t>> failed_;
+  // Per submission, test_count bytes: time bucket low nibble, memory
+  // bucket high nibble.
+  std::vector<std::uint8_t> buckets_;
+};
+
+}  // namespace codecoach::analysis
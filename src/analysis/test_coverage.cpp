@@ -0,0 +1,87 @@
+#include "analysis/test_coverage.h"
+
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+#include "common/parallel.h"
+
+namespace codecoach::analysis {
+
+DetectionMatrix build_detection_matrix(
+    std::size_t submissions, std::size_t tests,
+    const std::function<bool(std::size_t, std::size_t)>& fails,
+    std::size_t parallelism) {
+  // One byte per pair while running, so threads never share a word.
+  std::vector<char> failed(submissions * tests, 0);
+  parallel_for(submissions * tests, parallelism, [&](std::size_t pair) {
+    failed[pair] = fails(pair / tests, pair % tests);
+  });
+
+  DetectionMatrix detections(tests, Bitset(submissions));
+  for (std::size_t s = 0; s < submissions; ++s) {
+    for (std::size_t t = 0; t < tests; ++t) {
+      if (failed[s * tests + t]) detections[t].set(s);
+    }
+  }
+  return detections;
+}
+
+CoverResult greedy_cover(const DetectionMatrix& detections,
+                         std::span<const std::size_t> always_keep) {
+  const std::size_t tests = detections.size();
+  const std::size_t submissions = tests == 0 ? 0 : detections[0].size();
+
+  CoverResult result;
+  Bitset covered(submissions);
+  std::vector<char> kept(tests, 0);
+  for (const std::size_t t : always_keep) {
+    if (t >= tests || kept[t]) continue;
+    kept[t] = 1;
+    covered |= detections[t];
+    result.kept.push_back(t);
+  }
+
+  // Lazy greedy: a test's marginal gain only shrinks as coverage grows, so a
+  // stale heap entry is an upper bound. Re-score the top entry and keep it
+  // only if it still beats everything below it.
+  using Candidate = std::pair<std::size_t, std::size_t>;  // (gain, test)
+  const auto worse = [](const Candidate& a, const Candidate& b) {
+    return a.first != b.first ? a.first < b.first : a.second > b.second;
+  };
+  std::priority_queue<Candidate, std::vector<Candidate>, decltype(worse)> heap(
+      worse);
+  for (std::size_t t = 0; t < tests; ++t) {
+    if (kept[t]) continue;
+    const std::size_t gain = detections[t].count_and_not(covered);
+    if (gain > 0) heap.emplace(gain, t);
+  }
+
+  while (!heap.empty()) {
+    auto [stale_gain, t] = heap.top();
+    heap.pop();
+    const std::size_t gain = detections[t].count_and_not(covered);
+    if (gain == 0) continue;
+    if (gain < stale_gain && !heap.empty() && worse({gain, t}, heap.top())) {
+      heap.emplace(gain, t);
+      continue;
+    }
+    kept[t] = 1;
+    covered |= detections[t];
+    result.kept.push_back(t);
+  }
+
+  for (std::size_t t = 0; t < tests; ++t) {
+    if (!kept[t]) result.redundant.push_back(t);
+  }
+
+  Bitset detected(submissions);
+  for (const auto& tests_catch : detections) detected |= tests_catch;
+  result.undetected = Bitset(submissions);
+  for (std::size_t s = 0; s < submissions; ++s) {
+    if (!detected.test(s)) result.undetected.set(s);
+  }
+  return result;
+}
+
+}  // namespace codecoach::analysis
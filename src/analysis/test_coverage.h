@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "common/bitset.h"
+
+namespace codecoach::analysis {
+
+// detections[t] has bit s set when test t catches wrong submission s.
+using DetectionMatrix = std::vector<Bitset>;
+
+// Fills the detection matrix by evaluating `fails(submission, test)` for
+// every pair, `parallelism` pairs at a time. `fails` must be thread-safe.
+DetectionMatrix build_detection_matrix(
+    std::size_t submissions, std::size_t tests,
+    const std::function<bool(std::size_t submission, std::size_t test)>& fails,
+    std::size_t parallelism);
+
+struct CoverResult {
+  std::vector<std::size_t> kept;       // In selection order.
+  std::vector<std::size_t> redundant;  // Ascending.
+  // Wrong submissions no test catches; the suite is too weak for these.
+  Bitset undetected;
+};
+
+// Picks a small subset of tests that still catches every wrong submission
+// any test catches, by greedy set cover: repeatedly keep the test that
+// catches the most not-yet-caught submissions. Greedy is within a ln(n)
+// factor of the optimum, and in practice lands close to it.
+//
+// `always_keep` (e.g. sample tests) are kept unconditionally and seed the
+// covered set. Ties go to the lower test index, so earlier (usually
+// smaller) tests are preferred.
+CoverResult greedy_cover(const DetectionMatrix& detections,
+                         std::span<const std::size_t> always_keep);
+
+}  // namespace codecoach::analysis
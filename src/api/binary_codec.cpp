@@ -0,0 +1,240 @@
+#include "api/binary_codec.h"
+
+#include <cstring>
+
+namespace codecoach::api::binary_codec {
+
+namespace {
+
+struct SubmitFixed {
+  std::uint64_t job_id;
+  std::uint32_t tenant;
+  std::uint8_t priority;
+  std::uint8_t reserved[3];
+  std::uint32_t problem_size;
+  std::uint32_t language_size;
+  std::uint32_t source_size;
+  std::uint32_t reserved2;
+};
+static_assert(sizeof(SubmitFixed) == 32);
+
+struct VerdictFixed {
+  std::uint64_t job_id;
+  std::uint32_t test_count;
+  std::uint32_t log_size;
+  std::uint8_t overall;
+  std::uint8_t has_cluster;
+  std::uint8_t reserved[2];
+  std::uint32_t cluster;
+};
+static_assert(sizeof(VerdictFixed) == 24);
+
+template <typename T>
+void append_pod(std::string& out, const T& value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Reserves room for a frame header, returning its offset for finish_frame().
+std::size_t begin_frame(std::string& out) {
+  const std::size_t at = out.size();
+  out.resize(at + sizeof(FrameHeader));
+  return at;
+}
+
+// Pads the frame to a multiple of 8 bytes so the next frame batched into the
+// same buffer keeps its arrays aligned, then fills in the header.
+void finish_frame(std::string& out, std::size_t at, MessageType type) {
+  out.resize(at + (out.size() - at + 7) / 8 * 8);
+  const FrameHeader header{
+      .magic = kFrameMagic,
+      .version = kWireVersion,
+      .type = type,
+      .payload_size =
+          static_cast<std::uint32_t>(out.size() - at - sizeof(FrameHeader)),
+      .reserved = 0,
+  };
+  std::memcpy(out.data() + at, &header, sizeof(header));
+}
+
+// Bounds-checked cursor over a frame payload.
+class Reader {
+ public:
+  explicit Reader(std::string_view payload) : payload_(payload) {}
+
+  template <typename T>
+  T pod() {
+    T value;
+    std::memcpy(&value, take(sizeof(T)).data(), sizeof(T));
+    return value;
+  }
+
+  std::string_view bytes(std::size_t n) { return take(n); }
+
+  template <typename T>
+  std::span<const T> array(std::size_t n) {
+    const auto raw = take(n * sizeof(T));
+    if (reinterpret_cast<std::uintptr_t>(raw.data()) % alignof(T) != 0) {
+      throw DecodeError("frame buffer is not suitably aligned");
+    }
+    return {reinterpret_cast<const T*>(raw.data()), n};
+  }
+
+ private:
+  std::string_view take(std::size_t n) {
+    if (n > payload_.size()) throw DecodeError("frame payload truncated");
+    auto out = payload_.substr(0, n);
+    payload_.remove_prefix(n);
+    return out;
+  }
+
+  std::string_view payload_;
+};
+
+std::string_view payload_of(std::string_view frame, MessageType expected) {
+  const auto size = frame_size(frame);
+  if (!size || *size != frame.size()) throw DecodeError("incomplete frame");
+  if (frame_type(frame) != expected) throw DecodeError("unexpected message");
+  return frame.substr(sizeof(FrameHeader));
+}
+
+}  // namespace
+
+std::optional<std::size_t> frame_size(std::string_view buffer) {
+  if (buffer.size() < sizeof(FrameHeader)) return std::nullopt;
+  FrameHeader header;
+  std::memcpy(&header, buffer.data(), sizeof(header));
+  if (header.magic != kFrameMagic) throw DecodeError("bad frame magic");
+  if (header.version != kWireVersion) {
+    throw DecodeError("unsupported wire version");
+  }
+  const std::size_t total = sizeof(FrameHeader) + header.payload_size;
+  if (buffer.size() < total) return std::nullopt;
+  return total;
+}
+
+MessageType frame_type(std::string_view frame) {
+  FrameHeader header;
+  if (frame.size() < sizeof(header)) throw DecodeError("incomplete frame");
+  std::memcpy(&header, frame.data(), sizeof(header));
+  return header.type;
+}
+
+void encode(const SubmitRequest& request, std::string& out) {
+  out.reserve(out.size() + sizeof(FrameHeader) + sizeof(SubmitFixed) +
+              request.problem.size() + request.language.size() +
+              request.source.size());
+  const std::size_t at = begin_frame(out);
+  append_pod(out, SubmitFixed{
+                      .job_id = request.job_id,
+                      .tenant = request.tenant,
+                      .priority = static_cast<std::uint8_t>(request.priority),
+                      .reserved = {},
+                      .problem_size =
+                          static_cast<std::uint32_t>(request.problem.size()),
+                      .language_size =
+                          static_cast<std::uint32_t>(request.language.size()),
+                      .source_size =
+                          static_cast<std::uint32_t>(request.source.size()),
+                      .reserved2 = 0,
+                  });
+  out += request.problem;
+  out += request.language;
+  out += request.source;
+  finish_frame(out, at, MessageType::kSubmitRequest);
+}
+
+void encode(const VerdictResponse& response, std::string& out) {
+  const auto& verdict = response.verdict;
+  const std::size_t n = verdict.tests.size();
+  out.reserve(out.size() + sizeof(FrameHeader) + sizeof(VerdictFixed) +
+              n * 9 + verdict.compile_log.size());
+  const std::size_t at = begin_frame(out);
+  append_pod(out, VerdictFixed{
+                      .job_id = response.job_id,
+                      .test_count = static_cast<std::uint32_t>(n),
+                      .log_size = static_cast<std::uint32_t>(
+                          verdict.compile_log.size()),
+                      .overall = static_cast<std::uint8_t>(verdict.overall),
+                      .has_cluster = response.failure_cluster.has_value(),
+                      .reserved = {},
+                      .cluster = response.failure_cluster.value_or(0),
+                  });
+  // Write the three columns in one pass over the results.
+  const std::size_t columns = out.size();
+  out.resize(columns + n * (2 * sizeof(std::uint32_t) + 1));
+  char* time_col = out.data() + columns;
+  char* memory_col = time_col + n * sizeof(std::uint32_t);
+  char* outcome_col = memory_col + n * sizeof(std::uint32_t);
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto& test = verdict.tests[i];
+    std::memcpy(time_col + i * sizeof(std::uint32_t), &test.time_ms,
+                sizeof(std::uint32_t));
+    std::memcpy(memory_col + i * sizeof(std::uint32_t), &test.memory_kb,
+                sizeof(std::uint32_t));
+    outcome_col[i] = static_cast<char>(test.outcome);
+  }
+  out += verdict.compile_log;
+  finish_frame(out, at, MessageType::kVerdictResponse);
+}
+
+SubmitRequestView decode_submit(std::string_view frame) {
+  Reader reader(payload_of(frame, MessageType::kSubmitRequest));
+  const auto fixed = reader.pod<SubmitFixed>();
+  if (fixed.priority > static_cast<std::uint8_t>(Priority::kBatch)) {
+    throw DecodeError("unknown priority");
+  }
+  SubmitRequestView view;
+  view.job_id = fixed.job_id;
+  view.tenant = fixed.tenant;
+  view.priority = static_cast<Priority>(fixed.priority);
+  view.problem = reader.bytes(fixed.problem_size);
+  view.language = reader.bytes(fixed.language_size);
+  view.source = reader.bytes(fixed.source_size);
+  return view;
+}
+
+VerdictView decode_verdict(std::string_view frame) {
+  Reader reader(payload_of(frame, MessageType::kVerdictResponse));
+  const auto fixed = reader.pod<VerdictFixed>();
+  if (fixed.overall >= judge::kOutcomeCount) {
+    throw DecodeError("unknown outcome");
+  }
+  VerdictView view;
+  view.job_id = fixed.job_id;
+  view.overall = static_cast<judge::Outcome>(fixed.overall);
+  if (fixed.has_cluster) view.failure_cluster = fixed.cluster;
+  view.time_ms = reader.array<std::uint32_t>(fixed.test_count);
+  view.memory_kb = reader.array<std::uint32_t>(fixed.test_count);
+  view.outcomes = reader.array<std::uint8_t>(fixed.test_count);
+  for (const std::uint8_t outcome : view.outcomes) {
+    if (outcome >= judge::kOutcomeCount) throw DecodeError("unknown outcome");
+  }
+  view.compile_log = reader.bytes(fixed.log_size);
+  return view;
+}
+
+SubmitRequest SubmitRequestView::to_owned() const {
+  return SubmitRequest{
+      .job_id = job_id,
+      .tenant = tenant,
+      .priority = priority,
+      .problem = std::string(problem),
+      .language = std::string(language),
+      .source = std::string(source),
+  };
+}
+
+VerdictResponse VerdictView::to_owned() const {
+  VerdictResponse response;
+  response.job_id = job_id;
+  response.verdict.overall = overall;
+  response.failure_cluster = failure_cluster;
+  response.verdict.tests.reserve(test_count());
+  for (std::size_t i = 0; i < test_count(); ++i) {
+    response.verdict.tests.push_back(test(i));
+  }
+  response.verdict.compile_log = std::string(compile_log);
+  return response;
+}
+
+}  // namespace codecoach::api::binary_codec
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "api/messages.h"
+
+// Binary framing for high-volume internal callers (the web tier).
+//
+// Messages are laid out so that the receiver can read them in place: the
+// decoded views point into the receive buffer, so the source payload and the
+// per-test verdict arrays are never copied or parsed element by element.
+//
+//   FrameHeader (16 bytes)
+//   payload: fixed-size record, then variable-size arrays and byte strings
+//
+// Verdict arrays are stored column-wise (all times, all memory figures, all
+// outcomes) so each can be exposed as a span. Integers are little-endian.
+// Receive buffers must be 8-byte aligned, as any heap allocation is.
+namespace codecoach::api::binary_codec {
+
+static_assert(std::endian::native == std::endian::little,
+              "binary codec assumes a little-endian host");
+
+enum class MessageType : std::uint16_t {
+  kSubmitRequest = 1,
+  kVerdictResponse = 2,
+};
+
+inline constexpr std::uint32_t kFrameMagic = 0x31424343;  // "CCB1"
+inline constexpr std::uint16_t kWireVersion = 1;
+
+struct FrameHeader {
+  std::uint32_t magic;
+  std::uint16_t version;
+  MessageType type;
+  std::uint32_t payload_size;
+  std::uint32_t reserved;
+};
+static_assert(sizeof(FrameHeader) == 16);
+
+// Total frame size if `buffer` starts with a complete, valid header; nullopt
+// if more bytes are needed. Throws DecodeError on a corrupt header. Stream
+// readers use this to split a byte stream into frames.
+std::optional<std::size_t> frame_size(std::string_view buffer);
+
+// Message type of a complete frame.
+MessageType frame_type(std::string_view frame);
+
+struct SubmitRequestView {
+  JobId job_id = 0;
+  TenantId tenant = 0;
+  Priority priority = Priority::kBatch;
+  std::string_view problem;
+  std::string_view language;
+  std::string_view source;
+
+  SubmitRequest to_owned() const;
+};
+
+struct VerdictView {
+  JobId job_id = 0;
+  judge::Outcome overall = judge::Outcome::kInternalError;
+  std::optional<std::uint32_t> failure_cluster;
+  std::span<const std::uint32_t> time_ms;
+  std::span<const std::uint32_t> memory_kb;
+  std::span<const std::uint8_t> outcomes;
+  std::string_view compile_log;
+
+  std::size_t test_count() const { return outcomes.size(); }
+  judge::Outcome outcome(std::size_t i) const {
+    return static_cast<judge::Outcome>(outcomes[i]);
+  }
+  judge::TestResult test(std::size_t i) const {
+    return {outcome(i), time_ms[i], memory_kb[i]};
+  }
+
+  VerdictResponse to_owned() const;
+};
+
+// Appends one frame to `out`, so a connection can batch several messages
+// into one write buffer.
+void encode(const SubmitRequest& request, std::string& out);
+void encode(const VerdictResponse& response, std::string& out);
+
+// Views into `frame`, valid while `frame` is. Throw DecodeError on malformed
+// input or a type mismatch.
+SubmitRequestView decode_submit(std::string_view frame);
+VerdictView decode_verdict(std::string_view frame);
+
+}  // namespace codecoach::api::binary_codec
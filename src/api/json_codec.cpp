@@ -0,0 +1,154 @@
+#include "api/json_codec.h"
+
+#include <cstdint>
+#include <limits>
+#include <variant>
+
+#include "common/json.h"
+
+namespace codecoach::api::json_codec {
+
+namespace {
+
+const json::Value& member(const json::Value& object, std::string_view key) {
+  const json::Value* value = object.find(key);
+  if (value == nullptr) {
+    throw DecodeError("missing field \"" + std::string(key) + "\"");
+  }
+  return *value;
+}
+
+// An unsigned field of type T: negative or oversized numbers are rejected
+// rather than wrapped.
+template <typename T>
+T unsigned_of(const json::Value& value, std::string_view key) {
+  const std::int64_t n = value.as_int();
+  if (n < 0 ||
+      static_cast<std::uint64_t>(n) > std::numeric_limits<T>::max()) {
+    throw DecodeError("field \"" + std::string(key) + "\" out of range");
+  }
+  return static_cast<T>(n);
+}
+
+template <typename T>
+T unsigned_member(const json::Value& object, std::string_view key) {
+  return unsigned_of<T>(member(object, key), key);
+}
+
+judge::Outcome outcome_of(const json::Value& value) {
+  const auto outcome = judge::outcome_from_string(value.as_string());
+  if (!outcome) throw DecodeError("unknown outcome " + value.as_string());
+  return *outcome;
+}
+
+// Runs a decoder, mapping JSON-level failures onto DecodeError.
+template <typename Fn>
+auto decoding(std::string_view text, Fn&& fn) {
+  try {
+    return fn(json::parse(text));
+  } catch (const json::ParseError& e) {
+    throw DecodeError(e.what());
+  } catch (const std::bad_variant_access&) {
+    throw DecodeError("field has the wrong type");
+  }
+}
+
+}  // namespace
+
+std::string encode(const SubmitRequest& request) {
+  std::string out;
+  out.reserve(request.source.size() + 128);
+  out += "{\"job_id\":";
+  out += std::to_string(request.job_id);
+  out += ",\"tenant\":";
+  out += std::to_string(request.tenant);
+  out += ",\"priority\":";
+  out += request.priority == Priority::kInteractive ? "\"interactive\""
+                                                    : "\"batch\"";
+  out += ",\"problem\":";
+  json::append_quoted(out, request.problem);
+  out += ",\"language\":";
+  json::append_quoted(out, request.language);
+  out += ",\"source\":";
+  json::append_quoted(out, request.source);
+  out += '}';
+  return out;
+}
+
+std::string encode(const VerdictResponse& response) {
+  const auto& verdict = response.verdict;
+  std::string out;
+  out.reserve(verdict.tests.size() * 48 + verdict.compile_log.size() + 64);
+  out += "{\"job_id\":";
+  out += std::to_string(response.job_id);
+  out += ",\"overall\":\"";
+  out += judge::to_string(verdict.overall);
+  out += "\",\"tests\":[";
+  for (std::size_t i = 0; i < verdict.tests.size(); ++i) {
+    const auto& test = verdict.tests[i];
+    if (i != 0) out += ',';
+    out += "{\"outcome\":\"";
+    out += judge::to_string(test.outcome);
+    out += "\",\"time_ms\":";
+    out += std::to_string(test.time_ms);
+    out += ",\"memory_kb\":";
+    out += std::to_string(test.memory_kb);
+    out += '}';
+  }
+  out += "],\"compile_log\":";
+  json::append_quoted(out, verdict.compile_log);
+  if (response.failure_cluster) {
+    out += ",\"failure_cluster\":";
+    out += std::to_string(*response.failure_cluster);
+  }
+  out += '}';
+  return out;
+}
+
+SubmitRequest decode_submit(std::string_view text) {
+  return decoding(text, [](const json::Value& doc) {
+    SubmitRequest request;
+    request.job_id = unsigned_member<JobId>(doc, "job_id");
+    request.tenant = unsigned_member<TenantId>(doc, "tenant");
+    const auto& priority = member(doc, "priority").as_string();
+    if (priority == "interactive") {
+      request.priority = Priority::kInteractive;
+    } else if (priority == "batch") {
+      request.priority = Priority::kBatch;
+    } else {
+      throw DecodeError("unknown priority " + priority);
+    }
+    request.problem = member(doc, "problem").as_string();
+    request.language = member(doc, "language").as_string();
+    request.source = member(doc, "source").as_string();
+    return request;
+  });
+}
+
+VerdictResponse decode_verdict(std::string_view text) {
+  return decoding(text, [](const json::Value& doc) {
+    VerdictResponse response;
+    response.job_id = unsigned_member<JobId>(doc, "job_id");
+    auto& verdict = response.verdict;
+    verdict.overall = outcome_of(member(doc, "overall"));
+    const auto& tests = member(doc, "tests").as_array();
+    verdict.tests.reserve(tests.size());
+    for (const auto& test : tests) {
+      verdict.tests.push_back(judge::TestResult{
+          .outcome = outcome_of(member(test, "outcome")),
+          .time_ms = unsigned_member<std::uint32_t>(test, "time_ms"),
+          .memory_kb = unsigned_member<std::uint32_t>(test, "memory_kb"),
+      });
+    }
+    if (const auto* log = doc.find("compile_log")) {
+      verdict.compile_log = log->as_string();
+    }
+    if (const auto* cluster = doc.find("failure_cluster")) {
+      response.failure_cluster =
+          unsigned_of<std::uint32_t>(*cluster, "failure_cluster");
+    }
+    return response;
+  });
+}
+
+}  // namespace codecoach::api::json_codec
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "api/messages.h"
+
+// JSON encoding of the API messages, used by external clients.
+namespace codecoach::api::json_codec {
+
+std::string encode(const SubmitRequest& request);
+std::string encode(const VerdictResponse& response);
+
+// Throw DecodeError on malformed or incomplete input.
+SubmitRequest decode_submit(std::string_view text);
+VerdictResponse decode_verdict(std::string_view text);
+
+}  // namespace codecoach::api::json_codec
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include "common/types.h"
+#include "judge/verdict.h"
+
+namespace codecoach::api {
+
+// Thrown by the codecs on malformed or incomplete input.
+class DecodeError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+struct SubmitRequest {
+  JobId job_id = 0;
+  TenantId tenant = 0;
+  Priority priority = Priority::kBatch;
+  std::string problem;
+  std::string language;
+  std::string source;
+
+  bool operator==(const SubmitRequest&) const = default;
+};
+
+struct VerdictResponse {
+  JobId job_id = 0;
+  judge::Verdict verdict;
+  // Failure cluster of a wrong submit verdict, when the problem has
+  // clusters and this failure was seen (judge::find_failure_cluster).
+  std::optional<std::uint32_t> failure_cluster;
+
+  bool operator==(const VerdictResponse&) const = default;
+};
+
+}  // namespace codecoach::api
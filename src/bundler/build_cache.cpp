@@ -0,0 +1,62 @@
+#include "bundler/build_cache.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace codecoach::bundler {
+
+namespace {
+
+// One "<key-hex>\t<value-hex>" pair per line after the header line.
+constexpr std::string_view kHeader = "codecoach-build-cache\t1";
+
+}  // namespace
+
+BuildCache::BuildCache(std::filesystem::path path) : path_(std::move(path)) {
+  bool fresh = true;
+  bool torn = false;
+  if (std::ifstream in(path_, std::ios::binary); in) {
+    std::string line;
+    if (std::getline(in, line) && line == kHeader) {
+      fresh = false;
+      while (std::getline(in, line)) {
+        const auto tab = line.find('\t');
+        if (tab == std::string::npos) continue;  // Torn final line.
+        const auto key = Digest128::from_hex(line.substr(0, tab));
+        const auto value = Digest128::from_hex(line.substr(tab + 1));
+        if (key && value) entries_[*key] = *value;
+      }
+      in.clear();
+      in.seekg(-1, std::ios::end);
+      torn = in.get() != '\n';
+    }
+  }
+  if (path_.has_parent_path()) {
+    std::filesystem::create_directories(path_.parent_path());
+  }
+  log_.open(path_, fresh ? std::ios::trunc : std::ios::app);
+  if (!log_) throw std::runtime_error("cannot open " + path_.string());
+  if (fresh) log_ << kHeader << '\n' << std::flush;
+  // Terminate a line left unfinished by a crash so the next entry parses.
+  if (torn) log_ << '\n' << std::flush;
+}
+
+std::optional<Digest128> BuildCache::find(const Digest128& key) const {
+  std::lock_guard lock(mu_);
+  const auto it = entries_.find(key);
+  if (it == entries_.end()) return std::nullopt;
+  return it->second;
+}
+
+void BuildCache::record(const Digest128& key, const Digest128& value) {
+  std::lock_guard lock(mu_);
+  entries_[key] = value;
+  log_ << key.hex() << '\t' << value.hex() << '\n' << std::flush;
+}
+
+std::size_t BuildCache::size() const {
+  std::lock_guard lock(mu_);
+  return entries_.size();
+}
+
+}  // namespace codecoach::bundler
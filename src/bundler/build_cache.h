@@ -0,0 +1,33 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "common/hash.h"
+
+namespace codecoach::bundler {
+
+// Persistent memo of build steps: step key (a digest of everything the step
+// depends on) -> digest of its result in the BlobStore. Entries are appended
+// to a log as soon as a step finishes, so an interrupted build resumes where
+// it stopped. A key recorded twice takes its last value. Thread-safe.
+class BuildCache {
+ public:
+  explicit BuildCache(std::filesystem::path path);
+
+  std::optional<Digest128> find(const Digest128& key) const;
+  void record(const Digest128& key, const Digest128& value);
+
+  std::size_t size() const;
+
+ private:
+  std::filesystem::path path_;
+  mutable std::mutex mu_;
+  std::unordered_map<Digest128, Digest128, Digest128Hash> entries_;
+  std::ofstream log_;
+};
+
+}  // namespace codecoach::bundler
@@ -0,0 +1,539 @@
+#include "bundler/problem_builder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "catalog/bundle_writer.h"
+#include "catalog/problem_bundle.h"
+#include "coach/hint_ladder.h"
+#include "common/mapped_file.h"
+#include "common/parallel.h"
+#include "common/subprocess.h"
+#include "harness/driver.h"
+#include "validation/schema.h"
+
+namespace codecoach::bundler {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::string read_file(const std::filesystem::path& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) throw BuildError("cannot read " + path.string());
+  return std::string(std::istreambuf_iterator<char>(in), {});
+}
+
+std::optional<std::string> read_optional(const std::filesystem::path& path) {
+  if (!std::filesystem::exists(path)) return std::nullopt;
+  return read_file(path);
+}
+
+std::vector<std::string> split_words(std::string_view line) {
+  std::vector<std::string> words;
+  std::size_t i = 0;
+  while (i < line.size()) {
+    while (i < line.size() &&
+           std::isspace(static_cast<unsigned char>(line[i]))) {
+      ++i;
+    }
+    const std::size_t start = i;
+    while (i < line.size() &&
+           !std::isspace(static_cast<unsigned char>(line[i]))) {
+      ++i;
+    }
+    if (i > start) words.emplace_back(line.substr(start, i - start));
+  }
+  return words;
+}
+
+// Calls fn(line_no, words) for every non-blank line, '#' starting a comment.
+template <typename Fn>
+void for_each_line(std::string_view text, Fn&& fn) {
+  std::size_t line_no = 0;
+  while (!text.empty()) {
+    ++line_no;
+    const auto newline = text.find('\n');
+    auto line = text.substr(0, newline);
+    text.remove_prefix(newline == std::string_view::npos ? text.size()
+                                                         : newline + 1);
+    auto words = split_words(line.substr(0, line.find('#')));
+    if (!words.empty()) fn(line_no, std::move(words));
+  }
+}
+
+struct ProblemConf {
+  std::string id;
+  std::uint32_t time_limit_ms = 1000;
+  std::uint32_t memory_limit_kb = 256 * 1024;
+  std::optional<harness::Signature> signature;
+};
+
+ProblemConf parse_conf(std::string_view text) {
+  ProblemConf conf;
+  for_each_line(text, [&](std::size_t line_no,
+                          std::vector<std::string> words) {
+    const auto fail = [&](const std::string& what) {
+      return BuildError("problem.conf line " + std::to_string(line_no) +
+                        ": " + what);
+    };
+    // The one value with spaces in it.
+    if (words[0] == "signature" && words.size() >= 3 && words[1] == "=") {
+      std::string text;
+      for (std::size_t i = 2; i < words.size(); ++i) {
+        text += (i > 2 ? " " : "") + words[i];
+      }
+      try {
+        conf.signature = harness::parse_signature(text);
+      } catch (const harness::SignatureError& e) {
+        throw fail(std::string("signature: ") + e.what());
+      }
+      return;
+    }
+    if (words.size() != 3 || words[1] != "=") {
+      throw fail("expected 'key = value'");
+    }
+    const auto number = [&](std::uint32_t& out) {
+      const auto& value = words[2];
+      const auto result =
+          std::from_chars(value.data(), value.data() + value.size(), out);
+      if (result.ec != std::errc() ||
+          result.ptr != value.data() + value.size() || out == 0) {
+        throw fail("bad value '" + value + "'");
+      }
+    };
+    if (words[0] == "id") {
+      conf.id = words[2];
+    } else if (words[0] == "time_limit_ms") {
+      number(conf.time_limit_ms);
+    } else if (words[0] == "memory_limit_kb") {
+      number(conf.memory_limit_kb);
+    } else {
+      throw fail("unknown key '" + words[0] + "'");
+    }
+  });
+  // The id names the bundle file.
+  if (conf.id.empty() || conf.id.find('/') != std::string::npos ||
+      conf.id.front() == '.') {
+    throw BuildError("problem.conf: missing or invalid id");
+  }
+  return conf;
+}
+
+struct PlannedTest {
+  std::size_t line = 0;
+  std::string file;  // Input file, or generator source when `generated`.
+  bool generated = false;
+  std::vector<std::string> args;
+  std::uint32_t flags = 0;
+};
+
+std::vector<PlannedTest> parse_plan(std::string_view text) {
+  std::vector<PlannedTest> plan;
+  for_each_line(text, [&](std::size_t line_no,
+                          std::vector<std::string> words) {
+    PlannedTest test;
+    test.line = line_no;
+    if (words[0] == "gen" && words.size() >= 2) {
+      test.generated = true;
+      test.args.assign(words.begin() + 2, words.end());
+    } else if ((words[0] == "file" || words[0] == "sample") &&
+               words.size() == 2) {
+      if (words[0] == "sample") test.flags = catalog::format::kTestSample;
+    } else {
+      throw BuildError("tests.txt line " + std::to_string(line_no) +
+                       ": expected 'sample <file>', 'file <file>' or "
+                       "'gen <source> [args...]'");
+    }
+    test.file = words[1];
+    plan.push_back(std::move(test));
+  });
+  if (plan.empty()) throw BuildError("tests.txt: no tests");
+  return plan;
+}
+
+// Digest of the headers `source` includes as `#include "name"` from `dir`,
+// transitively, by name and contents. Names are relative to `dir`; those
+// that are not files there are left to the compiler.
+Digest128 local_includes_digest(const std::filesystem::path& dir,
+                                std::string_view source) {
+  DigestBuilder digest;
+  std::unordered_set<std::string> seen;
+  std::vector<std::string> pending;
+  const auto scan = [&](std::string_view text) {
+    while (!text.empty()) {
+      const auto newline = text.find('\n');
+      std::string_view line = text.substr(0, newline);
+      text.remove_prefix(newline == std::string_view::npos ? text.size()
+                                                           : newline + 1);
+      const auto skip_blanks = [&] {
+        while (!line.empty() && (line.front() == ' ' || line.front() == '\t')) {
+          line.remove_prefix(1);
+        }
+      };
+      skip_blanks();
+      if (!line.starts_with('#')) continue;
+      line.remove_prefix(1);
+      skip_blanks();
+      if (!line.starts_with("include")) continue;
+      line.remove_prefix(7);
+      skip_blanks();
+      if (!line.starts_with('"')) continue;
+      const auto close = line.find('"', 1);
+      if (close == std::string_view::npos) continue;
+      std::string name(line.substr(1, close - 1));
+      if (seen.insert(name).second) pending.push_back(std::move(name));
+    }
+  };
+  scan(source);
+  while (!pending.empty()) {
+    const std::string name = std::move(pending.back());
+    pending.pop_back();
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(dir / name, ec)) continue;
+    const std::string text = read_file(dir / name);
+    digest.add(name).add(text);
+    scan(text);
+  }
+  return digest.finish();
+}
+
+std::string describe_failure(const ProcessResult& run) {
+  if (run.timed_out) return "timed out";
+  if (run.output_limit_exceeded) return "output limit exceeded";
+  std::string what = run.signal != 0
+                         ? "killed by signal " + std::to_string(run.signal)
+                         : "exit code " + std::to_string(run.exit_code);
+  if (!run.stderr_data.empty()) {
+    what += ": " + run.stderr_data.substr(0, 512);
+  }
+  return what;
+}
+
+}  // namespace
+
+ProblemBuilder::ProblemBuilder(compile::Compiler& compiler,
+                               storage::BlobStore& blobs, BuildCache& cache,
+                               BuildOptions options)
+    : compiler_(compiler), blobs_(blobs), cache_(cache), options_(options) {}
+
+BuildStats ProblemBuilder::build(const std::filesystem::path& problem_dir,
+                                 const std::filesystem::path& out_dir) {
+  const auto start = Clock::now();
+  const ProblemConf conf = parse_conf(read_file(problem_dir / "problem.conf"));
+  const std::vector<PlannedTest> plan =
+      parse_plan(read_file(problem_dir / "tests.txt"));
+  const std::optional<std::string> statement =
+      read_optional(problem_dir / "statement.md");
+  const std::optional<std::string> schema_text =
+      read_optional(problem_dir / "schema.txt");
+  const std::optional<std::string> hints =
+      read_optional(problem_dir / "hints.txt");
+  if (hints) {
+    try {
+      coach::HintLadders::parse(*hints);
+    } catch (const coach::HintFormatError& e) {
+      throw BuildError(std::string("hints.txt: ") + e.what());
+    }
+  }
+  std::optional<validation::Schema> schema;
+  if (schema_text) {
+    try {
+      schema = validation::Schema::parse(*schema_text);
+    } catch (const validation::SchemaError& e) {
+      throw BuildError(std::string("schema.txt: ") + e.what());
+    }
+  }
+
+  std::string prologue, driver;
+  if (conf.signature) {
+    prologue = harness::driver_prologue(read_file(options_.harness_header));
+    driver = harness::driver_main(*conf.signature);
+  }
+
+  // Reference and generators compile concurrently; most are cache hits.
+  std::vector<std::string> names = {"reference.cpp"};
+  std::map<std::string, std::size_t> program_of;
+  for (const auto& test : plan) {
+    if (test.generated) program_of.try_emplace(test.file, 0);
+  }
+  for (auto& [name, index] : program_of) {
+    index = names.size();
+    names.push_back(name);
+  }
+  std::vector<std::string> sources(names.size());
+  // Sources compile from stdin, so their local headers (testlib.h and the
+  // like) come from -I the problem directory and key every step built on
+  // them.
+  std::vector<compile::LocalIncludes> includes(names.size());
+  std::vector<compile::CompileResult> programs(names.size());
+  compiler_.ensure_pch();
+  parallel_for(names.size(), options_.parallelism, [&](std::size_t i) {
+    sources[i] = read_file(problem_dir / names[i]);
+    includes[i] = {problem_dir, local_includes_digest(problem_dir, sources[i])};
+    // Generators are whole programs; the reference may be a Solution.
+    if (i == 0) {
+      sources[0] = harness::program_source(prologue, sources[0], driver);
+    }
+    programs[i] = compiler_.compile(sources[i], &includes[i]);
+  });
+  for (std::size_t i = 0; i < names.size(); ++i) {
+    if (!programs[i].ok) {
+      throw BuildError(names[i] + " does not compile:\n" + programs[i].log);
+    }
+  }
+
+  BuildStats stats;
+  stats.tests = plan.size();
+  std::vector<Digest128> inputs(plan.size());
+  std::vector<Digest128> outputs(plan.size());
+  std::vector<std::string> errors(plan.size());
+  // Every stage runs all tests and then reports the first failing one, so
+  // the error does not depend on thread timing.
+  const auto run_stage = [&](auto&& step) {
+    parallel_for(plan.size(), options_.parallelism, [&](std::size_t i) {
+      try {
+        step(i);
+      } catch (const std::exception& e) {
+        errors[i] = e.what();
+      }
+    });
+    for (std::size_t i = 0; i < plan.size(); ++i) {
+      if (!errors[i].empty()) {
+        throw BuildError("test " + std::to_string(i + 1) + " (tests.txt line " +
+                         std::to_string(plan[i].line) + "): " + errors[i]);
+      }
+    }
+  };
+
+  std::atomic<std::size_t> generated{0};
+  run_stage([&](std::size_t i) {
+    const auto& test = plan[i];
+    if (!test.generated) {
+      inputs[i] = blobs_.put(read_file(problem_dir / test.file));
+      return;
+    }
+    const std::size_t program = program_of.at(test.file);
+    DigestBuilder key;
+    key.add("gen")
+        .add(compiler_.identity())
+        .add(sources[program])
+        .add(includes[program].digest.hex());
+    key.add(std::to_string(test.args.size()));
+    for (const auto& arg : test.args) key.add(arg);
+    const Digest128 step = key.finish();
+    if (const auto cached = cache_.find(step);
+        cached && blobs_.contains(*cached)) {
+      inputs[i] = *cached;
+      return;
+    }
+    std::vector<std::string> argv = {programs[program].artifact.string()};
+    argv.insert(argv.end(), test.args.begin(), test.args.end());
+    ProcessLimits limits;
+    limits.wall_time = options_.generator_timeout;
+    limits.max_output_bytes = std::size_t{1} << 30;
+    const auto run = run_process(argv, {}, limits);
+    if (!run.ok() || run.output_limit_exceeded) {
+      throw BuildError("generator " + test.file + " failed: " +
+                       describe_failure(run));
+    }
+    inputs[i] = blobs_.put(run.stdout_data);
+    cache_.record(step, inputs[i]);
+    ++generated;
+  });
+  stats.generated = generated;
+  stats.inputs_reused = static_cast<std::size_t>(
+      std::count_if(plan.begin(), plan.end(),
+                    [](const PlannedTest& t) { return t.generated; })) -
+      stats.generated;
+
+  if (schema) {
+    std::atomic<std::size_t> validated{0};
+    run_stage([&](std::size_t i) {
+      const Digest128 step = DigestBuilder()
+                                 .add("valid")
+                                 .add(*schema_text)
+                                 .add(inputs[i].hex())
+                                 .finish();
+      if (cache_.find(step)) return;
+      const auto input = MappedFile::open(blobs_.path_of(inputs[i]));
+      schema->validate(input.bytes());
+      cache_.record(step, inputs[i]);
+      ++validated;
+    });
+    stats.validated = validated;
+  }
+
+  std::vector<std::uint32_t> reference_ms(plan.size(), 0);
+  std::atomic<std::size_t> solved{0};
+  run_stage([&](std::size_t i) {
+    const Digest128 step = DigestBuilder()
+                               .add("solve")
+                               .add(compiler_.identity())
+                               .add(sources[0])
+                               .add(includes[0].digest.hex())
+                               .add(inputs[i].hex())
+                               .finish();
+    if (const auto cached = cache_.find(step);
+        cached && blobs_.contains(*cached)) {
+      outputs[i] = *cached;
+      return;
+    }
+    const auto input = MappedFile::open(blobs_.path_of(inputs[i]));
+    ProcessLimits limits;
+    // The reference is trusted; generous limits keep a loaded build host
+    // from failing it, and max_reference_ms reports how close it came.
+    limits.wall_time = std::max<std::chrono::milliseconds>(
+        std::chrono::milliseconds(10 * conf.time_limit_ms),
+        std::chrono::seconds(10));
+    limits.address_space_bytes =
+        std::uint64_t{conf.memory_limit_kb} * 1024 * 2 + (64u << 20);
+    limits.max_output_bytes = std::size_t{1} << 30;
+    const auto run =
+        run_process({programs[0].artifact.string()}, input.bytes(), limits);
+    if (!run.ok() || run.output_limit_exceeded) {
+      throw BuildError("reference failed: " + describe_failure(run));
+    }
+    outputs[i] = blobs_.put(run.stdout_data);
+    cache_.record(step, outputs[i]);
+    reference_ms[i] = static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(run.cpu_time)
+            .count());
+    ++solved;
+  });
+  stats.solved = solved;
+  stats.outputs_reused = plan.size() - stats.solved;
+  stats.max_reference_ms =
+      *std::max_element(reference_ms.begin(), reference_ms.end());
+
+  // Audit-only marks come from tools/test_pruner, not from the sources;
+  // keep them for tests whose data did not change.
+  const auto out_path = out_dir / (conf.id + ".ccb");
+  std::shared_ptr<const catalog::ProblemBundle> previous;
+  if (std::filesystem::exists(out_path)) {
+    try {
+      previous = catalog::ProblemBundle::open(out_path);
+    } catch (const std::exception&) {
+      // Unreadable: rebuilt from scratch below.
+    }
+  }
+  const auto pair_key = [](const Digest128& in, const Digest128& out) {
+    return DigestBuilder().add(in.hex()).add(out.hex()).finish();
+  };
+  std::unordered_set<Digest128, Digest128Hash> audit_only;
+  // Failure clusters (tools/failure_clusters) are keyed by signatures over
+  // the whole suite, so they only survive if no test changed.
+  bool same_tests = previous && previous->test_count() == plan.size();
+  if (previous) {
+    for (std::size_t t = 0; t < previous->test_count(); ++t) {
+      const auto test = previous->test(t);
+      const Digest128 key = pair_key(digest128(test.input),
+                                     digest128(test.expected_output));
+      if (test.flags & catalog::format::kTestAuditOnly) audit_only.insert(key);
+      if (same_tests && key != pair_key(inputs[t], outputs[t])) {
+        same_tests = false;
+      }
+    }
+  }
+  std::vector<std::uint32_t> flags(plan.size());
+  for (std::size_t i = 0; i < plan.size(); ++i) {
+    flags[i] = plan[i].flags;
+    if (audit_only.contains(pair_key(inputs[i], outputs[i]))) {
+      flags[i] |= catalog::format::kTestAuditOnly;
+    }
+  }
+  std::optional<std::string> clusters;
+  if (same_tests) {
+    if (const auto section = previous->section(
+            catalog::format::SectionKind::kFailureClusters)) {
+      clusters = std::string(*section);
+    }
+  }
+
+  DigestBuilder content;
+  content.add(conf.id)
+      .add(std::to_string(conf.time_limit_ms))
+      .add(std::to_string(conf.memory_limit_kb))
+      .add(statement.value_or(""))
+      .add(schema_text.value_or(""))
+      .add(hints.value_or(""))
+      .add(clusters.value_or(""))
+      .add(prologue)
+      .add(driver);
+  for (std::size_t i = 0; i < plan.size(); ++i) {
+    content.add(inputs[i].hex())
+        .add(outputs[i].hex())
+        .add(std::to_string(flags[i]));
+  }
+  const Digest128 content_digest = content.finish();
+  const Digest128 bundle_step =
+      DigestBuilder().add("bundle").add(out_path.string()).finish();
+  stats.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      Clock::now() - start);
+  if (previous && cache_.find(bundle_step) == content_digest) {
+    stats.version = previous->version();
+    return stats;
+  }
+
+  catalog::BundleSpec spec;
+  spec.problem_id = conf.id;
+  spec.content_version = previous ? previous->version() + 1 : 1;
+  spec.time_limit_ms = conf.time_limit_ms;
+  spec.memory_limit_kb = conf.memory_limit_kb;
+  if (statement) {
+    spec.sections.emplace_back(catalog::format::SectionKind::kStatement,
+                               *statement);
+  }
+  if (schema_text) {
+    spec.sections.emplace_back(catalog::format::SectionKind::kInputSchema,
+                               *schema_text);
+  }
+  if (hints) {
+    spec.sections.emplace_back(catalog::format::SectionKind::kHints, *hints);
+  }
+  if (clusters) {
+    spec.sections.emplace_back(catalog::format::SectionKind::kFailureClusters,
+                               *clusters);
+  }
+  if (conf.signature) {
+    spec.sections.emplace_back(catalog::format::SectionKind::kHarness,
+                               prologue);
+    spec.sections.emplace_back(catalog::format::SectionKind::kHarnessMain,
+                               driver);
+  }
+  // Test data is served straight from the blob store's files.
+  std::unordered_map<Digest128, MappedFile, Digest128Hash> blobs;
+  const auto view = [&](const Digest128& digest) {
+    auto it = blobs.find(digest);
+    if (it == blobs.end()) {
+      it = blobs.emplace(digest, MappedFile::open(blobs_.path_of(digest)))
+               .first;
+    }
+    return it->second.bytes();
+  };
+  for (std::size_t i = 0; i < plan.size(); ++i) {
+    spec.tests.push_back({view(inputs[i]), view(outputs[i]), flags[i]});
+  }
+  std::filesystem::create_directories(out_dir);
+  stats.shared_bytes = catalog::write_bundle(spec, out_path);
+  cache_.record(bundle_step, content_digest);
+  stats.version = spec.content_version;
+  stats.written = true;
+  stats.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      Clock::now() - start);
+  return stats;
+}
+
+}  // namespace codecoach::bundler
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+
+#include "bundler/build_cache.h"
+#include "compile/compiler.h"
+#include "storage/blob_store.h"
+
+// Builds a *.ccb bundle from a problem source directory:
+//
+//   problem.conf    "key = value" lines: id, time_limit_ms, memory_limit_kb,
+//                   and optionally signature (see harness/driver.h)
+//   reference.cpp   reference solution; produces every expected output.
+//                   With a signature, it and every submission are a
+//                   `class Solution` judged through the generated harness
+//   tests.txt       test plan, one test per line, in judging order:
+//                     sample <file>          hand-written input, shown
+//                     file <file>            hand-written input
+//                     gen <gen.cpp> <args>   generator output; the
+//                                            generator must be
+//                                            deterministic in its args
+//                   With a signature, every input is in the harness
+//                   encoding (harness/harness.h); strings and chars are
+//                   quoted, "abc" and "x", not bare tokens
+//   schema.txt      optional validation::Schema every input must satisfy
+//   statement.md    optional statement
+//   hints.txt       optional coach::HintLadders, generated offline
+//
+// The reference and generators may `#include "..."` headers from the
+// problem directory (testlib.h, shared helpers).
+//
+// Each step (generate, validate, solve) is keyed by a digest of its inputs,
+// local headers included, in the BuildCache and its result stored in the
+// content-addressed BlobStore, so a rebuild only redoes steps whose inputs
+// changed and identical test data is stored once across problems.
+namespace codecoach::bundler {
+
+class BuildError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+struct BuildOptions {
+  std::size_t parallelism = 1;
+  std::chrono::milliseconds generator_timeout{30'000};
+  // Pasted into problems that declare a signature; relative paths are
+  // against the working directory.
+  std::filesystem::path harness_header = "src/harness/harness.h";
+};
+
+struct BuildStats {
+  std::size_t tests = 0;
+  std::size_t generated = 0;       // Generator runs.
+  std::size_t inputs_reused = 0;   // Generator runs skipped via the cache.
+  std::size_t validated = 0;       // Schema checks run.
+  std::size_t solved = 0;          // Reference runs.
+  std::size_t outputs_reused = 0;  // Reference runs skipped via the cache.
+  std::size_t shared_bytes = 0;    // Duplicate test data stored once.
+  // Slowest fresh reference run; compare against the time limit.
+  std::uint32_t max_reference_ms = 0;
+  std::uint64_t version = 0;
+  bool written = false;  // False when the bundle content was unchanged.
+  std::chrono::milliseconds elapsed{0};
+};
+
+class ProblemBuilder {
+ public:
+  ProblemBuilder(compile::Compiler& compiler, storage::BlobStore& blobs,
+                 BuildCache& cache, BuildOptions options);
+
+  // Builds `problem_dir` into `out_dir`/<id>.ccb, replacing any previous
+  // bundle atomically. Throws BuildError on bad sources, compile errors,
+  // failing generators or reference runs, and schema violations.
+  BuildStats build(const std::filesystem::path& problem_dir,
+                   const std::filesystem::path& out_dir);
+
+ private:
+  compile::Compiler& compiler_;
+  storage::BlobStore& blobs_;
+  BuildCache& cache_;
+  BuildOptions options_;
+};
+
+}  // namespace codecoach::bundler
@@ -0,0 +1,101 @@
+#include "catalog/bundle_edit.h"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "catalog/bundle_format.h"
+#include "catalog/bundle_writer.h"
+#include "catalog/problem_bundle.h"
+#include "common/mapped_file.h"
+
+namespace codecoach::catalog {
+
+void rewrite_test_flags(const std::filesystem::path& path,
+                        std::span<const std::uint32_t> flags) {
+  // Validates the whole file before we patch offsets blindly.
+  if (ProblemBundle::open(path)->test_count() != flags.size()) {
+    throw BundleError(path.string() + ": flag count does not match tests");
+  }
+
+  std::string bytes;
+  {
+    std::ifstream in(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), {});
+    if (!in.good() && !in.eof()) {
+      throw BundleError(path.string() + ": read failed");
+    }
+  }
+
+  format::BundleHeader header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  ++header.content_version;
+  std::memcpy(bytes.data(), &header, sizeof(header));
+
+  for (std::uint32_t s = 0; s < header.section_count; ++s) {
+    format::SectionEntry section;
+    std::memcpy(&section,
+                bytes.data() + sizeof(header) + s * sizeof(section),
+                sizeof(section));
+    if (section.kind != format::SectionKind::kTests) continue;
+    const std::size_t table = section.offset + sizeof(format::TestsHeader);
+    for (std::size_t t = 0; t < flags.size(); ++t) {
+      std::memcpy(bytes.data() + table + t * sizeof(format::TestEntry) +
+                      offsetof(format::TestEntry, flags),
+                  &flags[t], sizeof(std::uint32_t));
+    }
+  }
+
+  auto tmp = path;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    out.flush();
+    if (!out) throw BundleError(tmp.string() + ": write failed");
+  }
+  std::filesystem::rename(tmp, path);
+}
+
+void replace_section(const std::filesystem::path& path,
+                     format::SectionKind kind, std::string_view payload) {
+  if (kind == format::SectionKind::kProblemId ||
+      kind == format::SectionKind::kTests) {
+    throw BundleError("replace_section: cannot replace a core section");
+  }
+  const auto bundle = ProblemBundle::open(path);
+  // Validated above; walk the raw table so sections this build does not
+  // know about are carried over too.
+  const auto file = MappedFile::open(path);
+  const std::string_view bytes = file.bytes();
+  format::BundleHeader header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+
+  BundleSpec spec;
+  spec.problem_id = std::string(bundle->problem_id());
+  spec.content_version = bundle->version() + 1;
+  spec.time_limit_ms = bundle->time_limit_ms();
+  spec.memory_limit_kb = bundle->memory_limit_kb();
+  for (std::uint32_t s = 0; s < header.section_count; ++s) {
+    format::SectionEntry section;
+    std::memcpy(&section,
+                bytes.data() + sizeof(header) + s * sizeof(section),
+                sizeof(section));
+    if (section.kind == format::SectionKind::kProblemId ||
+        section.kind == format::SectionKind::kTests || section.kind == kind) {
+      continue;
+    }
+    spec.sections.emplace_back(
+        section.kind, std::string(bytes.substr(section.offset, section.size)));
+  }
+  spec.sections.emplace_back(kind, std::string(payload));
+  for (std::size_t t = 0; t < bundle->test_count(); ++t) {
+    const auto test = bundle->test(t);
+    spec.tests.push_back({test.input, test.expected_output, test.flags});
+  }
+  write_bundle(spec, path);
+}
+
+}  // namespace codecoach::catalog
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+#include "catalog/bundle_format.h"
+
+namespace codecoach::catalog {
+
+// Replaces the per-test flags of the bundle at `path`, bumps its content
+// version and atomically renames the result over the original, so a running
+// evaluator picks it up on the next Catalog::reload(). `flags` must have one
+// entry per test. Throws BundleError or std::system_error.
+void rewrite_test_flags(const std::filesystem::path& path,
+                        std::span<const std::uint32_t> flags);
+
+// Adds or replaces an optional section (not the problem id or tests) of the
+// bundle at `path` the same way: new content version, atomic rename.
+void replace_section(const std::filesystem::path& path,
+                     format::SectionKind kind, std::string_view payload);
+
+}  // namespace codecoach::catalog
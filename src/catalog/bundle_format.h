@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// On-disk layout of a problem bundle (*.ccb). A bundle is a single file that
+// is mapped read-only by the evaluator; test data is served directly from the
+// mapping. All integers are little-endian and all offsets are absolute file
+// offsets.
+//
+//   BundleHeader
+//   SectionEntry[section_count]
+//   ...section payloads...
+//
+// Bundles are replaced on disk by writing a new file and renaming it over the
+// old one, never by rewriting in place, so existing mappings stay valid.
+namespace codecoach::catalog::format {
+
+inline constexpr std::array<char, 8> kMagic = {'C', 'C', 'B', 'N',
+                                               'D', 'L', '\0', '\0'};
+inline constexpr std::uint32_t kFormatVersion = 1;
+
+struct BundleHeader {
+  std::array<char, 8> magic;
+  std::uint32_t format_version;
+  std::uint32_t section_count;
+  // Content version; bumped by the bundle builder on every change.
+  std::uint64_t content_version;
+  std::uint32_t time_limit_ms;
+  std::uint32_t memory_limit_kb;
+};
+static_assert(sizeof(BundleHeader) == 32);
+
+enum class SectionKind : std::uint32_t {
+  kProblemId = 1,  // UTF-8 problem slug
+  kTests = 2,      // TestsHeader + TestEntry[count]
+  kStatement = 3,  // Markdown statement
+  kInputSchema = 4,  // validation::Schema source text
+  kHints = 5,        // coach::HintLadders source text
+  kFailureClusters = 6,  // ClusterTableHeader + ClusterSlot[slot_count]
+  // Signature problems (harness/driver.h): source pasted before and after
+  // every solution.
+  kHarness = 7,      // harness/harness.h, prepared by driver_prologue()
+  kHarnessMain = 8,  // driver_main() for the declared signature
+};
+
+struct SectionEntry {
+  SectionKind kind;
+  std::uint32_t reserved;
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+static_assert(sizeof(SectionEntry) == 24);
+
+struct TestsHeader {
+  std::uint32_t count;
+  std::uint32_t reserved;
+};
+static_assert(sizeof(TestsHeader) == 8);
+
+// Per-test flag bits.
+enum TestFlag : std::uint32_t {
+  kTestSample = 1u << 0,  // Shown to users; judged first.
+  // Redundant for catching known wrong submissions (see tools/test_pruner);
+  // only run in full-audit mode.
+  kTestAuditOnly = 1u << 1,
+};
+
+struct TestEntry {
+  std::uint64_t input_offset;
+  std::uint64_t input_size;
+  std::uint64_t output_offset;
+  std::uint64_t output_size;
+  std::uint32_t flags;
+  std::uint32_t reserved;
+};
+static_assert(sizeof(TestEntry) == 40);
+
+// Failure-signature -> cluster id table (see analysis/failure_clusters),
+// an open-addressing hash table read in place: a verdict's signature hash,
+// or for a verdict that skipped tests the hash of its first failed test
+// (judge/failure_cluster.h), is probed linearly from slot
+// (hash & (slot_count - 1)). slot_count is a power of two with at least one
+// empty slot; hash 0 marks an empty slot.
+struct ClusterTableHeader {
+  std::uint32_t test_count;  // Signatures of other lengths never match.
+  std::uint32_t slot_count;
+};
+static_assert(sizeof(ClusterTableHeader) == 8);
+
+struct ClusterSlot {
+  std::uint64_t signature_hash;
+  std::uint32_t cluster;
+  std::uint32_t reserved;
+};
+static_assert(sizeof(ClusterSlot) == 16);
+
+}  // namespace codecoach::catalog::format
@@ -0,0 +1,98 @@
+#include "catalog/bundle_writer.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "common/hash.h"
+
+namespace codecoach::catalog {
+
+namespace {
+
+template <typename T>
+void put_at(std::string& out, std::size_t offset, const T& value) {
+  std::memcpy(out.data() + offset, &value, sizeof(value));
+}
+
+void align_to(std::string& out, std::size_t alignment) {
+  out.resize((out.size() + alignment - 1) / alignment * alignment, '\0');
+}
+
+}  // namespace
+
+std::size_t serialize_bundle(const BundleSpec& spec, std::string& out) {
+  using namespace format;
+  out.clear();
+  const std::uint32_t section_count =
+      2 + static_cast<std::uint32_t>(spec.sections.size());
+  out.resize(sizeof(BundleHeader) + section_count * sizeof(SectionEntry));
+  put_at(out, 0,
+         BundleHeader{kMagic, kFormatVersion, section_count,
+                      spec.content_version, spec.time_limit_ms,
+                      spec.memory_limit_kb});
+
+  std::uint32_t section = 0;
+  const auto add_section = [&](SectionKind kind, std::string_view payload,
+                               std::size_t alignment) {
+    align_to(out, alignment);
+    const SectionEntry entry{kind, 0, out.size(), payload.size()};
+    put_at(out, sizeof(BundleHeader) + section++ * sizeof(SectionEntry),
+           entry);
+    out.append(payload);
+  };
+
+  add_section(SectionKind::kProblemId, spec.problem_id, 1);
+  for (const auto& [kind, payload] : spec.sections) {
+    add_section(kind, payload, 1);
+  }
+
+  // Tests section: header and table first, blobs after.
+  const std::size_t table_bytes =
+      sizeof(TestsHeader) + spec.tests.size() * sizeof(TestEntry);
+  add_section(SectionKind::kTests, std::string(table_bytes, '\0'),
+              alignof(TestEntry));
+  const std::size_t table = out.size() - table_bytes;
+  put_at(out, table,
+         TestsHeader{static_cast<std::uint32_t>(spec.tests.size()), 0});
+
+  std::unordered_map<Digest128, std::uint64_t, Digest128Hash> blob_offsets;
+  std::size_t saved = 0;
+  const auto place = [&](std::string_view blob) -> std::uint64_t {
+    const auto [it, inserted] =
+        blob_offsets.try_emplace(digest128(blob), out.size());
+    if (inserted) {
+      out.append(blob);
+    } else {
+      saved += blob.size();
+    }
+    return it->second;
+  };
+  for (std::size_t t = 0; t < spec.tests.size(); ++t) {
+    const auto& test = spec.tests[t];
+    const TestEntry entry{place(test.input), test.input.size(),
+                          place(test.expected_output),
+                          test.expected_output.size(), test.flags, 0};
+    put_at(out, table + sizeof(TestsHeader) + t * sizeof(TestEntry), entry);
+  }
+  return saved;
+}
+
+std::size_t write_bundle(const BundleSpec& spec,
+                         const std::filesystem::path& path) {
+  std::string bytes;
+  const std::size_t saved = serialize_bundle(spec, bytes);
+  auto tmp = path;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    out.flush();
+    if (!out) throw std::runtime_error("bundle write failed: " + tmp.string());
+  }
+  std::filesystem::rename(tmp, path);
+  return saved;
+}
+
+}  // namespace codecoach::catalog
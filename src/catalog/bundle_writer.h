@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "catalog/bundle_format.h"
+
+namespace codecoach::catalog {
+
+struct BundleTestSpec {
+  std::string_view input;
+  std::string_view expected_output;
+  std::uint32_t flags = 0;
+};
+
+// Everything that goes into a bundle file. Views must outlive write().
+struct BundleSpec {
+  std::string problem_id;
+  std::uint64_t content_version = 1;
+  std::uint32_t time_limit_ms = 1000;
+  std::uint32_t memory_limit_kb = 256 * 1024;
+  std::vector<BundleTestSpec> tests;
+  // Optional sections (statement, schema, ...), written in order.
+  std::vector<std::pair<format::SectionKind, std::string>> sections;
+};
+
+// Serializes `spec` in the bundle format. Identical test blobs are stored
+// once and shared by offset. Returns the number of bytes saved that way.
+std::size_t serialize_bundle(const BundleSpec& spec, std::string& out);
+
+// Writes the bundle next to `path` and renames it into place, so a live
+// Catalog never maps a partial file.
+std::size_t write_bundle(const BundleSpec& spec,
+                         const std::filesystem::path& path);
+
+}  // namespace codecoach::catalog
@@ -0,0 +1,100 @@
+#include "catalog/catalog.h"
+
+#include <algorithm>
+#include <exception>
+#include <unordered_set>
+
+namespace codecoach::catalog {
+
+namespace {
+
+constexpr std::string_view kBundleExtension = ".ccb";
+
+}  // namespace
+
+std::shared_ptr<const ProblemBundle> CatalogSnapshot::find(
+    std::string_view problem) const {
+  auto it = bundles_.find(problem);
+  return it == bundles_.end() ? nullptr : it->second;
+}
+
+Catalog::Catalog(std::filesystem::path directory)
+    : directory_(std::move(directory)),
+      current_(std::make_shared<const CatalogSnapshot>()) {}
+
+ReloadResult Catalog::reload() {
+  std::lock_guard lock(reload_mu_);
+  const auto previous = snapshot();
+
+  // Index the live bundles by path so unchanged files can be reused.
+  std::unordered_map<std::string, std::shared_ptr<const ProblemBundle>>
+      by_path;
+  previous->for_each([&](const auto& bundle) {
+    by_path.emplace(bundle->path().string(), bundle);
+  });
+
+  auto next = std::make_shared<CatalogSnapshot>();
+  next->generation_ = previous->generation() + 1;
+  ReloadResult result;
+  result.generation = next->generation_;
+
+  std::vector<std::filesystem::path> paths;
+  for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
+    if (entry.is_regular_file() &&
+        entry.path().extension() == kBundleExtension) {
+      paths.push_back(entry.path());
+    }
+  }
+  // Deterministic order, so duplicate ids always resolve the same way.
+  std::sort(paths.begin(), paths.end());
+
+  std::unordered_set<std::string> failed_ids;
+  for (const auto& path : paths) {
+    std::shared_ptr<const ProblemBundle> bundle;
+    const auto reuse = by_path.find(path.string());
+    try {
+      if (reuse != by_path.end() &&
+          reuse->second->stamp() == FileStamp::of(path)) {
+        bundle = reuse->second;
+      } else {
+        bundle = ProblemBundle::open(path);
+        if (check_) check_(*bundle);
+      }
+    } catch (const std::exception& e) {
+      result.errors.push_back(e.what());
+      if (reuse != by_path.end()) {
+        failed_ids.emplace(reuse->second->problem_id());
+      }
+      continue;
+    }
+
+    std::string id(bundle->problem_id());
+    if (next->bundles_.contains(id)) {
+      result.errors.push_back(path.string() + ": duplicate problem id " + id);
+      continue;
+    }
+    const auto old = previous->find(id);
+    if (!old) {
+      result.added.push_back(id);
+    } else if (old != bundle) {
+      result.updated.push_back(id);
+    }
+    next->bundles_.emplace(std::move(id), std::move(bundle));
+  }
+
+  // A bundle that failed to reload keeps serving its previous version.
+  previous->for_each([&](const auto& bundle) {
+    std::string id(bundle->problem_id());
+    if (next->bundles_.contains(id)) return;
+    if (failed_ids.contains(id)) {
+      next->bundles_.emplace(std::move(id), bundle);
+    } else {
+      result.removed.push_back(std::move(id));
+    }
+  });
+
+  current_.store(std::move(next), std::memory_order_release);
+  return result;
+}
+
+}  // namespace codecoach::catalog
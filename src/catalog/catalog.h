@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "catalog/problem_bundle.h"
+
+namespace codecoach::catalog {
+
+// Immutable view of the whole problem catalog at one point in time.
+class CatalogSnapshot {
+ public:
+  std::shared_ptr<const ProblemBundle> find(std::string_view problem) const;
+
+  std::uint64_t generation() const { return generation_; }
+  std::size_t size() const { return bundles_.size(); }
+
+  template <typename Fn>
+  void for_each(Fn&& fn) const {
+    for (const auto& [id, bundle] : bundles_) fn(bundle);
+  }
+
+ private:
+  friend class Catalog;
+
+  struct StringHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const {
+      return std::hash<std::string_view>{}(s);
+    }
+  };
+
+  std::uint64_t generation_ = 0;
+  std::unordered_map<std::string, std::shared_ptr<const ProblemBundle>,
+                     StringHash, std::equal_to<>>
+      bundles_;
+};
+
+struct ReloadResult {
+  std::uint64_t generation = 0;
+  std::vector<std::string> added;
+  std::vector<std::string> updated;
+  std::vector<std::string> removed;
+  // Bundles that failed to load. The previous version, if any, stays live.
+  std::vector<std::string> errors;
+};
+
+// The live problem catalog, hot-reloadable with read-copy-update semantics.
+//
+// Readers take a snapshot (or a single bundle) and keep it for the duration
+// of a submission; they never block and never observe a half-applied reload.
+// reload() builds a new snapshot off to the side and publishes it with one
+// atomic store. Superseded bundles are unmapped once the last in-flight
+// submission holding them completes.
+class Catalog {
+ public:
+  // Runs on every newly mapped bundle during reload(); throwing rejects the
+  // bundle, which leaves its previous version live.
+  using BundleCheck = std::function<void(const ProblemBundle&)>;
+
+  explicit Catalog(std::filesystem::path directory);
+
+  // Must be set before concurrent reload() calls start.
+  void set_bundle_check(BundleCheck check) { check_ = std::move(check); }
+
+  std::shared_ptr<const CatalogSnapshot> snapshot() const {
+    return current_.load(std::memory_order_acquire);
+  }
+
+  std::shared_ptr<const ProblemBundle> find(std::string_view problem) const {
+    return snapshot()->find(problem);
+  }
+
+  // Rescans the catalog directory for *.ccb files. Files whose on-disk stamp
+  // is unchanged keep their existing mapping (and warm page cache).
+  ReloadResult reload();
+
+ private:
+  std::filesystem::path directory_;
+  BundleCheck check_;
+  std::mutex reload_mu_;  // Serializes writers only.
+  std::atomic<std::shared_ptr<const CatalogSnapshot>> current_;
+};
+
+}  // namespace codecoach::catalog
@@ -0,0 +1,137 @@
+#include "catalog/problem_bundle.h"
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace codecoach::catalog {
+
+namespace {
+
+bool in_bounds(std::uint64_t offset, std::uint64_t size, std::size_t total) {
+  return offset <= total && size <= total - offset;
+}
+
+template <typename T>
+bool aligned_for(std::uint64_t offset) {
+  return offset % alignof(T) == 0;
+}
+
+}  // namespace
+
+FileStamp FileStamp::of(const std::filesystem::path& path) {
+  struct stat st {};
+  if (::stat(path.c_str(), &st) != 0) {
+    throw std::system_error(errno, std::generic_category(),
+                            "stat " + path.string());
+  }
+  return FileStamp{
+      .inode = static_cast<std::uintmax_t>(st.st_ino),
+      .size = static_cast<std::uintmax_t>(st.st_size),
+      .mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 +
+                  st.st_mtim.tv_nsec,
+  };
+}
+
+std::shared_ptr<const ProblemBundle> ProblemBundle::open(
+    const std::filesystem::path& path) {
+  std::shared_ptr<ProblemBundle> bundle(new ProblemBundle());
+  bundle->path_ = path;
+  bundle->stamp_ = FileStamp::of(path);
+  bundle->file_ = MappedFile::open(path);
+
+  const std::string_view bytes = bundle->file_.bytes();
+  const auto fail = [&](const char* what) {
+    return BundleError(path.string() + ": " + what);
+  };
+
+  if (bytes.size() < sizeof(format::BundleHeader)) throw fail("truncated");
+  const auto& header = bundle->header();
+  if (header.magic != format::kMagic) throw fail("bad magic");
+  if (header.format_version != format::kFormatVersion) {
+    throw fail("unsupported format version");
+  }
+  if (!in_bounds(sizeof(format::BundleHeader),
+                 std::uint64_t{header.section_count} *
+                     sizeof(format::SectionEntry),
+                 bytes.size())) {
+    throw fail("section table out of bounds");
+  }
+
+  bool have_tests = false;
+  for (const auto& entry : bundle->sections()) {
+    if (!in_bounds(entry.offset, entry.size, bytes.size())) {
+      throw fail("section out of bounds");
+    }
+    const char* payload = bytes.data() + entry.offset;
+    switch (entry.kind) {
+      case format::SectionKind::kProblemId:
+        bundle->problem_id_ = {payload, entry.size};
+        break;
+      case format::SectionKind::kTests: {
+        if (!aligned_for<format::TestEntry>(entry.offset) ||
+            entry.size < sizeof(format::TestsHeader)) {
+          throw fail("malformed tests section");
+        }
+        const auto* tests_header =
+            reinterpret_cast<const format::TestsHeader*>(payload);
+        const std::uint64_t table_size =
+            std::uint64_t{tests_header->count} * sizeof(format::TestEntry);
+        if (table_size > entry.size - sizeof(format::TestsHeader)) {
+          throw fail("test table out of bounds");
+        }
+        bundle->tests_ = {reinterpret_cast<const format::TestEntry*>(
+                              payload + sizeof(format::TestsHeader)),
+                          tests_header->count};
+        for (const auto& test : bundle->tests_) {
+          if (!in_bounds(test.input_offset, test.input_size, bytes.size()) ||
+              !in_bounds(test.output_offset, test.output_size, bytes.size())) {
+            throw fail("test data out of bounds");
+          }
+        }
+        have_tests = true;
+        break;
+      }
+      default:
+        // Unknown sections are skipped so older evaluators can load bundles
+        // produced by newer builders.
+        break;
+    }
+  }
+  if (bundle->problem_id_.empty()) throw fail("missing problem id");
+  if (!have_tests) throw fail("missing tests section");
+  return bundle;
+}
+
+TestCase ProblemBundle::test(std::size_t index) const {
+  const auto& entry = tests_[index];
+  const char* base = file_.bytes().data();
+  return TestCase{
+      .input = {base + entry.input_offset, entry.input_size},
+      .expected_output = {base + entry.output_offset, entry.output_size},
+      .flags = entry.flags,
+  };
+}
+
+std::optional<std::string_view> ProblemBundle::section(
+    format::SectionKind kind) const {
+  for (const auto& entry : sections()) {
+    if (entry.kind == kind) {
+      return file_.bytes().substr(entry.offset, entry.size);
+    }
+  }
+  return std::nullopt;
+}
+
+const format::BundleHeader& ProblemBundle::header() const {
+  return *reinterpret_cast<const format::BundleHeader*>(file_.bytes().data());
+}
+
+std::span<const format::SectionEntry> ProblemBundle::sections() const {
+  return {reinterpret_cast<const format::SectionEntry*>(
+              file_.bytes().data() + sizeof(format::BundleHeader)),
+          header().section_count};
+}
+
+}  // namespace codecoach::catalog
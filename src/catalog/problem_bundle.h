@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "catalog/bundle_format.h"
+#include "common/mapped_file.h"
+
+namespace codecoach::catalog {
+
+class BundleError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Identity of a bundle file on disk, used to detect replaced files cheaply.
+struct FileStamp {
+  std::uintmax_t inode = 0;
+  std::uintmax_t size = 0;
+  std::int64_t mtime_ns = 0;
+
+  static FileStamp of(const std::filesystem::path& path);
+  bool operator==(const FileStamp&) const = default;
+};
+
+// One test case. Views point into the bundle mapping and stay valid for as
+// long as the owning ProblemBundle is alive.
+struct TestCase {
+  std::string_view input;
+  std::string_view expected_output;
+  std::uint32_t flags = 0;
+};
+
+enum class JudgeMode {
+  kStandard,   // Skips audit-only tests.
+  kFullAudit,  // Runs every test; used for rejudges and background audits.
+};
+
+inline bool runs_in(const TestCase& test, JudgeMode mode) {
+  return mode == JudgeMode::kFullAudit ||
+         (test.flags & format::kTestAuditOnly) == 0;
+}
+
+// An immutable, memory-mapped problem bundle. Bundles are shared through
+// shared_ptr: a submission pins the version it started with, and the mapping
+// is released when the last holder lets go.
+class ProblemBundle {
+ public:
+  // Maps and validates `path`. Throws BundleError on malformed input and
+  // std::system_error on I/O failure.
+  static std::shared_ptr<const ProblemBundle> open(
+      const std::filesystem::path& path);
+
+  std::string_view problem_id() const { return problem_id_; }
+  std::uint64_t version() const { return header().content_version; }
+  std::uint32_t time_limit_ms() const { return header().time_limit_ms; }
+  std::uint32_t memory_limit_kb() const { return header().memory_limit_kb; }
+
+  std::size_t test_count() const { return tests_.size(); }
+  TestCase test(std::size_t index) const;
+
+  // Raw payload of an optional section.
+  std::optional<std::string_view> section(format::SectionKind kind) const;
+
+  // Starts paging in the test data ahead of the first submission.
+  void prefetch() const { file_.prefetch(); }
+
+  const std::filesystem::path& path() const { return path_; }
+  const FileStamp& stamp() const { return stamp_; }
+
+ private:
+  ProblemBundle() = default;
+
+  const format::BundleHeader& header() const;
+  std::span<const format::SectionEntry> sections() const;
+
+  std::filesystem::path path_;
+  FileStamp stamp_;
+  MappedFile file_;
+  std::string_view problem_id_;
+  std::span<const format::TestEntry> tests_;
+};
+
+}  // namespace codecoach::catalog
@@ -0,0 +1,61 @@
+#include "coach/coach.h"
+
+#include <algorithm>
+
+namespace codecoach::coach {
+
+std::shared_ptr<const HintLadders> Coach::ladders_for(
+    const catalog::ProblemBundle& bundle) {
+  const std::string id(bundle.problem_id());
+  {
+    std::lock_guard lock(mu_);
+    const auto it = parsed_.find(id);
+    if (it != parsed_.end() && it->second.version == bundle.version()) {
+      return it->second.ladders;
+    }
+  }
+
+  auto ladders = std::make_shared<HintLadders>();
+  if (const auto text = bundle.section(catalog::format::SectionKind::kHints)) {
+    try {
+      *ladders = HintLadders::parse(*text);
+    } catch (const HintFormatError&) {
+      // The bundle builder rejects bad hints; a bundle that slipped through
+      // falls back to live hints rather than failing the request.
+    }
+  }
+  std::lock_guard lock(mu_);
+  auto& entry = parsed_[id];
+  // Another thread may have cached a newer version meanwhile.
+  if (entry.ladders == nullptr || entry.version <= bundle.version()) {
+    entry = {bundle.version(), ladders};
+  }
+  return ladders;
+}
+
+Hint Coach::hint(const catalog::ProblemBundle& bundle,
+                 const judge::Verdict& verdict, std::string_view source,
+                 std::size_t level) {
+  const auto failure = first_failure(verdict);
+  if (!failure) return {};
+
+  const auto ladders = ladders_for(bundle);
+  if (const HintLadder* ladder = ladders->select(*failure)) {
+    ++ladder_hints_;
+    const std::size_t step = std::min(level, ladder->hints.size() - 1);
+    return {Hint::Source::kLadder, ladder->failure_class, ladder->hints[step],
+            step};
+  }
+
+  ++live_hints_;
+  std::string compile_errors;
+  if (verdict.overall == judge::Outcome::kCompileError) {
+    compile_errors = diagnostics_.summarize(verdict.compile_log);
+  }
+  const HintContext context{bundle.problem_id(), bundle.version(), verdict,
+                            source,              failure,          level,
+                            compile_errors};
+  return {Hint::Source::kLive, {}, live_.hint(context), level};
+}
+
+}  // namespace codecoach::coach
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "catalog/problem_bundle.h"
+#include "coach/hint_ladder.h"
+#include "compile/diagnostics.h"
+#include "judge/verdict.h"
+
+namespace codecoach::coach {
+
+struct HintContext {
+  std::string_view problem_id;
+  std::uint64_t bundle_version = 0;
+  const judge::Verdict& verdict;
+  std::string_view source;
+  std::optional<FailureSignature> failure;
+  std::size_t level = 0;  // Hints this user already got for this failure.
+  // For compile errors, the summarized diagnostics (compile/diagnostics):
+  // send this rather than verdict.compile_log, which can run to tens of
+  // kilobytes of template instantiation notes.
+  std::string_view compile_errors;
+};
+
+// The live model. Called only for failures no pre-generated ladder covers,
+// so it sees the long tail rather than every wrong submission.
+class CoachClient {
+ public:
+  virtual ~CoachClient() = default;
+  virtual std::string hint(const HintContext& context) = 0;
+};
+
+struct Hint {
+  enum class Source { kNone, kLadder, kLive };
+  Source source = Source::kNone;
+  std::string failure_class;  // Ladder hints only.
+  std::string text;
+  // Ladder step served; stays on the last step once the ladder runs out.
+  std::size_t step = 0;
+};
+
+// Picks the next hint for a judged submission: the matching step of the
+// problem's pre-generated ladder when one covers the failure, else a live
+// hint. Parsed ladders are cached per problem and version. Thread-safe.
+class Coach {
+ public:
+  explicit Coach(CoachClient& live) : live_(live) {}
+
+  // `level` is the number of hints the user already received for this
+  // problem and failure class; higher levels give more direct hints.
+  Hint hint(const catalog::ProblemBundle& bundle,
+            const judge::Verdict& verdict, std::string_view source,
+            std::size_t level);
+
+  std::size_t ladder_hints() const { return ladder_hints_; }
+  std::size_t live_hints() const { return live_hints_; }
+
+ private:
+  std::shared_ptr<const HintLadders> ladders_for(
+      const catalog::ProblemBundle& bundle);
+
+  CoachClient& live_;
+  compile::DiagnosticSummarizer diagnostics_;
+  std::mutex mu_;
+  struct Parsed {
+    std::uint64_t version = 0;
+    std::shared_ptr<const HintLadders> ladders;
+  };
+  std::unordered_map<std::string, Parsed> parsed_;  // By problem id.
+  std::atomic<std::size_t> ladder_hints_{0};
+  std::atomic<std::size_t> live_hints_{0};
+};
+
+}  // namespace codecoach::coach
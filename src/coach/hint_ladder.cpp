@@ -0,0 +1,139 @@
+#include "coach/hint_ladder.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+
+namespace codecoach::coach {
+
+namespace {
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) {
+    s.remove_prefix(1);
+  }
+  while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) {
+    s.remove_suffix(1);
+  }
+  return s;
+}
+
+// Splits off the first whitespace-delimited word.
+std::string_view take_word(std::string_view& s) {
+  s = trim(s);
+  const auto end = std::min(s.find_first_of(" \t"), s.size());
+  const auto word = s.substr(0, end);
+  s = trim(s.substr(end));
+  return word;
+}
+
+bool parse_test_number(std::string_view text, std::size_t& out) {
+  const auto result =
+      std::from_chars(text.data(), text.data() + text.size(), out);
+  return result.ec == std::errc() &&
+         result.ptr == text.data() + text.size() && out >= 1;
+}
+
+}  // namespace
+
+std::optional<FailureSignature> first_failure(const judge::Verdict& verdict) {
+  using judge::Outcome;
+  if (verdict.overall == Outcome::kCompileError) {
+    return FailureSignature{Outcome::kCompileError, std::nullopt};
+  }
+  for (std::size_t t = 0; t < verdict.tests.size(); ++t) {
+    const Outcome outcome = verdict.tests[t].outcome;
+    if (outcome != Outcome::kAccepted && outcome != Outcome::kSkipped) {
+      return FailureSignature{outcome, t};
+    }
+  }
+  if (verdict.overall == Outcome::kAccepted) return std::nullopt;
+  return FailureSignature{verdict.overall, std::nullopt};
+}
+
+bool HintLadder::matches(const FailureSignature& failure) const {
+  return std::any_of(rules.begin(), rules.end(), [&](const Rule& rule) {
+    if (rule.outcome != failure.outcome) return false;
+    if (!failure.test) {
+      return rule.first_test == 0 && rule.last_test == SIZE_MAX;
+    }
+    return *failure.test >= rule.first_test && *failure.test <= rule.last_test;
+  });
+}
+
+HintLadders HintLadders::parse(std::string_view text) {
+  HintLadders result;
+  std::size_t line_no = 0;
+  while (!text.empty()) {
+    ++line_no;
+    const auto newline = text.find('\n');
+    std::string_view line = text.substr(0, newline);
+    text.remove_prefix(newline == std::string_view::npos ? text.size()
+                                                         : newline + 1);
+    const auto fail = [&](const std::string& what) {
+      return HintFormatError("hints line " + std::to_string(line_no) + ": " +
+                             what);
+    };
+
+    // Hint text may contain '#', so only whole-line comments exist.
+    line = trim(line);
+    if (line.empty() || line.front() == '#') continue;
+    const auto keyword = take_word(line);
+    if (keyword == "class") {
+      if (line.empty()) throw fail("class needs a name");
+      result.ladders_.push_back({std::string(line), {}, {}});
+      continue;
+    }
+    if (result.ladders_.empty()) throw fail("statement outside a class");
+    auto& ladder = result.ladders_.back();
+    if (keyword == "hint") {
+      if (line.empty()) throw fail("empty hint");
+      ladder.hints.emplace_back(line);
+    } else if (keyword == "when") {
+      // Strip a trailing comment from rules only.
+      line = trim(line.substr(0, line.find('#')));
+      const auto outcome_name = take_word(line);
+      const auto outcome = judge::outcome_from_string(outcome_name);
+      if (!outcome || *outcome == judge::Outcome::kAccepted ||
+          *outcome == judge::Outcome::kSkipped) {
+        throw fail("bad outcome '" + std::string(outcome_name) + "'");
+      }
+      HintLadder::Rule rule{*outcome};
+      if (const auto range = take_word(line); !range.empty()) {
+        const auto dash = range.find('-');
+        std::size_t first = 0;
+        std::size_t last = 0;
+        if (!parse_test_number(range.substr(0, dash), first) ||
+            (dash != std::string_view::npos &&
+             !parse_test_number(range.substr(dash + 1), last))) {
+          throw fail("bad test range '" + std::string(range) + "'");
+        }
+        if (dash == std::string_view::npos) last = first;
+        if (last < first) throw fail("empty test range");
+        rule.first_test = first - 1;
+        rule.last_test = last - 1;
+      }
+      if (!line.empty()) throw fail("trailing text after test range");
+      ladder.rules.push_back(rule);
+    } else {
+      throw fail("unknown statement '" + std::string(keyword) + "'");
+    }
+  }
+  for (const auto& ladder : result.ladders_) {
+    if (ladder.rules.empty() || ladder.hints.empty()) {
+      throw HintFormatError("hints: class '" + ladder.failure_class +
+                            "' needs at least one when and one hint");
+    }
+  }
+  return result;
+}
+
+const HintLadder* HintLadders::select(const FailureSignature& failure) const {
+  for (const auto& ladder : ladders_) {
+    if (ladder.matches(failure)) return &ladder;
+  }
+  return nullptr;
+}
+
+}  // namespace codecoach::coach
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "judge/verdict.h"
+
+namespace codecoach::coach {
+
+class HintFormatError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Where a verdict first went wrong: the outcome of the first failing test,
+// or kCompileError with no test.
+struct FailureSignature {
+  judge::Outcome outcome = judge::Outcome::kAccepted;
+  std::optional<std::size_t> test;  // 0-based.
+
+  bool operator==(const FailureSignature&) const = default;
+};
+
+// Returns nullopt for an accepted verdict.
+std::optional<FailureSignature> first_failure(const judge::Verdict& verdict);
+
+// Progressive hints for one failure class, gentlest first.
+struct HintLadder {
+  std::string failure_class;  // e.g. "TLE-quadratic", "WA-overflow".
+  struct Rule {
+    judge::Outcome outcome;
+    std::size_t first_test = 0;  // 0-based, inclusive.
+    std::size_t last_test = SIZE_MAX;
+  };
+  std::vector<Rule> rules;  // Matches if any rule does.
+  std::vector<std::string> hints;
+
+  bool matches(const FailureSignature& failure) const;
+};
+
+// The hint ladders of one problem, generated offline and stored in the
+// bundle's kHints section. Text format, one statement per line, '#'
+// starting a comment:
+//
+//   class TLE-quadratic
+//   when TLE 5-8       # first failure is a TLE on tests 5..8 (1-based)
+//   when TLE 10
+//   hint Consider n = 2*10^5: how many steps does the inner loop take?
+//   hint ...
+//   class WA-edge-empty
+//   when WA 1
+//   when RE 1
+//   hint ...
+//
+// A "when" without a test range matches any test; "when CE" matches
+// compile errors. The first class with a matching rule wins.
+class HintLadders {
+ public:
+  // Throws HintFormatError.
+  static HintLadders parse(std::string_view text);
+
+  const HintLadder* select(const FailureSignature& failure) const;
+
+  const std::vector<HintLadder>& ladders() const { return ladders_; }
+
+ private:
+  std::vector<HintLadder> ladders_;
+};
+
+}  // namespace codecoach::coach
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace codecoach {
+
+// Fixed-size (set at construction) bitset over 64-bit words, for test and
+// submission signatures whose length is only known at run time.
+class Bitset {
+ public:
+  Bitset() = default;
+  explicit Bitset(std::size_t size) : size_(size), words_(word_count(size)) {}
+  // Adopts `words`, which must hold word_count(size) words with the bits
+  // past `size` clear.
+  Bitset(std::size_t size, std::vector<std::uint64_t> words)
+      : size_(size), words_(std::move(words)) {
+    words_.resize(word_count(size));
+  }
+
+  std::size_t size() const { return size_; }
+
+  void set(std::size_t i) { words_[i / 64] |= std::uint64_t{1} << (i % 64); }
+  void reset(std::size_t i) {
+    words_[i / 64] &= ~(std::uint64_t{1} << (i % 64));
+  }
+  bool test(std::size_t i) const {
+    return (words_[i / 64] >> (i % 64)) & 1;
+  }
+
+  std::size_t count() const {
+    std::size_t total = 0;
+    for (const auto w : words_) total += std::popcount(w);
+    return total;
+  }
+  bool any() const {
+    for (const auto w : words_) {
+      if (w != 0) return true;
+    }
+    return false;
+  }
+
+  // popcount(*this & other) without materializing the intermediate.
+  std::size_t count_and(const Bitset& other) const {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      total += std::popcount(words_[i] & other.words_[i]);
+    }
+    return total;
+  }
+
+  // popcount(*this & ~other) without materializing the intermediate.
+  std::size_t count_and_not(const Bitset& other) const {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      total += std::popcount(words_[i] & ~other.words_[i]);
+    }
+    return total;
+  }
+
+  Bitset& operator|=(const Bitset& other) {
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      words_[i] |= other.words_[i];
+    }
+    return *this;
+  }
+  Bitset& operator&=(const Bitset& other) {
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      words_[i] &= other.words_[i];
+    }
+    return *this;
+  }
+
+  bool operator==(const Bitset&) const = default;
+
+  const std::vector<std::uint64_t>& words() const { return words_; }
+
+  static std::size_t word_count(std::size_t bits) { return (bits + 63) / 64; }
+
+ private:
+  std::size_t size_ = 0;
+  std::vector<std::uint64_t> words_;
+};
+
+}  // namespace codecoach
@@ -0,0 +1,51 @@
+#include "common/durable_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <string>
+#include <system_error>
+
+namespace codecoach {
+
+void replace_file_synced(const std::filesystem::path& path,
+                         std::string_view data, std::string_view tmp_suffix) {
+  const std::string tmp = path.string() + std::string(tmp_suffix);
+  const auto fail = [&](int fd, const std::string& what) {
+    const int e = errno;
+    if (fd >= 0) ::close(fd);
+    ::unlink(tmp.c_str());
+    throw std::system_error(e, std::generic_category(), what);
+  };
+  const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                        0644);
+  if (fd < 0) fail(fd, "create " + tmp);
+  std::size_t written = 0;
+  while (written < data.size()) {
+    const ssize_t n =
+        ::write(fd, data.data() + written, data.size() - written);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) fail(fd, "write " + tmp);
+    written += static_cast<std::size_t>(n);
+  }
+  if (::fsync(fd) != 0) fail(fd, "sync " + tmp);
+  ::close(fd);
+  if (::rename(tmp.c_str(), path.c_str()) != 0) fail(-1, "rename " + tmp);
+  const auto parent =
+      path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+  const int dir = ::open(parent.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir < 0) {
+    throw std::system_error(errno, std::generic_category(),
+                            "open " + parent.string());
+  }
+  const int synced = ::fsync(dir);
+  const int e = errno;
+  ::close(dir);
+  if (synced != 0) {
+    throw std::system_error(e, std::generic_category(),
+                            "sync " + parent.string());
+  }
+}
+
+}  // namespace codecoach
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+namespace codecoach {
+
+// Replaces `path` with `data` durably: writes `path` + `tmp_suffix`,
+// fsyncs it, renames it over `path`, then fsyncs the directory so the
+// rename itself survives a crash. Readers see the old file or the new one,
+// never a truncated one. Callers writing the same path concurrently pass
+// distinct suffixes. Throws std::system_error; the temp file is removed.
+void replace_file_synced(const std::filesystem::path& path,
+                         std::string_view data,
+                         std::string_view tmp_suffix = ".tmp");
+
+}  // namespace codecoach
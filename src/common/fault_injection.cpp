@@ -0,0 +1,43 @@
+#include "common/fault_injection.h"
+
+namespace codecoach {
+
+void FaultInjector::arm(Fault fault, FaultSpec spec) {
+  std::lock_guard lock(mu_);
+  Slot& slot = slots_[static_cast<std::size_t>(fault)];
+  slot.spec = spec;
+  slot.armed.store(true, std::memory_order_relaxed);
+}
+
+void FaultInjector::disarm(Fault fault) {
+  slots_[static_cast<std::size_t>(fault)].armed.store(
+      false, std::memory_order_relaxed);
+}
+
+void FaultInjector::disarm_all() {
+  for (auto& slot : slots_) slot.armed.store(false, std::memory_order_relaxed);
+}
+
+std::optional<std::chrono::milliseconds> FaultInjector::fire(Fault fault) {
+  Slot& slot = slots_[static_cast<std::size_t>(fault)];
+  if (!slot.armed.load(std::memory_order_relaxed)) return std::nullopt;
+  std::lock_guard lock(mu_);
+  if (!slot.armed.load(std::memory_order_relaxed) ||
+      slot.fired >= slot.spec.limit) {
+    return std::nullopt;
+  }
+  if (slot.spec.probability < 1.0 &&
+      std::uniform_real_distribution<double>(0.0, 1.0)(rng_) >=
+          slot.spec.probability) {
+    return std::nullopt;
+  }
+  ++slot.fired;
+  return slot.spec.delay;
+}
+
+std::uint64_t FaultInjector::fired(Fault fault) const {
+  std::lock_guard lock(mu_);
+  return slots_[static_cast<std::size_t>(fault)].fired;
+}
+
+}  // namespace codecoach
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string_view>
+
+namespace codecoach {
+
+// Failures the evaluator path can be made to suffer on purpose, to measure
+// throughput and recovery under them.
+enum class Fault : std::uint8_t {
+  kWorkerCrash = 0,   // A worker dies mid-job (judge::Evaluator).
+  kCompileDelay = 1,  // The compile tier stalls (compile::Compiler).
+  kDiskFull = 2,      // The compiler's output write fails with ENOSPC.
+  kCoachDrop = 3,     // The coach never answers (judge::Evaluator).
+};
+
+inline constexpr std::size_t kFaultCount = 4;
+
+constexpr std::string_view to_string(Fault fault) {
+  switch (fault) {
+    case Fault::kWorkerCrash: return "worker-crash";
+    case Fault::kCompileDelay: return "compile-delay";
+    case Fault::kDiskFull: return "disk-full";
+    case Fault::kCoachDrop: return "coach-drop";
+  }
+  return "unknown";
+}
+
+inline std::optional<Fault> fault_from_string(std::string_view name) {
+  for (std::size_t i = 0; i < kFaultCount; ++i) {
+    const auto fault = static_cast<Fault>(i);
+    if (to_string(fault) == name) return fault;
+  }
+  return std::nullopt;
+}
+
+struct FaultSpec {
+  // Chance of firing at each opportunity (each compile, each test run...).
+  double probability = 1.0;
+  // How long the fault holds things up: the stall for kCompileDelay, the
+  // time spent waiting for an answer for kCoachDrop. Ignored otherwise.
+  std::chrono::milliseconds delay{0};
+  // Stops firing after this many times.
+  std::uint64_t limit = std::numeric_limits<std::uint64_t>::max();
+};
+
+// Process-local switchboard of armed faults. Components that support
+// injection take a FaultInjector* (null: never fails) and ask fire() at
+// each opportunity. Draws come from a seeded generator, so a run with the
+// same seed and the same order of opportunities fails the same way.
+// Thread-safe; fire() on an unarmed fault is one relaxed atomic load.
+class FaultInjector {
+ public:
+  explicit FaultInjector(std::uint64_t seed = 1) : rng_(seed) {}
+
+  void arm(Fault fault, FaultSpec spec);
+  void disarm(Fault fault);
+  void disarm_all();
+
+  // Whether `fault` fires at this opportunity; when it does, returns the
+  // spec's delay for the caller to apply.
+  std::optional<std::chrono::milliseconds> fire(Fault fault);
+
+  std::uint64_t fired(Fault fault) const;
+
+ private:
+  struct Slot {
+    std::atomic<bool> armed{false};
+    FaultSpec spec;
+    std::uint64_t fired = 0;
+  };
+
+  mutable std::mutex mu_;
+  std::array<Slot, kFaultCount> slots_;
+  std::mt19937_64 rng_;
+};
+
+}  // namespace codecoach
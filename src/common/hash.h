@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace codecoach {
+
+// MurmurHash64A. Fast, well distributed, not cryptographic.
+inline std::uint64_t hash64(std::string_view data,
+                            std::uint64_t seed = 0) noexcept {
+  constexpr std::uint64_t m = 0xc6a4a7935bd1e995ULL;
+  constexpr int r = 47;
+  std::uint64_t h = seed ^ (data.size() * m);
+
+  const char* p = data.data();
+  const char* end = p + (data.size() & ~std::size_t{7});
+  for (; p != end; p += 8) {
+    std::uint64_t k;
+    std::memcpy(&k, p, sizeof(k));
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+  }
+  const auto tail = reinterpret_cast<const unsigned char*>(p);
+  switch (data.size() & 7) {
+    case 7: h ^= std::uint64_t{tail[6]} << 48; [[fallthrough]];
+    case 6: h ^= std::uint64_t{tail[5]} << 40; [[fallthrough]];
+    case 5: h ^= std::uint64_t{tail[4]} << 32; [[fallthrough]];
+    case 4: h ^= std::uint64_t{tail[3]} << 24; [[fallthrough]];
+    case 3: h ^= std::uint64_t{tail[2]} << 16; [[fallthrough]];
+    case 2: h ^= std::uint64_t{tail[1]} << 8; [[fallthrough]];
+    case 1:
+      h ^= std::uint64_t{tail[0]};
+      h *= m;
+  }
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
+
+// 128-bit content digest used for content-addressed keys (compile artifacts,
+// test blobs). Two independently seeded 64-bit hashes; collision odds are
+// negligible at catalog scale.
+struct Digest128 {
+  std::uint64_t hi = 0;
+  std::uint64_t lo = 0;
+
+  bool operator==(const Digest128&) const = default;
+  auto operator<=>(const Digest128&) const = default;
+
+  std::string hex() const;
+  static std::optional<Digest128> from_hex(std::string_view hex);
+};
+
+struct Digest128Hash {
+  std::size_t operator()(const Digest128& d) const noexcept {
+    return static_cast<std::size_t>(d.lo);
+  }
+};
+
+inline Digest128 digest128(std::string_view data) noexcept {
+  return {hash64(data, 0x9e3779b97f4a7c15ULL),
+          hash64(data, 0xc2b2ae3d27d4eb4fULL)};
+}
+
+// Incremental digest over several fields; each field is length-prefixed so
+// ("ab", "c") and ("a", "bc") differ.
+class DigestBuilder {
+ public:
+  DigestBuilder& add(std::string_view field) {
+    const auto size = static_cast<std::uint64_t>(field.size());
+    buffer_.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    buffer_.append(field);
+    return *this;
+  }
+  Digest128 finish() const { return digest128(buffer_); }
+
+ private:
+  std::string buffer_;
+};
+
+inline std::string Digest128::hex() const {
+  static constexpr char kDigits[] = "0123456789abcdef";
+  std::string out(32, '0');
+  for (int i = 0; i < 16; ++i) {
+    out[15 - i] = kDigits[(hi >> (4 * i)) & 0xf];
+    out[31 - i] = kDigits[(lo >> (4 * i)) & 0xf];
+  }
+  return out;
+}
+
+inline std::optional<Digest128> Digest128::from_hex(std::string_view hex) {
+  if (hex.size() != 32) return std::nullopt;
+  std::array<std::uint64_t, 2> words{};
+  for (std::size_t i = 0; i < 32; ++i) {
+    const char c = hex[i];
+    std::uint64_t v;
+    if (c >= '0' && c <= '9') {
+      v = static_cast<std::uint64_t>(c - '0');
+    } else if (c >= 'a' && c <= 'f') {
+      v = static_cast<std::uint64_t>(c - 'a' + 10);
+    } else {
+      return std::nullopt;
+    }
+    words[i / 16] = (words[i / 16] << 4) | v;
+  }
+  return Digest128{words[0], words[1]};
+}
+
+}  // namespace codecoach
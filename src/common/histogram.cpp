@@ -0,0 +1,73 @@
+#include "common/histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace codecoach {
+
+std::size_t LatencyHistogram::index_of(std::uint64_t value) {
+  if (value < kSubBuckets) return static_cast<std::size_t>(value);
+  const int exponent = std::bit_width(value) - 1;
+  const int shift = exponent - kSubBucketBits;
+  const auto sub = static_cast<std::size_t>(value >> shift) - kSubBuckets;
+  return static_cast<std::size_t>(shift + 1) * kSubBuckets + sub;
+}
+
+std::uint64_t LatencyHistogram::upper_bound_of(std::size_t index) {
+  if (index < kSubBuckets) return index;
+  const std::size_t shift = index / kSubBuckets - 1;
+  const std::uint64_t lower = static_cast<std::uint64_t>(
+                                  kSubBuckets + index % kSubBuckets)
+                              << shift;
+  return lower + ((std::uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::record(std::uint64_t value, std::uint64_t count) {
+  if (count == 0) return;
+  buckets_[index_of(value)] += count;
+  count_ += count;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+  sum_ += static_cast<long double>(value) * count;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+  for (std::size_t i = 0; i < kBuckets; ++i) buckets_[i] += other.buckets_[i];
+  count_ += other.count_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+  sum_ += other.sum_;
+}
+
+void LatencyHistogram::clear() { *this = LatencyHistogram(); }
+
+double LatencyHistogram::mean() const {
+  return count_ == 0 ? 0.0 : static_cast<double>(sum_ / count_);
+}
+
+std::uint64_t LatencyHistogram::percentile(double q) const {
+  if (count_ == 0) return 0;
+  const auto target = std::max<std::uint64_t>(
+      1, static_cast<std::uint64_t>(
+             std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count_))));
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    seen += buckets_[i];
+    if (seen >= target) {
+      return std::clamp(upper_bound_of(i), min_, max_);
+    }
+  }
+  return max_;
+}
+
+double LatencyHistogram::fraction_above(std::uint64_t value) const {
+  if (count_ == 0) return 0.0;
+  std::uint64_t above = 0;
+  for (std::size_t i = index_of(value) + 1; i < kBuckets; ++i) {
+    above += buckets_[i];
+  }
+  return static_cast<double>(above) / static_cast<double>(count_);
+}
+
+}  // namespace codecoach
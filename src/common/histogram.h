@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace codecoach {
+
+// Streaming histogram of non-negative integer samples (latencies in
+// microseconds, typically) with bounded relative error: buckets are
+// log-linear, 32 per power of two, so any reported quantile is within
+// about 3% of the true sample value. Fixed 15 KB footprint, O(1) record,
+// mergeable across threads and time windows. Not thread-safe.
+class LatencyHistogram {
+ public:
+  void record(std::uint64_t value, std::uint64_t count = 1);
+  void merge(const LatencyHistogram& other);
+  void clear();
+
+  std::uint64_t count() const { return count_; }
+  std::uint64_t min() const { return count_ == 0 ? 0 : min_; }
+  std::uint64_t max() const { return max_; }
+  double mean() const;
+
+  // Smallest bucket bound with at least `q` (0..1) of the samples at or
+  // below it, clamped to the observed maximum. 0 when empty.
+  std::uint64_t percentile(double q) const;
+  // Fraction of samples above `value` (bucket-resolution).
+  double fraction_above(std::uint64_t value) const;
+
+ private:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr std::size_t kSubBuckets = std::size_t{1} << kSubBucketBits;
+  static constexpr std::size_t kBuckets = (64 - kSubBucketBits + 1) *
+                                          kSubBuckets;
+
+  static std::size_t index_of(std::uint64_t value);
+  static std::uint64_t upper_bound_of(std::size_t index);
+
+  std::array<std::uint64_t, kBuckets> buckets_{};
+  std::uint64_t count_ = 0;
+  std::uint64_t min_ = ~std::uint64_t{0};
+  std::uint64_t max_ = 0;
+  long double sum_ = 0;
+};
+
+}  // namespace codecoach
@@ -0,0 +1,307 @@
+#include "common/json.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+namespace codecoach::json {
+
+namespace {
+
+// Deeply nested input is rejected rather than risking stack exhaustion.
+constexpr int kMaxDepth = 256;
+
+class Parser {
+ public:
+  explicit Parser(std::string_view text) : text_(text) {}
+
+  Value parse_document() {
+    Value value = parse_value(0);
+    skip_ws();
+    if (pos_ != text_.size()) fail("trailing characters");
+    return value;
+  }
+
+ private:
+  [[noreturn]] void fail(const char* what) const {
+    throw ParseError(std::string(what) + " at offset " + std::to_string(pos_));
+  }
+
+  void skip_ws() {
+    while (pos_ < text_.size()) {
+      const char c = text_[pos_];
+      if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+      ++pos_;
+    }
+  }
+
+  char peek() {
+    skip_ws();
+    if (pos_ >= text_.size()) fail("unexpected end of input");
+    return text_[pos_];
+  }
+
+  void expect(char c) {
+    if (peek() != c) fail("unexpected character");
+    ++pos_;
+  }
+
+  bool consume_literal(std::string_view literal) {
+    if (text_.substr(pos_, literal.size()) != literal) return false;
+    pos_ += literal.size();
+    return true;
+  }
+
+  Value parse_value(int depth) {
+    if (depth > kMaxDepth) fail("nesting too deep");
+    switch (peek()) {
+      case '{': return parse_object(depth);
+      case '[': return parse_array(depth);
+      case '"': return parse_string();
+      case 't':
+        if (consume_literal("true")) return true;
+        break;
+      case 'f':
+        if (consume_literal("false")) return false;
+        break;
+      case 'n':
+        if (consume_literal("null")) return nullptr;
+        break;
+      default: return parse_number();
+    }
+    fail("invalid literal");
+  }
+
+  Value parse_object(int depth) {
+    expect('{');
+    Object object;
+    if (peek() == '}') {
+      ++pos_;
+      return object;
+    }
+    for (;;) {
+      if (peek() != '"') fail("expected object key");
+      std::string key = parse_string();
+      expect(':');
+      object.insert_or_assign(std::move(key), parse_value(depth + 1));
+      if (peek() == ',') {
+        ++pos_;
+        continue;
+      }
+      expect('}');
+      return object;
+    }
+  }
+
+  Value parse_array(int depth) {
+    expect('[');
+    Array array;
+    if (peek() == ']') {
+      ++pos_;
+      return array;
+    }
+    for (;;) {
+      array.push_back(parse_value(depth + 1));
+      if (peek() == ',') {
+        ++pos_;
+        continue;
+      }
+      expect(']');
+      return array;
+    }
+  }
+
+  unsigned parse_hex4() {
+    if (text_.size() - pos_ < 4) fail("truncated \\u escape");
+    unsigned value = 0;
+    const auto result = std::from_chars(text_.data() + pos_,
+                                        text_.data() + pos_ + 4, value, 16);
+    if (result.ptr != text_.data() + pos_ + 4) fail("bad \\u escape");
+    pos_ += 4;
+    return value;
+  }
+
+  static void append_utf8(std::string& out, unsigned cp) {
+    if (cp < 0x80) {
+      out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+      out += static_cast<char>(0xc0 | (cp >> 6));
+      out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+      out += static_cast<char>(0xe0 | (cp >> 12));
+      out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+      out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else {
+      out += static_cast<char>(0xf0 | (cp >> 18));
+      out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+      out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+      out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+  }
+
+  std::string parse_string() {
+    expect('"');
+    std::string out;
+    for (;;) {
+      // Copy the run up to the next quote or escape in one go.
+      const auto stop = text_.find_first_of("\"\\", pos_);
+      if (stop == std::string_view::npos) fail("unterminated string");
+      out.append(text_, pos_, stop - pos_);
+      pos_ = stop + 1;
+      if (text_[stop] == '"') return out;
+
+      if (pos_ >= text_.size()) fail("unterminated escape");
+      const char esc = text_[pos_++];
+      switch (esc) {
+        case '"': out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '/': out += '/'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+          unsigned cp = parse_hex4();
+          if (cp >= 0xd800 && cp < 0xdc00 && consume_literal("\\u")) {
+            const unsigned low = parse_hex4();
+            if (low < 0xdc00 || low >= 0xe000) fail("bad surrogate pair");
+            cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+          }
+          append_utf8(out, cp);
+          break;
+        }
+        default: fail("bad escape");
+      }
+    }
+  }
+
+  Value parse_number() {
+    const std::size_t start = pos_;
+    bool integral = true;
+    while (pos_ < text_.size()) {
+      const char c = text_[pos_];
+      if (c == '.' || c == 'e' || c == 'E') {
+        integral = false;
+      } else if (!(c == '-' || c == '+' || (c >= '0' && c <= '9'))) {
+        break;
+      }
+      ++pos_;
+    }
+    const char* first = text_.data() + start;
+    const char* last = text_.data() + pos_;
+    if (first == last) fail("expected value");
+    if (integral) {
+      std::int64_t i = 0;
+      const auto result = std::from_chars(first, last, i);
+      if (result.ec == std::errc() && result.ptr == last) return i;
+    }
+    double d = 0;
+    const auto result = std::from_chars(first, last, d);
+    if (result.ec != std::errc() || result.ptr != last) fail("bad number");
+    return d;
+  }
+
+  std::string_view text_;
+  std::size_t pos_ = 0;
+};
+
+void serialize_to(std::string& out, const Value& value) {
+  if (value.is_null()) {
+    out += "null";
+  } else if (value.is_bool()) {
+    out += value.as_bool() ? "true" : "false";
+  } else if (value.is_int()) {
+    out += std::to_string(value.as_int());
+  } else if (value.is_number()) {
+    const double d = value.as_double();
+    if (!std::isfinite(d)) {
+      out += "null";
+      return;
+    }
+    char buf[32];
+    const auto result = std::to_chars(buf, buf + sizeof(buf), d);
+    out.append(buf, result.ptr);
+  } else if (value.is_string()) {
+    append_quoted(out, value.as_string());
+  } else if (value.is_array()) {
+    out += '[';
+    bool first = true;
+    for (const auto& element : value.as_array()) {
+      if (!first) out += ',';
+      first = false;
+      serialize_to(out, element);
+    }
+    out += ']';
+  } else {
+    out += '{';
+    bool first = true;
+    for (const auto& [key, element] : value.as_object()) {
+      if (!first) out += ',';
+      first = false;
+      append_quoted(out, key);
+      out += ':';
+      serialize_to(out, element);
+    }
+    out += '}';
+  }
+}
+
+}  // namespace
+
+std::int64_t Value::as_int() const {
+  if (const auto* d = std::get_if<double>(&data_)) {
+    return static_cast<std::int64_t>(*d);
+  }
+  return std::get<std::int64_t>(data_);
+}
+
+double Value::as_double() const {
+  if (const auto* i = std::get_if<std::int64_t>(&data_)) {
+    return static_cast<double>(*i);
+  }
+  return std::get<double>(data_);
+}
+
+const Value* Value::find(std::string_view key) const {
+  const auto* object = std::get_if<Object>(&data_);
+  if (object == nullptr) return nullptr;
+  auto it = object->find(key);
+  return it == object->end() ? nullptr : &it->second;
+}
+
+Value parse(std::string_view text) { return Parser(text).parse_document(); }
+
+std::string serialize(const Value& value) {
+  std::string out;
+  serialize_to(out, value);
+  return out;
+}
+
+void append_quoted(std::string& out, std::string_view s) {
+  out.reserve(out.size() + s.size() + 2);
+  out += '"';
+  std::size_t run = 0;
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    const auto c = static_cast<unsigned char>(s[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    out.append(s, run, i - run);
+    run = i + 1;
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default: {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+        out += buf;
+      }
+    }
+  }
+  out.append(s, run, std::string_view::npos);
+  out += '"';
+}
+
+}  // namespace codecoach::json
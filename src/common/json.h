@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// Minimal JSON document model: enough for the public API, LSP traffic and
+// compiler diagnostics. Not tuned for speed; hot internal paths use the
+// binary codec in api/binary_codec.h instead.
+namespace codecoach::json {
+
+class ParseError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+class Value;
+using Array = std::vector<Value>;
+using Object = std::map<std::string, Value, std::less<>>;
+
+class Value {
+ public:
+  Value() = default;
+  Value(std::nullptr_t) {}
+  Value(bool b) : data_(b) {}
+  Value(int i) : data_(std::int64_t{i}) {}
+  Value(std::int64_t i) : data_(i) {}
+  Value(std::uint64_t i) : data_(static_cast<std::int64_t>(i)) {}
+  Value(double d) : data_(d) {}
+  Value(const char* s) : data_(std::string(s)) {}
+  Value(std::string s) : data_(std::move(s)) {}
+  Value(std::string_view s) : data_(std::string(s)) {}
+  Value(Array a) : data_(std::move(a)) {}
+  Value(Object o) : data_(std::move(o)) {}
+
+  bool is_null() const { return holds<std::nullptr_t>(); }
+  bool is_bool() const { return holds<bool>(); }
+  bool is_int() const { return holds<std::int64_t>(); }
+  bool is_number() const { return is_int() || holds<double>(); }
+  bool is_string() const { return holds<std::string>(); }
+  bool is_array() const { return holds<Array>(); }
+  bool is_object() const { return holds<Object>(); }
+
+  // Typed accessors throw std::bad_variant_access on a type mismatch.
+  bool as_bool() const { return std::get<bool>(data_); }
+  std::int64_t as_int() const;
+  double as_double() const;
+  const std::string& as_string() const { return std::get<std::string>(data_); }
+  const Array& as_array() const { return std::get<Array>(data_); }
+  Array& as_array() { return std::get<Array>(data_); }
+  const Object& as_object() const { return std::get<Object>(data_); }
+  Object& as_object() { return std::get<Object>(data_); }
+
+  // Object member lookup; returns nullptr if absent or not an object.
+  const Value* find(std::string_view key) const;
+
+ private:
+  template <typename T>
+  bool holds() const {
+    return std::holds_alternative<T>(data_);
+  }
+
+  std::variant<std::nullptr_t, bool, std::int64_t, double, std::string, Array,
+               Object>
+      data_;
+};
+
+Value parse(std::string_view text);
+std::string serialize(const Value& value);
+
+// Appends `s` as a quoted, escaped JSON string.
+void append_quoted(std::string& out, std::string_view s);
+
+}  // namespace codecoach::json
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace codecoach {
+
+// Read-only memory mapping of a whole file. The mapping is released when the
+// object is destroyed, so sharing it through a shared_ptr keeps it alive for
+// as long as any reader still holds views into it.
+class MappedFile {
+ public:
+  // Throws std::system_error if the file cannot be opened or mapped.
+  static MappedFile open(const std::filesystem::path& path);
+
+  MappedFile() = default;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  std::string_view bytes() const {
+    return {static_cast<const char*>(data_), size_};
+  }
+  std::size_t size() const { return size_; }
+
+  // Asks the kernel to start reading the whole file into the page cache.
+  void prefetch() const;
+
+ private:
+  MappedFile(void* data, std::size_t size) : data_(data), size_(size) {}
+  void reset() noexcept;
+
+  void* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+}  // namespace codecoach
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace codecoach {
+
+// Runs fn(i) for every i in [0, count) on up to `parallelism` threads.
+// Iterations are handed out one at a time, so uneven work balances itself.
+// The first exception thrown by any iteration is rethrown after all threads
+// have stopped; remaining iterations are skipped.
+template <typename Fn>
+void parallel_for(std::size_t count, std::size_t parallelism, Fn&& fn) {
+  if (count == 0) return;
+  parallelism = std::clamp<std::size_t>(parallelism, 1, count);
+  if (parallelism == 1) {
+    for (std::size_t i = 0; i < count; ++i) fn(i);
+    return;
+  }
+
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+  std::mutex error_mu;
+
+  const auto worker = [&] {
+    for (;;) {
+      const std::size_t i = next.fetch_add(1, std::memory_order_relaxed);
+      if (i >= count || failed.load(std::memory_order_relaxed)) return;
+      try {
+        fn(i);
+      } catch (...) {
+        std::lock_guard lock(error_mu);
+        if (!error) error = std::current_exception();
+        failed.store(true, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(parallelism - 1);
+  for (std::size_t t = 1; t < parallelism; ++t) threads.emplace_back(worker);
+  worker();
+  for (auto& thread : threads) thread.join();
+  if (error) std::rethrow_exception(error);
+}
+
+inline std::size_t default_parallelism() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+}  // namespace codecoach
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace codecoach {
+
+// popcount(a[i] & b[i]) summed over `words` words: the inner loop of every
+// co-occurrence count over bit columns. Uses an AVX2 nibble-lookup kernel
+// when the CPU has it, chosen at run time, otherwise scalar popcounts.
+std::uint64_t popcount_and(const std::uint64_t* a, const std::uint64_t* b,
+                           std::size_t words);
+
+}  // namespace codecoach
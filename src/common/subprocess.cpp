@@ -0,0 +1,275 @@
+#include "common/subprocess.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace codecoach {
+
+namespace {
+
+[[noreturn]] void throw_errno(const char* what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+class Fd {
+ public:
+  Fd() = default;
+  explicit Fd(int fd) : fd_(fd) {}
+  Fd(const Fd&) = delete;
+  Fd& operator=(const Fd&) = delete;
+  ~Fd() { reset(); }
+
+  int get() const { return fd_; }
+  void reset(int fd = -1) {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = fd;
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+struct Pipe {
+  Fd read;
+  Fd write;
+};
+
+void make_pipe(Pipe& p) {
+  int fds[2];
+  if (::pipe2(fds, O_CLOEXEC) != 0) throw_errno("pipe2");
+  p.read.reset(fds[0]);
+  p.write.reset(fds[1]);
+}
+
+std::chrono::microseconds to_micros(const timeval& tv) {
+  return std::chrono::seconds(tv.tv_sec) +
+         std::chrono::microseconds(tv.tv_usec);
+}
+
+// Blocks SIGPIPE on the calling thread while feeding a child's stdin, so a
+// child that exits without reading its input cannot kill the caller. A
+// pending SIGPIPE is consumed before the mask is restored.
+class SigpipeGuard {
+ public:
+  SigpipeGuard() {
+    sigemptyset(&pipe_set_);
+    sigaddset(&pipe_set_, SIGPIPE);
+    ::pthread_sigmask(SIG_BLOCK, &pipe_set_, &saved_);
+  }
+  ~SigpipeGuard() {
+    const timespec zero{0, 0};
+    while (::sigtimedwait(&pipe_set_, nullptr, &zero) > 0) {
+    }
+    ::pthread_sigmask(SIG_SETMASK, &saved_, nullptr);
+  }
+  SigpipeGuard(const SigpipeGuard&) = delete;
+  SigpipeGuard& operator=(const SigpipeGuard&) = delete;
+
+ private:
+  sigset_t pipe_set_;
+  sigset_t saved_;
+};
+
+// Child side of fork(): only async-signal-safe calls from here on, so no
+// allocation; `argv` is built by the parent.
+[[noreturn]] void exec_child(char* const* argv, const ProcessLimits& limits,
+                             const std::filesystem::path& cwd, Pipe& in,
+                             Pipe& out, Pipe& err, Pipe& exec_status,
+                             Pipe* go) {
+  ::setpgid(0, 0);
+  if (go != nullptr) {
+    // Wait for the parent's on_spawn; EOF is the signal.
+    ::close(go->write.get());
+    char byte;
+    while (::read(go->read.get(), &byte, 1) < 0 && errno == EINTR) {
+    }
+  }
+  ::dup2(in.read.get(), STDIN_FILENO);
+  ::dup2(out.write.get(), STDOUT_FILENO);
+  ::dup2(err.write.get(), STDERR_FILENO);
+  if (!cwd.empty() && ::chdir(cwd.c_str()) != 0) {
+    const int e = errno;
+    (void)!::write(exec_status.write.get(), &e, sizeof(e));
+    ::_exit(127);
+  }
+  if (limits.address_space_bytes != 0) {
+    const rlimit rl{limits.address_space_bytes, limits.address_space_bytes};
+    ::setrlimit(RLIMIT_AS, &rl);
+  }
+  ::execvp(argv[0], argv);
+  const int e = errno;
+  (void)!::write(exec_status.write.get(), &e, sizeof(e));
+  ::_exit(127);
+}
+
+}  // namespace
+
+ProcessResult run_process(const std::vector<std::string>& argv,
+                          std::string_view input, const ProcessLimits& limits,
+                          const std::filesystem::path& cwd,
+                          const std::function<void(int pid)>& on_spawn) {
+  if (argv.empty()) throw std::invalid_argument("run_process: empty argv");
+
+  Pipe in, out, err, exec_status, go;
+  make_pipe(in);
+  make_pipe(out);
+  make_pipe(err);
+  make_pipe(exec_status);
+  if (on_spawn) make_pipe(go);
+  std::vector<char*> args;
+  args.reserve(argv.size() + 1);
+  for (const auto& arg : argv) args.push_back(const_cast<char*>(arg.c_str()));
+  args.push_back(nullptr);
+
+  const auto start = std::chrono::steady_clock::now();
+  const pid_t pid = ::fork();
+  if (pid < 0) throw_errno("fork");
+  if (pid == 0) {
+    exec_child(args.data(), limits, cwd, in, out, err, exec_status,
+               on_spawn ? &go : nullptr);
+  }
+
+  in.read.reset();
+  out.write.reset();
+  err.write.reset();
+  exec_status.write.reset();
+  if (on_spawn) {
+    go.read.reset();
+    try {
+      on_spawn(pid);
+    } catch (...) {
+      ::kill(-pid, SIGKILL);
+      ::kill(pid, SIGKILL);
+      ::waitpid(pid, nullptr, 0);
+      throw;
+    }
+    go.write.reset();
+  }
+
+  int exec_errno = 0;
+  if (::read(exec_status.read.get(), &exec_errno, sizeof(exec_errno)) ==
+      sizeof(exec_errno)) {
+    ::waitpid(pid, nullptr, 0);
+    throw std::system_error(exec_errno, std::generic_category(),
+                            "exec " + argv[0]);
+  }
+
+  ProcessResult result;
+  const SigpipeGuard sigpipe_guard;
+  ::fcntl(in.write.get(), F_SETFL, O_NONBLOCK);
+  std::size_t written = 0;
+  if (input.empty()) in.write.reset();
+
+  bool killed = false;
+  const auto kill_group = [&] {
+    if (!killed) ::kill(-pid, SIGKILL);
+    killed = true;
+  };
+
+  while (out.read.get() >= 0 || err.read.get() >= 0) {
+    pollfd fds[3];
+    nfds_t n = 0;
+    for (const int fd : {out.read.get(), err.read.get()}) {
+      if (fd >= 0) fds[n++] = {fd, POLLIN, 0};
+    }
+    if (in.write.get() >= 0) fds[n++] = {in.write.get(), POLLOUT, 0};
+
+    int timeout_ms = -1;
+    if (limits.wall_time.count() > 0) {
+      const auto left =
+          limits.wall_time -
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start);
+      if (left.count() <= 0) {
+        result.timed_out = true;
+        kill_group();
+        break;
+      }
+      timeout_ms = static_cast<int>(left.count());
+    }
+
+    if (::poll(fds, n, timeout_ms) < 0) {
+      if (errno == EINTR) continue;
+      kill_group();
+      ::waitpid(pid, nullptr, 0);
+      throw_errno("poll");
+    }
+
+    for (nfds_t i = 0; i < n; ++i) {
+      if (fds[i].revents == 0) continue;
+      if (fds[i].fd == in.write.get()) {
+        const ssize_t w = ::write(fds[i].fd, input.data() + written,
+                                  input.size() - written);
+        if (w > 0) written += static_cast<std::size_t>(w);
+        // EPIPE (child stopped reading) is not an error for us.
+        if (w < 0 || written == input.size()) in.write.reset();
+        continue;
+      }
+      const bool is_out = fds[i].fd == out.read.get();
+      std::string& sink = is_out ? result.stdout_data : result.stderr_data;
+      char buf[65536];
+      const ssize_t r = ::read(fds[i].fd, buf, sizeof(buf));
+      if (r <= 0) {
+        (is_out ? out.read : err.read).reset();
+        continue;
+      }
+      sink.append(buf, static_cast<std::size_t>(r));
+      if (result.stdout_data.size() + result.stderr_data.size() >
+          limits.max_output_bytes) {
+        result.output_limit_exceeded = true;
+        kill_group();
+      }
+    }
+    if (result.output_limit_exceeded) break;
+  }
+  in.write.reset();
+
+  // A child can close its output and keep running; the wall-time limit
+  // holds until it is reaped.
+  int status = 0;
+  rusage usage{};
+  auto nap = std::chrono::microseconds(100);
+  while (true) {
+    const bool limited = limits.wall_time.count() > 0 && !killed;
+    const pid_t r = ::wait4(pid, &status, limited ? WNOHANG : 0, &usage);
+    if (r == pid) break;
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      throw_errno("wait4");
+    }
+    const auto left = limits.wall_time -
+                      std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - start);
+    if (left.count() <= 0) {
+      result.timed_out = true;
+      kill_group();
+      continue;
+    }
+    std::this_thread::sleep_for(std::min(nap, left));
+    nap = std::min(nap * 2, std::chrono::microseconds(10'000));
+  }
+
+  result.wall_time = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  result.cpu_time = to_micros(usage.ru_utime) + to_micros(usage.ru_stime);
+  result.max_rss_kb = static_cast<std::uint64_t>(usage.ru_maxrss);
+  if (WIFSIGNALED(status)) {
+    result.signal = WTERMSIG(status);
+  } else if (WIFEXITED(status)) {
+    result.exit_code = WEXITSTATUS(status);
+  }
+  return result;
+}
+
+}  // namespace codecoach
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace codecoach {
+
+struct ProcessLimits {
+  std::chrono::milliseconds wall_time{0};  // 0 = unlimited
+  std::uint64_t address_space_bytes = 0;   // 0 = unlimited
+  // Output beyond this is discarded and the process killed.
+  std::size_t max_output_bytes = 64u << 20;
+};
+
+struct ProcessResult {
+  int exit_code = -1;  // Valid when signal == 0.
+  int signal = 0;
+  bool timed_out = false;
+  bool output_limit_exceeded = false;
+  std::string stdout_data;
+  std::string stderr_data;
+  std::chrono::microseconds cpu_time{0};
+  std::chrono::microseconds wall_time{0};
+  std::uint64_t max_rss_kb = 0;
+
+  bool ok() const { return signal == 0 && exit_code == 0 && !timed_out; }
+};
+
+// Runs argv[0] (looked up on PATH) with `input` on stdin, capturing stdout
+// and stderr. The child runs in its own process group, which is killed as a
+// whole on timeout. Throws std::system_error if the process cannot be
+// started.
+//
+// `on_spawn`, if set, is called with the child's pid after fork() and
+// before the child execs, which waits until it returns; used to attach
+// per-process monitoring such as perf counters. If it throws, the child is
+// killed and the exception propagates.
+//
+// This is for trusted tooling (compilers, generators, offline analysis);
+// untrusted submissions on the live path run inside a Sandbox.
+ProcessResult run_process(const std::vector<std::string>& argv,
+                          std::string_view input = {},
+                          const ProcessLimits& limits = {},
+                          const std::filesystem::path& cwd = {},
+                          const std::function<void(int pid)>& on_spawn = {});
+
+}  // namespace codecoach
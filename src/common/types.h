@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace codecoach {
+
+using TenantId = std::uint32_t;
+using WorkerId = std::uint32_t;
+using JobId = std::uint64_t;
+
+// Latency class of a job. Interactive work (live interviews, "Run" in the
+// editor) is always dispatched ahead of batch work (homework submissions).
+enum class Priority : std::uint8_t {
+  kInteractive = 0,
+  kBatch = 1,
+};
+
+inline constexpr std::size_t kPriorityCount = 2;
+
+}  // namespace codecoach
@@ -0,0 +1,134 @@
+#include "compile/compile_cache.h"
+
+#include <mutex>
+#include <system_error>
+
+#include "common/parallel.h"
+
+namespace codecoach::compile {
+
+CompileCache::CompileCache(std::filesystem::path directory)
+    : directory_(std::move(directory)) {
+  std::filesystem::create_directories(directory_);
+}
+
+Digest128 CompileCache::key(std::string_view compiler,
+                            std::string_view pch_header,
+                            std::string_view source) {
+  return DigestBuilder().add(compiler).add(pch_header).add(source).finish();
+}
+
+std::filesystem::path CompileCache::artifact_path(const Digest128& key) const {
+  const std::string hex = key.hex();
+  // Two-level fan-out keeps directories small.
+  return directory_ / hex.substr(0, 2) / hex;
+}
+
+std::size_t CompileCache::persist_index(storage::LsmStore& store,
+                                        storage::AsyncWriter& writer,
+                                        std::string family,
+                                        std::size_t parallelism) {
+  std::vector<Entry> entries;
+  store.scan(family, "", [&](std::string_view key, std::string_view value) {
+    if (const auto digest = Digest128::from_hex(key)) {
+      entries.push_back({*digest, std::filesystem::path(value)});
+    }
+  });
+  persistent_ = PersistentIndex{&store, &writer, std::move(family)};
+  // Evicted artifacts may outlive their index entries; restore() skips
+  // those.
+  return restore(entries, parallelism);
+}
+
+bool CompileCache::contains(const Digest128& key) const {
+  const Shard& s = shard(key);
+  std::shared_lock lock(s.mu);
+  return s.map.contains(key);
+}
+
+std::optional<std::filesystem::path> CompileCache::lookup(
+    const Digest128& key) {
+  {
+    const Shard& s = shard(key);
+    std::shared_lock lock(s.mu);
+    auto it = s.map.find(key);
+    if (it != s.map.end()) return it->second;
+  }
+  std::error_code ec;
+  // Artifacts are renamed into place only once complete, so one sitting at
+  // the canonical path is valid even if this process never indexed it
+  // (another process built it, or the index was not restored).
+  auto path = artifact_path(key);
+  if (!std::filesystem::is_regular_file(path, ec)) return std::nullopt;
+  remember(key, path);
+  return path;
+}
+
+void CompileCache::remember(const Digest128& key,
+                            std::filesystem::path artifact) {
+  Shard& s = shard(key);
+  std::unique_lock lock(s.mu);
+  s.map.insert_or_assign(key, std::move(artifact));
+}
+
+void CompileCache::insert(const Digest128& key,
+                          std::filesystem::path artifact) {
+  if (persistent_) {
+    storage::WriteBatch batch;
+    batch.put(persistent_->family, key.hex(), artifact.string());
+    // Dropped under backlog: the entry is rebuilt by the next compile.
+    persistent_->writer->submit(std::move(batch));
+  }
+  remember(key, std::move(artifact));
+}
+
+void CompileCache::erase(const Digest128& key) {
+  if (persistent_) {
+    storage::WriteBatch batch;
+    batch.erase(persistent_->family, key.hex());
+    persistent_->writer->submit(std::move(batch));
+  }
+  Shard& s = shard(key);
+  std::unique_lock lock(s.mu);
+  s.map.erase(key);
+}
+
+std::vector<CompileCache::Entry> CompileCache::snapshot() const {
+  std::vector<Entry> entries;
+  for (const Shard& s : shards_) {
+    std::shared_lock lock(s.mu);
+    for (const auto& [key, artifact] : s.map) {
+      entries.push_back({key, artifact});
+    }
+  }
+  return entries;
+}
+
+std::size_t CompileCache::restore(const std::vector<Entry>& entries,
+                                  std::size_t parallelism) {
+  std::vector<char> present(entries.size(), 0);
+  // Stat calls dominate on a cold disk; spread them out.
+  parallel_for(entries.size(), parallelism, [&](std::size_t i) {
+    std::error_code ec;
+    present[i] = std::filesystem::is_regular_file(entries[i].artifact, ec);
+  });
+
+  std::size_t restored = 0;
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    if (!present[i]) continue;
+    remember(entries[i].key, entries[i].artifact);
+    ++restored;
+  }
+  return restored;
+}
+
+std::size_t CompileCache::size() const {
+  std::size_t total = 0;
+  for (const Shard& s : shards_) {
+    std::shared_lock lock(s.mu);
+    total += s.map.size();
+  }
+  return total;
+}
+
+}  // namespace codecoach::compile
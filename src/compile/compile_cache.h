@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "common/hash.h"
+#include "common/parallel.h"
+#include "storage/async_writer.h"
+#include "storage/lsm_store.h"
+
+namespace codecoach::compile {
+
+// Content-addressed index of compiled executables. Keys digest what
+// compile::Compiler builds with: its identity (compiler version and
+// flags), the precompiled header in use and the program text byte for
+// byte; values are artifact paths under the cache directory.
+//
+// The index itself lives in memory and is sharded to keep lookups from
+// contending; the artifacts are ordinary files so that the index can be
+// snapshotted and restored across restarts (see warmup/warm_state.h).
+// Optionally it is also persisted to a column family of an LSM store and
+// loaded from there at startup (persist_index()); lookups never wait on
+// the store.
+class CompileCache {
+ public:
+  struct Entry {
+    Digest128 key;
+    std::filesystem::path artifact;
+  };
+
+  explicit CompileCache(std::filesystem::path directory);
+
+  static Digest128 key(std::string_view compiler,
+                       std::string_view pch_header, std::string_view source);
+
+  // Where the artifact for `key` should be written before insert().
+  std::filesystem::path artifact_path(const Digest128& key) const;
+
+  // Makes `family` of `store` the index of record: loads the entries whose
+  // artifacts still exist into memory, and from then on queues inserts and
+  // erases on `writer`, off the compile path. Returns the number of
+  // entries loaded. Call before the cache is shared between threads.
+  std::size_t persist_index(storage::LsmStore& store,
+                            storage::AsyncWriter& writer, std::string family,
+                            std::size_t parallelism = default_parallelism());
+
+  // Whether `key` is indexed in memory. Touches neither the disk nor the
+  // persistent index, so it is cheap enough for the submit path.
+  bool contains(const Digest128& key) const;
+  // Falls back to the canonical artifact path on an in-memory miss.
+  std::optional<std::filesystem::path> lookup(const Digest128& key);
+  void insert(const Digest128& key, std::filesystem::path artifact);
+  void erase(const Digest128& key);
+
+  std::vector<Entry> snapshot() const;
+
+  // Re-populates the index from a snapshot, skipping entries whose artifact
+  // no longer exists. Returns the number of entries restored.
+  std::size_t restore(const std::vector<Entry>& entries,
+                      std::size_t parallelism);
+
+  std::size_t size() const;
+  const std::filesystem::path& directory() const { return directory_; }
+
+ private:
+  static constexpr std::size_t kShards = 16;
+
+  struct Shard {
+    mutable std::shared_mutex mu;
+    std::unordered_map<Digest128, std::filesystem::path, Digest128Hash> map;
+  };
+
+  struct PersistentIndex {
+    storage::LsmStore* store;
+    storage::AsyncWriter* writer;
+    std::string family;
+  };
+
+  // In memory only.
+  void remember(const Digest128& key, std::filesystem::path artifact);
+
+  Shard& shard(const Digest128& key) { return shards_[key.hi % kShards]; }
+  const Shard& shard(const Digest128& key) const {
+    return shards_[key.hi % kShards];
+  }
+
+  std::filesystem::path directory_;
+  std::array<Shard, kShards> shards_;
+  std::optional<PersistentIndex> persistent_;
+};
+
+}  // namespace codecoach::compile
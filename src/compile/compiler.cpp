@@ -0,0 +1,175 @@
+#include "compile/compiler.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <system_error>
+#include <thread>
+
+#include "common/subprocess.h"
+
+namespace codecoach::compile {
+
+namespace {
+
+constexpr std::chrono::seconds kCompileTimeout{30};
+
+std::string compiler_version(const std::string& executable) {
+  try {
+    const auto result = run_process({executable, "--version"});
+    return result.stdout_data.substr(0, result.stdout_data.find('\n'));
+  } catch (const std::system_error&) {
+    return "unknown";
+  }
+}
+
+// Unique sibling path for writing an artifact before renaming it into place.
+std::filesystem::path temp_sibling(const std::filesystem::path& path) {
+  static std::atomic<unsigned> counter{0};
+  auto tmp = path;
+  tmp += ".tmp" + std::to_string(::getpid()) + "." +
+         std::to_string(counter.fetch_add(1));
+  return tmp;
+}
+
+// The I/O error a failed toolchain run reported on its own behalf (not
+// in a diagnostic about the source, which starts with "<stdin>:"), if
+// any: the host, not the submission, failed.
+std::optional<int> io_failure(std::string_view log) {
+  static constexpr int kErrors[] = {ENOSPC, EDQUOT, EIO, EROFS};
+  while (!log.empty()) {
+    const auto newline = log.find('\n');
+    const auto line = log.substr(0, newline);
+    log.remove_prefix(newline == std::string_view::npos ? log.size()
+                                                        : newline + 1);
+    if (line.starts_with("<stdin>:")) continue;
+    for (const int error : kErrors) {
+      if (line.find(std::strerror(error)) != std::string_view::npos) {
+        return error;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+Compiler::Compiler(CompilerConfig config, CompileCache& cache,
+                   PchRegistry& pch)
+    : config_(std::move(config)), cache_(cache), pch_(pch) {
+  identity_ = compiler_version(config_.executable);
+  for (const auto& flag : config_.flags) identity_ += " " + flag;
+}
+
+std::vector<std::string> Compiler::base_command() const {
+  std::vector<std::string> command{config_.executable};
+  command.insert(command.end(), config_.flags.begin(), config_.flags.end());
+  return command;
+}
+
+bool Compiler::ensure_pch() {
+  if (config_.pch_header.empty()) return false;
+  if (pch_.find(identity_)) return true;
+
+  // GCC uses <name>.gch in place of <name> when it was built with the same
+  // flags, so the PCH lives next to a one-line wrapper header.
+  const auto dir =
+      cache_.directory() / "pch" / digest128(identity_).hex();
+  std::filesystem::create_directories(dir);
+  const auto header = dir / "pch.h";
+  {
+    std::ofstream out(header, std::ios::trunc);
+    out << "#include <" << config_.pch_header << ">\n";
+  }
+  const auto gch = dir / "pch.h.gch";
+  std::error_code ec;
+  if (std::filesystem::is_regular_file(gch, ec)) {
+    pch_.set(identity_, gch);
+    return true;
+  }
+  const auto tmp = temp_sibling(gch);
+  auto command = base_command();
+  command.insert(command.end(),
+                 {"-x", "c++-header", header.string(), "-o", tmp.string()});
+  const auto result = run_process(command, {}, {.wall_time = kCompileTimeout});
+  if (!result.ok()) {
+    std::filesystem::remove(tmp);
+    return false;
+  }
+  std::filesystem::rename(tmp, gch);
+  pch_.set(identity_, gch);
+  return true;
+}
+
+Digest128 Compiler::cache_key(std::string_view source,
+                              const LocalIncludes* includes) const {
+  const auto key = CompileCache::key(identity_, config_.pch_header, source);
+  if (includes == nullptr) return key;
+  return DigestBuilder().add(key.hex()).add(includes->digest.hex()).finish();
+}
+
+bool Compiler::cached(std::string_view source) {
+  return cache_.contains(cache_key(source, nullptr));
+}
+
+CompileResult Compiler::compile(std::string_view source,
+                                const LocalIncludes* includes) {
+  const auto key = cache_key(source, includes);
+  if (auto artifact = cache_.lookup(key)) {
+    return {.ok = true, .cache_hit = true, .artifact = *artifact, .log = {}};
+  }
+
+  const auto artifact = cache_.artifact_path(key);
+  std::filesystem::create_directories(artifact.parent_path());
+  const auto tmp = temp_sibling(artifact);
+
+  auto command = base_command();
+  if (const auto gch = pch_.find(identity_)) {
+    auto header = *gch;
+    header.replace_extension();  // pch.h.gch -> pch.h
+    command.insert(command.end(), {"-include", header.string()});
+  }
+  if (includes != nullptr) {
+    command.insert(command.end(), {"-I", includes->dir.string()});
+  }
+  command.insert(command.end(), {"-x", "c++", "-", "-o", tmp.string()});
+
+  if (faults_ != nullptr) {
+    if (const auto delay = faults_->fire(Fault::kCompileDelay)) {
+      std::this_thread::sleep_for(*delay);
+    }
+  }
+  auto result = run_process(command, source, {.wall_time = kCompileTimeout});
+  if (faults_ != nullptr && faults_->fire(Fault::kDiskFull)) {
+    // The linker ran out of space writing the artifact.
+    result.exit_code = 1;
+    result.stderr_data += "ld: final link failed: ";
+    result.stderr_data += std::strerror(ENOSPC);
+    result.stderr_data += '\n';
+  }
+  CompileResult out;
+  out.log = result.stderr_data;
+  if (!result.ok()) {
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+    if (const auto error = io_failure(result.stderr_data)) {
+      throw std::system_error(*error, std::generic_category(),
+                              "compiling to " + tmp.string());
+    }
+    if (result.timed_out) out.log += "\ncompilation timed out";
+    return out;
+  }
+  // Rename last, so a concurrent compile of the same key never sees a
+  // partially written artifact.
+  std::filesystem::rename(tmp, artifact);
+  cache_.insert(key, artifact);
+  out.ok = true;
+  out.artifact = artifact;
+  return out;
+}
+
+}  // namespace codecoach::compile
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/fault_injection.h"
+#include "common/hash.h"
+#include "compile/compile_cache.h"
+#include "compile/pch_registry.h"
+
+namespace codecoach::compile {
+
+struct CompilerConfig {
+  std::string executable = "g++";
+  std::vector<std::string> flags = {"-std=c++20", "-O2", "-pipe"};
+  // Header precompiled once per configuration and force-included into every
+  // translation unit. Empty disables PCH.
+  std::string pch_header = "bits/stdc++.h";
+};
+
+// Headers a source pulls in with `#include "..."` from its own directory,
+// which a source compiled from stdin has none of. `digest` covers their
+// contents: the source bytes alone no longer determine the program.
+struct LocalIncludes {
+  std::filesystem::path dir;  // Passed as -I.
+  Digest128 digest;
+};
+
+struct CompileResult {
+  bool ok = false;
+  bool cache_hit = false;
+  std::filesystem::path artifact;  // Valid when ok.
+  std::string log;                 // Compiler diagnostics.
+};
+
+// Compiles C++ sources through the content-addressed CompileCache. Identical
+// sources under the same configuration compile once; later requests are a
+// cache lookup. Thread-safe: many compiles may run concurrently.
+class Compiler {
+ public:
+  Compiler(CompilerConfig config, CompileCache& cache, PchRegistry& pch);
+
+  // Whether submissions in `language` (api::SubmitRequest::language) are
+  // this compiler's to build: C++ only.
+  static bool accepts(std::string_view language) {
+    return language == "cpp" || language == "c++";
+  }
+
+  // Honors Fault::kCompileDelay and Fault::kDiskFull on cache misses. Must
+  // be set before concurrent compile() calls start.
+  void set_fault_injector(FaultInjector* faults) { faults_ = faults; }
+
+  // A failed compile is a compile error, with the compiler's log, unless
+  // the toolchain itself hit an I/O error (a full disk, say): that is the
+  // host's failure, thrown as std::system_error.
+  CompileResult compile(std::string_view source,
+                        const LocalIncludes* includes = nullptr);
+
+  // Whether compile(source) would be a cache hit, by the in-memory index
+  // alone: no compiling and no I/O, so it may run on the submit path.
+  bool cached(std::string_view source);
+
+  // Builds the precompiled header for this configuration if the registry
+  // has none. Returns false (and compiles without PCH) if that fails.
+  bool ensure_pch();
+
+  // Configuration identity: compiler version and flags. Keys both the
+  // compile cache and the PCH registry.
+  const std::string& identity() const { return identity_; }
+
+  // The indexes behind this compiler, for warm-state snapshots.
+  CompileCache& cache() const { return cache_; }
+  PchRegistry& pch() const { return pch_; }
+
+ private:
+  std::vector<std::string> base_command() const;
+  Digest128 cache_key(std::string_view source,
+                      const LocalIncludes* includes) const;
+
+  CompilerConfig config_;
+  CompileCache& cache_;
+  PchRegistry& pch_;
+  FaultInjector* faults_ = nullptr;
+  std::string identity_;
+};
+
+}  // namespace codecoach::compile
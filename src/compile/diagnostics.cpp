@@ -0,0 +1,578 @@
+#include "compile/diagnostics.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <optional>
+
+#include "common/json.h"
+
+namespace codecoach::compile {
+
+namespace {
+
+struct KnownPattern {
+  std::string_view id;
+  std::string_view needle;  // Substring of the message.
+  std::string_view hint;
+};
+
+// Ordered: the first match wins, so specific needles precede general ones.
+constexpr std::array<KnownPattern, 18> kPatterns = {{
+    {"missing-less", "no match for 'operator<'",
+     "type has no operator<, which sort, set, map and priority_queue need"},
+    {"missing-operator", "no match for 'operator",
+     "operator is not defined for these operand types"},
+    {"undeclared", "was not declared in this scope",
+     "name used before its declaration, misspelled, or missing std::"},
+    {"undeclared", "use of undeclared identifier",
+     "name used before its declaration, misspelled, or missing std::"},
+    {"not-a-type", "does not name a type",
+     "unknown type name: typo, missing std:: or used before declared"},
+    {"no-member", "has no member named",
+     "member does not exist on this type (typo or wrong type)"},
+    {"no-matching-call", "no matching function for call to",
+     "arguments do not fit any overload"},
+    {"no-matching-call", "no matching member function for call to",
+     "arguments do not fit any overload"},
+    {"const-call", "discards qualifiers",
+     "non-const member called on a const object; mark the member const"},
+    {"deleted-function", "use of deleted function",
+     "copies a non-copyable type or calls a deleted overload"},
+    {"conversion", "invalid conversion from",
+     "value of the wrong type; check the declared types"},
+    {"conversion", "cannot convert",
+     "value of the wrong type; check the declared types"},
+    {"missing-semicolon", "expected ';'", "missing ';' on the line before"},
+    {"missing-semicolon", "or ';' before", "missing ';' on the line before"},
+    {"redefinition", "redefinition of",
+     "same name defined twice in one scope"},
+    {"redefinition", "conflicting declaration",
+     "same name declared twice with different types"},
+    {"incomplete-type", "incomplete type",
+     "type used before its full definition or missing #include"},
+    {"undefined-reference", "undefined reference to",
+     "declared but never defined (or main is missing)"},
+}};
+
+const KnownPattern* match_pattern(std::string_view message) {
+  for (const auto& pattern : kPatterns) {
+    if (message.find(pattern.needle) != std::string_view::npos) {
+      return &pattern;
+    }
+  }
+  return nullptr;
+}
+
+bool parse_number(std::string_view text, std::uint32_t& out) {
+  const auto result =
+      std::from_chars(text.data(), text.data() + text.size(), out);
+  return !text.empty() && result.ec == std::errc() &&
+         result.ptr == text.data() + text.size();
+}
+
+// Splits "FILE:LINE:COL" or "FILE:LINE" (with neither number, just FILE).
+SourceLocation parse_location(std::string_view text) {
+  SourceLocation location;
+  const auto last = text.rfind(':');
+  std::uint32_t number = 0;
+  if (last != std::string_view::npos &&
+      parse_number(text.substr(last + 1), number)) {
+    const auto prev = text.rfind(':', last - 1);
+    std::uint32_t line = 0;
+    if (prev != std::string_view::npos && last > 0 &&
+        parse_number(text.substr(prev + 1, last - prev - 1), line)) {
+      location.file = std::string(text.substr(0, prev));
+      location.line = line;
+      location.column = number;
+    } else {
+      location.file = std::string(text.substr(0, last));
+      location.line = number;
+    }
+  } else {
+    location.file = std::string(text);
+  }
+  return location;
+}
+
+// Index of the bracket closing the one at `open`, or npos.
+std::size_t matching(std::string_view s, std::size_t open, char left,
+                     char right) {
+  int depth = 0;
+  for (std::size_t i = open; i < s.size(); ++i) {
+    if (s[i] == left) ++depth;
+    if (s[i] == right && --depth == 0) return i;
+  }
+  return std::string_view::npos;
+}
+
+// '<' opening a template argument list, as opposed to an operator name or
+// a comparison.
+bool opens_template(std::string_view s, std::size_t i) {
+  if (i == 0) return false;
+  const char before = s[i - 1];
+  if (!std::isalnum(static_cast<unsigned char>(before)) && before != '_') {
+    return false;
+  }
+  return i < 8 || s.substr(i - 8, 8) != "operator";
+}
+
+void replace_all(std::string& s, std::string_view from, std::string_view to) {
+  for (std::size_t at = s.find(from); at != std::string::npos;
+       at = s.find(from, at + to.size())) {
+    s.replace(at, from.size(), to);
+  }
+}
+
+void strip_with_clauses(std::string& s) {
+  for (std::size_t at = s.find(" [with "); at != std::string::npos;
+       at = s.find(" [with ", at)) {
+    const auto end = matching(s, at + 1, '[', ']');
+    s.erase(at, end == std::string::npos ? std::string::npos : end - at + 1);
+  }
+}
+
+// Drops ", std::allocator<...>" and similar defaulted arguments.
+void strip_default_arguments(std::string& s) {
+  for (const std::string_view name :
+       {", std::allocator<", ", std::less<", ", std::char_traits<",
+        ", std::hash<", ", std::equal_to<", ", std::default_delete<"}) {
+    for (std::size_t at = s.find(name); at != std::string::npos;
+         at = s.find(name, at)) {
+      const auto end = matching(s, at + name.size() - 1, '<', '>');
+      if (end == std::string::npos) break;
+      s.erase(at, end - at + 1);
+    }
+  }
+}
+
+// Library entry point from an instantiation frame's signature, e.g.
+// "constexpr void std::sort(_RAIter, _RAIter)" -> "std::sort".
+std::string function_name(std::string_view signature) {
+  std::size_t paren = std::string_view::npos;
+  int depth = 0;
+  for (std::size_t i = 0; i < signature.size(); ++i) {
+    const char c = signature[i];
+    if (c == '<' && opens_template(signature, i)) ++depth;
+    if (c == '>' && depth > 0) --depth;
+    if (c == '(' && depth == 0) {
+      paren = i;
+      break;
+    }
+  }
+  if (paren == std::string_view::npos) return {};
+  std::size_t start = paren;
+  depth = 0;
+  while (start > 0) {
+    const char c = signature[start - 1];
+    if (c == '>') ++depth;
+    if (c == '<') --depth;
+    if (c == ' ' && depth == 0) break;
+    --start;
+  }
+  std::string name;
+  depth = 0;
+  for (const char c : signature.substr(start, paren - start)) {
+    if (c == '<') ++depth;
+    if (depth == 0) name += c;
+    if (c == '>') --depth;
+  }
+  return name;
+}
+
+struct Frame {
+  SourceLocation location;
+  std::string function;  // Empty for "required from here".
+};
+
+struct Raw {
+  bool error = true;
+  SourceLocation location;
+  std::string message;
+  std::vector<Frame> frames;  // Innermost first.
+  std::uint32_t notes = 0;
+};
+
+std::string quoted_function(std::string_view text) {
+  const auto open = text.find('\'');
+  const auto close = text.rfind('\'');
+  if (open == std::string_view::npos || close <= open) return {};
+  std::string inner(text.substr(open + 1, close - open - 1));
+  strip_with_clauses(inner);
+  return function_name(inner);
+}
+
+// GCC and Clang text output. Instantiation context comes before the error
+// in GCC ("In instantiation of", "required from") and after it in Clang
+// (notes ending "requested here").
+std::vector<Raw> parse_text(std::string_view log) {
+  std::vector<Raw> raws;
+  std::vector<Frame> pending;
+  while (!log.empty()) {
+    const auto newline = log.find('\n');
+    const auto line = log.substr(0, newline);
+    log.remove_prefix(newline == std::string_view::npos ? log.size()
+                                                        : newline + 1);
+    if (line.empty() || line.front() == ' ') continue;  // Source excerpts.
+    if (line.starts_with("In file included from")) continue;
+
+    if (line.find(": In ") != std::string_view::npos &&
+        line.find(": error: ") == std::string_view::npos) {
+      pending.clear();
+      continue;
+    }
+    if (line.find("undefined reference to") != std::string_view::npos) {
+      Raw raw;
+      raw.message = std::string(line.substr(line.find("undefined reference")));
+      raws.push_back(std::move(raw));
+      continue;
+    }
+
+    const auto required = line.find(":   required ");
+    const auto recursive = line.find(":   recursively required ");
+    if (required != std::string_view::npos ||
+        recursive != std::string_view::npos) {
+      const auto at = std::min(required, recursive);
+      pending.push_back({parse_location(line.substr(0, at)),
+                         line.ends_with("required from here")
+                             ? std::string()
+                             : quoted_function(line.substr(at))});
+      continue;
+    }
+
+    static constexpr std::array<std::pair<std::string_view, int>, 4> kinds = {
+        {{": fatal error: ", 0}, {": error: ", 0}, {": warning: ", 1},
+         {": note: ", 2}}};
+    std::size_t at = std::string_view::npos;
+    std::string_view tag;
+    int kind = -1;
+    for (const auto& [text, k] : kinds) {
+      const auto found = line.find(text);
+      if (found < at) {
+        at = found;
+        tag = text;
+        kind = k;
+      }
+    }
+    if (kind < 0) continue;
+    const auto location = parse_location(line.substr(0, at));
+    const auto message = line.substr(at + tag.size());
+    if (kind == 2) {
+      if (raws.empty()) continue;
+      Raw& last = raws.back();
+      if (message.find("requested here") != std::string_view::npos) {
+        last.frames.push_back({location, quoted_function(message)});
+      } else {
+        ++last.notes;
+      }
+      continue;
+    }
+    // The linker's exit status restates errors already reported.
+    if (location.file == "collect2" || location.file.ends_with("ld")) {
+      if (message.find("returned") != std::string_view::npos) continue;
+    }
+    Raw raw;
+    raw.error = kind == 0;
+    raw.location = location;
+    raw.message = std::string(message);
+    raw.frames = std::move(pending);
+    pending.clear();
+    raws.push_back(std::move(raw));
+  }
+  return raws;
+}
+
+SourceLocation json_location(const json::Value& diagnostic) {
+  SourceLocation location;
+  const auto* locations = diagnostic.find("locations");
+  if (locations == nullptr || !locations->is_array() ||
+      locations->as_array().empty()) {
+    return location;
+  }
+  const auto* caret = locations->as_array().front().find("caret");
+  if (caret == nullptr) return location;
+  if (const auto* file = caret->find("file"); file && file->is_string()) {
+    location.file = file->as_string();
+  }
+  if (const auto* line = caret->find("line"); line && line->is_int()) {
+    location.line = static_cast<std::uint32_t>(line->as_int());
+  }
+  if (const auto* column = caret->find("column"); column && column->is_int()) {
+    location.column = static_cast<std::uint32_t>(column->as_int());
+  }
+  return location;
+}
+
+// GCC's -fdiagnostics-format=json: top-level diagnostics with notes as
+// children.
+std::vector<Raw> parse_json(const json::Value& document) {
+  std::vector<Raw> raws;
+  for (const json::Value& diagnostic : document.as_array()) {
+    const auto* kind = diagnostic.find("kind");
+    const auto* message = diagnostic.find("message");
+    if (kind == nullptr || message == nullptr || !message->is_string()) {
+      continue;
+    }
+    if (kind->as_string() == "note") continue;
+    Raw raw;
+    raw.error = kind->as_string() != "warning";
+    raw.location = json_location(diagnostic);
+    raw.message = message->as_string();
+    if (const auto* children = diagnostic.find("children");
+        children != nullptr && children->is_array()) {
+      raw.notes = static_cast<std::uint32_t>(children->as_array().size());
+    }
+    raws.push_back(std::move(raw));
+  }
+  return raws;
+}
+
+// Shape of a message for the unknown-pattern tally: quoted names elided.
+std::string message_shape(std::string_view message) {
+  std::string shape;
+  bool quoted = false;
+  for (const char c : message) {
+    if (c == '\'') {
+      quoted = !quoted;
+      if (quoted) shape += "'...'";
+      continue;
+    }
+    if (!quoted) shape += c;
+  }
+  return shape;
+}
+
+}  // namespace
+
+bool SourceLocation::in_user_code() const {
+  return !file.empty() && file.front() != '/' && file != "collect2";
+}
+
+std::string shorten_types(std::string_view message) {
+  std::string s(message);
+  strip_with_clauses(s);
+  // Trailing option tags such as " [-fpermissive]".
+  if (s.ends_with(']')) {
+    if (const auto at = s.rfind(" [-"); at != std::string::npos) s.erase(at);
+  }
+  replace_all(s, "std::__cxx11::", "std::");
+  replace_all(s, "std::basic_string<char>", "std::string");
+  strip_default_arguments(s);
+  replace_all(s, " >", ">");
+
+  std::string out;
+  int depth = 0;
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    const char c = s[i];
+    if (c == '<' && opens_template(s, i)) {
+      if (++depth == 3) out += "<...";
+      if (depth >= 3) continue;
+    } else if (c == '>' && depth > 0) {
+      if (depth-- >= 3) {
+        if (depth == 2) out += '>';
+        continue;
+      }
+    } else if (depth >= 3) {
+      continue;
+    }
+    out += c;
+  }
+  constexpr std::size_t kMaxMessage = 240;
+  if (out.size() > kMaxMessage) {
+    out.resize(kMaxMessage - 3);
+    out += "...";
+  }
+  return out;
+}
+
+DiagnosticSummary summarize_diagnostics(std::string_view log) {
+  DiagnosticSummary summary;
+  summary.log_bytes = log.size();
+  std::vector<Raw> raws;
+  const auto first = log.find_first_not_of(" \t\r\n");
+  if (first != std::string_view::npos && log[first] == '[') {
+    try {
+      raws = parse_json(json::parse(log));
+    } catch (const std::exception&) {
+      raws = parse_text(log);
+    }
+  } else {
+    raws = parse_text(log);
+  }
+
+  std::vector<RootCause> errors;
+  std::vector<RootCause> warnings;
+  for (Raw& raw : raws) {
+    (raw.error ? summary.errors : summary.warnings) += 1;
+    RootCause cause;
+    cause.error = raw.error;
+    cause.location = raw.location;
+    cause.frames_omitted = static_cast<std::uint32_t>(raw.frames.size());
+    cause.notes_omitted = raw.notes;
+    if (!raw.location.in_user_code()) {
+      // Innermost user frame; the library frame just before it is what
+      // the user called.
+      for (std::size_t i = 0; i < raw.frames.size(); ++i) {
+        if (!raw.frames[i].location.in_user_code()) continue;
+        cause.location = raw.frames[i].location;
+        for (std::size_t j = i; j-- > 0;) {
+          if (!raw.frames[j].function.empty()) {
+            cause.via = raw.frames[j].function;
+            break;
+          }
+        }
+        break;
+      }
+    }
+    cause.message = shorten_types(raw.message);
+    if (const auto* pattern = match_pattern(raw.message)) {
+      cause.pattern = std::string(pattern->id);
+    }
+
+    auto& list = raw.error ? errors : warnings;
+    const auto same = std::find_if(list.begin(), list.end(),
+                                   [&](const RootCause& other) {
+                                     return other.location.line ==
+                                                cause.location.line &&
+                                            other.location.file ==
+                                                cause.location.file &&
+                                            other.message == cause.message;
+                                   });
+    if (same != list.end()) {
+      ++same->occurrences;
+      same->notes_omitted += cause.notes_omitted;
+      same->frames_omitted += cause.frames_omitted;
+      continue;
+    }
+    list.push_back(std::move(cause));
+  }
+  summary.causes = std::move(errors);
+  summary.causes.insert(summary.causes.end(),
+                        std::make_move_iterator(warnings.begin()),
+                        std::make_move_iterator(warnings.end()));
+  return summary;
+}
+
+std::string_view pattern_hint(std::string_view pattern) {
+  for (const auto& known : kPatterns) {
+    if (known.id == pattern) return known.hint;
+  }
+  return {};
+}
+
+std::string render(const DiagnosticSummary& summary, std::size_t max_causes) {
+  std::string out = std::to_string(summary.errors) + " errors, " +
+                    std::to_string(summary.warnings) + " warnings, " +
+                    std::to_string(summary.causes.size()) + " root causes (" +
+                    std::to_string(summary.log_bytes) + " bytes of log)\n";
+  const std::size_t shown = std::min(summary.causes.size(), max_causes);
+  for (std::size_t i = 0; i < shown; ++i) {
+    const RootCause& cause = summary.causes[i];
+    out += cause.error ? "error" : "warning";
+    if (cause.location.line != 0) {
+      out += cause.location.in_user_code()
+                 ? " line "
+                 : " " + cause.location.file + ":";
+      out += std::to_string(cause.location.line);
+    }
+    out += ": ";
+    out += cause.message;
+    std::vector<std::string> extras;
+    if (!cause.via.empty()) extras.push_back("inside " + cause.via);
+    if (cause.occurrences > 1) {
+      extras.push_back("x" + std::to_string(cause.occurrences));
+    }
+    if (cause.notes_omitted != 0) {
+      extras.push_back(std::to_string(cause.notes_omitted) +
+                       (cause.notes_omitted == 1 ? " note" : " notes") +
+                       " omitted");
+    }
+    if (!extras.empty()) {
+      out += " [";
+      for (std::size_t e = 0; e < extras.size(); ++e) {
+        if (e != 0) out += "; ";
+        out += extras[e];
+      }
+      out += ']';
+    }
+    if (const auto hint = pattern_hint(cause.pattern); !hint.empty()) {
+      out += " -- ";
+      out += cause.pattern;
+      out += ": ";
+      out += hint;
+    }
+    out += '\n';
+  }
+  if (shown < summary.causes.size()) {
+    out += "(" + std::to_string(summary.causes.size() - shown) +
+           " more, likely follow-on errors)\n";
+  }
+  return out;
+}
+
+DiagnosticSummarizer::DiagnosticSummarizer(std::size_t capacity)
+    : capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+std::string DiagnosticSummarizer::summarize(std::string_view log) {
+  const Digest128 key = digest128(log);
+  {
+    std::lock_guard lock(mu_);
+    if (const auto it = index_.find(key); it != index_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      ++hits_;
+      return it->second->second;
+    }
+  }
+
+  const auto summary = summarize_diagnostics(log);
+  std::string rendered = render(summary);
+
+  std::lock_guard lock(mu_);
+  ++misses_;
+  for (const RootCause& cause : summary.causes) {
+    if (!cause.pattern.empty()) continue;
+    auto shape = message_shape(cause.message);
+    // Bounded like the summaries: once full, only known shapes count up.
+    if (const auto it = unknown_.find(shape); it != unknown_.end()) {
+      it->second += cause.occurrences;
+    } else if (unknown_.size() < capacity_) {
+      unknown_.emplace(std::move(shape), cause.occurrences);
+    }
+  }
+  if (index_.find(key) == index_.end()) {
+    lru_.emplace_front(key, rendered);
+    index_.emplace(key, lru_.begin());
+    if (lru_.size() > capacity_) {
+      index_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+  }
+  return rendered;
+}
+
+std::vector<std::pair<std::string, std::size_t>>
+DiagnosticSummarizer::unknown_patterns(std::size_t limit) const {
+  std::vector<std::pair<std::string, std::size_t>> out;
+  {
+    std::lock_guard lock(mu_);
+    out.assign(unknown_.begin(), unknown_.end());
+  }
+  std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) {
+    return a.second != b.second ? a.second > b.second : a.first < b.first;
+  });
+  if (out.size() > limit) out.resize(limit);
+  return out;
+}
+
+std::size_t DiagnosticSummarizer::hits() const {
+  std::lock_guard lock(mu_);
+  return hits_;
+}
+
+std::size_t DiagnosticSummarizer::misses() const {
+  std::lock_guard lock(mu_);
+  return misses_;
+}
+
+}  // namespace codecoach::compile
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/hash.h"
+
+namespace codecoach::compile {
+
+struct SourceLocation {
+  std::string file;  // Empty for linker and driver messages.
+  std::uint32_t line = 0;
+  std::uint32_t column = 0;
+
+  // The submission itself (compiled from stdin) or another relative path,
+  // as opposed to an absolute system or library header.
+  bool in_user_code() const;
+};
+
+// One root cause: a diagnostic with its template instantiation context and
+// candidate notes collapsed, merged with identical ones.
+struct RootCause {
+  bool error = true;  // Else a warning.
+  // In user code whenever any instantiation frame was: for errors inside
+  // the standard library, the line of the user's call that triggered them.
+  SourceLocation location;
+  std::string message;  // With type names shortened.
+  // Library function the user called to get there ("std::sort"); empty
+  // when the error is directly in user code.
+  std::string via;
+  std::string pattern;  // Known pattern id (see pattern_hint); may be empty.
+  std::uint32_t occurrences = 1;
+  std::uint32_t notes_omitted = 0;
+  std::uint32_t frames_omitted = 0;
+};
+
+struct DiagnosticSummary {
+  std::vector<RootCause> causes;  // Errors in log order, then warnings.
+  std::size_t errors = 0;         // Before merging.
+  std::size_t warnings = 0;
+  std::size_t log_bytes = 0;
+};
+
+// Parses GCC or Clang diagnostics, as plain text (the compile log) or as
+// GCC's -fdiagnostics-format=json array. GCC's JSON omits instantiation
+// context, so the text form gives better user locations.
+DiagnosticSummary summarize_diagnostics(std::string_view log);
+
+// Compact text for the coach: a one-line count, then one line per root
+// cause (at most `max_causes`), typically a few hundred bytes however
+// large the log was.
+std::string render(const DiagnosticSummary& summary,
+                   std::size_t max_causes = 5);
+
+// Short explanation of a known pattern id, or empty.
+std::string_view pattern_hint(std::string_view pattern);
+
+// Type names in compiler messages with default template arguments,
+// "[with ...]" bindings and nesting beyond two levels removed.
+std::string shorten_types(std::string_view message);
+
+// Memoized summarize + render. Students hit the same errors over and
+// over, so rendered summaries are kept per log digest (LRU), and messages
+// that match no known pattern are tallied by shape so the most common ones
+// can be added to the pattern table. Thread-safe.
+class DiagnosticSummarizer {
+ public:
+  explicit DiagnosticSummarizer(std::size_t capacity = 4096);
+
+  std::string summarize(std::string_view log);
+
+  // The most frequent unmatched message shapes (quoted names elided).
+  std::vector<std::pair<std::string, std::size_t>> unknown_patterns(
+      std::size_t limit) const;
+
+  std::size_t hits() const;
+  std::size_t misses() const;
+
+ private:
+  using Entry = std::pair<Digest128, std::string>;
+
+  std::size_t capacity_;
+  mutable std::mutex mu_;
+  std::list<Entry> lru_;  // Most recent first.
+  std::unordered_map<Digest128, std::list<Entry>::iterator, Digest128Hash>
+      index_;
+  std::unordered_map<std::string, std::size_t> unknown_;
+  std::size_t hits_ = 0;
+  std::size_t misses_ = 0;
+};
+
+}  // namespace codecoach::compile
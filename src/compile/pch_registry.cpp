@@ -0,0 +1,42 @@
+#include "compile/pch_registry.h"
+
+#include <system_error>
+
+namespace codecoach::compile {
+
+std::optional<std::filesystem::path> PchRegistry::find(
+    const std::string& config) const {
+  std::lock_guard lock(mu_);
+  auto it = artifacts_.find(config);
+  if (it == artifacts_.end()) return std::nullopt;
+  return it->second;
+}
+
+void PchRegistry::set(const std::string& config,
+                      std::filesystem::path artifact) {
+  std::lock_guard lock(mu_);
+  artifacts_.insert_or_assign(config, std::move(artifact));
+}
+
+std::vector<PchRegistry::Entry> PchRegistry::snapshot() const {
+  std::lock_guard lock(mu_);
+  std::vector<Entry> entries;
+  entries.reserve(artifacts_.size());
+  for (const auto& [config, artifact] : artifacts_) {
+    entries.push_back({config, artifact});
+  }
+  return entries;
+}
+
+std::size_t PchRegistry::restore(const std::vector<Entry>& entries) {
+  std::size_t restored = 0;
+  for (const auto& entry : entries) {
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(entry.artifact, ec)) continue;
+    set(entry.config, entry.artifact);
+    ++restored;
+  }
+  return restored;
+}
+
+}  // namespace codecoach::compile
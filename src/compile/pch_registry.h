@@ -0,0 +1,34 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace codecoach::compile {
+
+// Precompiled header artifacts, one per compiler configuration (compiler,
+// standard, optimization flags). A PCH is only usable with exactly the
+// configuration that produced it, so the configuration string is the key.
+class PchRegistry {
+ public:
+  struct Entry {
+    std::string config;
+    std::filesystem::path artifact;
+  };
+
+  std::optional<std::filesystem::path> find(const std::string& config) const;
+  void set(const std::string& config, std::filesystem::path artifact);
+
+  std::vector<Entry> snapshot() const;
+  // Restores entries whose artifact still exists; returns how many.
+  std::size_t restore(const std::vector<Entry>& entries);
+
+ private:
+  mutable std::mutex mu_;
+  std::unordered_map<std::string, std::filesystem::path> artifacts_;
+};
+
+}  // namespace codecoach::compile
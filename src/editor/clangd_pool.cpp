@@ -0,0 +1,353 @@
+#include "editor/clangd_pool.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <optional>
+
+#include "common/hash.h"
+#include "common/json.h"
+#include "editor/lsp_client.h"
+
+namespace codecoach::editor {
+
+namespace {
+
+// Slot text before a session claims it: enough to build the preamble.
+constexpr std::string_view kWarmText = "int main() {}\n";
+
+std::string config_key(const compile::CompilerConfig& config) {
+  std::string key = config.executable;
+  for (const auto& flag : config.flags) key += "\n" + flag;
+  key += "\n-include " + config.pch_header;
+  return key;
+}
+
+std::string file_uri(const std::filesystem::path& path) {
+  return "file://" + path.string();
+}
+
+json::Value text_document(const std::string& uri, std::int64_t version) {
+  json::Object document;
+  document["uri"] = uri;
+  document["version"] = version;
+  return document;
+}
+
+std::uint32_t one_based(const json::Value* value) {
+  if (value == nullptr || !value->is_int() || value->as_int() < 0) return 1;
+  return static_cast<std::uint32_t>(value->as_int() + 1);
+}
+
+std::vector<Diagnostic> parse_diagnostics(const json::Value& list) {
+  std::vector<Diagnostic> out;
+  if (!list.is_array()) return out;
+  for (const json::Value& item : list.as_array()) {
+    Diagnostic d;
+    if (const auto* severity = item.find("severity");
+        severity != nullptr && severity->is_int() && severity->as_int() >= 1 &&
+        severity->as_int() <= 4) {
+      d.severity = static_cast<Severity>(severity->as_int());
+    }
+    if (const auto* range = item.find("range")) {
+      if (const auto* start = range->find("start")) {
+        d.line = one_based(start->find("line"));
+        d.column = one_based(start->find("character"));
+      }
+    }
+    if (const auto* message = item.find("message");
+        message != nullptr && message->is_string()) {
+      d.message = message->as_string();
+    }
+    out.push_back(std::move(d));
+  }
+  return out;
+}
+
+}  // namespace
+
+bool CheckResult::has_errors() const {
+  return std::any_of(diagnostics.begin(), diagnostics.end(),
+                     [](const Diagnostic& d) {
+                       return d.severity == Severity::kError;
+                     });
+}
+
+class ClangdPool::Instance {
+ public:
+  Instance(const ClangdOptions& options,
+           const compile::CompilerConfig& config,
+           const std::filesystem::path& dir);
+
+  bool alive() const { return client_->alive(); }
+
+  CheckResult check(std::uint64_t session, std::string_view source,
+                    std::chrono::milliseconds timeout);
+  // Waits until every slot has published its first diagnostics, i.e. its
+  // preamble is built.
+  void wait_warm(std::chrono::milliseconds timeout);
+
+ private:
+  struct Slot {
+    std::string uri;
+    std::optional<std::uint64_t> session;
+    std::int64_t version = 1;    // Last sent.
+    std::int64_t published = 0;  // Last diagnosed.
+    std::vector<Diagnostic> diagnostics;
+    std::uint64_t last_used = 0;
+  };
+
+  void on_notification(std::string_view method, const json::Value& params);
+
+  std::mutex mu_;
+  std::condition_variable published_;
+  // Taken under mu_ and held across the send, so didChange versions reach
+  // the server in order without holding mu_, which the reader thread needs.
+  std::mutex send_mu_;
+  std::vector<Slot> slots_;
+  std::uint64_t clock_ = 0;
+  // Last member: its reader thread calls on_notification, so it must stop
+  // before the slots go away.
+  std::unique_ptr<LspClient> client_;
+};
+
+ClangdPool::Instance::Instance(const ClangdOptions& options,
+                               const compile::CompilerConfig& config,
+                               const std::filesystem::path& dir) {
+  std::filesystem::create_directories(dir);
+  // One compile command per slot, matching the compile tier's command line.
+  const std::size_t slot_count =
+      std::max<std::size_t>(options.slots_per_instance, 1);
+  json::Array commands;
+  for (std::size_t i = 0; i < slot_count; ++i) {
+    const auto file = dir / ("slot-" + std::to_string(i) + ".cpp");
+    std::ofstream(file) << kWarmText;
+    json::Array arguments = {config.executable};
+    for (const auto& flag : config.flags) arguments.emplace_back(flag);
+    if (!config.pch_header.empty()) {
+      arguments.emplace_back("-include");
+      arguments.emplace_back(config.pch_header);
+    }
+    arguments.emplace_back("-c");
+    arguments.emplace_back(file.string());
+    json::Object command;
+    command["directory"] = dir.string();
+    command["file"] = file.string();
+    command["arguments"] = std::move(arguments);
+    commands.emplace_back(std::move(command));
+    slots_.push_back(Slot{file_uri(file), std::nullopt, 1, 0, {}, 0});
+  }
+  {
+    const auto path = dir / "compile_commands.json";
+    std::ofstream out(path.string() + ".tmp", std::ios::trunc);
+    out << json::serialize(commands);
+    if (!out.flush()) throw LspError("cannot write " + path.string());
+    out.close();
+    std::filesystem::rename(path.string() + ".tmp", path);
+  }
+
+  // Let clangd ask the configured compiler for its system include paths,
+  // so libstdc++ headers resolve exactly as they do when judging.
+  auto argv = options.command;
+  const std::string driver =
+      config.executable.find('/') == std::string::npos
+          ? "**/" + config.executable
+          : config.executable;
+  argv.push_back("--query-driver=" + driver);
+  client_ = std::make_unique<LspClient>(
+      argv, dir, [this](std::string_view method, const json::Value& params) {
+        on_notification(method, params);
+      });
+
+  json::Object versioned;
+  versioned["versionSupport"] = true;
+  json::Object text_capabilities;
+  text_capabilities["publishDiagnostics"] = std::move(versioned);
+  json::Object capabilities;
+  capabilities["textDocument"] = std::move(text_capabilities);
+  json::Object init;
+  init["processId"] = static_cast<std::int64_t>(::getpid());
+  init["rootUri"] = file_uri(dir);
+  init["capabilities"] = std::move(capabilities);
+  client_->request("initialize", std::move(init), options.timeout);
+  client_->notify("initialized", json::Object{});
+
+  for (const Slot& slot : slots_) {
+    json::Object document;
+    document["uri"] = slot.uri;
+    document["languageId"] = "cpp";
+    document["version"] = std::int64_t{1};
+    document["text"] = kWarmText;
+    json::Object params;
+    params["textDocument"] = std::move(document);
+    client_->notify("textDocument/didOpen", std::move(params));
+  }
+}
+
+void ClangdPool::Instance::on_notification(std::string_view method,
+                                           const json::Value& params) {
+  if (method != "textDocument/publishDiagnostics") return;
+  const json::Value* uri = params.find("uri");
+  const json::Value* version = params.find("version");
+  const json::Value* diagnostics = params.find("diagnostics");
+  if (uri == nullptr || !uri->is_string() || version == nullptr ||
+      !version->is_int() || diagnostics == nullptr) {
+    return;
+  }
+  std::lock_guard lock(mu_);
+  for (Slot& slot : slots_) {
+    if (slot.uri != uri->as_string()) continue;
+    if (version->as_int() < slot.published) return;  // Stale.
+    slot.published = version->as_int();
+    slot.diagnostics = parse_diagnostics(*diagnostics);
+    published_.notify_all();
+    return;
+  }
+}
+
+CheckResult ClangdPool::Instance::check(std::uint64_t session,
+                                        std::string_view source,
+                                        std::chrono::milliseconds timeout) {
+  const auto start = std::chrono::steady_clock::now();
+  CheckResult result;
+  std::unique_lock lock(mu_);
+  auto it = std::find_if(slots_.begin(), slots_.end(),
+                         [&](const Slot& s) { return s.session == session; });
+  if (it == slots_.end()) {
+    it = std::min_element(slots_.begin(), slots_.end(),
+                          [](const Slot& a, const Slot& b) {
+                            return a.last_used < b.last_used;
+                          });
+    it->session = session;
+  }
+  Slot& slot = *it;
+  slot.last_used = ++clock_;
+  const std::int64_t version = ++slot.version;
+  const std::string uri = slot.uri;
+
+  std::unique_lock send_lock(send_mu_);
+  lock.unlock();
+  try {
+    json::Object change;
+    change["text"] = source;
+    json::Object params;
+    params["textDocument"] = text_document(uri, version);
+    params["contentChanges"] = json::Array{std::move(change)};
+    client_->notify("textDocument/didChange", std::move(params));
+  } catch (const LspError&) {
+    return result;
+  }
+  send_lock.unlock();
+
+  // Polls liveness between waits: a crashed server never publishes.
+  const auto deadline = start + timeout;
+  lock.lock();
+  while (slot.published < version && slot.version == version &&
+         std::chrono::steady_clock::now() < deadline) {
+    published_.wait_until(
+        lock, std::min(deadline, std::chrono::steady_clock::now() +
+                                     std::chrono::milliseconds(100)));
+    if (!client_->alive()) break;
+  }
+  result.ok = slot.published == version && slot.version == version;
+  if (result.ok) result.diagnostics = slot.diagnostics;
+  lock.unlock();
+  result.latency = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  return result;
+}
+
+void ClangdPool::Instance::wait_warm(std::chrono::milliseconds timeout) {
+  std::unique_lock lock(mu_);
+  published_.wait_for(lock, timeout, [&] {
+    return std::all_of(slots_.begin(), slots_.end(),
+                       [](const Slot& s) { return s.published > 0; });
+  });
+}
+
+ClangdPool::ClangdPool(ClangdOptions options) : options_(std::move(options)) {
+  options_.instances_per_config =
+      std::max<std::size_t>(options_.instances_per_config, 1);
+}
+
+ClangdPool::~ClangdPool() = default;
+
+std::shared_ptr<ClangdPool::Instance> ClangdPool::instance_for(
+    const compile::CompilerConfig& config, std::size_t index) {
+  const std::string key = config_key(config);
+  std::promise<std::shared_ptr<Instance>> started;
+  std::unique_lock lock(mu_);
+  auto& list = instances_[key];
+  if (list.empty()) list.resize(options_.instances_per_config);
+  // Stable: the list is sized once and map nodes do not move.
+  Slot& slot = list[index];
+  if (slot.instance && slot.instance->alive()) return slot.instance;
+  if (slot.starting.valid()) {
+    const auto starting = slot.starting;
+    lock.unlock();
+    return starting.get();  // Rethrows the starter's LspError.
+  }
+  // In-flight checks keep a replaced instance alive until they return.
+  slot.instance.reset();
+  slot.starting = started.get_future().share();
+  lock.unlock();
+
+  std::shared_ptr<Instance> instance;
+  try {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx",
+                  static_cast<unsigned long long>(hash64(key)));
+    instance = std::make_shared<Instance>(
+        options_, config,
+        options_.workspace_root / name / std::to_string(index));
+  } catch (...) {
+    lock.lock();
+    slot.starting = {};
+    lock.unlock();
+    started.set_exception(std::current_exception());
+    throw;
+  }
+  lock.lock();
+  slot.instance = instance;
+  slot.starting = {};
+  lock.unlock();
+  started.set_value(instance);
+  return instance;
+}
+
+CheckResult ClangdPool::check(const compile::CompilerConfig& config,
+                              std::uint64_t session,
+                              std::string_view source) {
+  const auto index = static_cast<std::size_t>(
+      hash64(std::string_view(reinterpret_cast<const char*>(&session),
+                              sizeof(session))) %
+      options_.instances_per_config);
+  return instance_for(config, index)->check(session, source,
+                                            options_.timeout);
+}
+
+void ClangdPool::prewarm(const compile::CompilerConfig& config) {
+  std::vector<std::shared_ptr<Instance>> started;
+  for (std::size_t i = 0; i < options_.instances_per_config; ++i) {
+    started.push_back(instance_for(config, i));
+  }
+  // Preambles build concurrently across instances; wait for all of them.
+  for (const auto& instance : started) instance->wait_warm(options_.timeout);
+}
+
+std::size_t ClangdPool::running_instances() const {
+  std::lock_guard lock(mu_);
+  std::size_t n = 0;
+  for (const auto& [key, list] : instances_) {
+    for (const Slot& slot : list) {
+      n += slot.instance && slot.instance->alive();
+    }
+  }
+  return n;
+}
+
+}  // namespace codecoach::editor
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "compile/compiler.h"
+
+namespace codecoach::editor {
+
+enum class Severity : std::uint8_t {
+  kError = 1,
+  kWarning = 2,
+  kInformation = 3,
+  kHint = 4,
+};
+
+struct Diagnostic {
+  Severity severity = Severity::kError;
+  std::uint32_t line = 0;    // 1-based.
+  std::uint32_t column = 0;  // 1-based, in UTF-16 units as LSP counts.
+  std::string message;
+};
+
+struct CheckResult {
+  // False if the diagnostics could not be produced for exactly this text:
+  // the server timed out or died, or a newer edit of the same session
+  // superseded it (that later check answers instead).
+  bool ok = false;
+  std::vector<Diagnostic> diagnostics;
+  std::chrono::microseconds latency{0};
+
+  bool has_errors() const;
+};
+
+struct ClangdOptions {
+  std::vector<std::string> command = {
+      "clangd", "--background-index=false", "--clang-tidy=false",
+      "--pch-storage=memory", "--log=error"};
+  // Each instance gets a workspace directory beneath this.
+  std::filesystem::path workspace_root;
+  std::size_t instances_per_config = 2;
+  // Open documents per instance. Each holds its own preamble, so this is
+  // how many editor sessions per instance skip the STL parse.
+  std::size_t slots_per_instance = 4;
+  std::chrono::milliseconds timeout{3000};
+};
+
+// Resident clangd instances serving editor diagnostics as the user types,
+// so compile errors surface before Run instead of as compile jobs in the
+// judge queue.
+//
+// Instances are keyed by compiler configuration and see the same flags
+// and force-included header (bits/stdc++.h) as the compile tier. That
+// header is part of every document's preamble, which clangd builds once
+// per document and reuses across edits; documents are therefore fixed
+// slots that sessions take over with a full-text change rather than new
+// files, so a new session inherits a warm preamble. Sessions stick to one
+// instance and slot while they stay recent; the least recently used slot
+// is reassigned. Dead instances are restarted on next use. Thread-safe.
+class ClangdPool {
+ public:
+  explicit ClangdPool(ClangdOptions options);
+  ~ClangdPool();
+  ClangdPool(const ClangdPool&) = delete;
+  ClangdPool& operator=(const ClangdPool&) = delete;
+
+  // Diagnostics for the current text of an editor session's document.
+  // Throws LspError only if an instance cannot be started.
+  CheckResult check(const compile::CompilerConfig& config,
+                    std::uint64_t session, std::string_view source);
+
+  // Starts every instance for `config` and builds the slot preambles, so
+  // the first keystrokes are served warm.
+  void prewarm(const compile::CompilerConfig& config);
+
+  std::size_t running_instances() const;
+
+ private:
+  class Instance;
+
+  struct Slot {
+    std::shared_ptr<Instance> instance;
+    // Valid while an instance is starting; callers for the slot wait on it
+    // instead of starting another.
+    std::shared_future<std::shared_ptr<Instance>> starting;
+  };
+
+  // Starts the instance, if needed, outside mu_: clangd takes a while, and
+  // other configurations and slots must not wait for it.
+  std::shared_ptr<Instance> instance_for(const compile::CompilerConfig& config,
+                                         std::size_t index);
+
+  ClangdOptions options_;
+  mutable std::mutex mu_;
+  std::unordered_map<std::string, std::vector<Slot>> instances_;
+};
+
+}  // namespace codecoach::editor
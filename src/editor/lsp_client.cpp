@@ -0,0 +1,310 @@
+#include "editor/lsp_client.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+
+namespace codecoach::editor {
+
+namespace {
+
+constexpr std::string_view kLengthHeader = "content-length:";
+
+bool starts_with_ignoring_case(std::string_view text, std::string_view prefix) {
+  if (text.size() < prefix.size()) return false;
+  for (std::size_t i = 0; i < prefix.size(); ++i) {
+    const char c = text[i];
+    if ((c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c) != prefix[i]) return false;
+  }
+  return true;
+}
+
+json::Value message(std::string_view method, json::Value params) {
+  json::Object object;
+  object["jsonrpc"] = "2.0";
+  object["method"] = method;
+  object["params"] = std::move(params);
+  return object;
+}
+
+}  // namespace
+
+std::string frame(std::string_view body) {
+  std::string out = "Content-Length: " + std::to_string(body.size());
+  out += "\r\n\r\n";
+  out += body;
+  return out;
+}
+
+std::optional<std::string> next_frame(std::string& buffer) {
+  const auto header_end = buffer.find("\r\n\r\n");
+  if (header_end == std::string::npos) return std::nullopt;
+  std::optional<std::size_t> length;
+  std::string_view headers(buffer.data(), header_end);
+  while (!headers.empty()) {
+    const auto eol = headers.find("\r\n");
+    const auto line = headers.substr(0, eol);
+    headers.remove_prefix(eol == std::string_view::npos ? headers.size()
+                                                        : eol + 2);
+    if (!starts_with_ignoring_case(line, kLengthHeader)) continue;
+    auto value = line.substr(kLengthHeader.size());
+    while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+    std::size_t n = 0;
+    const auto result =
+        std::from_chars(value.data(), value.data() + value.size(), n);
+    if (result.ec != std::errc() || result.ptr != value.data() + value.size()) {
+      throw LspError("bad Content-Length header");
+    }
+    length = n;
+  }
+  if (!length) throw LspError("message without Content-Length");
+  const std::size_t body_start = header_end + 4;
+  if (buffer.size() - body_start < *length) return std::nullopt;
+  std::string body = buffer.substr(body_start, *length);
+  buffer.erase(0, body_start + *length);
+  return body;
+}
+
+LspClient::LspClient(const std::vector<std::string>& argv,
+                     const std::filesystem::path& cwd,
+                     NotificationHandler on_notification)
+    : on_notification_(std::move(on_notification)) {
+  if (argv.empty()) throw LspError("empty server command");
+  int sv[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) {
+    throw LspError(std::string("socketpair: ") + std::strerror(errno));
+  }
+  int status[2];
+  if (::pipe2(status, O_CLOEXEC) != 0) {
+    const int e = errno;
+    ::close(sv[0]);
+    ::close(sv[1]);
+    throw LspError(std::string("pipe2: ") + std::strerror(e));
+  }
+  std::vector<char*> args;
+  for (const auto& arg : argv) args.push_back(const_cast<char*>(arg.c_str()));
+  args.push_back(nullptr);
+
+  const pid_t pid = ::fork();
+  if (pid == 0) {
+    // Child: only async-signal-safe calls from here on.
+    ::setpgid(0, 0);
+    ::dup2(sv[1], STDIN_FILENO);
+    ::dup2(sv[1], STDOUT_FILENO);
+    const int null = ::open("/dev/null", O_WRONLY);
+    if (null >= 0) ::dup2(null, STDERR_FILENO);
+    if (!cwd.empty() && ::chdir(cwd.c_str()) != 0) {
+      const int e = errno;
+      (void)!::write(status[1], &e, sizeof(e));
+      ::_exit(127);
+    }
+    ::execvp(args[0], args.data());
+    const int e = errno;
+    (void)!::write(status[1], &e, sizeof(e));
+    ::_exit(127);
+  }
+  const int fork_errno = errno;
+  ::close(sv[1]);
+  ::close(status[1]);
+  if (pid < 0) {
+    ::close(sv[0]);
+    ::close(status[0]);
+    throw LspError(std::string("fork: ") + std::strerror(fork_errno));
+  }
+  int exec_errno = 0;
+  const bool failed =
+      ::read(status[0], &exec_errno, sizeof(exec_errno)) == sizeof(exec_errno);
+  ::close(status[0]);
+  if (failed) {
+    ::close(sv[0]);
+    ::waitpid(pid, nullptr, 0);
+    throw LspError("cannot start " + argv[0] + ": " +
+                   std::strerror(exec_errno));
+  }
+  pid_ = pid;
+  fd_ = sv[0];
+  reader_ = std::thread([this] { read_loop(); });
+  writer_ = std::thread([this] { write_loop(); });
+}
+
+LspClient::~LspClient() {
+  if (alive()) {
+    try {
+      request("shutdown", nullptr, std::chrono::seconds(1));
+      notify("exit", nullptr);
+    } catch (const LspError&) {
+    }
+  }
+  // Give a cooperative server a moment to exit before killing the group.
+  int status = 0;
+  bool reaped = false;
+  for (int i = 0; i < 50 && !reaped; ++i) {
+    reaped = ::waitpid(pid_, &status, WNOHANG) == pid_;
+    if (!reaped) ::usleep(10'000);
+  }
+  if (!reaped) {
+    ::kill(-pid_, SIGKILL);
+    ::kill(pid_, SIGKILL);
+    ::waitpid(pid_, &status, 0);
+  }
+  ::shutdown(fd_, SHUT_RDWR);
+  reader_.join();
+  {
+    std::lock_guard lock(mu_);
+    stopping_ = true;
+  }
+  queued_.notify_all();
+  writer_.join();
+  ::close(fd_);
+}
+
+bool LspClient::alive() const {
+  std::lock_guard lock(mu_);
+  return !closed_;
+}
+
+json::Value LspClient::request(std::string_view method, json::Value params,
+                               std::chrono::milliseconds timeout) {
+  std::int64_t id;
+  {
+    std::lock_guard lock(mu_);
+    if (closed_) throw LspError("server has exited");
+    id = next_id_++;
+    pending_.emplace(id, Reply{});
+  }
+  auto request = message(method, std::move(params));
+  request.as_object()["id"] = id;
+  try {
+    send(request);
+  } catch (...) {
+    std::lock_guard lock(mu_);
+    pending_.erase(id);
+    throw;
+  }
+
+  std::unique_lock lock(mu_);
+  const bool replied = replied_.wait_for(lock, timeout, [&] {
+    return pending_.at(id).done || closed_;
+  });
+  Reply reply = std::move(pending_.at(id));
+  pending_.erase(id);
+  lock.unlock();
+
+  if (!replied) {
+    json::Object cancel;
+    cancel["id"] = id;
+    notify("$/cancelRequest", std::move(cancel));
+    throw LspError(std::string(method) + " timed out");
+  }
+  if (!reply.done) {
+    throw LspError("server exited during " + std::string(method));
+  }
+  if (reply.error) throw LspError(std::string(method) + ": " + *reply.error);
+  return std::move(reply.result);
+}
+
+void LspClient::notify(std::string_view method, json::Value params) {
+  send(message(method, std::move(params)));
+}
+
+void LspClient::send(const json::Value& message) {
+  write_frame(frame(json::serialize(message)));
+}
+
+void LspClient::write_frame(std::string_view data) {
+  std::lock_guard lock(write_mu_);
+  std::size_t written = 0;
+  while (written < data.size()) {
+    // MSG_NOSIGNAL: a dead server must not raise SIGPIPE in the service.
+    const ssize_t n = ::send(fd_, data.data() + written, data.size() - written,
+                             MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) throw LspError("server connection lost");
+    written += static_cast<std::size_t>(n);
+  }
+}
+
+void LspClient::read_loop() {
+  std::string buffer;
+  char chunk[65536];
+  try {
+    for (;;) {
+      const ssize_t n = ::read(fd_, chunk, sizeof(chunk));
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) break;
+      buffer.append(chunk, static_cast<std::size_t>(n));
+      while (auto body = next_frame(buffer)) dispatch(json::parse(*body));
+    }
+  } catch (const std::exception&) {
+    // A malformed stream cannot be resynchronized; treat it as a crash.
+  }
+  std::lock_guard lock(mu_);
+  closed_ = true;
+  replied_.notify_all();
+}
+
+void LspClient::write_loop() {
+  std::unique_lock lock(mu_);
+  for (;;) {
+    queued_.wait(lock, [&] { return stopping_ || !outbox_.empty(); });
+    if (stopping_) return;
+    const std::string data = std::move(outbox_.front());
+    outbox_.pop_front();
+    lock.unlock();
+    try {
+      write_frame(data);
+    } catch (const LspError&) {
+      // The server is gone; the reader sees it close.
+    }
+    lock.lock();
+  }
+}
+
+void LspClient::dispatch(const json::Value& message) {
+  const json::Value* method = message.find("method");
+  const json::Value* id = message.find("id");
+  if (method == nullptr) {
+    if (id == nullptr || !id->is_int()) return;
+    std::lock_guard lock(mu_);
+    const auto it = pending_.find(id->as_int());
+    if (it == pending_.end()) return;  // Timed out already.
+    Reply& reply = it->second;
+    if (const json::Value* error = message.find("error")) {
+      const json::Value* text = error->find("message");
+      reply.error = text != nullptr && text->is_string() ? text->as_string()
+                                                         : "error response";
+    } else if (const json::Value* result = message.find("result")) {
+      reply.result = *result;
+    }
+    reply.done = true;
+    replied_.notify_all();
+    return;
+  }
+  if (id != nullptr) {
+    // Server-to-client request (progress tokens, configuration): accept
+    // with an empty result so the server never blocks on us.
+    json::Object response;
+    response["jsonrpc"] = "2.0";
+    response["id"] = *id;
+    response["result"] = nullptr;
+    {
+      std::lock_guard lock(mu_);
+      outbox_.push_back(frame(json::serialize(response)));
+    }
+    queued_.notify_one();
+    return;
+  }
+  const json::Value* params = message.find("params");
+  if (on_notification_) {
+    on_notification_(method->as_string(),
+                     params != nullptr ? *params : json::Value());
+  }
+}
+
+}  // namespace codecoach::editor
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/json.h"
+
+namespace codecoach::editor {
+
+class LspError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Client end of a Language Server Protocol connection to a resident server
+// process (JSON-RPC with Content-Length framing over the child's stdin and
+// stdout). A reader thread dispatches responses to waiting requests and
+// notifications to the handler; requests the server sends to us are
+// answered with a null result, sent by a writer thread so the reader never
+// waits on a send that is itself waiting for the server to be read.
+// Thread-safe.
+class LspClient {
+ public:
+  using NotificationHandler =
+      std::function<void(std::string_view method, const json::Value& params)>;
+
+  // Starts argv[0] (looked up on PATH) in `cwd` with stderr discarded.
+  // `on_notification` runs on the reader thread. Throws LspError if the
+  // process cannot be started.
+  LspClient(const std::vector<std::string>& argv,
+            const std::filesystem::path& cwd,
+            NotificationHandler on_notification);
+  // Asks the server to shut down, then kills it if it lingers.
+  ~LspClient();
+  LspClient(const LspClient&) = delete;
+  LspClient& operator=(const LspClient&) = delete;
+
+  // Sends a request and waits for its result. Throws LspError on an error
+  // response, a timeout, or if the server has exited.
+  json::Value request(std::string_view method, json::Value params,
+                      std::chrono::milliseconds timeout);
+  void notify(std::string_view method, json::Value params);
+
+  // False once the server has closed its end (crashed or exited).
+  bool alive() const;
+
+ private:
+  struct Reply {
+    bool done = false;
+    json::Value result;
+    std::optional<std::string> error;
+  };
+
+  void send(const json::Value& message);
+  void write_frame(std::string_view data);
+  void read_loop();
+  void write_loop();
+  void dispatch(const json::Value& message);
+
+  int pid_ = -1;
+  int fd_ = -1;  // Socket carrying both directions.
+  NotificationHandler on_notification_;
+  std::thread reader_;
+  std::thread writer_;  // Sends the reader's replies.
+
+  std::mutex write_mu_;
+  mutable std::mutex mu_;
+  std::condition_variable replied_;
+  std::int64_t next_id_ = 1;
+  std::unordered_map<std::int64_t, Reply> pending_;
+  bool closed_ = false;
+  std::condition_variable queued_;
+  std::deque<std::string> outbox_;  // Framed replies for writer_.
+  bool stopping_ = false;
+};
+
+// Content-Length framing, exposed for reuse. frame() wraps one message;
+// next_frame() removes the first complete message from `buffer`, returning
+// nullopt until one has fully arrived. Throws LspError on bad headers.
+std::string frame(std::string_view body);
+std::optional<std::string> next_frame(std::string& buffer);
+
+}  // namespace codecoach::editor
@@ -0,0 +1,254 @@
+#include "harness/driver.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <unordered_set>
+
+namespace codecoach::harness {
+
+namespace {
+
+// "::"-joined identifiers and the punctuation of a declaration.
+std::vector<std::string> tokenize(std::string_view text) {
+  std::vector<std::string> tokens;
+  std::size_t i = 0;
+  const auto word_char = [&](std::size_t at) {
+    return at < text.size() &&
+           (std::isalnum(static_cast<unsigned char>(text[at])) ||
+            text[at] == '_');
+  };
+  while (i < text.size()) {
+    const char c = text[i];
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      ++i;
+    } else if (word_char(i)) {
+      const std::size_t start = i;
+      while (word_char(i) ||
+             (text.substr(i, 2) == "::" && word_char(i + 2))) {
+        i += text[i] == ':' ? 2 : 1;
+      }
+      tokens.emplace_back(text.substr(start, i - start));
+    } else if (std::string_view("<>,&()").find(c) !=
+               std::string_view::npos) {
+      tokens.emplace_back(1, c);
+      ++i;
+    } else {
+      throw SignatureError("unexpected '" + std::string(1, c) + "'");
+    }
+  }
+  return tokens;
+}
+
+bool is_identifier(const std::string& token) {
+  return !token.empty() &&
+         (std::isalpha(static_cast<unsigned char>(token.front())) ||
+          token.front() == '_') &&
+         token.find(':') == std::string::npos;
+}
+
+class Parser {
+ public:
+  explicit Parser(std::string_view text) : tokens_(tokenize(text)) {}
+
+  Signature signature() {
+    Signature out;
+    out.result = type(/*result=*/true);
+    out.method = identifier("method name");
+    expect("(");
+    std::unordered_set<std::string> names;
+    if (!accept(")")) {
+      do {
+        out.params.push_back(parameter());
+        if (!names.insert(out.params.back().name).second) {
+          throw SignatureError("duplicate parameter '" +
+                               out.params.back().name + "'");
+        }
+      } while (accept(","));
+      expect(")");
+    }
+    if (pos_ != tokens_.size()) {
+      throw SignatureError("unexpected '" + tokens_[pos_] + "' at end");
+    }
+    if (out.result == "void" &&
+        std::none_of(out.params.begin(), out.params.end(),
+                     [](const Parameter& p) {
+                       return p.reference && !p.is_const;
+                     })) {
+      throw SignatureError(
+          "a void method needs a non-const reference parameter to return "
+          "through");
+    }
+    return out;
+  }
+
+ private:
+  Parameter parameter() {
+    Parameter out;
+    out.is_const = accept("const");
+    out.type = type(/*result=*/false);
+    out.reference = accept("&");
+    out.name = identifier("parameter name");
+    return out;
+  }
+
+  // Canonical spelling of the type at the cursor. Floating-point results
+  // would need a tolerance checker; the token checker compares exactly.
+  std::string type(bool result) {
+    std::string word = next("type");
+    if (word.starts_with("std::")) word.erase(0, 5);
+    if (word == "void") {
+      if (!result || depth_ > 0) throw SignatureError("misplaced void");
+      return word;
+    }
+    if (word == "vector") {
+      return "std::vector<" + nested(result) + ">";
+    }
+    if (word == "pair") {
+      ++depth_;
+      expect("<");
+      std::string first = type(result);
+      expect(",");
+      std::string second = type(result);
+      expect(">");
+      --depth_;
+      return "std::pair<" + first + ", " + second + ">";
+    }
+    if (word == "string") return "std::string";
+    if (word == "int64_t" || word == "uint64_t") return "std::" + word;
+    if (word == "bool" || word == "char" || word == "int") return word;
+    if (word == "long") return accept("long") ? "long long" : "long";
+    if (word == "unsigned") {
+      accept("int");
+      return "unsigned";
+    }
+    if (word == "float" || word == "double") {
+      if (result) {
+        throw SignatureError("floating-point results are not supported");
+      }
+      return word;
+    }
+    throw SignatureError("unsupported type '" + word + "'");
+  }
+
+  std::string nested(bool result) {
+    ++depth_;
+    expect("<");
+    std::string element = type(result);
+    expect(">");
+    --depth_;
+    return element;
+  }
+
+  std::string identifier(const char* what) {
+    std::string token = next(what);
+    if (!is_identifier(token)) {
+      throw SignatureError(std::string("expected ") + what + ", got '" +
+                           token + "'");
+    }
+    return token;
+  }
+
+  std::string next(const char* what) {
+    if (pos_ == tokens_.size()) {
+      throw SignatureError(std::string("expected ") + what + " at end");
+    }
+    return tokens_[pos_++];
+  }
+
+  bool accept(std::string_view token) {
+    if (pos_ < tokens_.size() && tokens_[pos_] == token) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(std::string_view token) {
+    if (!accept(token)) {
+      throw SignatureError(
+          "expected '" + std::string(token) + "'" +
+          (pos_ < tokens_.size() ? ", got '" + tokens_[pos_] + "'"
+                                 : std::string(" at end")));
+    }
+  }
+
+  std::vector<std::string> tokens_;
+  std::size_t pos_ = 0;
+  int depth_ = 0;  // Inside template arguments.
+};
+
+}  // namespace
+
+std::string Parameter::declared_type() const {
+  return (is_const ? "const " : "") + type + (reference ? "&" : "");
+}
+
+Signature parse_signature(std::string_view text) {
+  return Parser(text).signature();
+}
+
+std::string to_string(const Signature& signature) {
+  std::string out = signature.result + " " + signature.method + "(";
+  for (std::size_t i = 0; i < signature.params.size(); ++i) {
+    if (i > 0) out += ", ";
+    out += signature.params[i].declared_type() + " " +
+           signature.params[i].name;
+  }
+  return out + ")";
+}
+
+std::string driver_prologue(std::string_view harness_header) {
+  // `#pragma once` outside a header draws a warning.
+  std::string out;
+  while (!harness_header.empty()) {
+    const auto newline = harness_header.find('\n');
+    const auto line = harness_header.substr(
+        0, newline == std::string_view::npos ? newline : newline + 1);
+    harness_header.remove_prefix(line.size());
+    if (!line.starts_with("#pragma once")) out.append(line);
+  }
+  if (!out.empty() && out.back() != '\n') out += '\n';
+  // Solutions are written as on interview sites, against the standard
+  // library unqualified. Their diagnostics count lines from their own
+  // start.
+  return out + "using namespace std;\n#line 1\n";
+}
+
+std::string driver_main(const Signature& signature) {
+  const std::string method = "&Solution::" + signature.method;
+  std::string declared = signature.result;
+  for (const Parameter& param : signature.params) {
+    declared += ", " + param.declared_type();
+  }
+  return "#line 1 \"<harness>\"\n"
+         "static_assert(codecoach::harness::declared_as<" + method + ", " +
+         declared + ">(),\n"
+         "              \"expected Solution::" + signature.method + " as: " +
+         to_string(signature) + "\");\n"
+         "int main() { return codecoach::harness::run<" + method +
+         ">(); }\n";
+}
+
+std::string program_source(std::string_view prologue,
+                           std::string_view solution,
+                           std::string_view main) {
+  if (prologue.empty() || main.empty()) return std::string(solution);
+  std::string out;
+  out.reserve(prologue.size() + solution.size() + main.size() + 1);
+  out.append(prologue).append(solution);
+  if (!solution.empty() && solution.back() != '\n') out += '\n';
+  return out.append(main);
+}
+
+std::string program_source(const catalog::ProblemBundle& bundle,
+                           std::string_view solution) {
+  const auto prologue =
+      bundle.section(catalog::format::SectionKind::kHarness);
+  const auto main =
+      bundle.section(catalog::format::SectionKind::kHarnessMain);
+  if (!prologue || !main) return std::string(solution);
+  return program_source(*prologue, solution, *main);
+}
+
+}  // namespace codecoach::harness
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "catalog/problem_bundle.h"
+
+// Problems that declare a method signature instead of a stdin/stdout
+// contract, e.g.
+//
+//   signature = vector<int> twoSum(vector<int>& nums, int target)
+//
+// are judged by a harness generated for that signature (harness/harness.h):
+// the bundle carries the harness header and a generated main(), and every
+// program built for the problem, reference and submissions alike, is
+//
+//   <harness header> <solution> <main() for the signature>
+//
+// Types: bool, char, int, long, long long, unsigned, int64_t, uint64_t,
+// float, double (parameters only), string, and vector<T> and pair<A, B> of
+// those; `std::` is optional. Parameters may be `T`, `T&` or `const T&`.
+// A void method's result is its non-const reference parameters.
+namespace codecoach::harness {
+
+class SignatureError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+struct Parameter {
+  std::string type;  // Canonical spelling, e.g. "std::vector<int>".
+  std::string name;
+  bool reference = false;
+  bool is_const = false;
+
+  // As declared in C++, e.g. "const std::vector<int>&".
+  std::string declared_type() const;
+};
+
+struct Signature {
+  std::string result;  // Canonical spelling; "void" allowed.
+  std::string method;
+  std::vector<Parameter> params;
+};
+
+// Throws SignatureError on syntax errors and unsupported types.
+Signature parse_signature(std::string_view text);
+
+// Canonical declaration, e.g. "std::vector<int> twoSum(std::vector<int>&
+// nums, int target)".
+std::string to_string(const Signature& signature);
+
+// The harness header prepared to precede a solution: `harness_header` is
+// the text of harness/harness.h.
+std::string driver_prologue(std::string_view harness_header);
+
+// The main() that follows a solution and runs Solution::<method>.
+std::string driver_main(const Signature& signature);
+
+// The program compiled for `solution`: framed by the prologue and main()
+// when both are non-empty, `solution` itself otherwise. The solution's
+// diagnostics keep their line numbers.
+std::string program_source(std::string_view prologue,
+                           std::string_view solution,
+                           std::string_view main);
+
+// As above with the bundle's harness sections; stdin/stdout problems have
+// none.
+std::string program_source(const catalog::ProblemBundle& bundle,
+                           std::string_view solution);
+
+}  // namespace codecoach::harness
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace codecoach::judge {
+
+// What the user pressed. Run judges the sample tests only (the editor's
+// Run button); Submit judges the standard test set and may earn a hint.
+enum class Action : std::uint8_t {
+  kRun = 0,
+  kSubmit = 1,
+};
+
+inline constexpr std::size_t kActionCount = 2;
+
+constexpr std::string_view to_string(Action action) {
+  return action == Action::kRun ? "run" : "submit";
+}
+
+inline std::optional<Action> action_from_string(std::string_view name) {
+  if (name == "run") return Action::kRun;
+  if (name == "submit") return Action::kSubmit;
+  return std::nullopt;
+}
+
+}  // namespace codecoach::judge
@@ -0,0 +1,34 @@
+#include "judge/checker.h"
+
+namespace codecoach::judge {
+
+namespace {
+
+bool is_space(char c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f' ||
+         c == '\v';
+}
+
+// Advances past leading whitespace and returns the next token.
+std::string_view next_token(std::string_view& text) {
+  std::size_t i = 0;
+  while (i < text.size() && is_space(text[i])) ++i;
+  std::size_t j = i;
+  while (j < text.size() && !is_space(text[j])) ++j;
+  const auto token = text.substr(i, j - i);
+  text.remove_prefix(j);
+  return token;
+}
+
+}  // namespace
+
+bool tokens_match(std::string_view expected, std::string_view actual) {
+  for (;;) {
+    const auto want = next_token(expected);
+    const auto got = next_token(actual);
+    if (want != got) return false;
+    if (want.empty()) return true;
+  }
+}
+
+}  // namespace codecoach::judge
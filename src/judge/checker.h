@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string_view>
+
+namespace codecoach::judge {
+
+// Default checker: compares whitespace-separated tokens, so trailing spaces
+// and line-ending differences never turn an accepted answer into WA.
+bool tokens_match(std::string_view expected, std::string_view actual);
+
+}  // namespace codecoach::judge
@@ -0,0 +1,24 @@
+#include "judge/coalescer.h"
+
+#include <string>
+
+#include "judge/source_normalizer.h"
+
+namespace codecoach::judge {
+
+Digest128 coalescing_key(std::string_view problem,
+                         std::uint64_t bundle_version, std::string_view tests,
+                         std::string_view language, std::string_view source,
+                         TenantId tenant, Priority priority) {
+  return DigestBuilder()
+      .add(problem)
+      .add(std::to_string(bundle_version))
+      .add(tests)
+      .add(language)
+      .add(normalize_source(source))
+      .add(std::to_string(tenant))
+      .add(std::to_string(static_cast<int>(priority)))
+      .finish();
+}
+
+}  // namespace codecoach::judge
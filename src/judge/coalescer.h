@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/hash.h"
+#include "common/types.h"
+#include "judge/verdict.h"
+
+namespace codecoach::judge {
+
+// Result of a coalesced job, shared by everyone who joined it.
+struct CoalescedVerdict {
+  Verdict verdict;
+  // Digest of the leader's exact source bytes.
+  Digest128 source_digest;
+
+  // Whether a submission with raw source digest `digest` may take this
+  // result as its own. Runtime verdicts depend only on the normalized source;
+  // compile errors quote line and column positions, so they are only shared
+  // with byte-identical submissions and anyone else must compile itself.
+  bool usable_by(const Digest128& digest) const {
+    return verdict.overall != Outcome::kCompileError ||
+           digest == source_digest;
+  }
+};
+
+// Key over everything that determines the verdict, and over who waits for
+// it. `bundle_version` ties the key to the test data, so a hot reload
+// starts a fresh job; `tests` names the test selection (e.g. run vs.
+// submit). Tenant and priority keep a follower in its own queue: an
+// interactive submission never waits behind batch work, its own tenant's
+// or another's, and the job is charged to the tenant every joiner is from.
+Digest128 coalescing_key(std::string_view problem,
+                         std::uint64_t bundle_version, std::string_view tests,
+                         std::string_view language, std::string_view source,
+                         TenantId tenant, Priority priority);
+
+// Collapses identical submissions that are in flight at the same time into
+// one judge job.
+//
+// The first caller for a key becomes the leader and schedules the job; later
+// callers for the same key are parked behind it as followers. When the
+// leader finishes, release() removes the entry and hands back its followers,
+// so coalescing only spans the job's lifetime; finished results are the
+// compile and verdict caches' job.
+template <typename Follower>
+class Coalescer {
+ public:
+  // Returns true when the caller leads `key`. Otherwise `follower` is moved
+  // into the leader's group and false is returned.
+  bool join(const Digest128& key, Follower& follower) {
+    std::lock_guard lock(mu_);
+    auto [it, inserted] = pending_.try_emplace(key);
+    if (inserted) return true;
+    it->second.push_back(std::move(follower));
+    ++coalesced_;
+    return false;
+  }
+
+  // Ends the leader's job: the next join() for `key` leads again. Returns
+  // the followers to hand its result to.
+  std::vector<Follower> release(const Digest128& key) {
+    std::lock_guard lock(mu_);
+    auto it = pending_.find(key);
+    if (it == pending_.end()) return {};
+    std::vector<Follower> followers = std::move(it->second);
+    pending_.erase(it);
+    return followers;
+  }
+
+  std::size_t in_flight() const {
+    std::lock_guard lock(mu_);
+    return pending_.size();
+  }
+  // Number of join() calls that attached to an existing job.
+  std::uint64_t coalesced() const {
+    std::lock_guard lock(mu_);
+    return coalesced_;
+  }
+
+ private:
+  mutable std::mutex mu_;
+  std::unordered_map<Digest128, std::vector<Follower>, Digest128Hash>
+      pending_;
+  std::uint64_t coalesced_ = 0;
+};
+
+}  // namespace codecoach::judge
@@ -0,0 +1,397 @@
+#include "judge/evaluator.h"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <utility>
+
+#include "harness/driver.h"
+#include "judge/failure_cluster.h"
+#include "judge/local_runner.h"
+
+namespace codecoach::judge {
+
+namespace {
+
+bool selected(const catalog::TestCase& test, Action action) {
+  return action == Action::kRun
+             ? (test.flags & catalog::format::kTestSample) != 0
+             : catalog::runs_in(test, catalog::JudgeMode::kStandard);
+}
+
+// Thrown where an injected worker crash kills the job in flight.
+struct WorkerCrash {};
+
+std::chrono::microseconds since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+}
+
+}  // namespace
+
+Evaluator::Evaluator(EvaluatorOptions options, catalog::Catalog& catalog,
+                     compile::Compiler& compiler, coach::Coach& coach)
+    : options_(options),
+      catalog_(catalog),
+      compiler_(compiler),
+      coach_(coach),
+      scheduler_(std::max<std::size_t>(options.workers, 1), options.queue),
+      costs_(options.costs),
+      hints_(options.hints) {
+  if (options_.slo) {
+    slo_.emplace(*options_.slo);
+    slo_->add_knob("hints", Pressure::kElevated,
+                   [this](bool engaged) { set_hints(!engaged); });
+  }
+  for (const auto& [tenant, config] : options_.tenants) {
+    scheduler_.configure_tenant(tenant, config);
+  }
+  for (const auto& [tenant, workers] : options_.reserved_workers) {
+    scheduler_.reserve_workers(tenant, workers);
+  }
+  const std::size_t workers = std::max<std::size_t>(options_.workers, 1);
+  workers_.reserve(workers);
+  for (std::size_t w = 0; w < workers; ++w) {
+    workers_.emplace_back(
+        [this, w] { work(static_cast<WorkerId>(w)); });
+  }
+  if (options_.quota_window.count() > 0 ||
+      options_.hot_half_life.count() > 0) {
+    timers_ = std::thread([this] { run_timers(); });
+  }
+}
+
+Evaluator::~Evaluator() {
+  {
+    std::lock_guard lock(mu_);
+    stop_ = true;
+  }
+  ready_.notify_all();
+  for (auto& worker : workers_) worker.join();
+  // The timers outlive the workers: queued jobs of a tenant over quota may
+  // be waiting for the next window.
+  {
+    std::lock_guard lock(mu_);
+    workers_done_ = true;
+  }
+  ready_.notify_all();
+  if (timers_.joinable()) timers_.join();
+  if (pch_builder_.joinable()) pch_builder_.join();
+}
+
+void Evaluator::submit(EvaluationRequest request, Callback done) {
+  const auto submitted = Clock::now();
+  if (!compile::Compiler::accepts(request.submission.language)) {
+    ++unsupported_;
+    Evaluation evaluation;
+    evaluation.response.job_id = request.submission.job_id;
+    evaluation.unsupported_language = true;
+    evaluation.error =
+        "unsupported language '" + request.submission.language + "'";
+    done(std::move(evaluation));
+    return;
+  }
+  auto bundle = catalog_.find(request.submission.problem);
+  if (bundle == nullptr) {
+    Evaluation evaluation;
+    evaluation.response.job_id = request.submission.job_id;
+    evaluation.error = "unknown problem " + request.submission.problem;
+    done(std::move(evaluation));
+    return;
+  }
+  hot_.record(request.submission.problem);
+  std::size_t tests = 0;
+  for (std::size_t t = 0; t < bundle->test_count(); ++t) {
+    if (selected(bundle->test(t), request.action)) ++tests;
+  }
+  const auto& submission = request.submission;
+  std::string program = harness::program_source(*bundle, submission.source);
+  const std::int64_t estimate =
+      costs_
+          .estimate({submission.problem, submission.language,
+                     submission.source.size(), compiler_.cached(program),
+                     request.user, tests})
+          .expected_us();
+  const scheduler::JobTicket ticket{0, submission.tenant, submission.priority,
+                                    estimate};
+  const Digest128 key = coalescing_key(
+      submission.problem, bundle->version(), to_string(request.action),
+      submission.language, submission.source, submission.tenant,
+      submission.priority);
+  Job job;
+  job.request = std::move(request);
+  job.bundle = std::move(bundle);
+  job.program = std::move(program);
+  job.tests = tests;
+  job.estimate = estimate;
+  if (slo_) job.problem_class = classify(*job.bundle);
+  job.done = std::move(done);
+  job.submitted = submitted;
+  if (!coalescer_.join(key, job)) return;
+  job.coalesce_key = key;
+  enqueue(std::move(job), ticket);
+}
+
+void Evaluator::enqueue(Job job, const scheduler::JobTicket& ticket) {
+  {
+    std::lock_guard lock(mu_);
+    scheduler::JobTicket queued = ticket;
+    queued.id = next_ticket_++;
+    scheduler_.submit(queued);
+    jobs_.emplace(queued.id, std::move(job));
+  }
+  ready_.notify_one();
+}
+
+warmup::WarmStartReport Evaluator::warm_start(
+    const warmup::WarmState& state) {
+  warmup::WarmStartTargets targets;
+  targets.catalog = &catalog_;
+  targets.compile_cache = &compiler_.cache();
+  targets.pch = &compiler_.pch();
+  targets.parallelism = workers_.size();
+  // Hottest first: the first problem outranks the second, and so on.
+  const std::size_t hot = state.hot_problems.size();
+  for (std::size_t i = 0; i < hot; ++i) {
+    hot_.record(state.hot_problems[i], hot - i);
+  }
+  auto report = warmup::warm_start(state, targets);
+  // Whether the snapshot's PCH is gone (report.pch_missing) or it never had
+  // one, build it off the startup path; compiles go without it meanwhile.
+  if (!compiler_.pch().find(compiler_.identity()) &&
+      !pch_builder_.joinable()) {
+    pch_builder_ = std::thread([this] {
+      try {
+        compiler_.ensure_pch();
+      } catch (const std::exception&) {
+        // Compiles keep going without a PCH.
+      }
+    });
+  }
+  return report;
+}
+
+warmup::WarmState Evaluator::warm_state(std::size_t hot_limit) const {
+  return warmup::capture_warm_state(compiler_.cache(), compiler_.pch(), hot_,
+                                    hot_limit);
+}
+
+std::future<Evaluation> Evaluator::evaluate(EvaluationRequest request) {
+  auto promise = std::make_shared<std::promise<Evaluation>>();
+  auto result = promise->get_future();
+  submit(std::move(request), [promise](Evaluation evaluation) {
+    promise->set_value(std::move(evaluation));
+  });
+  return result;
+}
+
+void Evaluator::work(WorkerId worker) {
+  for (;;) {
+    std::optional<scheduler::JobTicket> ticket;
+    Job job;
+    {
+      std::unique_lock lock(mu_);
+      ready_.wait(lock, [&] {
+        ticket = scheduler_.next_for(worker);
+        return ticket.has_value() || (stop_ && jobs_.empty());
+      });
+      if (!ticket) return;
+      const auto it = jobs_.find(ticket->id);
+      job = std::move(it->second);
+      jobs_.erase(it);
+    }
+
+    ++job.attempts;
+    if (job.crashed) {
+      job.recovery += since(*job.crashed);
+      job.crashed.reset();
+    }
+    Evaluation evaluation;
+    evaluation.times.queued = since(job.submitted);
+    evaluation.times.recovery = job.recovery;
+    evaluation.attempts = job.attempts;
+    std::int64_t cpu_us = 0;
+    try {
+      cpu_us = judge(job, evaluation);
+    } catch (const WorkerCrash&) {
+      if (job.attempts < std::max<std::size_t>(options_.max_attempts, 1)) {
+        crash(*ticket, std::move(job));
+        continue;
+      }
+      evaluation.response.verdict = {};
+      evaluation.error = "worker lost " + std::to_string(job.attempts) +
+                         " times";
+    } catch (const std::exception& e) {
+      evaluation.response.verdict = {};
+      evaluation.error = e.what();
+    }
+    scheduler_.complete(*ticket, cpu_us);
+    // Completion frees quota, which may unblock another worker.
+    ready_.notify_all();
+    if (job.coalesce_key) release_followers(job, evaluation);
+    finish(job, std::move(evaluation));
+  }
+}
+
+void Evaluator::run_timers() {
+  // A period of zero is off; it stays a day out so the wait has a bound.
+  const auto period = [](std::chrono::milliseconds every) {
+    return every.count() > 0 ? Clock::duration(every) : std::chrono::hours(24);
+  };
+  const auto roll_every = period(options_.quota_window);
+  const auto decay_every = period(options_.hot_half_life);
+  auto next_roll = Clock::now() + roll_every;
+  auto next_decay = Clock::now() + decay_every;
+  std::unique_lock lock(mu_);
+  for (;;) {
+    if (ready_.wait_until(lock, std::min(next_roll, next_decay),
+                          [this] { return workers_done_; })) {
+      return;
+    }
+    const auto now = Clock::now();
+    if (now >= next_roll) {
+      next_roll = now + roll_every;
+      if (options_.quota_window.count() > 0) {
+        scheduler_.roll_window();
+        // Tenants that were over quota may have work for idle workers now.
+        ready_.notify_all();
+      }
+    }
+    if (now >= next_decay) {
+      next_decay = now + decay_every;
+      if (options_.hot_half_life.count() > 0) hot_.decay();
+    }
+  }
+}
+
+void Evaluator::finish(Job& job, Evaluation evaluation) {
+  // Internal errors are the service's, not the submission's, to record.
+  if (options_.records != nullptr && evaluation.error.empty()) {
+    options_.records->record(job.request.submission, evaluation.response,
+                             evaluation.hint);
+  }
+  evaluation.times.total = since(job.submitted);
+  if (slo_) {
+    slo_->record(job.request.action, job.problem_class,
+                 evaluation.times.total);
+  }
+  job.done(std::move(evaluation));
+}
+
+void Evaluator::release_followers(const Job& leader,
+                                  const Evaluation& result) {
+  const Digest128 source = digest128(leader.request.submission.source);
+  std::vector<Job> followers = coalescer_.release(*leader.coalesce_key);
+  const CoalescedVerdict shared{result.response.verdict, source};
+  for (Job& follower : followers) {
+    const api::SubmitRequest& submission = follower.request.submission;
+    if (result.error.empty() &&
+        !shared.usable_by(digest128(submission.source))) {
+      // A compile error quotes positions; this one must compile itself.
+      const scheduler::JobTicket ticket{0, submission.tenant,
+                                        submission.priority,
+                                        follower.estimate};
+      enqueue(std::move(follower), ticket);
+      continue;
+    }
+    Evaluation evaluation;
+    evaluation.response = result.response;
+    evaluation.response.job_id = submission.job_id;
+    evaluation.error = result.error;
+    evaluation.coalesced = true;
+    evaluation.times.queued = since(follower.submitted);
+    if (evaluation.error.empty()) add_hint(follower, evaluation);
+    finish(follower, std::move(evaluation));
+  }
+}
+
+void Evaluator::crash(const scheduler::JobTicket& ticket, Job job) {
+  ++crashes_;
+  const auto crashed = Clock::now();
+  job.crashed = crashed;
+  // The tenant is not charged for work the crash threw away.
+  scheduler_.complete(ticket, 0);
+  ready_.notify_all();
+  std::this_thread::sleep_for(options_.crash_detection);
+  enqueue(std::move(job), ticket);
+  std::this_thread::sleep_until(crashed + options_.worker_restart);
+}
+
+std::int64_t Evaluator::judge(Job& job, Evaluation& out) {
+  const api::SubmitRequest& submission = job.request.submission;
+  const catalog::ProblemBundle& bundle = *job.bundle;
+  out.response.job_id = submission.job_id;
+  Verdict& verdict = out.response.verdict;
+  std::int64_t compile_us = 0;
+  std::size_t tests_run = 0;
+
+  auto stage = Clock::now();
+  const compile::CompileResult build = compiler_.compile(job.program);
+  out.times.compile = since(stage);
+  out.compile_cache_hit = build.cache_hit;
+  if (!build.cache_hit) compile_us = out.times.compile.count();
+  if (!build.ok) {
+    verdict.overall = Outcome::kCompileError;
+    verdict.compile_log = build.log;
+  } else {
+    stage = Clock::now();
+    const auto limits = RunLimits::of(bundle);
+    verdict.overall = Outcome::kAccepted;
+    verdict.tests.resize(bundle.test_count());
+    for (std::size_t t = 0; t < bundle.test_count(); ++t) {
+      const catalog::TestCase test = bundle.test(t);
+      if (!selected(test, job.request.action)) continue;
+      if (verdict.overall != Outcome::kAccepted) continue;
+      if (options_.faults != nullptr &&
+          options_.faults->fire(Fault::kWorkerCrash)) {
+        throw WorkerCrash{};
+      }
+      verdict.tests[t] = run_test_locally(build.artifact, test, limits);
+      ++tests_run;
+      if (verdict.tests[t].outcome != Outcome::kAccepted) {
+        verdict.overall = verdict.tests[t].outcome;
+      }
+    }
+    out.times.run = since(stage);
+    if (job.request.action == Action::kSubmit &&
+        verdict.overall != Outcome::kAccepted) {
+      out.response.failure_cluster = find_failure_cluster(bundle, verdict);
+    }
+  }
+  // Worker time, process startup included, is what capacity is made of.
+  costs_.observe({submission.problem, submission.language,
+                  submission.source.size(), std::nullopt, job.request.user,
+                  job.tests},
+                 build.cache_hit, compile_us, tests_run,
+                 out.times.run.count());
+
+  add_hint(job, out);
+  return compile_us + out.times.run.count();
+}
+
+void Evaluator::add_hint(const Job& job, Evaluation& out) {
+  const api::SubmitRequest& submission = job.request.submission;
+  const Verdict& verdict = out.response.verdict;
+  if (hints() && job.request.action == Action::kSubmit &&
+      verdict.overall != Outcome::kAccepted) {
+    const auto stage = Clock::now();
+    const auto dropped = options_.faults != nullptr
+                             ? options_.faults->fire(Fault::kCoachDrop)
+                             : std::nullopt;
+    if (dropped) {
+      // Waits out the request timeout, then goes without, as on a real
+      // lost response.
+      std::this_thread::sleep_for(*dropped);
+    } else {
+      try {
+        out.hint = coach_.hint(*job.bundle, verdict, submission.source,
+                               job.request.hint_level);
+      } catch (const std::exception&) {
+        // The verdict stands without a hint.
+      }
+    }
+    out.times.coach = since(stage);
+  }
+}
+
+}  // namespace codecoach::judge
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "api/messages.h"
+#include "catalog/catalog.h"
+#include "coach/coach.h"
+#include "common/fault_injection.h"
+#include "common/parallel.h"
+#include "common/types.h"
+#include "common/hash.h"
+#include "compile/compiler.h"
+#include "judge/action.h"
+#include "judge/coalescer.h"
+#include "judge/record_store.h"
+#include "judge/slo_tracker.h"
+#include "scheduler/cost_model.h"
+#include "scheduler/tenant_scheduler.h"
+#include "warmup/hot_problems.h"
+#include "warmup/warm_state.h"
+
+namespace codecoach::judge {
+
+struct EvaluationRequest {
+  api::SubmitRequest submission;
+  Action action = Action::kSubmit;
+  // Hints the user already got for this problem (coach::Coach::hint).
+  std::size_t hint_level = 0;
+  // Submitting user, for per-user cost history; 0 when unknown.
+  std::uint64_t user = 0;
+};
+
+struct StageTimes {
+  std::chrono::microseconds queued{0};
+  std::chrono::microseconds compile{0};
+  std::chrono::microseconds run{0};
+  std::chrono::microseconds coach{0};
+  // Lost to worker crashes: from each crash until the job was dispatched
+  // again. Included in queued.
+  std::chrono::microseconds recovery{0};
+  std::chrono::microseconds total{0};  // Submit to callback.
+};
+
+struct Evaluation {
+  api::VerdictResponse response;
+  std::optional<coach::Hint> hint;
+  StageTimes times;
+  bool compile_cache_hit = false;
+  // Dispatches it took; more than one after worker crashes.
+  std::size_t attempts = 1;
+  // Took the verdict of an identical submission already in flight rather
+  // than being judged itself.
+  bool coalesced = false;
+  // Rejected unjudged: the compiler does not build its language.
+  bool unsupported_language = false;
+  // Why the verdict is kInternalError, when it is.
+  std::string error;
+};
+
+struct EvaluatorOptions {
+  std::size_t workers = default_parallelism();
+  // Ask the coach for a hint on failed submits. Initial value; see
+  // Evaluator::set_hints().
+  bool hints = true;
+
+  // Fault drills: honors Fault::kWorkerCrash and Fault::kCoachDrop. Null in
+  // production.
+  FaultInjector* faults = nullptr;
+  // A crashed worker's job is requeued once the loss is noticed (a missed
+  // heartbeat), and the worker rejoins the pool after restarting.
+  std::chrono::milliseconds crash_detection{1000};
+  std::chrono::milliseconds worker_restart{3000};
+  // Crashes a job may suffer before it fails with kInternalError.
+  std::size_t max_attempts = 3;
+
+  // Priors of the cost model that prices jobs for the scheduler, and how
+  // the scheduler orders them.
+  scheduler::CostModelOptions costs;
+  scheduler::QueuePolicy queue;
+
+  // Per-tenant quota and share; tenants not listed run unlimited at weight
+  // 1. Quota budgets are per `quota_window`, which the evaluator rolls on
+  // its own timer; zero never rolls it.
+  std::unordered_map<TenantId, scheduler::TenantConfig> tenants;
+  std::chrono::milliseconds quota_window{60'000};
+  // Workers (0 .. workers-1) dedicated to a tenant's jobs.
+  std::unordered_map<TenantId, std::vector<WorkerId>> reserved_workers;
+
+  // The submission counts that rank hot problems for warm_state() halve
+  // this often, so the ranking follows recent traffic. Zero: all-time
+  // counts.
+  std::chrono::milliseconds hot_half_life{600'000};
+
+  // Where judged submissions, verdicts and hints are recorded, off the
+  // verdict path. Null: not recorded.
+  RecordStore* records = nullptr;
+
+  // Latency targets for the evaluator's own SloTracker, which sheds hints
+  // at elevated pressure. Unset: no tracking.
+  std::optional<SloOptions> slo;
+};
+
+// In-process judge: tenant-aware queue, a pool of worker threads, compile
+// through the compile cache, test runs and coach hints. It is the whole
+// evaluator path on one host, for load replays, fault drills and
+// benchmarks; production runs the same stages across the worker fleet.
+//
+// Tests run without a sandbox (judge::run_test_locally), so only judge
+// trusted or replayed submissions with it, on an isolated host. Sandbox
+// sizing and prewarm are the fleet's and are not exercised here.
+//
+// Identical submissions in flight at the same time (judge::coalescing_key:
+// same tenant, priority, problem version, action, language and normalized
+// source) are judged once; the others take the leader's verdict when it
+// completes.
+//
+// Thread-safe. A coach failure never fails a verdict; it only loses the
+// hint. A worker crash costs its job a requeue, not a verdict, until the
+// job runs out of attempts.
+class Evaluator {
+ public:
+  // Called on a worker thread; must not throw.
+  using Callback = std::function<void(Evaluation)>;
+
+  // Throws std::out_of_range if reserved_workers names a worker past
+  // `workers`, and std::invalid_argument on a tenant weight of zero.
+  Evaluator(EvaluatorOptions options, catalog::Catalog& catalog,
+            compile::Compiler& compiler, coach::Coach& coach);
+  // Finishes every queued job, then stops the workers.
+  ~Evaluator();
+  Evaluator(const Evaluator&) = delete;
+  Evaluator& operator=(const Evaluator&) = delete;
+
+  // Queues the request. An unknown problem or a language the compiler does
+  // not build (compile::Compiler::accepts) is answered at once, on the
+  // calling thread, with kInternalError.
+  void submit(EvaluationRequest request, Callback done);
+  std::future<Evaluation> evaluate(EvaluationRequest request);
+
+  std::size_t queued() const { return scheduler_.queued(); }
+  std::size_t crashes() const { return crashes_; }
+  // Submissions rejected for their language.
+  std::size_t unsupported() const { return unsupported_; }
+  // Submissions that took an in-flight job's verdict.
+  std::uint64_t coalesced() const { return coalescer_.coalesced(); }
+
+  // Estimated CPU of accepted, unfinished jobs: the autoscaling signal.
+  scheduler::Backlog backlog() const { return scheduler_.backlog(); }
+  const scheduler::CostModel& costs() const { return costs_; }
+
+  // Restart support (warmup/warm_state.h). warm_start() restores `state`
+  // into the compiler's cache and PCH registry, prefetches the hot
+  // problems' bundles and carries the hot-problem ranking over; call it
+  // before the first submit(), with an empty state on a cold start. A PCH
+  // the restore did not bring back is built in the background.
+  // warm_state() is the snapshot to save at shutdown.
+  warmup::WarmStartReport warm_start(const warmup::WarmState& state);
+  warmup::WarmState warm_state(std::size_t hot_limit) const;
+
+  // Runtime knob: hints are optional work and the first thing to give up
+  // when verdict latency is over target. With EvaluatorOptions::slo set,
+  // the evaluator's SloTracker turns it.
+  void set_hints(bool on) { hints_.store(on, std::memory_order_relaxed); }
+  bool hints() const { return hints_.load(std::memory_order_relaxed); }
+
+  // Verdict latency by action and problem class, submit to callback, of
+  // every judged or coalesced submission. Null without
+  // EvaluatorOptions::slo.
+  const SloTracker* slo() const { return slo_ ? &*slo_ : nullptr; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Job {
+    EvaluationRequest request;
+    std::shared_ptr<const catalog::ProblemBundle> bundle;
+    // What is compiled: the source inside the problem's harness, if any.
+    std::string program;
+    std::size_t tests = 0;  // Selected for the action.
+    std::int64_t estimate = 0;  // Expected CPU, for its scheduler ticket.
+    ProblemClass problem_class = ProblemClass::kStandard;  // For the SLO.
+    // Set on the leader of a coalesced group.
+    std::optional<Digest128> coalesce_key;
+    Callback done;
+    Clock::time_point submitted;
+    std::size_t attempts = 0;
+    std::optional<Clock::time_point> crashed;
+    std::chrono::microseconds recovery{0};
+  };
+
+  void work(WorkerId worker);
+  // Rolls the scheduler's quota window every quota_window and decays the
+  // hot-problem counts every hot_half_life, until the workers are gone.
+  void run_timers();
+  // Queues the job under a fresh scheduler ticket.
+  void enqueue(Job job, const scheduler::JobTicket& ticket);
+  // A simulated worker death: the job is requeued after crash_detection and
+  // the worker is back after worker_restart.
+  void crash(const scheduler::JobTicket& ticket, Job job);
+  // Hands a finished leader's result to the submissions coalesced into it.
+  void release_followers(const Job& leader, const Evaluation& result);
+  // The coach step of a failed submit: a hint, unless hints are shed.
+  void add_hint(const Job& job, Evaluation& out);
+  // Records a finished job, and its latency against the SLO, and hands it
+  // its evaluation.
+  void finish(Job& job, Evaluation evaluation);
+  // Returns the worker time spent, for the scheduler's accounting, and
+  // feeds it to the cost model that prices later jobs.
+  std::int64_t judge(Job& job, Evaluation& out);
+
+  EvaluatorOptions options_;
+  catalog::Catalog& catalog_;
+  compile::Compiler& compiler_;
+  coach::Coach& coach_;
+  scheduler::TenantScheduler scheduler_;
+  scheduler::CostModel costs_;
+  warmup::HotProblemTracker hot_;  // Submits with a known problem.
+  std::optional<SloTracker> slo_;
+
+  std::mutex mu_;
+  std::condition_variable ready_;
+  std::unordered_map<JobId, Job> jobs_;  // By scheduler ticket id.
+  Coalescer<Job> coalescer_;  // Followers wait here on in-flight leaders.
+  JobId next_ticket_ = 1;
+  bool stop_ = false;
+  bool workers_done_ = false;  // Stops the timers.
+  std::atomic<std::size_t> crashes_{0};
+  std::atomic<std::size_t> unsupported_{0};
+  std::atomic<bool> hints_;
+  std::vector<std::thread> workers_;
+  std::thread timers_;
+  std::thread pch_builder_;  // Started by warm_start().
+};
+
+}  // namespace codecoach::judge
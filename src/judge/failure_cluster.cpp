@@ -0,0 +1,138 @@
+#include "judge/failure_cluster.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "common/hash.h"
+
+namespace codecoach::judge {
+
+namespace {
+
+using catalog::format::ClusterSlot;
+using catalog::format::ClusterTableHeader;
+
+// Never 0, and apart from signature hashes by seed.
+std::uint64_t first_failure_hash(std::size_t test, std::size_t test_count) {
+  const auto index = static_cast<std::uint64_t>(test);
+  const std::uint64_t hash =
+      hash64({reinterpret_cast<const char*>(&index), sizeof(index)},
+             ~static_cast<std::uint64_t>(test_count));
+  return hash == 0 ? 1 : hash;
+}
+
+}  // namespace
+
+Bitset failure_signature(const Verdict& verdict) {
+  Bitset signature(verdict.tests.size());
+  for (std::size_t t = 0; t < verdict.tests.size(); ++t) {
+    const Outcome outcome = verdict.tests[t].outcome;
+    if (outcome != Outcome::kAccepted && outcome != Outcome::kSkipped) {
+      signature.set(t);
+    }
+  }
+  return signature;
+}
+
+std::uint64_t signature_hash(const Bitset& signature) {
+  const auto& words = signature.words();
+  const std::uint64_t hash = hash64(
+      {reinterpret_cast<const char*>(words.data()),
+       words.size() * sizeof(std::uint64_t)},
+      signature.size());
+  return hash == 0 ? 1 : hash;
+}
+
+std::string encode_cluster_table(
+    const catalog::ProblemBundle& bundle,
+    std::span<const std::pair<Bitset, std::uint32_t>> clusters) {
+  const auto test_count = static_cast<std::uint32_t>(bundle.test_count());
+  std::vector<std::pair<std::uint64_t, std::uint32_t>> keys;
+  keys.reserve(2 * clusters.size());
+  for (const auto& [signature, cluster] : clusters) {
+    keys.emplace_back(signature_hash(signature), cluster);
+  }
+  for (const auto& [signature, cluster] : clusters) {
+    for (std::size_t t = 0; t < signature.size(); ++t) {
+      if (!signature.test(t) ||
+          !catalog::runs_in(bundle.test(t), catalog::JudgeMode::kStandard)) {
+        continue;
+      }
+      keys.emplace_back(first_failure_hash(t, test_count), cluster);
+      break;
+    }
+  }
+  // Load factor at most 1/2 keeps probes short.
+  const std::uint32_t slot_count =
+      std::bit_ceil(static_cast<std::uint32_t>(2 * keys.size() + 2));
+  std::string out(sizeof(ClusterTableHeader) + slot_count * sizeof(ClusterSlot),
+                  '\0');
+  const ClusterTableHeader header{test_count, slot_count};
+  std::memcpy(out.data(), &header, sizeof(header));
+  char* slots = out.data() + sizeof(header);
+  // The first of duplicate keys, the most common, wins.
+  for (const auto& [hash, cluster] : keys) {
+    for (std::uint32_t i = hash & (slot_count - 1);;
+         i = (i + 1) & (slot_count - 1)) {
+      ClusterSlot slot;
+      std::memcpy(&slot, slots + i * sizeof(slot), sizeof(slot));
+      if (slot.signature_hash == hash) break;
+      if (slot.signature_hash != 0) continue;
+      slot = {hash, cluster, 0};
+      std::memcpy(slots + i * sizeof(slot), &slot, sizeof(slot));
+      break;
+    }
+  }
+  return out;
+}
+
+std::optional<std::uint32_t> find_failure_cluster(
+    const catalog::ProblemBundle& bundle, const Verdict& verdict) {
+  const auto table =
+      bundle.section(catalog::format::SectionKind::kFailureClusters);
+  if (!table || table->size() < sizeof(ClusterTableHeader)) {
+    return std::nullopt;
+  }
+  ClusterTableHeader header;
+  std::memcpy(&header, table->data(), sizeof(header));
+  if (header.test_count != verdict.tests.size() ||
+      !std::has_single_bit(header.slot_count) ||
+      (table->size() - sizeof(header)) / sizeof(ClusterSlot) <
+          header.slot_count) {
+    return std::nullopt;
+  }
+
+  const auto skipped = [](const TestResult& test) {
+    return test.outcome == Outcome::kSkipped;
+  };
+  const auto failed = [](const TestResult& test) {
+    return test.outcome != Outcome::kAccepted &&
+           test.outcome != Outcome::kSkipped;
+  };
+  std::uint64_t hash;
+  if (std::any_of(verdict.tests.begin(), verdict.tests.end(), skipped)) {
+    const auto first =
+        std::find_if(verdict.tests.begin(), verdict.tests.end(), failed);
+    if (first == verdict.tests.end()) return std::nullopt;
+    hash = first_failure_hash(
+        static_cast<std::size_t>(first - verdict.tests.begin()),
+        verdict.tests.size());
+  } else {
+    hash = signature_hash(failure_signature(verdict));
+  }
+  const char* slots = table->data() + sizeof(header);
+  const std::uint32_t mask = header.slot_count - 1;
+  for (std::uint32_t probe = 0, i = hash & mask; probe < header.slot_count;
+       ++probe, i = (i + 1) & mask) {
+    ClusterSlot slot;
+    std::memcpy(&slot, slots + i * sizeof(slot), sizeof(slot));
+    if (slot.signature_hash == hash) return slot.cluster;
+    if (slot.signature_hash == 0) break;
+  }
+  return std::nullopt;
+}
+
+}  // namespace codecoach::judge
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+
+#include "catalog/problem_bundle.h"
+#include "common/bitset.h"
+#include "judge/verdict.h"
+
+namespace codecoach::judge {
+
+// Bit t is set when test t failed. Skipped tests count as not failed, so
+// signatures are only comparable between verdicts judged in the same mode;
+// clusters are built from full-audit runs.
+Bitset failure_signature(const Verdict& verdict);
+
+// Never 0, which marks an empty table slot.
+std::uint64_t signature_hash(const Bitset& signature);
+
+// Serializes a kFailureClusters section for `bundle`'s full-audit
+// signatures, `clusters` most common first. Besides each signature, it
+// keys the first test a standard-mode submit would fail under each
+// signature, to the cluster of the most common signature failing there
+// first.
+std::string encode_cluster_table(
+    const catalog::ProblemBundle& bundle,
+    std::span<const std::pair<Bitset, std::uint32_t>> clusters);
+
+// The cluster of a submit verdict, looked up in the bundle's
+// kFailureClusters section: one hash and a short probe, no allocation
+// beyond the signature. A verdict that ran every test is matched on its
+// whole signature. One that skipped tests stopped at its first failure,
+// and the tests it ran tell only which one that was, so it is matched on
+// that test alone: the likeliest cluster, not an exact one. nullopt when
+// the bundle has no table or nothing matched when clustering.
+std::optional<std::uint32_t> find_failure_cluster(
+    const catalog::ProblemBundle& bundle, const Verdict& verdict);
+
+}  // namespace codecoach::judge
@@ -0,0 +1,55 @@
+#include "judge/local_runner.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "common/subprocess.h"
+#include "judge/checker.h"
+
+namespace codecoach::judge {
+
+TestResult run_test_locally(const std::filesystem::path& executable,
+                            const catalog::TestCase& test,
+                            const RunLimits& limits,
+                            sandbox::PerfSample* counters) {
+  ProcessLimits process_limits;
+  // CPU time is what is graded; the wall clock only guards against a
+  // program that sleeps or blocks.
+  process_limits.wall_time =
+      std::chrono::milliseconds(2 * limits.time_limit_ms + 100);
+  // Leave headroom over the graded limit so the runtime can start; the
+  // peak RSS below decides MLE.
+  process_limits.address_space_bytes =
+      std::uint64_t{limits.memory_limit_kb} * 1024 * 2 + (64u << 20);
+
+  sandbox::PerfCounters perf;
+  std::function<void(int)> attach;
+  if (counters != nullptr) {
+    attach = [&](int pid) { perf = sandbox::PerfCounters::for_exec_of(pid); };
+  }
+  const auto run = run_process({executable.string()}, test.input,
+                               process_limits, {}, attach);
+  if (counters != nullptr) *counters = perf.read();
+
+  TestResult result;
+  result.time_ms = static_cast<std::uint32_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(run.cpu_time)
+          .count());
+  result.memory_kb = static_cast<std::uint32_t>(
+      std::min<std::uint64_t>(run.max_rss_kb, UINT32_MAX));
+
+  if (run.timed_out || result.time_ms > limits.time_limit_ms) {
+    result.outcome = Outcome::kTimeLimit;
+  } else if (result.memory_kb > limits.memory_limit_kb) {
+    result.outcome = Outcome::kMemoryLimit;
+  } else if (!run.ok() || run.output_limit_exceeded) {
+    result.outcome = Outcome::kRuntimeError;
+  } else if (!tokens_match(test.expected_output, run.stdout_data)) {
+    result.outcome = Outcome::kWrongAnswer;
+  } else {
+    result.outcome = Outcome::kAccepted;
+  }
+  return result;
+}
+
+}  // namespace codecoach::judge
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include "catalog/problem_bundle.h"
+#include "judge/verdict.h"
+#include "sandbox/perf_counters.h"
+
+namespace codecoach::judge {
+
+struct RunLimits {
+  std::uint32_t time_limit_ms = 1000;
+  std::uint32_t memory_limit_kb = 256 * 1024;
+
+  static RunLimits of(const catalog::ProblemBundle& bundle) {
+    return {bundle.time_limit_ms(), bundle.memory_limit_kb()};
+  }
+};
+
+// Runs `executable` on one test without a sandbox and grades it with the
+// default checker. For offline tooling on isolated batch hosts (test
+// pruning, mutation analysis, bundle builds) and for the in-process
+// judge::Evaluator behind load replays; only the fleet's judge runs
+// submissions inside a sandbox::Sandbox.
+//
+// With `counters`, the run is also measured with hardware performance
+// counters (see sandbox::PerfCounters); events the host lacks stay empty.
+TestResult run_test_locally(const std::filesystem::path& executable,
+                            const catalog::TestCase& test,
+                            const RunLimits& limits,
+                            sandbox::PerfSample* counters = nullptr);
+
+}  // namespace codecoach::judge
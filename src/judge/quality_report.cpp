@@ -0,0 +1,183 @@
+#include "judge/quality_report.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <optional>
+#include <string>
+
+#include "judge/local_runner.h"
+
+namespace codecoach::judge {
+
+namespace {
+
+using sandbox::PerfEvent;
+using sandbox::PerfSample;
+
+json::Value optional_number(std::optional<double> value) {
+  if (!value) return nullptr;
+  // Two decimals keep the payload short for the coach.
+  return static_cast<double>(static_cast<std::int64_t>(*value * 100 + 0.5)) /
+         100;
+}
+
+json::Value optional_count(std::optional<std::uint64_t> value) {
+  if (!value) return nullptr;
+  return static_cast<std::int64_t>(*value);
+}
+
+std::optional<double> normalized_cycles(const PerfSample& sample,
+                                        const sandbox::NodeCalibration& node) {
+  const auto cycles = sample.get(PerfEvent::kCycles);
+  if (!cycles) return std::nullopt;
+  return node.normalize_cycles(*cycles);
+}
+
+json::Object metrics(const PerfSample& sample,
+                     const sandbox::NodeCalibration& node) {
+  json::Object object;
+  object["instructions"] = optional_count(sample.get(PerfEvent::kInstructions));
+  object["normalized_cycles"] =
+      optional_number(normalized_cycles(sample, node));
+  object["ipc"] = optional_number(sample.ipc());
+  object["cache_mpki"] =
+      optional_number(sample.per_kilo_instruction(PerfEvent::kCacheMisses));
+  object["cache_miss_rate"] = optional_number(
+      sample.miss_rate(PerfEvent::kCacheMisses, PerfEvent::kCacheReferences));
+  object["branch_mpki"] =
+      optional_number(sample.per_kilo_instruction(PerfEvent::kBranchMisses));
+  object["branch_miss_rate"] = optional_number(
+      sample.miss_rate(PerfEvent::kBranchMisses, PerfEvent::kBranches));
+  return object;
+}
+
+std::optional<double> ratio(std::optional<double> mine,
+                            std::optional<double> theirs) {
+  if (!mine || !theirs || *theirs <= 0) return std::nullopt;
+  return *mine / *theirs;
+}
+
+std::optional<double> as_double(std::optional<std::uint64_t> value) {
+  if (!value) return std::nullopt;
+  return static_cast<double>(*value);
+}
+
+std::string times(double r) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.1fx", r);
+  return buf;
+}
+
+}  // namespace
+
+QualityReport profile_solution(const catalog::ProblemBundle& bundle,
+                               const std::filesystem::path& executable,
+                               const sandbox::NodeCalibration& calibration,
+                               catalog::JudgeMode mode) {
+  QualityReport report;
+  report.calibration = calibration;
+  const auto limits = RunLimits::of(bundle);
+  bool first = true;
+  // Sequential on purpose: concurrent runs would share caches and skew the
+  // very counters being measured.
+  for (std::size_t t = 0; t < bundle.test_count(); ++t) {
+    const auto test = bundle.test(t);
+    if (!catalog::runs_in(test, mode)) continue;
+    TestProfile profile{t, {}, {}};
+    profile.result = run_test_locally(executable, test, limits,
+                                      &profile.counters);
+    if (first) {
+      report.total = profile.counters;
+      first = false;
+    } else {
+      report.total += profile.counters;
+    }
+    report.tests.push_back(std::move(profile));
+  }
+  return report;
+}
+
+json::Value report_json(const QualityReport& report,
+                        const QualityReport* reference) {
+  json::Object root;
+  root["counters_available"] = report.counters_available();
+  root["total"] = metrics(report.total, report.calibration);
+
+  std::vector<const TestProfile*> heaviest;
+  for (const auto& profile : report.tests) heaviest.push_back(&profile);
+  const auto cycles_of = [](const TestProfile* p) {
+    return p->counters.get(PerfEvent::kCycles).value_or(0);
+  };
+  std::stable_sort(heaviest.begin(), heaviest.end(),
+                   [&](const TestProfile* a, const TestProfile* b) {
+                     return cycles_of(a) > cycles_of(b);
+                   });
+  heaviest.resize(std::min<std::size_t>(heaviest.size(), 3));
+  json::Array tests;
+  for (const TestProfile* profile : heaviest) {
+    auto object = metrics(profile->counters, report.calibration);
+    object["test"] = static_cast<std::int64_t>(profile->test + 1);
+    object["outcome"] = std::string(to_string(profile->result.outcome));
+    object["time_ms"] = static_cast<std::int64_t>(profile->result.time_ms);
+    tests.emplace_back(std::move(object));
+  }
+  root["heaviest_tests"] = std::move(tests);
+
+  if (reference == nullptr || !reference->counters_available()) {
+    return root;
+  }
+  const PerfSample& mine = report.total;
+  const PerfSample& theirs = reference->total;
+  const auto work = ratio(as_double(mine.get(PerfEvent::kInstructions)),
+                          as_double(theirs.get(PerfEvent::kInstructions)));
+  const auto cycles = ratio(normalized_cycles(mine, report.calibration),
+                            normalized_cycles(theirs, reference->calibration));
+  const auto cache =
+      ratio(mine.per_kilo_instruction(PerfEvent::kCacheMisses),
+            theirs.per_kilo_instruction(PerfEvent::kCacheMisses));
+  const auto branch =
+      ratio(mine.per_kilo_instruction(PerfEvent::kBranchMisses),
+            theirs.per_kilo_instruction(PerfEvent::kBranchMisses));
+  const auto ipc = ratio(mine.ipc(), theirs.ipc());
+
+  json::Object vs;
+  vs["cycles"] = optional_number(cycles);
+  vs["instructions"] = optional_number(work);
+  vs["cache_mpki"] = optional_number(cache);
+  vs["branch_mpki"] = optional_number(branch);
+  vs["ipc"] = optional_number(ipc);
+  root["vs_reference"] = std::move(vs);
+
+  // Thresholds pick out differences worth a sentence; small ones are noise.
+  json::Array findings;
+  if (work && *work >= 1.5) {
+    findings.emplace_back(
+        "executes " + times(*work) +
+        " the reference's instructions: more work overall (algorithm or "
+        "constant factor)");
+  }
+  const auto own_cache =
+      mine.per_kilo_instruction(PerfEvent::kCacheMisses).value_or(0);
+  if (cache && *cache >= 1.5 && own_cache >= 1) {
+    findings.emplace_back(
+        times(*cache) +
+        " the reference's cache misses per instruction: poor memory "
+        "locality (pointer-heavy structures, scattered access)");
+  }
+  const auto own_branch =
+      mine.per_kilo_instruction(PerfEvent::kBranchMisses).value_or(0);
+  if (branch && *branch >= 1.5 && own_branch >= 1) {
+    findings.emplace_back(
+        times(*branch) +
+        " the reference's branch mispredictions per instruction: "
+        "data-dependent branches in the hot loop");
+  }
+  if (ipc && *ipc <= 1 / 1.5) {
+    findings.emplace_back("instructions per cycle at " + times(*ipc) +
+                          " of the reference: the CPU stalls more often");
+  }
+  root["findings"] = std::move(findings);
+  return root;
+}
+
+}  // namespace codecoach::judge
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+#include "catalog/problem_bundle.h"
+#include "common/json.h"
+#include "judge/verdict.h"
+#include "sandbox/perf_counters.h"
+
+namespace codecoach::judge {
+
+struct TestProfile {
+  std::size_t test = 0;
+  TestResult result;
+  sandbox::PerfSample counters;
+};
+
+// Hardware-counter profile of one solution over a problem's tests: the
+// "why is my O(n log n) slower than the top solution" view. Optional and
+// offline: it reruns the tests outside the grading path.
+struct QualityReport {
+  std::vector<TestProfile> tests;
+  sandbox::PerfSample total;  // Sum over the tests.
+  sandbox::NodeCalibration calibration;
+
+  bool counters_available() const { return total.any(); }
+};
+
+QualityReport profile_solution(const catalog::ProblemBundle& bundle,
+                               const std::filesystem::path& executable,
+                               const sandbox::NodeCalibration& calibration,
+                               catalog::JudgeMode mode);
+
+// Compact structured form for the coach: totals, the three heaviest tests,
+// and with `reference` (e.g. the fastest accepted solution) per-metric
+// ratios and plain-language findings. Only node-independent figures are
+// included: instruction counts, per-instruction rates and normalized
+// cycles.
+json::Value report_json(const QualityReport& report,
+                        const QualityReport* reference = nullptr);
+
+}  // namespace codecoach::judge
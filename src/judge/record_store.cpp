@@ -0,0 +1,94 @@
+#include "judge/record_store.h"
+
+#include <utility>
+
+#include "api/binary_codec.h"
+#include "storage/coding.h"
+
+namespace codecoach::judge {
+
+namespace {
+
+std::string job_key(JobId job) {
+  std::string key(8, '\0');
+  for (int i = 7; i >= 0; --i, job >>= 8) {
+    key[i] = static_cast<char>(job & 0xff);
+  }
+  return key;
+}
+
+std::string encode_hint(const coach::Hint& hint) {
+  std::string out;
+  storage::coding::put_u8(out, static_cast<std::uint8_t>(hint.source));
+  storage::coding::put_u64(out, hint.step);
+  storage::coding::put_bytes(out, hint.failure_class);
+  storage::coding::put_bytes(out, hint.text);
+  return out;
+}
+
+}  // namespace
+
+storage::LsmStore::Families RecordStore::families() {
+  storage::ColumnFamilyOptions records;
+  records.compaction_trigger = 8;
+  storage::ColumnFamilyOptions artifacts;
+  artifacts.memtable_bytes = 1u << 20;
+  artifacts.bloom_bits_per_key = 14;
+  artifacts.compaction_trigger = 2;
+  return {{std::string(kSubmissions), records},
+          {std::string(kVerdicts), records},
+          {std::string(kCoach), records},
+          {std::string(kArtifacts), artifacts}};
+}
+
+RecordStore::RecordStore(std::filesystem::path directory,
+                         storage::LsmOptions options)
+    : store_(std::move(directory), families(), options), writer_(store_) {}
+
+std::size_t RecordStore::index(compile::CompileCache& cache) {
+  return cache.persist_index(store_, writer_, std::string(kArtifacts));
+}
+
+bool RecordStore::record(const api::SubmitRequest& submission,
+                         const api::VerdictResponse& response,
+                         const std::optional<coach::Hint>& hint) {
+  const std::string key = job_key(submission.job_id);
+  std::string value;
+  storage::WriteBatch batch;
+  api::binary_codec::encode(submission, value);
+  batch.put(kSubmissions, key, value);
+  value.clear();
+  api::binary_codec::encode(response, value);
+  batch.put(kVerdicts, key, value);
+  if (hint && hint->source != coach::Hint::Source::kNone) {
+    batch.put(kCoach, key, encode_hint(*hint));
+  }
+  return writer_.submit(std::move(batch));
+}
+
+std::optional<api::VerdictResponse> RecordStore::verdict(JobId job) const {
+  const auto value = store_.get(kVerdicts, job_key(job));
+  if (!value) return std::nullopt;
+  return api::binary_codec::decode_verdict(*value).to_owned();
+}
+
+std::optional<coach::Hint> RecordStore::hint(JobId job) const {
+  const auto value = store_.get(kCoach, job_key(job));
+  if (!value) return std::nullopt;
+  storage::coding::Reader in(*value);
+  std::uint8_t source = 0;
+  std::uint64_t step = 0;
+  std::string_view failure_class, text;
+  if (!in.u8(source) || !in.u64(step) || !in.bytes(failure_class) ||
+      !in.bytes(text) || source > 2) {
+    throw storage::CorruptionError("coach record " + std::to_string(job));
+  }
+  coach::Hint hint;
+  hint.source = static_cast<coach::Hint::Source>(source);
+  hint.step = static_cast<std::size_t>(step);
+  hint.failure_class = failure_class;
+  hint.text = text;
+  return hint;
+}
+
+}  // namespace codecoach::judge
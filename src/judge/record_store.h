@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "api/messages.h"
+#include "coach/coach.h"
+#include "compile/compile_cache.h"
+#include "storage/async_writer.h"
+#include "storage/lsm_store.h"
+
+namespace codecoach::judge {
+
+// Durable record of judged work in the embedded LSM store, one column
+// family per data kind, keyed by job id (big-endian, so scans run in id
+// order):
+//
+//   submissions  api::SubmitRequest, binary codec
+//   verdicts     api::VerdictResponse, binary codec
+//   coach        the hint served, when there was one
+//   artifacts    compile-cache index (compile::CompileCache), by cache key
+//
+// Records are queued on an AsyncWriter: storage latency never reaches the
+// verdict path, and when storage falls far behind records are dropped and
+// counted instead. Thread-safe.
+class RecordStore {
+ public:
+  static constexpr std::string_view kSubmissions = "submissions";
+  static constexpr std::string_view kVerdicts = "verdicts";
+  static constexpr std::string_view kCoach = "coach";
+  static constexpr std::string_view kArtifacts = "artifacts";
+
+  // Tuned per family: append-heavy records compact rarely; the artifact
+  // index, scanned whole at startup, keeps few tables.
+  static storage::LsmStore::Families families();
+
+  explicit RecordStore(std::filesystem::path directory,
+                       storage::LsmOptions options = {});
+
+  // Makes the artifacts family `cache`'s persistent index and loads it
+  // (compile::CompileCache::persist_index). Returns the entries loaded.
+  // Call before the cache is shared between threads.
+  std::size_t index(compile::CompileCache& cache);
+
+  // Queues the records of one judged submission. False if they were
+  // dropped because the writer is too far behind.
+  bool record(const api::SubmitRequest& submission,
+              const api::VerdictResponse& response,
+              const std::optional<coach::Hint>& hint);
+
+  std::optional<api::VerdictResponse> verdict(JobId job) const;
+  std::optional<coach::Hint> hint(JobId job) const;
+
+  // Waits until every record queued so far is written or dropped.
+  void drain() { writer_.drain(); }
+
+  storage::LsmStore& store() { return store_; }
+  const storage::AsyncWriter& writer() const { return writer_; }
+
+ private:
+  storage::LsmStore store_;
+  storage::AsyncWriter writer_;
+};
+
+}  // namespace codecoach::judge
@@ -0,0 +1,183 @@
+#include "judge/slo_tracker.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace codecoach::judge {
+
+namespace {
+
+constexpr std::uint64_t kLightBudgetMs = 2'000;
+constexpr std::uint64_t kStandardBudgetMs = 20'000;
+
+std::chrono::microseconds micros(std::uint64_t value) {
+  return std::chrono::microseconds(static_cast<std::int64_t>(value));
+}
+
+}  // namespace
+
+ProblemClass classify(const catalog::ProblemBundle& bundle) {
+  std::uint64_t tests = 0;
+  for (std::size_t t = 0; t < bundle.test_count(); ++t) {
+    if (catalog::runs_in(bundle.test(t), catalog::JudgeMode::kStandard)) {
+      ++tests;
+    }
+  }
+  const std::uint64_t budget_ms = tests * bundle.time_limit_ms();
+  if (budget_ms < kLightBudgetMs) return ProblemClass::kLight;
+  if (budget_ms < kStandardBudgetMs) return ProblemClass::kStandard;
+  return ProblemClass::kHeavy;
+}
+
+SloTracker::SloTracker(SloOptions options)
+    : options_(options),
+      buckets_(std::max<std::size_t>(options.windows, 1)) {}
+
+void SloTracker::add_knob(std::string name, Pressure level, Knob knob) {
+  std::lock_guard evaluating(evaluate_mu_);
+  std::lock_guard lock(mu_);
+  knobs_.push_back({std::move(name), level, std::move(knob)});
+}
+
+std::int64_t SloTracker::epoch_of(Clock::time_point now) const {
+  const auto window = std::max<std::chrono::seconds::rep>(
+      options_.window.count(), 1);
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             now.time_since_epoch())
+             .count() /
+         window;
+}
+
+SloTracker::Bucket& SloTracker::bucket_locked(std::int64_t epoch) {
+  Bucket& bucket = buckets_[static_cast<std::size_t>(epoch) %
+                            buckets_.size()];
+  if (bucket.epoch != epoch) {
+    for (auto& histogram : bucket.latency) histogram.clear();
+    bucket.over.fill(0);
+    bucket.epoch = epoch;
+  }
+  return bucket;
+}
+
+void SloTracker::record(Action action, ProblemClass cls,
+                        std::chrono::microseconds latency,
+                        Clock::time_point now) {
+  const auto a = static_cast<std::size_t>(action);
+  const auto c = static_cast<std::size_t>(cls);
+  const std::size_t key = a * kProblemClassCount + c;
+  const SloTarget& target = options_.targets[a][c];
+  bool due = false;
+  {
+    std::lock_guard lock(mu_);
+    Bucket& bucket = bucket_locked(epoch_of(now));
+    const auto us = std::max<std::int64_t>(latency.count(), 0);
+    bucket.latency[key].record(static_cast<std::uint64_t>(us));
+    if (target.latency.count() > 0 && latency > target.latency) {
+      ++bucket.over[key];
+    }
+    due = now - evaluated_ >= options_.evaluate_every;
+  }
+  if (due) evaluate(now);
+}
+
+std::pair<double, double> SloTracker::burn_locked(std::size_t key,
+                                                  std::int64_t epoch) const {
+  const SloTarget& target =
+      options_.targets[key / kProblemClassCount][key % kProblemClassCount];
+  const double budget = 1.0 - target.quantile;
+  if (target.latency.count() <= 0 || budget <= 0) return {0.0, 0.0};
+  std::uint64_t short_count = 0, short_over = 0;
+  std::uint64_t long_count = 0, long_over = 0;
+  for (const Bucket& bucket : buckets_) {
+    if (bucket.epoch < 0 ||
+        epoch - bucket.epoch >= static_cast<std::int64_t>(buckets_.size())) {
+      continue;
+    }
+    long_count += bucket.latency[key].count();
+    long_over += bucket.over[key];
+    if (epoch - bucket.epoch <= 1) {
+      short_count += bucket.latency[key].count();
+      short_over += bucket.over[key];
+    }
+  }
+  if (short_count < options_.min_samples) return {0.0, 0.0};
+  return {static_cast<double>(short_over) / short_count / budget,
+          static_cast<double>(long_over) / long_count / budget};
+}
+
+Pressure SloTracker::evaluate(Clock::time_point now) {
+  std::lock_guard evaluating(evaluate_mu_);
+  std::vector<std::pair<Knob*, bool>> flips;
+  Pressure pressure = Pressure::kNormal;
+  {
+    std::lock_guard lock(mu_);
+    evaluated_ = now;
+    const std::int64_t epoch = epoch_of(now);
+    for (std::size_t key = 0; key < kKeys; ++key) {
+      const auto [short_burn, long_burn] = burn_locked(key, epoch);
+      const double burn = std::min(short_burn, long_burn);
+      if (burn >= options_.critical_burn) {
+        pressure = Pressure::kCritical;
+      } else if (burn >= options_.elevated_burn) {
+        pressure = std::max(pressure, Pressure::kElevated);
+      }
+    }
+    pressure_ = pressure;
+    for (KnobState& knob : knobs_) {
+      const bool engage = pressure >= knob.level;
+      if (engage == knob.engaged) continue;
+      knob.engaged = engage;
+      if (engage) ++knob.engagements;
+      flips.emplace_back(&knob.set, engage);
+    }
+  }
+  // add_knob() also takes evaluate_mu_, so the pointers stay valid here.
+  for (const auto& [set, engage] : flips) (*set)(engage);
+  return pressure;
+}
+
+Pressure SloTracker::pressure() const {
+  std::lock_guard lock(mu_);
+  return pressure_;
+}
+
+std::vector<SloStatus> SloTracker::status(Clock::time_point now) const {
+  std::lock_guard lock(mu_);
+  const std::int64_t epoch = epoch_of(now);
+  std::vector<SloStatus> out;
+  for (std::size_t key = 0; key < kKeys; ++key) {
+    LatencyHistogram merged;
+    for (const Bucket& bucket : buckets_) {
+      if (bucket.epoch < 0 || epoch - bucket.epoch >=
+                                  static_cast<std::int64_t>(buckets_.size())) {
+        continue;
+      }
+      merged.merge(bucket.latency[key]);
+    }
+    if (merged.count() == 0) continue;
+    SloStatus status;
+    status.action = static_cast<Action>(key / kProblemClassCount);
+    status.problem_class = static_cast<ProblemClass>(key % kProblemClassCount);
+    status.target = options_.targets[key / kProblemClassCount]
+                                    [key % kProblemClassCount];
+    status.count = merged.count();
+    status.p50 = micros(merged.percentile(0.50));
+    status.p95 = micros(merged.percentile(0.95));
+    status.p99 = micros(merged.percentile(0.99));
+    std::tie(status.short_burn, status.long_burn) = burn_locked(key, epoch);
+    out.push_back(status);
+  }
+  return out;
+}
+
+std::vector<std::pair<std::string, std::uint64_t>>
+SloTracker::knob_engagements() const {
+  std::lock_guard lock(mu_);
+  std::vector<std::pair<std::string, std::uint64_t>> out;
+  for (const KnobState& knob : knobs_) {
+    out.emplace_back(knob.name, knob.engagements);
+  }
+  return out;
+}
+
+}  // namespace codecoach::judge
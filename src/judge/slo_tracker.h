@@ -0,0 +1,167 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "catalog/problem_bundle.h"
+#include "common/histogram.h"
+#include "judge/action.h"
+
+namespace codecoach::judge {
+
+// Coarse judging cost of a problem, so a heavy problem's slow verdicts are
+// held to a different target than a one-test warm-up's.
+enum class ProblemClass : std::uint8_t {
+  kLight = 0,     // Under 2 s of worst-case test time.
+  kStandard = 1,  // Under 20 s.
+  kHeavy = 2,
+};
+
+inline constexpr std::size_t kProblemClassCount = 3;
+
+constexpr std::string_view to_string(ProblemClass cls) {
+  switch (cls) {
+    case ProblemClass::kLight: return "light";
+    case ProblemClass::kStandard: return "standard";
+    case ProblemClass::kHeavy: return "heavy";
+  }
+  return "unknown";
+}
+
+// By worst-case time on the standard test set: time limit x test count.
+ProblemClass classify(const catalog::ProblemBundle& bundle);
+
+// How far the service is from its latency targets.
+enum class Pressure : std::uint8_t {
+  kNormal = 0,
+  kElevated = 1,  // Burning error budget faster than it accrues.
+  kCritical = 2,  // Burning fast enough to exhaust it within hours.
+};
+
+constexpr std::string_view to_string(Pressure pressure) {
+  switch (pressure) {
+    case Pressure::kNormal: return "normal";
+    case Pressure::kElevated: return "elevated";
+    case Pressure::kCritical: return "critical";
+  }
+  return "unknown";
+}
+
+// `quantile` of end-to-end verdict latencies must stay within `latency`.
+// A zero latency means no target.
+struct SloTarget {
+  double quantile = 0.95;
+  std::chrono::milliseconds latency{0};
+};
+
+struct SloOptions {
+  // By [action][problem class].
+  std::array<std::array<SloTarget, kProblemClassCount>, kActionCount>
+      targets{};
+  // Latencies are kept in `windows` rolling buckets of `window` each. The
+  // newest two (the filling one and the last full one) are the short burn
+  // window, all of them the long one.
+  std::chrono::seconds window{60};
+  std::size_t windows = 10;
+  // Burn rate: the share of verdicts over target divided by the share the
+  // target allows. A level holds while both windows burn at least this
+  // fast; the long window ignores blips, the short one clears quickly.
+  double elevated_burn = 2.0;
+  double critical_burn = 10.0;
+  // Short windows with fewer verdicts than this don't count.
+  std::uint64_t min_samples = 20;
+  // Pressure is re-evaluated on record() at most this often.
+  std::chrono::milliseconds evaluate_every{1000};
+};
+
+struct SloStatus {
+  Action action = Action::kSubmit;
+  ProblemClass problem_class = ProblemClass::kStandard;
+  SloTarget target;
+  std::uint64_t count = 0;  // Long window.
+  std::chrono::microseconds p50{0};
+  std::chrono::microseconds p95{0};
+  std::chrono::microseconds p99{0};
+  double short_burn = 0;
+  double long_burn = 0;
+};
+
+// Tracks end-to-end verdict latency per action and problem class over
+// rolling windows, compares it against the configured targets and turns
+// the error-budget burn rate into a pressure level. Knobs registered with
+// add_knob() are engaged while pressure is at or above their level: each
+// is a piece of optional work (live hints, diagnostics, eager batching...)
+// that the owner is willing to give up to hold the latency target.
+// Thread-safe.
+class SloTracker {
+ public:
+  using Clock = std::chrono::steady_clock;
+  // Called with true to engage, false to release. Runs on the thread that
+  // triggered the evaluation, outside the tracker's lock.
+  using Knob = std::function<void(bool engaged)>;
+
+  explicit SloTracker(SloOptions options);
+
+  void add_knob(std::string name, Pressure level, Knob knob);
+
+  void record(Action action, ProblemClass cls,
+              std::chrono::microseconds latency, Clock::time_point now);
+  void record(Action action, ProblemClass cls,
+              std::chrono::microseconds latency) {
+    record(action, cls, latency, Clock::now());
+  }
+
+  // Recomputes pressure and flips knobs whose state changed.
+  Pressure evaluate(Clock::time_point now);
+  Pressure pressure() const;
+
+  // Every (action, class) pair with verdicts in the long window.
+  std::vector<SloStatus> status(Clock::time_point now) const;
+
+  // Number of times each knob was engaged, in add_knob() order.
+  std::vector<std::pair<std::string, std::uint64_t>> knob_engagements()
+      const;
+
+ private:
+  static constexpr std::size_t kKeys = kActionCount * kProblemClassCount;
+
+  struct Bucket {
+    std::int64_t epoch = -1;  // Window number since the clock's epoch.
+    std::array<LatencyHistogram, kKeys> latency;
+    std::array<std::uint64_t, kKeys> over{};  // Verdicts over target.
+  };
+
+  struct KnobState {
+    std::string name;
+    Pressure level;
+    Knob set;
+    bool engaged = false;
+    std::uint64_t engagements = 0;
+  };
+
+  std::int64_t epoch_of(Clock::time_point now) const;
+  Bucket& bucket_locked(std::int64_t epoch);
+  // Short and long burn rates of one key; zero without a target or enough
+  // verdicts.
+  std::pair<double, double> burn_locked(std::size_t key,
+                                        std::int64_t epoch) const;
+
+  const SloOptions options_;
+  // Serializes evaluations, so knob flips land in order.
+  std::mutex evaluate_mu_;
+  mutable std::mutex mu_;
+  std::vector<Bucket> buckets_;
+  std::vector<KnobState> knobs_;
+  Pressure pressure_ = Pressure::kNormal;
+  Clock::time_point evaluated_{};
+};
+
+}  // namespace codecoach::judge
@@ -0,0 +1,136 @@
+#include "judge/source_normalizer.h"
+
+#include <cctype>
+
+namespace codecoach::judge {
+
+namespace {
+
+void trim_trailing_blanks(std::string& out) {
+  while (!out.empty() && (out.back() == ' ' || out.back() == '\t')) {
+    out.pop_back();
+  }
+}
+
+// Copies a quoted literal starting at source[i] (the opening quote) and
+// returns the index just past it.
+std::size_t copy_quoted(std::string_view source, std::size_t i,
+                        std::string& out) {
+  const char quote = source[i];
+  out += source[i++];
+  while (i < source.size()) {
+    const char c = source[i];
+    out += c;
+    ++i;
+    if (c == '\\' && i < source.size()) {
+      out += source[i++];
+    } else if (c == quote || c == '\n') {
+      break;
+    }
+  }
+  return i;
+}
+
+// Copies R"delim(...)delim" starting at source[i] (the opening quote).
+std::size_t copy_raw_string(std::string_view source, std::size_t i,
+                            std::string& out) {
+  const std::size_t open = source.find('(', i);
+  if (open == std::string_view::npos) return copy_quoted(source, i, out);
+  const std::string close =
+      ")" + std::string(source.substr(i + 1, open - i - 1)) + "\"";
+  const std::size_t end = source.find(close, open);
+  const std::size_t stop =
+      end == std::string_view::npos ? source.size() : end + close.size();
+  out.append(source.substr(i, stop - i));
+  return stop;
+}
+
+bool is_identifier_char(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// The identifier or number token that `out` currently ends with.
+std::string_view trailing_token(const std::string& out) {
+  std::size_t start = out.size();
+  while (start > 0 && is_identifier_char(out[start - 1])) --start;
+  return std::string_view(out).substr(start);
+}
+
+}  // namespace
+
+std::string normalize_source(std::string_view source) {
+  std::string out;
+  out.reserve(source.size());
+  std::size_t i = 0;
+  while (i < source.size()) {
+    const char c = source[i];
+    const char next = i + 1 < source.size() ? source[i + 1] : '\0';
+
+    if (c == '/' && next == '/') {
+      // Line comment: drop up to (not including) the newline. A trailing
+      // backslash continues the comment onto the next line; the line break
+      // it swallows is kept, so later lines keep their numbers.
+      while (i < source.size() && source[i] != '\n') {
+        std::size_t j = i + 1;
+        if (source[i] == '\\' && j < source.size() && source[j] == '\r') ++j;
+        if (source[i] == '\\' && j < source.size() && source[j] == '\n') {
+          trim_trailing_blanks(out);
+          out += '\n';
+          i = j + 1;
+        } else {
+          ++i;
+        }
+      }
+    } else if (c == '/' && next == '*') {
+      const std::size_t end = source.find("*/", i + 2);
+      const std::size_t stop =
+          end == std::string_view::npos ? source.size() : end + 2;
+      // A comment separates tokens; keep one space and any line breaks.
+      out += ' ';
+      for (std::size_t j = i; j < stop; ++j) {
+        if (source[j] == '\n') {
+          trim_trailing_blanks(out);
+          out += '\n';
+        }
+      }
+      i = stop;
+    } else if (c == 'R' && next == '"') {
+      // R"( is a raw string only as a token of its own or after an
+      // encoding prefix; otherwise it is the tail of an identifier.
+      const auto prefix = trailing_token(out);
+      out += 'R';
+      if (prefix.empty() || prefix == "u8" || prefix == "u" ||
+          prefix == "U" || prefix == "L") {
+        i = copy_raw_string(source, i + 1, out);
+      } else {
+        ++i;
+      }
+    } else if (c == '"') {
+      i = copy_quoted(source, i, out);
+    } else if (c == '\'') {
+      // Inside a number this is a digit separator (1'000'000).
+      const auto token = trailing_token(out);
+      if (!token.empty() &&
+          std::isdigit(static_cast<unsigned char>(token.front()))) {
+        out += c;
+        ++i;
+      } else {
+        i = copy_quoted(source, i, out);
+      }
+    } else if (c == '\r' && next == '\n') {
+      ++i;
+    } else if (c == '\n') {
+      trim_trailing_blanks(out);
+      out += '\n';
+      ++i;
+    } else {
+      out += c;
+      ++i;
+    }
+  }
+  trim_trailing_blanks(out);
+  while (!out.empty() && out.back() == '\n') out.pop_back();
+  return out;
+}
+
+}  // namespace codecoach::judge
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace codecoach::judge {
+
+// Canonical form of a C++ submission for deduplication: comments removed,
+// CRLF folded to LF, trailing whitespace and trailing blank lines dropped.
+//
+// Line structure is preserved on purpose (block comments keep their line
+// breaks), so preprocessor directives stay intact and runtime behaviour is
+// identical for every source with the same normal form. String, character
+// and raw string literals are copied verbatim.
+std::string normalize_source(std::string_view source);
+
+}  // namespace codecoach::judge
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace codecoach::judge {
+
+enum class Outcome : std::uint8_t {
+  kAccepted = 0,
+  kWrongAnswer = 1,
+  kTimeLimit = 2,
+  kMemoryLimit = 3,
+  kRuntimeError = 4,
+  kCompileError = 5,
+  kInternalError = 6,
+  kSkipped = 7,  // Not run because an earlier test already failed.
+};
+
+inline constexpr std::uint8_t kOutcomeCount = 8;
+
+constexpr std::string_view to_string(Outcome outcome) {
+  switch (outcome) {
+    case Outcome::kAccepted: return "AC";
+    case Outcome::kWrongAnswer: return "WA";
+    case Outcome::kTimeLimit: return "TLE";
+    case Outcome::kMemoryLimit: return "MLE";
+    case Outcome::kRuntimeError: return "RE";
+    case Outcome::kCompileError: return "CE";
+    case Outcome::kInternalError: return "IE";
+    case Outcome::kSkipped: return "SKIP";
+  }
+  return "?";
+}
+
+inline std::optional<Outcome> outcome_from_string(std::string_view name) {
+  for (std::uint8_t i = 0; i < kOutcomeCount; ++i) {
+    const auto outcome = static_cast<Outcome>(i);
+    if (to_string(outcome) == name) return outcome;
+  }
+  return std::nullopt;
+}
+
+struct TestResult {
+  Outcome outcome = Outcome::kSkipped;
+  std::uint32_t time_ms = 0;
+  std::uint32_t memory_kb = 0;
+
+  bool operator==(const TestResult&) const = default;
+};
+
+struct Verdict {
+  Outcome overall = Outcome::kInternalError;
+  std::vector<TestResult> tests;
+  std::string compile_log;  // Compiler output; empty on a clean build.
+
+  bool operator==(const Verdict&) const = default;
+};
+
+}  // namespace codecoach::judge
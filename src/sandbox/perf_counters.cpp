@@ -0,0 +1,205 @@
+#include "sandbox/perf_counters.h"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace codecoach::sandbox {
+
+namespace {
+
+constexpr std::array<std::uint64_t, kPerfEventCount> kConfigs = {
+    PERF_COUNT_HW_CPU_CYCLES,       PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+// Scale for NodeCalibration: normalized cycles are what the program would
+// take on a node where the reference workload takes exactly this many.
+constexpr double kReferenceScale = 1e9;
+
+int perf_event_open(perf_event_attr& attr, int pid) {
+  return static_cast<int>(::syscall(SYS_perf_event_open, &attr, pid, -1, -1,
+                                    PERF_FLAG_FD_CLOEXEC));
+}
+
+// Fixed mix of dependent cache-missing loads, arithmetic and unpredictable
+// branches; deterministic so every node runs exactly the same work.
+std::uint64_t reference_workload() {
+  constexpr std::size_t kSlots = std::size_t{1} << 21;  // 8 MiB of indices.
+  std::vector<std::uint32_t> next(kSlots);
+  std::iota(next.begin(), next.end(), 0u);
+  std::uint64_t state = 0x9e3779b97f4a7c15ULL;
+  const auto random = [&] {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 33;
+  };
+  // Sattolo's algorithm: a single cycle through every slot.
+  for (std::size_t i = kSlots - 1; i > 0; --i) {
+    std::swap(next[i], next[random() % i]);
+  }
+  std::uint64_t sink = 0;
+  std::uint32_t at = 0;
+  for (std::size_t i = 0; i < (std::size_t{1} << 20); ++i) at = next[at];
+  sink += at;
+  for (std::size_t i = 0; i < (std::size_t{1} << 22); ++i) {
+    sink = sink * 31 + i;
+  }
+  for (std::size_t i = 0; i < (std::size_t{1} << 21); ++i) {
+    if (random() & 1) sink += i;
+  }
+  return sink;
+}
+
+}  // namespace
+
+std::string_view to_string(PerfEvent event) {
+  switch (event) {
+    case PerfEvent::kCycles: return "cycles";
+    case PerfEvent::kInstructions: return "instructions";
+    case PerfEvent::kCacheReferences: return "cache_references";
+    case PerfEvent::kCacheMisses: return "cache_misses";
+    case PerfEvent::kBranches: return "branches";
+    case PerfEvent::kBranchMisses: return "branch_misses";
+  }
+  return "?";
+}
+
+bool PerfSample::any() const {
+  return std::any_of(counts.begin(), counts.end(),
+                     [](const auto& count) { return count.has_value(); });
+}
+
+std::optional<double> PerfSample::ipc() const {
+  const auto instructions = get(PerfEvent::kInstructions);
+  const auto cycles = get(PerfEvent::kCycles);
+  if (!instructions || !cycles || *cycles == 0) return std::nullopt;
+  return static_cast<double>(*instructions) / static_cast<double>(*cycles);
+}
+
+std::optional<double> PerfSample::per_kilo_instruction(PerfEvent event) const {
+  const auto count = get(event);
+  const auto instructions = get(PerfEvent::kInstructions);
+  if (!count || !instructions || *instructions == 0) return std::nullopt;
+  return 1000.0 * static_cast<double>(*count) /
+         static_cast<double>(*instructions);
+}
+
+std::optional<double> PerfSample::miss_rate(PerfEvent misses,
+                                            PerfEvent total) const {
+  const auto m = get(misses);
+  const auto t = get(total);
+  if (!m || !t || *t == 0) return std::nullopt;
+  return static_cast<double>(*m) / static_cast<double>(*t);
+}
+
+PerfSample& PerfSample::operator+=(const PerfSample& other) {
+  for (std::size_t i = 0; i < kPerfEventCount; ++i) {
+    if (counts[i] && other.counts[i]) {
+      *counts[i] += *other.counts[i];
+    } else {
+      counts[i].reset();
+    }
+  }
+  return *this;
+}
+
+PerfCounters PerfCounters::open(int pid, bool enable_on_exec) {
+  PerfCounters counters;
+  for (std::size_t i = 0; i < kPerfEventCount; ++i) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = kConfigs[i];
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.disabled = enable_on_exec ? 1 : 0;
+    attr.enable_on_exec = enable_on_exec ? 1 : 0;
+    attr.inherit = enable_on_exec ? 1 : 0;
+    // Unsupported events fail with ENOENT/EOPNOTSUPP; keep the rest.
+    counters.fds_[i] = perf_event_open(attr, pid);
+  }
+  return counters;
+}
+
+PerfCounters PerfCounters::for_exec_of(int pid) { return open(pid, true); }
+
+PerfCounters PerfCounters::for_this_thread() { return open(0, false); }
+
+PerfCounters::PerfCounters(PerfCounters&& other) noexcept
+    : fds_(other.fds_) {
+  other.fds_.fill(-1);
+}
+
+PerfCounters& PerfCounters::operator=(PerfCounters&& other) noexcept {
+  if (this != &other) {
+    close_all();
+    fds_ = other.fds_;
+    other.fds_.fill(-1);
+  }
+  return *this;
+}
+
+PerfCounters::~PerfCounters() { close_all(); }
+
+void PerfCounters::close_all() noexcept {
+  for (int& fd : fds_) {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+  }
+}
+
+bool PerfCounters::any() const {
+  return std::any_of(fds_.begin(), fds_.end(), [](int fd) { return fd >= 0; });
+}
+
+PerfSample PerfCounters::read() const {
+  PerfSample sample;
+  for (std::size_t i = 0; i < kPerfEventCount; ++i) {
+    if (fds_[i] < 0) continue;
+    std::uint64_t values[3];  // value, time enabled, time running
+    if (::read(fds_[i], values, sizeof(values)) != sizeof(values)) continue;
+    if (values[2] == 0) {
+      // Never scheduled onto the PMU: unknown, unless it never ran at all.
+      if (values[1] == 0) sample.counts[i] = values[0];
+      continue;
+    }
+    sample.counts[i] = static_cast<std::uint64_t>(
+        static_cast<double>(values[0]) * static_cast<double>(values[1]) /
+        static_cast<double>(values[2]));
+  }
+  return sample;
+}
+
+NodeCalibration NodeCalibration::measure() {
+  NodeCalibration calibration;
+  // Best of three: interference only ever adds cycles.
+  for (int run = 0; run < 3; ++run) {
+    const auto counters = PerfCounters::for_this_thread();
+    volatile std::uint64_t sink = reference_workload();
+    (void)sink;
+    const auto cycles = counters.read().get(PerfEvent::kCycles);
+    if (!cycles) return calibration;
+    calibration.reference_cycles =
+        std::min(calibration.reference_cycles.value_or(UINT64_MAX), *cycles);
+  }
+  return calibration;
+}
+
+std::optional<double> NodeCalibration::normalize_cycles(
+    std::uint64_t cycles) const {
+  if (!reference_cycles || *reference_cycles == 0) return std::nullopt;
+  return static_cast<double>(cycles) * kReferenceScale /
+         static_cast<double>(*reference_cycles);
+}
+
+}  // namespace codecoach::sandbox
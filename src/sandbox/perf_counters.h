@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace codecoach::sandbox {
+
+// Generic perf_event hardware events: every PMU the kernel supports maps
+// these, so no model-specific event codes are needed.
+enum class PerfEvent : std::uint8_t {
+  kCycles = 0,
+  kInstructions = 1,
+  kCacheReferences = 2,  // Last-level cache accesses.
+  kCacheMisses = 3,      // Last-level cache misses.
+  kBranches = 4,
+  kBranchMisses = 5,
+};
+
+inline constexpr std::size_t kPerfEventCount = 6;
+
+std::string_view to_string(PerfEvent event);
+
+struct PerfSample {
+  // Counts scaled up for time the kernel multiplexed the counter out;
+  // nullopt when the host does not provide the event (VMs often lack a
+  // PMU, and perf_event_paranoid may forbid access).
+  std::array<std::optional<std::uint64_t>, kPerfEventCount> counts;
+
+  std::optional<std::uint64_t> get(PerfEvent event) const {
+    return counts[static_cast<std::size_t>(event)];
+  }
+  bool any() const;
+
+  // Instructions per cycle.
+  std::optional<double> ipc() const;
+  // Events per thousand instructions (e.g. cache MPKI). Unlike raw counts
+  // and cycles these depend on the program and input, not on the node's
+  // clock speed, so they compare across nodes as is.
+  std::optional<double> per_kilo_instruction(PerfEvent event) const;
+  // misses / references, or branch misses / branches.
+  std::optional<double> miss_rate(PerfEvent misses, PerfEvent total) const;
+
+  // Sums counters present in both; used to total a run over its tests.
+  PerfSample& operator+=(const PerfSample& other);
+};
+
+// A set of per-process counters, opened with perf_event_open(2) for user
+// space only (exclude_kernel), so they work at perf_event_paranoid <= 2
+// without privileges. Events the host cannot count are skipped rather than
+// failing. Move-only; closes its descriptors on destruction.
+class PerfCounters {
+ public:
+  // Counts `pid` and the threads it creates, starting when it execs. Pair
+  // with run_process's on_spawn hook, which holds the child until then.
+  static PerfCounters for_exec_of(int pid);
+  // Counts the calling thread from now on.
+  static PerfCounters for_this_thread();
+
+  PerfCounters() { fds_.fill(-1); }
+  PerfCounters(PerfCounters&& other) noexcept;
+  PerfCounters& operator=(PerfCounters&& other) noexcept;
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+  ~PerfCounters();
+
+  bool any() const;
+  // Valid while or after the process runs.
+  PerfSample read() const;
+
+ private:
+  static PerfCounters open(int pid, bool enable_on_exec);
+  void close_all() noexcept;
+
+  std::array<int, kPerfEventCount> fds_;
+};
+
+// Converts cycle counts between nodes. Each node times a fixed reference
+// workload (a mix of arithmetic, branches and cache-missing loads) once;
+// dividing a program's cycles by the node's reference cycles gives a
+// figure that is comparable across CPU generations and clock speeds to
+// within a few percent.
+struct NodeCalibration {
+  std::optional<std::uint64_t> reference_cycles;
+
+  static NodeCalibration measure();
+
+  // `cycles` scaled to a node on which the reference workload takes 10^9
+  // cycles. nullopt if this node has no cycle counter.
+  std::optional<double> normalize_cycles(std::uint64_t cycles) const;
+};
+
+}  // namespace codecoach::sandbox
@@ -0,0 +1,69 @@
+#include "sandbox/sandbox_pool.h"
+
+#include <algorithm>
+
+#include "common/parallel.h"
+
+namespace codecoach::sandbox {
+
+SandboxPool::Lease& SandboxPool::Lease::operator=(Lease&& other) noexcept {
+  if (this != &other) {
+    release();
+    pool_ = other.pool_;
+    sandbox_ = std::move(other.sandbox_);
+  }
+  return *this;
+}
+
+void SandboxPool::Lease::release() {
+  if (sandbox_ && pool_ != nullptr) pool_->give_back(std::move(sandbox_));
+  sandbox_.reset();
+}
+
+SandboxPool::SandboxPool(Factory factory, std::size_t max_idle)
+    : factory_(std::move(factory)), max_idle_(max_idle) {}
+
+std::size_t SandboxPool::prewarm(std::size_t count,
+                                 std::size_t parallelism) {
+  count = std::min(count, max_idle_);
+  const std::size_t have = idle();
+  if (have >= count) return 0;
+
+  std::vector<std::unique_ptr<Sandbox>> created(count - have);
+  parallel_for(created.size(), parallelism,
+               [&](std::size_t i) { created[i] = factory_(); });
+
+  std::lock_guard lock(mu_);
+  std::size_t added = 0;
+  for (auto& sandbox : created) {
+    if (!sandbox || idle_.size() >= max_idle_) continue;
+    idle_.push_back(std::move(sandbox));
+    ++added;
+  }
+  return added;
+}
+
+SandboxPool::Lease SandboxPool::acquire() {
+  {
+    std::lock_guard lock(mu_);
+    if (!idle_.empty()) {
+      auto sandbox = std::move(idle_.back());
+      idle_.pop_back();
+      return Lease(this, std::move(sandbox));
+    }
+  }
+  return Lease(this, factory_());
+}
+
+std::size_t SandboxPool::idle() const {
+  std::lock_guard lock(mu_);
+  return idle_.size();
+}
+
+void SandboxPool::give_back(std::unique_ptr<Sandbox> sandbox) {
+  if (!sandbox->reset()) return;
+  std::lock_guard lock(mu_);
+  if (idle_.size() < max_idle_) idle_.push_back(std::move(sandbox));
+}
+
+}  // namespace codecoach::sandbox
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace codecoach::sandbox {
+
+// A prepared execution environment (namespaces, cgroup, scratch directory).
+// Creating one is expensive; resetting one between jobs is cheap.
+class Sandbox {
+ public:
+  virtual ~Sandbox() = default;
+
+  // Restores a clean state after a job. Returns false if the sandbox is no
+  // longer usable and must be discarded.
+  virtual bool reset() = 0;
+};
+
+// Pool of ready sandboxes. Jobs lease a sandbox and return it on release.
+class SandboxPool {
+ public:
+  using Factory = std::function<std::unique_ptr<Sandbox>()>;
+
+  // RAII handle; returns the sandbox to the pool when destroyed.
+  class Lease {
+   public:
+    Lease() = default;
+    Lease(Lease&&) noexcept = default;
+    Lease& operator=(Lease&& other) noexcept;
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+    ~Lease() { release(); }
+
+    Sandbox* operator->() const { return sandbox_.get(); }
+    Sandbox& operator*() const { return *sandbox_; }
+    explicit operator bool() const { return sandbox_ != nullptr; }
+
+    void release();
+
+   private:
+    friend class SandboxPool;
+    Lease(SandboxPool* pool, std::unique_ptr<Sandbox> sandbox)
+        : pool_(pool), sandbox_(std::move(sandbox)) {}
+
+    SandboxPool* pool_ = nullptr;
+    std::unique_ptr<Sandbox> sandbox_;
+  };
+
+  // `max_idle` bounds how many returned sandboxes are kept for reuse.
+  SandboxPool(Factory factory, std::size_t max_idle);
+
+  // Creates sandboxes until `count` are idle, `parallelism` at a time.
+  // Sandbox setup is dominated by kernel work (mounts, cgroup creation), so
+  // creating them concurrently cuts startup time roughly by `parallelism`.
+  // Returns the number created.
+  std::size_t prewarm(std::size_t count, std::size_t parallelism);
+
+  // Takes an idle sandbox, or creates one if none is idle.
+  Lease acquire();
+
+  std::size_t idle() const;
+
+ private:
+  void give_back(std::unique_ptr<Sandbox> sandbox);
+
+  Factory factory_;
+  std::size_t max_idle_;
+  mutable std::mutex mu_;
+  std::vector<std::unique_ptr<Sandbox>> idle_;
+};
+
+}  // namespace codecoach::sandbox
@@ -0,0 +1,160 @@
+#include "scheduler/cost_model.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace codecoach::scheduler {
+
+namespace {
+
+// A user's run-time ratio is kept within this factor of the problem mean,
+// so one pathological submission cannot make the next look free or
+// enormous.
+constexpr double kMaxUserRatio = 10.0;
+
+// Plain mean over the first 1/alpha samples, so a prior that was off is
+// forgotten quickly, then an exponential moving average.
+void update(double& average, std::uint64_t& samples, double sample,
+            double alpha) {
+  ++samples;
+  const double weight = std::max(alpha, 1.0 / static_cast<double>(samples));
+  average += weight * (sample - average);
+}
+
+}  // namespace
+
+void CostModel::Regression::add(double sample_x, double sample_y,
+                                double alpha) {
+  ++samples;
+  const double keep =
+      1.0 - std::max(alpha, 1.0 / static_cast<double>(samples));
+  weight = keep * weight + 1.0;
+  x = keep * x + sample_x;
+  y = keep * y + sample_y;
+  xx = keep * xx + sample_x * sample_x;
+  xy = keep * xy + sample_x * sample_y;
+}
+
+std::optional<double> CostModel::Regression::predict(double at) const {
+  if (samples == 0) return std::nullopt;
+  const double mean_x = x / weight;
+  const double mean_y = y / weight;
+  const double variance = xx / weight - mean_x * mean_x;
+  // Too little spread in source sizes to fit a slope: use the mean.
+  if (samples < 3 || variance <= 1.0) return mean_y;
+  const double slope = (xy / weight - mean_x * mean_y) / variance;
+  return std::max(0.0, mean_y + std::max(0.0, slope) * (at - mean_x));
+}
+
+CostModel::CostModel(CostModelOptions options)
+    : options_(options),
+      compile_us_(static_cast<double>(options.compile_us)),
+      cache_hit_probability_(options.cache_hit_probability) {}
+
+double CostModel::test_us_locked(std::string_view problem) const {
+  const auto it = problems_.find(problem);
+  return it != problems_.end() && it->second.runs > 0
+             ? it->second.test_us
+             : static_cast<double>(options_.test_us);
+}
+
+const CostModel::UserHistory* CostModel::find_user_locked(
+    std::uint64_t user) const {
+  if (user == 0) return nullptr;
+  if (const auto it = users_.find(user); it != users_.end()) {
+    return &it->second;
+  }
+  const auto it = previous_users_.find(user);
+  return it != previous_users_.end() ? &it->second : nullptr;
+}
+
+CostModel::UserHistory& CostModel::user_locked(std::uint64_t user) {
+  if (const auto it = users_.find(user); it != users_.end()) {
+    return it->second;
+  }
+  UserHistory history;
+  if (const auto it = previous_users_.find(user);
+      it != previous_users_.end()) {
+    history = it->second;
+    previous_users_.erase(it);
+  }
+  if (users_.size() >= std::max<std::size_t>(options_.max_users / 2, 1)) {
+    previous_users_ = std::move(users_);
+    users_.clear();
+  }
+  return users_.emplace(user, history).first->second;
+}
+
+CostEstimate CostModel::estimate(const CostQuery& query) const {
+  const auto bytes = static_cast<double>(query.source_bytes);
+  std::lock_guard lock(mu_);
+  CostEstimate estimate;
+  double compile_us = compile_us_;
+  if (const auto it = languages_.find(query.language);
+      it != languages_.end()) {
+    compile_us = it->second.predict(bytes).value_or(compile_us);
+  }
+  estimate.compile_us = static_cast<std::int64_t>(compile_us);
+
+  if (query.cached) {
+    estimate.cache_hit_probability = *query.cached ? 1.0 : 0.0;
+  } else if (const auto it = problems_.find(query.problem);
+             it != problems_.end()) {
+    estimate.cache_hit_probability = it->second.cache_hit_probability;
+  } else {
+    estimate.cache_hit_probability = cache_hit_probability_;
+  }
+
+  double run_us =
+      test_us_locked(query.problem) * static_cast<double>(query.tests);
+  if (const UserHistory* user = find_user_locked(query.user)) {
+    run_us *= user->run_ratio;
+  }
+  estimate.run_us = static_cast<std::int64_t>(run_us);
+  return estimate;
+}
+
+void CostModel::observe(const CostQuery& query, bool cache_hit,
+                        std::int64_t compile_us, std::size_t tests_run,
+                        std::int64_t run_us) {
+  const double alpha = options_.alpha;
+  const double hit = cache_hit ? 1.0 : 0.0;
+  std::lock_guard lock(mu_);
+  if (!cache_hit) {
+    update(compile_us_, compiles_, static_cast<double>(compile_us), alpha);
+    languages_[std::string(query.language)].add(
+        static_cast<double>(query.source_bytes),
+        static_cast<double>(compile_us), alpha);
+  }
+  update(cache_hit_probability_, jobs_, hit, alpha);
+
+  // The user's ratio is against the prediction for the full test set, so
+  // it learns early failures as well as slow code.
+  const double predicted_run =
+      test_us_locked(query.problem) * static_cast<double>(query.tests);
+  if (query.user != 0 && predicted_run > 0) {
+    const double ratio =
+        std::clamp(static_cast<double>(run_us) / predicted_run,
+                   1.0 / kMaxUserRatio, kMaxUserRatio);
+    UserHistory& user = user_locked(query.user);
+    update(user.run_ratio, user.jobs, ratio, alpha);
+  }
+
+  auto it = problems_.find(query.problem);
+  if (it == problems_.end()) {
+    ProblemHistory history;
+    history.test_us = static_cast<double>(options_.test_us);
+    history.cache_hit_probability = cache_hit_probability_;
+    history.jobs = 1;  // The fleet-wide rate counts as one sample.
+    it = problems_.emplace(std::string(query.problem), history).first;
+  }
+  ProblemHistory& history = it->second;
+  update(history.cache_hit_probability, history.jobs, hit, alpha);
+  if (tests_run > 0) {
+    update(history.test_us, history.runs,
+           static_cast<double>(run_us) / static_cast<double>(tests_run),
+           alpha);
+  }
+}
+
+}  // namespace codecoach::scheduler
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace codecoach::scheduler {
+
+struct CostModelOptions {
+  // Priors, used until there is history of the relevant kind.
+  std::int64_t compile_us = 400'000;
+  std::int64_t test_us = 20'000;
+  double cache_hit_probability = 0.5;
+  // Weight of the newest observation in each moving average.
+  double alpha = 0.1;
+  // Users with history kept; those inactive longest are forgotten first.
+  std::size_t max_users = 200'000;
+};
+
+// What is known about a job before it runs.
+struct CostQuery {
+  std::string_view problem;
+  std::string_view language;
+  std::size_t source_bytes = 0;
+  // Compile cache status, when the caller could check it cheaply.
+  std::optional<bool> cached;
+  std::uint64_t user = 0;  // 0: unknown.
+  std::size_t tests = 0;   // Tests the job would run if all pass.
+};
+
+// Expected CPU cost of one judge job, in microseconds.
+struct CostEstimate {
+  std::int64_t compile_us = 0;  // On a compile cache miss.
+  double cache_hit_probability = 0;
+  std::int64_t run_us = 0;
+
+  std::int64_t expected_us() const {
+    return static_cast<std::int64_t>(
+               (1.0 - cache_hit_probability) *
+               static_cast<double>(compile_us)) +
+           run_us;
+  }
+};
+
+// Online judge cost predictor, trained on every finished job:
+//   - compile: per language, a moving least-squares line over source size;
+//   - cache hits: per problem moving hit rate, unless the caller knows;
+//   - run: per problem moving worker time per test, scaled by the user's
+//     history of actual vs. predicted run time (users whose code fails on
+//     the first test, or times out everywhere, are far from the mean).
+// Queued jobs differ in cost by three orders of magnitude, so dispatch
+// order and capacity decisions need this rather than job counts.
+// Thread-safe.
+class CostModel {
+ public:
+  explicit CostModel(CostModelOptions options = {});
+
+  CostEstimate estimate(const CostQuery& query) const;
+
+  // A finished job: whether its compile hit the cache, the compile CPU on a
+  // miss, and the CPU of the `tests_run` tests it actually ran.
+  void observe(const CostQuery& query, bool cache_hit,
+               std::int64_t compile_us, std::size_t tests_run,
+               std::int64_t run_us);
+
+ private:
+  // Exponentially weighted sums for y ~ a + b x.
+  struct Regression {
+    double weight = 0, x = 0, y = 0, xx = 0, xy = 0;
+    std::uint64_t samples = 0;
+
+    void add(double sample_x, double sample_y, double alpha);
+    std::optional<double> predict(double at) const;
+  };
+
+  struct ProblemHistory {
+    double test_us = 0;
+    std::uint64_t runs = 0;
+    double cache_hit_probability = 0;
+    std::uint64_t jobs = 0;
+  };
+
+  struct UserHistory {
+    double run_ratio = 1.0;  // Actual over predicted run time.
+    std::uint64_t jobs = 0;
+  };
+
+  struct StringHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const {
+      return std::hash<std::string_view>{}(s);
+    }
+  };
+  template <typename T>
+  using StringMap =
+      std::unordered_map<std::string, T, StringHash, std::equal_to<>>;
+
+  double test_us_locked(std::string_view problem) const;
+  const UserHistory* find_user_locked(std::uint64_t user) const;
+  UserHistory& user_locked(std::uint64_t user);
+
+  const CostModelOptions options_;
+  mutable std::mutex mu_;
+  double compile_us_;  // Fleet-wide; prior for new languages.
+  std::uint64_t compiles_ = 0;
+  double cache_hit_probability_;  // Fleet-wide; prior for new problems.
+  std::uint64_t jobs_ = 0;
+  StringMap<Regression> languages_;
+  StringMap<ProblemHistory> problems_;
+  // Two generations, each up to max_users / 2. When the current one is
+  // full it becomes the previous one, dropping the users not seen for a
+  // whole generation; a user found only in the previous one moves back.
+  std::unordered_map<std::uint64_t, UserHistory> users_;
+  std::unordered_map<std::uint64_t, UserHistory> previous_users_;
+};
+
+}  // namespace codecoach::scheduler
@@ -0,0 +1,32 @@
+#include "scheduler/tenant_quota.h"
+
+#include <algorithm>
+
+namespace codecoach::scheduler {
+
+bool CpuQuota::try_reserve(std::int64_t estimate_us) noexcept {
+  estimate_us = std::max<std::int64_t>(estimate_us, 0);
+  const std::int64_t budget = budget_us();
+  std::int64_t used = used_us_.load(std::memory_order_relaxed);
+  do {
+    // A tenant with any budget left may start one more job even if the
+    // estimate overshoots; otherwise a single large job could never run.
+    if (used >= budget) return false;
+  } while (!used_us_.compare_exchange_weak(used, used + estimate_us,
+                                           std::memory_order_relaxed));
+  return true;
+}
+
+void CpuQuota::charge(std::int64_t estimate_us) noexcept {
+  used_us_.fetch_add(std::max<std::int64_t>(estimate_us, 0),
+                     std::memory_order_relaxed);
+}
+
+void CpuQuota::settle(std::int64_t reserved_us,
+                      std::int64_t actual_us) noexcept {
+  const std::int64_t delta = std::max<std::int64_t>(actual_us, 0) -
+                             std::max<std::int64_t>(reserved_us, 0);
+  if (delta != 0) used_us_.fetch_add(delta, std::memory_order_relaxed);
+}
+
+}  // namespace codecoach::scheduler
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+namespace codecoach::scheduler {
+
+// CPU-time budget of one tenant for the current accounting window.
+//
+// All operations are lock-free so that workers can settle finished jobs and
+// the API tier can check admission without touching the scheduler lock.
+// Times are in microseconds of judge CPU (compile + run).
+class CpuQuota {
+ public:
+  static constexpr std::int64_t kUnlimited =
+      std::numeric_limits<std::int64_t>::max();
+
+  explicit CpuQuota(std::int64_t budget_us = kUnlimited) noexcept
+      : budget_us_(budget_us) {}
+
+  CpuQuota(const CpuQuota&) = delete;
+  CpuQuota& operator=(const CpuQuota&) = delete;
+
+  // Reserves `estimate_us` of the window budget. Returns false and reserves
+  // nothing if the budget is already used up; a reservation that starts
+  // under budget is admitted even if it overshoots, so one job larger than
+  // the whole budget can still run.
+  bool try_reserve(std::int64_t estimate_us) noexcept;
+
+  // Reserves unconditionally; used for work on a tenant's dedicated workers,
+  // which is accounted for but never refused.
+  void charge(std::int64_t estimate_us) noexcept;
+
+  // Replaces an earlier reservation with the measured usage.
+  void settle(std::int64_t reserved_us, std::int64_t actual_us) noexcept;
+
+  // Starts a new accounting window.
+  void reset_window() noexcept {
+    used_us_.store(0, std::memory_order_relaxed);
+  }
+
+  void set_budget(std::int64_t budget_us) noexcept {
+    budget_us_.store(budget_us, std::memory_order_relaxed);
+  }
+
+  std::int64_t budget_us() const noexcept {
+    return budget_us_.load(std::memory_order_relaxed);
+  }
+  std::int64_t used_us() const noexcept {
+    return used_us_.load(std::memory_order_relaxed);
+  }
+  bool exhausted() const noexcept { return used_us() >= budget_us(); }
+
+ private:
+  std::atomic<std::int64_t> budget_us_;
+  std::atomic<std::int64_t> used_us_{0};
+};
+
+}  // namespace codecoach::scheduler
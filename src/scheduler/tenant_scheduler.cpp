@@ -0,0 +1,198 @@
+#include "scheduler/tenant_scheduler.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace codecoach::scheduler {
+
+namespace {
+
+// Floor for fair-share accounting so zero-estimate jobs still cost something.
+constexpr std::int64_t kMinChargeUs = 1000;
+
+}  // namespace
+
+std::size_t Backlog::workers_to_drain(std::chrono::microseconds drain) const {
+  const std::int64_t work = cpu_us();
+  if (work <= 0) return 0;
+  const std::int64_t per_worker = std::max<std::int64_t>(drain.count(), 1);
+  return static_cast<std::size_t>((work + per_worker - 1) / per_worker);
+}
+
+bool TenantScheduler::Tenant::idle() const {
+  return std::all_of(queues.begin(), queues.end(),
+                     [](const auto& q) { return q.empty(); });
+}
+
+TenantScheduler::TenantScheduler(std::size_t worker_count,
+                                 QueuePolicy policy)
+    : policy_(policy), worker_owner_(worker_count) {}
+
+void TenantScheduler::configure_tenant(TenantId tenant,
+                                       const TenantConfig& config) {
+  if (config.weight == 0) {
+    throw std::invalid_argument("tenant weight must be positive");
+  }
+  std::lock_guard lock(mu_);
+  Tenant& t = tenant_locked(tenant);
+  t.config = config;
+  t.quota->set_budget(config.cpu_budget_us);
+}
+
+void TenantScheduler::reserve_workers(TenantId tenant,
+                                      const std::vector<WorkerId>& workers) {
+  std::lock_guard lock(mu_);
+  tenant_locked(tenant);
+  for (auto& owner : worker_owner_) {
+    if (owner == tenant) owner.reset();
+  }
+  for (WorkerId w : workers) {
+    if (w >= worker_owner_.size()) {
+      throw std::out_of_range("reserve_workers: unknown worker");
+    }
+    worker_owner_[w] = tenant;
+  }
+}
+
+void TenantScheduler::submit(const JobTicket& job) {
+  std::lock_guard lock(mu_);
+  Tenant& t = tenant_locked(job.tenant);
+  if (t.idle()) {
+    // A tenant returning from idle must not cash in the share it did not use.
+    t.virtual_time = std::max(t.virtual_time, min_active_virtual_time_locked());
+  }
+  Queued queued{job, 0, next_sequence_++};
+  if (policy_.shortest_first) {
+    const std::chrono::duration<double, std::micro> since =
+        Clock::now() - epoch_;
+    queued.key = static_cast<double>(job.estimated_cpu_us) +
+                 policy_.aging * since.count();
+  }
+  auto& queue = t.queues[static_cast<std::size_t>(job.priority)];
+  queue.push_back(queued);
+  std::push_heap(queue.begin(), queue.end(), DispatchesLater{});
+  ++queued_;
+  queued_cpu_us_ += job.estimated_cpu_us;
+}
+
+std::optional<JobTicket> TenantScheduler::next_for(WorkerId worker) {
+  std::lock_guard lock(mu_);
+  if (worker >= worker_owner_.size()) {
+    throw std::out_of_range("next_for: unknown worker");
+  }
+  if (queued_ == 0) return std::nullopt;
+
+  if (const auto owner = worker_owner_[worker]) {
+    Tenant& t = tenants_.at(*owner);
+    if (auto job = pop_own_locked(t)) return job;
+    if (!t.config.lend_reserved_workers) return std::nullopt;
+  }
+  if (auto job = pop_shared_locked(/*borrow=*/false)) return job;
+  return pop_shared_locked(/*borrow=*/true);
+}
+
+void TenantScheduler::complete(const JobTicket& job,
+                               std::int64_t actual_cpu_us) {
+  std::shared_ptr<CpuQuota> quota;
+  {
+    std::lock_guard lock(mu_);
+    --running_;
+    running_cpu_us_ -= job.estimated_cpu_us;
+    auto it = tenants_.find(job.tenant);
+    if (it == tenants_.end()) return;
+    quota = it->second.quota;
+  }
+  quota->settle(job.estimated_cpu_us, actual_cpu_us);
+}
+
+void TenantScheduler::roll_window() {
+  std::lock_guard lock(mu_);
+  for (auto& [id, t] : tenants_) t.quota->reset_window();
+}
+
+std::shared_ptr<const CpuQuota> TenantScheduler::quota(TenantId tenant) const {
+  std::lock_guard lock(mu_);
+  auto it = tenants_.find(tenant);
+  if (it == tenants_.end()) return nullptr;
+  return it->second.quota;
+}
+
+std::size_t TenantScheduler::queued() const {
+  std::lock_guard lock(mu_);
+  return queued_;
+}
+
+Backlog TenantScheduler::backlog() const {
+  std::lock_guard lock(mu_);
+  return {queued_, queued_cpu_us_, running_, running_cpu_us_};
+}
+
+TenantScheduler::Tenant& TenantScheduler::tenant_locked(TenantId id) {
+  return tenants_[id];
+}
+
+JobTicket TenantScheduler::pop_front(Queue& queue) {
+  std::pop_heap(queue.begin(), queue.end(), DispatchesLater{});
+  const JobTicket job = queue.back().job;
+  queue.pop_back();
+  return job;
+}
+
+std::optional<JobTicket> TenantScheduler::pop_own_locked(Tenant& tenant) {
+  for (auto& queue : tenant.queues) {
+    if (queue.empty()) continue;
+    const JobTicket job = pop_front(queue);
+    tenant.quota->charge(job.estimated_cpu_us);
+    dispatch_locked(tenant, job);
+    return job;
+  }
+  return std::nullopt;
+}
+
+std::optional<JobTicket> TenantScheduler::pop_shared_locked(bool borrow) {
+  for (std::size_t prio = 0; prio < kPriorityCount; ++prio) {
+    Tenant* best = nullptr;
+    for (auto& [id, t] : tenants_) {
+      if (t.queues[prio].empty()) continue;
+      if (borrow ? !t.config.borrow_idle : t.quota->exhausted()) continue;
+      if (best == nullptr || t.virtual_time < best->virtual_time) best = &t;
+    }
+    if (best == nullptr) continue;
+
+    auto& queue = best->queues[prio];
+    const JobTicket job = queue.front().job;
+    if (borrow) {
+      best->quota->charge(job.estimated_cpu_us);
+    } else if (!best->quota->try_reserve(job.estimated_cpu_us)) {
+      // Lost a race with a concurrent settle. Leave it for the borrow pass
+      // rather than moving on to a lower priority, which would dispatch
+      // batch work ahead of this blocked interactive job.
+      return std::nullopt;
+    }
+    pop_front(queue);
+    dispatch_locked(*best, job);
+    return job;
+  }
+  return std::nullopt;
+}
+
+void TenantScheduler::dispatch_locked(Tenant& tenant,
+                                      const JobTicket& job) {
+  --queued_;
+  queued_cpu_us_ -= job.estimated_cpu_us;
+  ++running_;
+  running_cpu_us_ += job.estimated_cpu_us;
+  const auto cost = std::max(job.estimated_cpu_us, kMinChargeUs);
+  tenant.virtual_time += static_cast<double>(cost) / tenant.config.weight;
+}
+
+double TenantScheduler::min_active_virtual_time_locked() const {
+  double min_time = std::numeric_limits<double>::infinity();
+  for (const auto& [id, t] : tenants_) {
+    if (!t.idle()) min_time = std::min(min_time, t.virtual_time);
+  }
+  return min_time == std::numeric_limits<double>::infinity() ? 0 : min_time;
+}
+
+}  // namespace codecoach::scheduler
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "common/types.h"
+#include "scheduler/tenant_quota.h"
+
+namespace codecoach::scheduler {
+
+// A queued unit of judge work. The scheduler only needs identity, ownership
+// and an up-front cost estimate; the payload stays with the caller.
+struct JobTicket {
+  JobId id = 0;
+  TenantId tenant = 0;
+  Priority priority = Priority::kBatch;
+  std::int64_t estimated_cpu_us = 0;
+};
+
+// Work accepted but not finished, by the jobs' up-front CPU estimates. This
+// is the autoscaling signal: queue length alone is no guide when one queued
+// job can cost a thousand times another.
+struct Backlog {
+  std::size_t queued_jobs = 0;
+  std::int64_t queued_cpu_us = 0;
+  std::size_t running_jobs = 0;
+  std::int64_t running_cpu_us = 0;  // Whole estimates, not what remains.
+
+  std::int64_t cpu_us() const { return queued_cpu_us + running_cpu_us; }
+  // Workers (one core each) needed to finish all of it within `drain`.
+  std::size_t workers_to_drain(std::chrono::microseconds drain) const;
+};
+
+struct TenantConfig {
+  // CPU budget per accounting window (see TenantScheduler::roll_window).
+  std::int64_t cpu_budget_us = CpuQuota::kUnlimited;
+  // Share of the shared worker pool relative to other tenants.
+  std::uint32_t weight = 1;
+  // Whether an over-quota tenant may still use shared workers that would
+  // otherwise sit idle.
+  bool borrow_idle = true;
+  // Whether the tenant's dedicated workers may pick up other tenants' work
+  // while the tenant has nothing queued. Off by default: a lent worker stuck
+  // in a long batch job is not available when the owner's interview starts.
+  bool lend_reserved_workers = false;
+};
+
+// Order of jobs within one tenant's queue of one priority.
+struct QueuePolicy {
+  // Shortest expected job first, by estimated_cpu_us; off means FIFO. A few
+  // heavy jobs at the head of a queue otherwise hold up every tiny one
+  // behind them.
+  bool shortest_first = true;
+  // Aging, so heavy jobs are not starved: each microsecond waited takes
+  // this many microseconds off a job's estimate for ordering purposes.
+  double aging = 1.0;
+};
+
+// Tenant-aware dispatcher for the judge worker fleet.
+//
+// Workers pull jobs with next_for(). Dispatch order on shared workers is:
+//   1. interactive before batch, across all tenants;
+//   2. within a priority, weighted fair share across tenants by CPU cost;
+//   3. tenants over their CPU quota only get otherwise idle capacity;
+//   4. within a tenant and priority, by QueuePolicy.
+// Workers reserved for a tenant serve that tenant first. This keeps one
+// tenant's homework deadline from degrading another tenant's live sessions.
+class TenantScheduler {
+ public:
+  explicit TenantScheduler(std::size_t worker_count,
+                           QueuePolicy policy = {});
+
+  // Registers or reconfigures a tenant. Unknown tenants seen in submit() get
+  // a default (unlimited, weight 1) configuration.
+  void configure_tenant(TenantId tenant, const TenantConfig& config);
+
+  // Dedicates `workers` to `tenant`, replacing any previous assignment.
+  void reserve_workers(TenantId tenant, const std::vector<WorkerId>& workers);
+
+  void submit(const JobTicket& job);
+
+  // Returns the next job for `worker`, or nullopt if it should stay idle.
+  // The job's estimated cost is reserved against its tenant's quota.
+  std::optional<JobTicket> next_for(WorkerId worker);
+
+  // Reports the measured CPU time of a job returned by next_for(). Call
+  // exactly once per dispatched job; it also leaves the backlog then.
+  void complete(const JobTicket& job, std::int64_t actual_cpu_us);
+
+  // Starts a new quota window for every tenant. Called from a timer
+  // (judge::Evaluator rolls it every EvaluatorOptions::quota_window).
+  void roll_window();
+
+  // Quota handle for admission checks outside the scheduler lock.
+  std::shared_ptr<const CpuQuota> quota(TenantId tenant) const;
+
+  std::size_t queued() const;
+  Backlog backlog() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Queued {
+    JobTicket job;
+    // Dispatch order within its queue, smallest first. Aging lowers every
+    // waiting job's score (estimate - aging x waited) at the same rate, so
+    // the order of two queued jobs never changes: the score minus the
+    // common aging term, estimate + aging x submit time, is a fixed key.
+    double key = 0;
+    std::uint64_t sequence = 0;  // Submission order; breaks ties.
+  };
+  // Heap order, so the job to dispatch next is at the front and submit and
+  // dispatch cost O(log n) under the lock.
+  struct DispatchesLater {
+    bool operator()(const Queued& a, const Queued& b) const {
+      return a.key != b.key ? a.key > b.key : a.sequence > b.sequence;
+    }
+  };
+  using Queue = std::vector<Queued>;  // A heap by DispatchesLater.
+
+  struct Tenant {
+    TenantConfig config;
+    std::shared_ptr<CpuQuota> quota = std::make_shared<CpuQuota>();
+    std::array<Queue, kPriorityCount> queues;
+    // Weighted CPU time served; the tenant with the smallest value is next.
+    double virtual_time = 0;
+
+    bool idle() const;
+  };
+
+  Tenant& tenant_locked(TenantId id);
+  static JobTicket pop_front(Queue& queue);
+  std::optional<JobTicket> pop_own_locked(Tenant& tenant);
+  std::optional<JobTicket> pop_shared_locked(bool borrow);
+  void dispatch_locked(Tenant& tenant, const JobTicket& job);
+  double min_active_virtual_time_locked() const;
+
+  const QueuePolicy policy_;
+  const Clock::time_point epoch_ = Clock::now();  // Of the queue keys.
+  mutable std::mutex mu_;
+  std::uint64_t next_sequence_ = 0;
+  std::unordered_map<TenantId, Tenant> tenants_;
+  std::vector<std::optional<TenantId>> worker_owner_;
+  std::size_t queued_ = 0;
+  std::int64_t queued_cpu_us_ = 0;
+  std::size_t running_ = 0;
+  std::int64_t running_cpu_us_ = 0;
+};
+
+}  // namespace codecoach::scheduler
@@ -0,0 +1,104 @@
+#include "storage/async_writer.h"
+
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+namespace codecoach::storage {
+
+AsyncWriter::AsyncWriter(LsmStore& store, std::size_t max_pending_bytes)
+    : store_(store),
+      max_pending_bytes_(max_pending_bytes),
+      thread_([this] { run(); }) {}
+
+AsyncWriter::~AsyncWriter() {
+  {
+    std::lock_guard lock(mu_);
+    stop_ = true;
+  }
+  queued_.notify_all();
+  thread_.join();
+}
+
+bool AsyncWriter::submit(WriteBatch batch) {
+  if (batch.empty()) return true;
+  {
+    std::lock_guard lock(mu_);
+    if (pending_bytes_ + batch.bytes() > max_pending_bytes_ &&
+        pending_bytes_ != 0) {
+      ++rejected_;
+      return false;
+    }
+    pending_bytes_ += batch.bytes();
+    ++submitted_;
+    queue_.push_back(std::move(batch));
+  }
+  queued_.notify_one();
+  return true;
+}
+
+void AsyncWriter::drain() {
+  std::unique_lock lock(mu_);
+  const std::size_t target = submitted_;
+  written_.wait(lock, [&] { return completed_ >= target; });
+}
+
+std::size_t AsyncWriter::rejected() const {
+  std::lock_guard lock(mu_);
+  return rejected_;
+}
+
+std::size_t AsyncWriter::failed() const {
+  std::lock_guard lock(mu_);
+  return failed_;
+}
+
+std::string AsyncWriter::last_error() const {
+  std::lock_guard lock(mu_);
+  return last_error_;
+}
+
+void AsyncWriter::run() {
+  std::unique_lock lock(mu_);
+  for (;;) {
+    queued_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) return;  // Stopping with nothing left.
+    std::vector<WriteBatch> batches;
+    batches.swap(queue_);
+    const std::size_t bytes = pending_bytes_;
+    lock.unlock();
+
+    WriteBatch group;
+    for (const auto& batch : batches) group.append(batch);
+    std::size_t lost = 0;
+    std::string error;
+    try {
+      store_.write(group);
+    } catch (const std::invalid_argument&) {
+      // A batch naming an unknown family rejects the whole group; commit
+      // the others one by one so it fails alone.
+      for (const auto& batch : batches) {
+        try {
+          store_.write(batch);
+        } catch (const std::exception& e) {
+          lost += batch.operations();
+          error = e.what();
+        }
+      }
+    } catch (const std::exception& e) {
+      lost = group.operations();
+      error = e.what();
+    }
+
+    lock.lock();
+    pending_bytes_ -= bytes;
+    completed_ += batches.size();
+    if (lost != 0) {
+      failed_ += lost;
+      last_error_ = std::move(error);
+    }
+    written_.notify_all();
+  }
+}
+
+}  // namespace codecoach::storage
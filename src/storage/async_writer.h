@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/lsm_store.h"
+
+namespace codecoach::storage {
+
+// Takes store writes off latency-critical threads (the verdict path): a
+// submit only queues the batch, and a background thread commits whatever
+// has queued up as one group write, so one log append and one memtable
+// pass serve many verdicts under load.
+//
+// The queue is bounded by bytes. When storage falls that far behind,
+// submit() rejects the batch instead of blocking its caller; callers that
+// must not lose a write can write synchronously instead.
+class AsyncWriter {
+ public:
+  explicit AsyncWriter(LsmStore& store,
+                       std::size_t max_pending_bytes = 64u << 20);
+  // Writes everything still queued, then stops.
+  ~AsyncWriter();
+  AsyncWriter(const AsyncWriter&) = delete;
+  AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+  // Never blocks on storage. False if the queue is full (batch dropped).
+  bool submit(WriteBatch batch);
+  // Waits until every batch submitted so far has been written or failed.
+  void drain();
+
+  std::size_t rejected() const;
+  // Operations lost to failed group writes; see last_error().
+  std::size_t failed() const;
+  std::string last_error() const;
+
+ private:
+  void run();
+
+  LsmStore& store_;
+  std::size_t max_pending_bytes_;
+  mutable std::mutex mu_;
+  std::condition_variable queued_;
+  std::condition_variable written_;
+  std::vector<WriteBatch> queue_;
+  std::size_t pending_bytes_ = 0;
+  std::size_t submitted_ = 0;  // Batches, for drain().
+  std::size_t completed_ = 0;
+  std::size_t rejected_ = 0;
+  std::size_t failed_ = 0;
+  std::string last_error_;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+}  // namespace codecoach::storage
@@ -0,0 +1,70 @@
+#include "storage/blob_store.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+
+#include "common/durable_file.h"
+
+namespace codecoach::storage {
+
+BlobStore::BlobStore(std::filesystem::path directory)
+    : directory_(std::move(directory)) {
+  std::filesystem::create_directories(directory_);
+}
+
+std::filesystem::path BlobStore::path_of(const Digest128& digest) const {
+  const std::string hex = digest.hex();
+  return directory_ / hex.substr(0, 2) / hex;
+}
+
+bool BlobStore::contains(const Digest128& digest) const {
+  std::error_code ec;
+  return std::filesystem::is_regular_file(path_of(digest), ec);
+}
+
+Digest128 BlobStore::put(std::string_view data) {
+  static std::atomic<unsigned> counter{0};
+  const Digest128 digest = digest128(data);
+  if (contains(digest)) return digest;
+
+  const auto path = path_of(digest);
+  std::filesystem::create_directories(path.parent_path());
+  // Unique per writer: two processes may store the same blob at once.
+  replace_file_synced(path, data,
+                      ".tmp" + std::to_string(::getpid()) + "." +
+                          std::to_string(counter.fetch_add(1)));
+  return digest;
+}
+
+bool BlobStore::remove(const Digest128& digest) {
+  std::error_code ec;
+  return std::filesystem::remove(path_of(digest), ec);
+}
+
+void BlobStore::for_each(
+    const std::function<void(const Digest128&, std::uint64_t size)>& fn)
+    const {
+  std::error_code ec;
+  for (const auto& shard :
+       std::filesystem::directory_iterator(directory_, ec)) {
+    if (!shard.is_directory()) continue;
+    for (const auto& entry : std::filesystem::directory_iterator(shard)) {
+      const auto digest = Digest128::from_hex(entry.path().filename().string());
+      if (!digest || !entry.is_regular_file()) continue;
+      fn(*digest, static_cast<std::uint64_t>(entry.file_size()));
+    }
+  }
+}
+
+std::optional<std::string> BlobStore::get(const Digest128& digest) const {
+  std::ifstream in(path_of(digest), std::ios::binary);
+  if (!in) return std::nullopt;
+  return std::string(std::istreambuf_iterator<char>(in), {});
+}
+
+}  // namespace codecoach::storage
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "common/hash.h"
+
+namespace codecoach::storage {
+
+// Content-addressed blob directory: each blob is stored once under the hex
+// digest of its bytes, so identical data written by different problems or
+// builds is deduplicated for free. Writes go to a temp file that is synced
+// and renamed into place, so neither readers nor a crash ever leave a
+// partial blob, and concurrent writers of the same content are harmless.
+class BlobStore {
+ public:
+  explicit BlobStore(std::filesystem::path directory);
+
+  // Stores `data` if absent and returns its digest.
+  Digest128 put(std::string_view data);
+
+  std::optional<std::string> get(const Digest128& digest) const;
+  bool contains(const Digest128& digest) const;
+  // Deletes the blob; returns false if it was not present.
+  bool remove(const Digest128& digest);
+  // Visits every complete blob with its size. Temp files are skipped.
+  void for_each(
+      const std::function<void(const Digest128&, std::uint64_t size)>& fn)
+      const;
+  std::filesystem::path path_of(const Digest128& digest) const;
+
+  const std::filesystem::path& directory() const { return directory_; }
+
+ private:
+  std::filesystem::path directory_;
+};
+
+}  // namespace codecoach::storage
@@ -0,0 +1,56 @@
+#include "storage/bloom_filter.h"
+
+#include <algorithm>
+
+#include "common/hash.h"
+
+namespace codecoach::storage {
+
+namespace {
+
+constexpr std::size_t kMaxProbes = 30;
+
+// Double hashing (Kirsch-Mitzenmacher): probe i is h + i * delta, so one
+// 64-bit hash serves every probe.
+std::uint64_t probe(std::uint64_t h, std::size_t i, std::uint64_t bits) {
+  const std::uint64_t delta = ((h >> 33) | (h << 31)) | 1;
+  return (h + i * delta) % bits;
+}
+
+}  // namespace
+
+std::uint64_t bloom_hash(std::string_view key) {
+  return hash64(key, 0xb10f11e5ULL);
+}
+
+std::string build_bloom_filter(const std::vector<std::uint64_t>& hashes,
+                               std::size_t bits_per_key) {
+  // k = bits_per_key * ln 2 minimizes the false-positive rate.
+  const std::size_t probes =
+      std::clamp<std::size_t>(bits_per_key * 69 / 100, 1, kMaxProbes);
+  const std::uint64_t bits =
+      std::max<std::uint64_t>(64, hashes.size() * bits_per_key + 7) / 8 * 8;
+  std::string filter(bits / 8, '\0');
+  for (const std::uint64_t h : hashes) {
+    for (std::size_t i = 0; i < probes; ++i) {
+      const auto b = probe(h, i, bits);
+      filter[b / 8] = static_cast<char>(filter[b / 8] | (1 << (b % 8)));
+    }
+  }
+  filter.push_back(static_cast<char>(probes));
+  return filter;
+}
+
+bool bloom_may_contain(std::string_view filter, std::uint64_t hash) {
+  if (filter.size() < 2) return true;
+  const std::size_t probes = static_cast<unsigned char>(filter.back());
+  if (probes == 0 || probes > kMaxProbes) return true;
+  const std::uint64_t bits = (filter.size() - 1) * 8;
+  for (std::size_t i = 0; i < probes; ++i) {
+    const auto b = probe(hash, i, bits);
+    if ((filter[b / 8] & (1 << (b % 8))) == 0) return false;
+  }
+  return true;
+}
+
+}  // namespace codecoach::storage
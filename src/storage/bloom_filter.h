@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace codecoach::storage {
+
+// Bloom filter over a table's keys, stored in the table and probed in
+// place. At 10 bits per key about 1% of lookups for absent keys still
+// read a block; the rest (most artifact-cache misses) touch no data.
+//
+// Filters are built from and probed with bloom_hash() values, so a lookup
+// hashes its key once for every table it checks, and a table writer keeps
+// 8 bytes per key rather than the keys. Layout: the bit array followed by
+// one byte holding the probe count.
+std::uint64_t bloom_hash(std::string_view key);
+
+std::string build_bloom_filter(const std::vector<std::uint64_t>& hashes,
+                               std::size_t bits_per_key);
+
+// True if the key may be among the filter's keys. An empty or malformed
+// filter matches everything.
+bool bloom_may_contain(std::string_view filter, std::uint64_t hash);
+
+}  // namespace codecoach::storage
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Byte encoding shared by the LSM store's files (write-ahead log, tables,
+// write batches): little-endian fixed-width integers and u32
+// length-prefixed byte strings.
+namespace codecoach::storage::coding {
+
+inline void put_u8(std::string& out, std::uint8_t v) {
+  out.push_back(static_cast<char>(v));
+}
+
+inline void put_u32(std::string& out, std::uint32_t v) {
+  char buf[4];
+  std::memcpy(buf, &v, 4);
+  out.append(buf, 4);
+}
+
+inline void put_u64(std::string& out, std::uint64_t v) {
+  char buf[8];
+  std::memcpy(buf, &v, 8);
+  out.append(buf, 8);
+}
+
+inline void put_bytes(std::string& out, std::string_view bytes) {
+  put_u32(out, static_cast<std::uint32_t>(bytes.size()));
+  out.append(bytes);
+}
+
+inline std::uint32_t load_u32(const char* p) {
+  std::uint32_t v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+inline std::uint64_t load_u64(const char* p) {
+  std::uint64_t v;
+  std::memcpy(&v, p, 8);
+  return v;
+}
+
+// Sequential reader over a byte range. Every read fails (returns false)
+// instead of running past the end, so truncated input is detected rather
+// than misread.
+class Reader {
+ public:
+  explicit Reader(std::string_view data) : data_(data) {}
+
+  bool empty() const { return data_.empty(); }
+  std::string_view rest() const { return data_; }
+
+  bool u8(std::uint8_t& v) {
+    if (data_.empty()) return false;
+    v = static_cast<std::uint8_t>(data_.front());
+    data_.remove_prefix(1);
+    return true;
+  }
+  bool u32(std::uint32_t& v) {
+    if (data_.size() < 4) return false;
+    v = load_u32(data_.data());
+    data_.remove_prefix(4);
+    return true;
+  }
+  bool u64(std::uint64_t& v) {
+    if (data_.size() < 8) return false;
+    v = load_u64(data_.data());
+    data_.remove_prefix(8);
+    return true;
+  }
+  bool bytes(std::string_view& v) {
+    std::uint32_t n = 0;
+    if (!u32(n) || data_.size() < n) return false;
+    v = data_.substr(0, n);
+    data_.remove_prefix(n);
+    return true;
+  }
+
+ private:
+  std::string_view data_;
+};
+
+}  // namespace codecoach::storage::coding
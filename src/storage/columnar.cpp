@@ -0,0 +1,318 @@
+#include "storage/columnar.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include "common/hash.h"
+#include "storage/coding.h"
+
+namespace codecoach::storage {
+
+namespace {
+
+constexpr std::string_view kHeaderMagic{"CCCOL1\0\0", 8};
+constexpr std::string_view kTrailerMagic{"CCCOLEND", 8};
+constexpr std::size_t kTrailerSize = 2 * 8 + kTrailerMagic.size();
+
+[[noreturn]] void throw_errno(const std::string& what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+std::size_t width(ColumnType type) {
+  switch (type) {
+    case ColumnType::kU8: return 1;
+    case ColumnType::kU32: return 4;
+    case ColumnType::kU64: return 8;
+    case ColumnType::kString: return 0;
+  }
+  return 0;
+}
+
+}  // namespace
+
+ColumnarWriter::ColumnarWriter(std::filesystem::path path, Schema schema,
+                               std::size_t chunk_rows,
+                               std::size_t chunk_bytes, int level)
+    : path_(std::move(path)),
+      tmp_(path_.string() + ".tmp"),
+      schema_(std::move(schema)),
+      chunk_rows_(std::max<std::size_t>(chunk_rows, 1)),
+      chunk_bytes_(chunk_bytes),
+      level_(level),
+      buffers_(schema_.size()) {
+  fd_ = ::open(tmp_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) throw_errno("create " + tmp_.string());
+  write_out(kHeaderMagic);
+}
+
+ColumnarWriter::~ColumnarWriter() {
+  if (fd_ >= 0) ::close(fd_);
+  if (!finished_) ::unlink(tmp_.c_str());
+}
+
+void ColumnarWriter::add(std::size_t column, std::uint64_t value) {
+  const ColumnType type = schema_.at(column).type;
+  Buffer& buffer = buffers_[column];
+  if (type == ColumnType::kString || buffer.filled != chunk_row_count_) {
+    throw std::logic_error("misplaced value for " + schema_[column].name);
+  }
+  switch (type) {
+    case ColumnType::kU8:
+      coding::put_u8(buffer.values, static_cast<std::uint8_t>(value));
+      break;
+    case ColumnType::kU32:
+      coding::put_u32(buffer.values, static_cast<std::uint32_t>(value));
+      break;
+    default:
+      coding::put_u64(buffer.values, value);
+      break;
+  }
+  buffered_bytes_ += width(type);
+  ++buffer.filled;
+}
+
+void ColumnarWriter::add(std::size_t column, std::string_view value) {
+  Buffer& buffer = buffers_[column];
+  if (schema_.at(column).type != ColumnType::kString ||
+      buffer.filled != chunk_row_count_) {
+    throw std::logic_error("misplaced value for " + schema_[column].name);
+  }
+  coding::put_u32(buffer.lengths, static_cast<std::uint32_t>(value.size()));
+  buffer.values.append(value);
+  buffered_bytes_ += 4 + value.size();
+  ++buffer.filled;
+}
+
+void ColumnarWriter::end_row() {
+  for (std::size_t c = 0; c < schema_.size(); ++c) {
+    if (buffers_[c].filled != chunk_row_count_ + 1) {
+      throw std::logic_error("row without a value for " + schema_[c].name);
+    }
+  }
+  ++rows_;
+  ++chunk_row_count_;
+  if (chunk_row_count_ >= chunk_rows_ || buffered_bytes_ >= chunk_bytes_) {
+    flush_chunk();
+  }
+}
+
+void ColumnarWriter::flush_chunk() {
+  if (chunk_row_count_ == 0) return;
+  coding::put_u64(index_, chunk_row_count_);
+  std::string raw;
+  std::string packed;
+  for (Buffer& buffer : buffers_) {
+    const std::string* block = &buffer.values;
+    if (!buffer.lengths.empty()) {
+      raw = buffer.lengths;
+      raw += buffer.values;
+      block = &raw;
+    }
+    packed.resize(ZSTD_compressBound(block->size()));
+    const std::size_t n = ZSTD_compress(packed.data(), packed.size(),
+                                        block->data(), block->size(), level_);
+    if (ZSTD_isError(n)) {
+      throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(n));
+    }
+    packed.resize(n);
+    coding::put_u64(index_, offset_);
+    coding::put_u64(index_, n);
+    coding::put_u64(index_, block->size());
+    coding::put_u64(index_, hash64(packed));
+    write_out(packed);
+    buffer.values.clear();
+    buffer.lengths.clear();
+    buffer.filled = 0;
+  }
+  ++chunks_;
+  chunk_row_count_ = 0;
+  buffered_bytes_ = 0;
+}
+
+void ColumnarWriter::write_out(std::string_view data) {
+  std::size_t written = 0;
+  while (written < data.size()) {
+    const ssize_t n =
+        ::write(fd_, data.data() + written, data.size() - written);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) throw_errno("write " + tmp_.string());
+    written += static_cast<std::size_t>(n);
+  }
+  offset_ += data.size();
+}
+
+std::uint64_t ColumnarWriter::finish() {
+  for (std::size_t c = 0; c < schema_.size(); ++c) {
+    if (buffers_[c].filled != chunk_row_count_) {
+      throw std::logic_error("unfinished row at " + schema_[c].name);
+    }
+  }
+  flush_chunk();
+  std::string footer;
+  coding::put_u32(footer, static_cast<std::uint32_t>(schema_.size()));
+  for (const Column& column : schema_) {
+    coding::put_bytes(footer, column.name);
+    coding::put_u8(footer, static_cast<std::uint8_t>(column.type));
+  }
+  coding::put_u64(footer, chunks_);
+  footer += index_;
+  const std::uint64_t footer_offset = offset_;
+  write_out(footer);
+  std::string trailer;
+  coding::put_u64(trailer, footer_offset);
+  coding::put_u64(trailer, footer.size());
+  trailer.append(kTrailerMagic);
+  write_out(trailer);
+  if (::fsync(fd_) != 0) throw_errno("sync " + tmp_.string());
+  ::close(fd_);
+  fd_ = -1;
+  std::filesystem::rename(tmp_, path_);
+  finished_ = true;
+  return offset_;
+}
+
+ColumnarReader::ColumnarReader(const std::filesystem::path& path)
+    : path_(path), file_(MappedFile::open(path)) {
+  const std::string_view bytes = file_.bytes();
+  const auto fail = [&](const char* what) {
+    return CorruptionError(path.string() + ": " + what);
+  };
+  if (bytes.size() < kHeaderMagic.size() + kTrailerSize ||
+      bytes.substr(0, kHeaderMagic.size()) != kHeaderMagic ||
+      bytes.substr(bytes.size() - kTrailerMagic.size()) != kTrailerMagic) {
+    throw fail("not a columnar file");
+  }
+  coding::Reader trailer(bytes.substr(bytes.size() - kTrailerSize));
+  std::uint64_t footer_offset = 0, footer_size = 0;
+  trailer.u64(footer_offset);
+  trailer.u64(footer_size);
+  const std::uint64_t body = bytes.size() - kTrailerSize;
+  if (footer_offset > body || footer_size != body - footer_offset) {
+    throw fail("footer out of range");
+  }
+
+  coding::Reader footer(bytes.substr(footer_offset, footer_size));
+  std::uint32_t columns = 0;
+  if (!footer.u32(columns)) throw fail("bad schema");
+  for (std::uint32_t c = 0; c < columns; ++c) {
+    std::string_view name;
+    std::uint8_t type = 0;
+    if (!footer.bytes(name) || !footer.u8(type) ||
+        type > static_cast<std::uint8_t>(ColumnType::kString)) {
+      throw fail("bad schema");
+    }
+    schema_.push_back({std::string(name), static_cast<ColumnType>(type)});
+  }
+  std::uint64_t chunks = 0;
+  if (!footer.u64(chunks)) throw fail("bad chunk index");
+  for (std::uint64_t i = 0; i < chunks; ++i) {
+    ChunkRef chunk;
+    if (!footer.u64(chunk.rows)) throw fail("bad chunk index");
+    for (std::uint32_t c = 0; c < columns; ++c) {
+      ColumnRef ref{};
+      if (!footer.u64(ref.offset) || !footer.u64(ref.size) ||
+          !footer.u64(ref.raw_size) || !footer.u64(ref.hash) ||
+          ref.offset > footer_offset ||
+          ref.size > footer_offset - ref.offset) {
+        throw fail("bad chunk index");
+      }
+      chunk.columns.push_back(ref);
+    }
+    rows_ += chunk.rows;
+    chunks_.push_back(std::move(chunk));
+  }
+}
+
+std::size_t ColumnarReader::column(std::string_view name) const {
+  for (std::size_t c = 0; c < schema_.size(); ++c) {
+    if (schema_[c].name == name) return c;
+  }
+  throw std::out_of_range(path_.string() + ": no column " + std::string(name));
+}
+
+ColumnarReader::Chunk ColumnarReader::chunk(
+    std::size_t index, const std::vector<std::size_t>& columns) const {
+  const ChunkRef& ref = chunks_.at(index);
+  Chunk chunk;
+  chunk.rows_ = static_cast<std::size_t>(ref.rows);
+  chunk.columns_.resize(schema_.size());
+  const auto fail = [&](const std::string& what) {
+    return CorruptionError(path_.string() + ": chunk " +
+                           std::to_string(index) + ": " + what);
+  };
+  const auto load = [&](std::size_t c) {
+    const ColumnRef& column = ref.columns.at(c);
+    const std::string_view packed =
+        file_.bytes().substr(column.offset, column.size);
+    if (hash64(packed) != column.hash) throw fail("checksum mismatch");
+    Chunk::Data& data = chunk.columns_[c];
+    data.type = schema_[c].type;
+    data.bytes.resize(column.raw_size);
+    const std::size_t n = ZSTD_decompress(data.bytes.data(), data.bytes.size(),
+                                          packed.data(), packed.size());
+    if (ZSTD_isError(n) || n != column.raw_size) throw fail("bad block");
+    if (data.type == ColumnType::kString) {
+      if (n < 4 * ref.rows) throw fail("bad string column");
+      data.offsets.reserve(chunk.rows_ + 1);
+      std::uint64_t offset = 4 * ref.rows;
+      data.offsets.push_back(offset);
+      for (std::size_t row = 0; row < chunk.rows_; ++row) {
+        offset += coding::load_u32(data.bytes.data() + 4 * row);
+        data.offsets.push_back(offset);
+      }
+      if (offset != n) throw fail("bad string column");
+    } else if (n != width(data.type) * ref.rows) {
+      throw fail("bad column size");
+    }
+    data.loaded = true;
+  };
+  if (columns.empty()) {
+    for (std::size_t c = 0; c < schema_.size(); ++c) load(c);
+  } else {
+    for (const std::size_t c : columns) load(c);
+  }
+  return chunk;
+}
+
+const ColumnarReader::Chunk::Data& ColumnarReader::Chunk::data(
+    std::size_t column) const {
+  const Data& data = columns_.at(column);
+  if (!data.loaded) throw std::out_of_range("column not loaded");
+  return data;
+}
+
+std::uint64_t ColumnarReader::Chunk::u64(std::size_t column,
+                                         std::size_t row) const {
+  const Data& d = data(column);
+  const char* p = d.bytes.data();
+  switch (d.type) {
+    case ColumnType::kU8:
+      return static_cast<std::uint8_t>(p[row]);
+    case ColumnType::kU32:
+      return coding::load_u32(p + 4 * row);
+    case ColumnType::kU64:
+      return coding::load_u64(p + 8 * row);
+    case ColumnType::kString:
+      break;
+  }
+  throw std::out_of_range("not an integer column");
+}
+
+std::string_view ColumnarReader::Chunk::str(std::size_t column,
+                                            std::size_t row) const {
+  const Data& d = data(column);
+  if (d.type != ColumnType::kString) {
+    throw std::out_of_range("not a string column");
+  }
+  return std::string_view(d.bytes).substr(
+      d.offsets[row], d.offsets[row + 1] - d.offsets[row]);
+}
+
+}  // namespace codecoach::storage
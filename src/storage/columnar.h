@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/mapped_file.h"
+#include "storage/sstable.h"
+
+namespace codecoach::storage {
+
+enum class ColumnType : std::uint8_t {
+  kU8 = 0,
+  kU32 = 1,
+  kU64 = 2,
+  kString = 3,
+};
+
+struct Column {
+  std::string name;
+  ColumnType type;
+
+  bool operator==(const Column&) const = default;
+};
+using Schema = std::vector<Column>;
+
+// Chunked columnar file for bulk export of judged data to analytics and
+// training jobs (our own format: the fleet has no Parquet or Arrow
+// dependency, and the layout is the same idea):
+//
+//   "CCCOL1\0\0"
+//   chunks        per column: zstd block of fixed-width little-endian
+//                 values, or of u32 lengths followed by the bytes
+//   footer        schema, then per chunk [u64 rows] and per column
+//                 [u64 offset][u64 size][u64 raw size][u64 hash]
+//   trailer       [u64 footer offset][u64 footer size][magic]
+//
+// Readers load one chunk at a time, and only the columns they ask for, so
+// memory is bounded by the chunk size whatever the file size.
+
+// Writes rows into a new file. Like SSTableWriter, the file appears under
+// its final name only once finish() has synced it. Buffers at most one
+// chunk: `chunk_rows` rows or `chunk_bytes` of values, whichever is hit
+// first.
+class ColumnarWriter {
+ public:
+  ColumnarWriter(std::filesystem::path path, Schema schema,
+                 std::size_t chunk_rows = 65536,
+                 std::size_t chunk_bytes = 16u << 20, int level = 1);
+  ~ColumnarWriter();
+  ColumnarWriter(const ColumnarWriter&) = delete;
+  ColumnarWriter& operator=(const ColumnarWriter&) = delete;
+
+  // One value per column, then end_row(). Throws std::logic_error on a
+  // type mismatch or a row with missing or repeated values.
+  void add(std::size_t column, std::uint64_t value);
+  void add(std::size_t column, std::string_view value);
+  void end_row();
+  // Returns the file size.
+  std::uint64_t finish();
+
+  std::uint64_t rows() const { return rows_; }
+
+ private:
+  struct Buffer {
+    std::string values;   // Fixed-width values, or string bytes.
+    std::string lengths;  // String columns: u32 per row.
+    std::uint64_t filled = 0;
+  };
+
+  void flush_chunk();
+  void write_out(std::string_view data);
+
+  std::filesystem::path path_;
+  std::filesystem::path tmp_;
+  Schema schema_;
+  std::size_t chunk_rows_;
+  std::size_t chunk_bytes_;
+  int level_;
+  int fd_ = -1;
+  std::uint64_t offset_ = 0;
+  std::uint64_t rows_ = 0;
+  std::uint64_t chunk_row_count_ = 0;
+  std::size_t buffered_bytes_ = 0;
+  std::vector<Buffer> buffers_;
+  std::string index_;
+  std::uint64_t chunks_ = 0;
+  bool finished_ = false;
+};
+
+class ColumnarReader {
+ public:
+  // Throws CorruptionError for a file that is not a complete columnar
+  // file.
+  explicit ColumnarReader(const std::filesystem::path& path);
+
+  const Schema& schema() const { return schema_; }
+  std::size_t chunk_count() const { return chunks_.size(); }
+  std::uint64_t rows() const { return rows_; }
+  // Throws std::out_of_range for an unknown column.
+  std::size_t column(std::string_view name) const;
+
+  // Decoded columns of one chunk. Views stay valid while the chunk lives.
+  class Chunk {
+   public:
+    std::size_t rows() const { return rows_; }
+    // Throw std::out_of_range for a column that was not loaded.
+    std::uint64_t u64(std::size_t column, std::size_t row) const;
+    std::string_view str(std::size_t column, std::size_t row) const;
+
+   private:
+    friend class ColumnarReader;
+    struct Data {
+      bool loaded = false;
+      ColumnType type = ColumnType::kU64;
+      std::string bytes;
+      std::vector<std::uint64_t> offsets;  // Strings: rows + 1 entries.
+    };
+    const Data& data(std::size_t column) const;
+
+    std::size_t rows_ = 0;
+    std::vector<Data> columns_;
+  };
+
+  // Decompresses `columns` of chunk `index` (all columns when empty) and
+  // verifies their hashes; throws CorruptionError on a mismatch.
+  Chunk chunk(std::size_t index,
+              const std::vector<std::size_t>& columns = {}) const;
+
+ private:
+  struct ColumnRef {
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint64_t raw_size;
+    std::uint64_t hash;
+  };
+  struct ChunkRef {
+    std::uint64_t rows;
+    std::vector<ColumnRef> columns;
+  };
+
+  std::filesystem::path path_;
+  MappedFile file_;
+  Schema schema_;
+  std::vector<ChunkRef> chunks_;
+  std::uint64_t rows_ = 0;
+};
+
+}  // namespace codecoach::storage
@@ -0,0 +1,587 @@
+#include "storage/lsm_store.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "common/durable_file.h"
+#include "storage/bloom_filter.h"
+#include "storage/coding.h"
+
+namespace codecoach::storage {
+
+namespace {
+
+constexpr std::string_view kManifestHeader = "codecoach-lsm\t1";
+constexpr std::uint8_t kPut = 1;
+constexpr std::uint8_t kDelete = 2;
+// Per-entry memtable overhead (map node, optional) counted toward its size.
+constexpr std::size_t kEntryOverhead = 64;
+
+// Calls fn(op, family, key, value) per operation; false if `rep` is
+// malformed.
+template <typename Fn>
+bool decode_batch(std::string_view rep, Fn&& fn) {
+  coding::Reader in(rep);
+  while (!in.empty()) {
+    std::uint8_t op = 0;
+    std::string_view family, key, value;
+    if (!in.u8(op) || !in.bytes(family) || !in.bytes(key)) return false;
+    if (op == kPut) {
+      if (!in.bytes(value)) return false;
+    } else if (op != kDelete) {
+      return false;
+    }
+    fn(op, family, key, value);
+  }
+  return true;
+}
+
+std::optional<std::uint64_t> parse_number(std::string_view text) {
+  std::uint64_t n = 0;
+  const auto result =
+      std::from_chars(text.data(), text.data() + text.size(), n);
+  if (text.empty() || result.ec != std::errc() ||
+      result.ptr != text.data() + text.size()) {
+    return std::nullopt;
+  }
+  return n;
+}
+
+bool valid_family_name(std::string_view name) {
+  return !name.empty() && name.find_first_of("\t\n") == std::string_view::npos;
+}
+
+}  // namespace
+
+void WriteBatch::put(std::string_view family, std::string_view key,
+                     std::string_view value) {
+  coding::put_u8(rep_, kPut);
+  coding::put_bytes(rep_, family);
+  coding::put_bytes(rep_, key);
+  coding::put_bytes(rep_, value);
+  ++operations_;
+}
+
+void WriteBatch::erase(std::string_view family, std::string_view key) {
+  coding::put_u8(rep_, kDelete);
+  coding::put_bytes(rep_, family);
+  coding::put_bytes(rep_, key);
+  ++operations_;
+}
+
+void WriteBatch::append(const WriteBatch& other) {
+  rep_ += other.rep_;
+  operations_ += other.operations_;
+}
+
+void WriteBatch::clear() {
+  rep_.clear();
+  operations_ = 0;
+}
+
+LsmStore::LsmStore(std::filesystem::path directory, const Families& families,
+                   LsmOptions options)
+    : directory_(std::move(directory)), options_(options) {
+  std::filesystem::create_directories(directory_);
+  for (const auto& [name, family_options] : families) {
+    if (!valid_family_name(name)) {
+      throw std::invalid_argument("bad column family name '" + name + "'");
+    }
+    families_[name].options = family_options;
+  }
+
+  // MANIFEST: header, then "next\tN", "log\tN", "family\tNAME" and
+  // "table\tNAME\tN" lines, tables newest first within a family.
+  std::vector<std::uint64_t> live;
+  const auto manifest = directory_ / "MANIFEST";
+  if (std::ifstream in(manifest); in) {
+    std::string line;
+    if (!std::getline(in, line) || line != kManifestHeader) {
+      throw CorruptionError(manifest.string() + ": bad header");
+    }
+    while (std::getline(in, line)) {
+      const auto tab = line.find('\t');
+      const std::string_view tag = std::string_view(line).substr(0, tab);
+      const std::string_view rest =
+          tab == std::string::npos ? std::string_view()
+                                   : std::string_view(line).substr(tab + 1);
+      const auto last_tab = rest.rfind('\t');
+      if (tag == "next" || tag == "log") {
+        const auto n = parse_number(rest);
+        if (!n) throw CorruptionError(manifest.string() + ": " + line);
+        (tag == "next" ? next_file_ : log_floor_) = *n;
+      } else if (tag == "family" && valid_family_name(rest)) {
+        families_.try_emplace(std::string(rest));
+      } else if (tag == "table" && last_tab != std::string_view::npos) {
+        const auto n = parse_number(rest.substr(last_tab + 1));
+        if (!n) throw CorruptionError(manifest.string() + ": " + line);
+        auto& family = families_[std::string(rest.substr(0, last_tab))];
+        auto tables = std::make_shared<TableList>(*family.tables);
+        tables->push_back({*n, SSTable::open(file_path(*n, "sst"))});
+        family.tables = std::move(tables);
+        live.push_back(*n);
+      } else {
+        throw CorruptionError(manifest.string() + ": " + line);
+      }
+    }
+  }
+
+  // Leftovers of an interrupted flush or compaction, and logs already
+  // covered by tables, go; newer logs are replayed in order.
+  std::vector<std::uint64_t> logs;
+  for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
+    const auto path = entry.path();
+    const auto number = parse_number(path.stem().string());
+    const auto ext = path.extension();
+    if (ext == ".tmp") {
+      std::filesystem::remove(path);
+      continue;
+    }
+    if (!number) continue;
+    next_file_ = std::max(next_file_, *number + 1);
+    if (ext == ".sst" &&
+        std::find(live.begin(), live.end(), *number) == live.end()) {
+      std::filesystem::remove(path);
+    } else if (ext == ".log") {
+      if (*number < log_floor_) {
+        std::filesystem::remove(path);
+      } else {
+        logs.push_back(*number);
+      }
+    }
+  }
+  std::sort(logs.begin(), logs.end());
+  for (const auto number : logs) {
+    WriteAheadLog::replay(file_path(number, "log"),
+                          [&](std::string_view rep) { apply_locked(rep); });
+  }
+
+  wal_number_ = next_file_++;
+  wal_ = std::make_unique<WriteAheadLog>(file_path(wal_number_, "log"));
+  background_ = std::thread([this] { background(); });
+}
+
+LsmStore::~LsmStore() {
+  {
+    std::lock_guard lock(mu_);
+    stop_ = true;
+  }
+  work_.notify_all();
+  background_.join();
+}
+
+std::filesystem::path LsmStore::file_path(std::uint64_t number,
+                                          std::string_view ext) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%06llu.",
+                static_cast<unsigned long long>(number));
+  return directory_ / (name + std::string(ext));
+}
+
+LsmStore::Family* LsmStore::find_family(std::string_view name) {
+  const auto it = families_.find(name);
+  return it == families_.end() ? nullptr : &it->second;
+}
+
+const LsmStore::Family* LsmStore::find_family(std::string_view name) const {
+  const auto it = families_.find(name);
+  return it == families_.end() ? nullptr : &it->second;
+}
+
+void LsmStore::apply_locked(std::string_view rep) {
+  const bool ok = decode_batch(
+      rep, [&](std::uint8_t op, std::string_view name, std::string_view key,
+               std::string_view value) {
+        // Replay may meet families no longer configured; keep their data.
+        auto& family = families_[std::string(name)];
+        family.active_bytes += key.size() + value.size() + kEntryOverhead;
+        auto& slot = (*family.active)[std::string(key)];
+        if (op == kPut) {
+          slot = std::string(value);
+        } else {
+          slot.reset();
+        }
+      });
+  if (!ok) throw CorruptionError("malformed write batch");
+}
+
+bool LsmStore::has_frozen_locked() const {
+  return std::any_of(families_.begin(), families_.end(), [](const auto& f) {
+    return f.second.frozen != nullptr;
+  });
+}
+
+void LsmStore::rotate_locked() {
+  const std::uint64_t number = next_file_++;
+  wal_ = std::make_unique<WriteAheadLog>(file_path(number, "log"));
+  wal_number_ = number;
+  for (auto& [name, family] : families_) {
+    if (family.active->empty()) continue;
+    family.frozen = std::move(family.active);
+    family.active = std::make_shared<Memtable>();
+    family.active_bytes = 0;
+  }
+  frozen_floor_ = number;
+  work_.notify_one();
+}
+
+void LsmStore::write(const WriteBatch& batch) {
+  if (batch.empty()) return;
+  std::lock_guard writer(write_mu_);
+  {
+    std::unique_lock lock(mu_);
+    decode_batch(batch.rep_, [&](std::uint8_t, std::string_view name,
+                                 std::string_view, std::string_view) {
+      if (find_family(name) == nullptr) {
+        throw std::invalid_argument("unknown column family '" +
+                                    std::string(name) + "'");
+      }
+    });
+    for (;;) {
+      if (background_error_) std::rethrow_exception(background_error_);
+      const bool full =
+          std::any_of(families_.begin(), families_.end(), [](const auto& f) {
+            return f.second.active_bytes >= f.second.options.memtable_bytes;
+          });
+      if (!full) break;
+      if (has_frozen_locked()) {
+        // The previous memtables are still being written out.
+        idle_.wait(lock);
+        continue;
+      }
+      rotate_locked();
+    }
+  }
+  // wal_ only changes under write_mu_, which this thread holds.
+  wal_->append(batch.rep_, options_.sync_writes);
+  std::lock_guard lock(mu_);
+  apply_locked(batch.rep_);
+}
+
+void LsmStore::put(std::string_view family, std::string_view key,
+                   std::string_view value) {
+  WriteBatch batch;
+  batch.put(family, key, value);
+  write(batch);
+}
+
+void LsmStore::erase(std::string_view family, std::string_view key) {
+  WriteBatch batch;
+  batch.erase(family, key);
+  write(batch);
+}
+
+std::optional<std::string> LsmStore::get(std::string_view family,
+                                         std::string_view key) const {
+  std::shared_ptr<const TableList> tables;
+  const Family* f = nullptr;
+  {
+    std::lock_guard lock(mu_);
+    f = find_family(family);
+    if (f == nullptr) {
+      throw std::invalid_argument("unknown column family '" +
+                                  std::string(family) + "'");
+    }
+    const Memtable* memtables[] = {f->active.get(), f->frozen.get()};
+    for (const Memtable* memtable : memtables) {
+      if (memtable == nullptr) continue;
+      if (const auto it = memtable->find(key); it != memtable->end()) {
+        return it->second;
+      }
+    }
+    tables = f->tables;
+  }
+  const std::uint64_t hash = bloom_hash(key);
+  for (const Table& t : *tables) {
+    if (!t.table->may_contain(hash)) {
+      f->bloom_skips.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    std::string_view value;
+    switch (t.table->get(key, value)) {
+      case SSTable::Found::kValue: return std::string(value);
+      case SSTable::Found::kTombstone: return std::nullopt;
+      case SSTable::Found::kAbsent: break;
+    }
+  }
+  return std::nullopt;
+}
+
+void LsmStore::scan(
+    std::string_view family, std::string_view prefix,
+    const std::function<void(std::string_view, std::string_view)>& fn) const {
+  // Newest source first; emplace keeps the first (newest) version.
+  Memtable merged;
+  std::shared_ptr<const TableList> tables;
+  {
+    std::lock_guard lock(mu_);
+    const Family* f = find_family(family);
+    if (f == nullptr) {
+      throw std::invalid_argument("unknown column family '" +
+                                  std::string(family) + "'");
+    }
+    const Memtable* memtables[] = {f->active.get(), f->frozen.get()};
+    for (const Memtable* memtable : memtables) {
+      if (memtable == nullptr) continue;
+      for (auto it = memtable->lower_bound(prefix);
+           it != memtable->end() && it->first.starts_with(prefix); ++it) {
+        merged.emplace(it->first, it->second);
+      }
+    }
+    tables = f->tables;
+  }
+  for (const Table& t : *tables) {
+    for (auto it = t.table->seek(prefix);
+         it.valid() && it.key().starts_with(prefix); it.next()) {
+      if (merged.find(it.key()) != merged.end()) continue;
+      merged.emplace(std::string(it.key()),
+                     it.tombstone() ? std::nullopt
+                                    : std::optional<std::string>(it.value()));
+    }
+  }
+  for (const auto& [key, value] : merged) {
+    if (value) fn(key, *value);
+  }
+}
+
+void LsmStore::flush() {
+  {
+    std::lock_guard writer(write_mu_);
+    std::unique_lock lock(mu_);
+    idle_.wait(lock, [&] {
+      return background_error_ != nullptr || !has_frozen_locked();
+    });
+    if (background_error_) std::rethrow_exception(background_error_);
+    const bool pending =
+        std::any_of(families_.begin(), families_.end(),
+                    [](const auto& f) { return !f.second.active->empty(); });
+    if (pending) rotate_locked();
+  }
+  std::unique_lock lock(mu_);
+  idle_.wait(lock, [&] {
+    return background_error_ != nullptr ||
+           (!has_frozen_locked() && !pick_compaction_locked());
+  });
+  if (background_error_) std::rethrow_exception(background_error_);
+}
+
+LsmStore::FamilyStats LsmStore::stats(std::string_view family) const {
+  std::lock_guard lock(mu_);
+  const Family* f = find_family(family);
+  if (f == nullptr) {
+    throw std::invalid_argument("unknown column family '" +
+                                std::string(family) + "'");
+  }
+  FamilyStats stats;
+  stats.tables = f->tables->size();
+  for (const Table& t : *f->tables) stats.table_bytes += t.table->file_size();
+  stats.memtable_bytes = f->active_bytes;
+  stats.bloom_skips = f->bloom_skips.load(std::memory_order_relaxed);
+  stats.compactions = f->compactions;
+  return stats;
+}
+
+void LsmStore::write_manifest_locked() {
+  std::string text(kManifestHeader);
+  text += "\nnext\t" + std::to_string(next_file_) + "\nlog\t" +
+          std::to_string(log_floor_) + "\n";
+  for (const auto& [name, family] : families_) {
+    text += "family\t" + name + "\n";
+    for (const Table& t : *family.tables) {
+      text += "table\t" + name + "\t" + std::to_string(t.number) + "\n";
+    }
+  }
+  replace_file_synced(directory_ / "MANIFEST", text);
+}
+
+void LsmStore::remove_obsolete_logs(std::uint64_t floor) {
+  std::error_code ec;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(directory_, ec)) {
+    const auto number = parse_number(entry.path().stem().string());
+    if (number && *number < floor && entry.path().extension() == ".log") {
+      std::filesystem::remove(entry.path(), ec);
+    }
+  }
+}
+
+void LsmStore::background() {
+  std::unique_lock lock(mu_);
+  while (!stop_) {
+    try {
+      if (has_frozen_locked()) {
+        flush_frozen(lock);
+        continue;
+      }
+      if (auto job = pick_compaction_locked()) {
+        compact(std::move(*job), lock);
+        continue;
+      }
+    } catch (...) {
+      // Reads keep working from what is installed; writes report this.
+      background_error_ = std::current_exception();
+      idle_.notify_all();
+      return;
+    }
+    idle_.notify_all();
+    work_.wait(lock);
+  }
+}
+
+void LsmStore::flush_frozen(std::unique_lock<std::mutex>& lock) {
+  struct Job {
+    Family* family;
+    std::shared_ptr<const Memtable> memtable;
+    std::uint64_t number;
+    std::shared_ptr<const SSTable> table;
+  };
+  std::vector<Job> jobs;
+  for (auto& [name, family] : families_) {
+    if (family.frozen) {
+      jobs.push_back({&family, family.frozen, next_file_++, nullptr});
+    }
+  }
+  const std::uint64_t floor = frozen_floor_;
+
+  lock.unlock();
+  try {
+    for (Job& job : jobs) {
+      const auto& options = job.family->options;
+      const auto path = file_path(job.number, "sst");
+      SSTableWriter writer(path, options.bloom_bits_per_key,
+                           options.block_bytes);
+      for (const auto& [key, value] : *job.memtable) {
+        writer.add(key, value ? *value : std::string_view(), !value);
+      }
+      writer.finish();
+      job.table = SSTable::open(path);
+    }
+  } catch (...) {
+    lock.lock();
+    throw;
+  }
+  lock.lock();
+
+  for (Job& job : jobs) {
+    auto tables = std::make_shared<TableList>();
+    tables->push_back({job.number, job.table});
+    tables->insert(tables->end(), job.family->tables->begin(),
+                   job.family->tables->end());
+    job.family->tables = std::move(tables);
+    job.family->frozen.reset();
+  }
+  log_floor_ = floor;
+  write_manifest_locked();
+  idle_.notify_all();
+  lock.unlock();
+  remove_obsolete_logs(floor);
+  lock.lock();
+}
+
+std::optional<LsmStore::Compaction> LsmStore::pick_compaction_locked() {
+  for (auto& [name, family] : families_) {
+    const TableList& tables = *family.tables;
+    const std::size_t trigger =
+        std::max<std::size_t>(family.options.compaction_trigger, 2);
+    if (tables.size() < trigger) continue;
+    // The newest run of `trigger` tables within a 4x size band; tables are
+    // ordered by age, so this merges like-sized neighbours. A family whose
+    // sizes never line up is merged whole once it has 3x the trigger.
+    std::size_t begin = 0, end = 0;
+    for (std::size_t start = 0; start + trigger <= tables.size(); ++start) {
+      std::uint64_t lo = UINT64_MAX, hi = 0;
+      for (std::size_t i = start; i < start + trigger; ++i) {
+        lo = std::min(lo, tables[i].table->file_size());
+        hi = std::max(hi, tables[i].table->file_size());
+      }
+      if (hi <= 4 * std::max<std::uint64_t>(lo, 1)) {
+        begin = start;
+        end = start + trigger;
+        break;
+      }
+    }
+    if (end == 0 && tables.size() >= 3 * trigger) end = tables.size();
+    if (end == 0) continue;
+    return Compaction{&family,
+                      TableList(tables.begin() + begin, tables.begin() + end),
+                      end == tables.size()};
+  }
+  return std::nullopt;
+}
+
+void LsmStore::compact(Compaction job, std::unique_lock<std::mutex>& lock) {
+  const std::uint64_t number = next_file_++;
+  const ColumnFamilyOptions options = job.family->options;
+  std::shared_ptr<const SSTable> merged;
+
+  lock.unlock();
+  try {
+    const auto path = file_path(number, "sst");
+    SSTableWriter writer(path, options.bloom_bits_per_key,
+                         options.block_bytes);
+    std::vector<SSTable::Iterator> inputs;
+    for (const Table& t : job.inputs) inputs.push_back(t.table->begin());
+    for (;;) {
+      // Smallest key; on a tie the newest input (lowest index) wins.
+      std::size_t best = inputs.size();
+      for (std::size_t i = 0; i < inputs.size(); ++i) {
+        if (inputs[i].valid() &&
+            (best == inputs.size() || inputs[i].key() < inputs[best].key())) {
+          best = i;
+        }
+      }
+      if (best == inputs.size()) break;
+      const std::string_view key = inputs[best].key();
+      if (!(job.drop_tombstones && inputs[best].tombstone())) {
+        writer.add(key, inputs[best].value(), inputs[best].tombstone());
+      }
+      for (std::size_t i = 0; i < inputs.size(); ++i) {
+        if (i != best && inputs[i].valid() && inputs[i].key() == key) {
+          inputs[i].next();
+        }
+      }
+      inputs[best].next();
+    }
+    if (writer.entries() > 0) {
+      writer.finish();
+      merged = SSTable::open(path);
+    }
+  } catch (...) {
+    lock.lock();
+    throw;
+  }
+  lock.lock();
+
+  // Flushes may have added newer tables meanwhile; the inputs are still a
+  // contiguous run, replaced in place by the merged table.
+  const auto is_input = [&](const Table& t) {
+    return std::any_of(job.inputs.begin(), job.inputs.end(),
+                       [&](const Table& in) { return in.number == t.number; });
+  };
+  auto tables = std::make_shared<TableList>();
+  bool placed = false;
+  for (const Table& t : *job.family->tables) {
+    if (!is_input(t)) {
+      tables->push_back(t);
+    } else if (!placed) {
+      if (merged) tables->push_back({number, merged});
+      placed = true;
+    }
+  }
+  job.family->tables = std::move(tables);
+  ++job.family->compactions;
+  write_manifest_locked();
+  idle_.notify_all();
+  lock.unlock();
+  // Readers still holding the inputs keep their mappings.
+  std::error_code ec;
+  for (const Table& t : job.inputs) {
+    std::filesystem::remove(file_path(t.number, "sst"), ec);
+  }
+  lock.lock();
+}
+
+}  // namespace codecoach::storage
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "storage/sstable.h"
+#include "storage/write_ahead_log.h"
+
+namespace codecoach::storage {
+
+struct ColumnFamilyOptions {
+  // A memtable this large is frozen and flushed to a table.
+  std::size_t memtable_bytes = 4u << 20;
+  std::size_t bloom_bits_per_key = 10;
+  std::size_t block_bytes = 4096;
+  // Size-tiered compaction merges this many tables of similar size into
+  // one. Low for read-mostly families (artifact cache: fewer tables per
+  // lookup), high for append-heavy ones (submissions: less rewriting).
+  std::size_t compaction_trigger = 4;
+};
+
+struct LsmOptions {
+  // fdatasync the log on every write. Without it a crash can lose the
+  // last moments of writes, but never tear a batch or corrupt older data.
+  bool sync_writes = false;
+};
+
+// Puts and deletes across column families, applied atomically.
+class WriteBatch {
+ public:
+  void put(std::string_view family, std::string_view key,
+           std::string_view value);
+  void erase(std::string_view family, std::string_view key);
+  // Appends `other`'s operations after this batch's.
+  void append(const WriteBatch& other);
+  void clear();
+
+  std::size_t operations() const { return operations_; }
+  std::size_t bytes() const { return rep_.size(); }
+  bool empty() const { return operations_ == 0; }
+
+ private:
+  friend class LsmStore;
+
+  // [u8 op][family][key][value] per operation, in storage/coding format;
+  // also the write-ahead log record.
+  std::string rep_;
+  std::size_t operations_ = 0;
+};
+
+// Embedded log-structured merge-tree store for submissions, verdicts,
+// compile artifacts and coach responses, one column family per data kind.
+//
+// Writes go to a shared write-ahead log and then to the family's memtable.
+// Full memtables are frozen (all families at once, starting a new log) and
+// a background thread writes them out as sorted tables, then merges tables
+// by size tier. Each table carries a bloom filter, so lookups of absent
+// keys rarely read table data. The set of live tables is recorded in a
+// MANIFEST replaced atomically; on open, logs not yet covered by flushed
+// tables are replayed.
+//
+// Thread-safe. Reads never wait for flushes or compaction. Writers block
+// only while both a frozen and a full memtable are pending; keep them off
+// latency-critical paths with AsyncWriter.
+class LsmStore {
+ public:
+  using Families = std::vector<std::pair<std::string, ColumnFamilyOptions>>;
+
+  // Opens or creates the store. Families found on disk but not listed are
+  // kept with default options. Throws std::system_error or
+  // CorruptionError.
+  LsmStore(std::filesystem::path directory, const Families& families,
+           LsmOptions options = {});
+  ~LsmStore();
+  LsmStore(const LsmStore&) = delete;
+  LsmStore& operator=(const LsmStore&) = delete;
+
+  // Throws std::invalid_argument for an unknown family (nothing is
+  // applied), or the background thread's error if it has failed.
+  void write(const WriteBatch& batch);
+  void put(std::string_view family, std::string_view key,
+           std::string_view value);
+  void erase(std::string_view family, std::string_view key);
+
+  std::optional<std::string> get(std::string_view family,
+                                 std::string_view key) const;
+  // Calls `fn` with each live key starting with `prefix`, in key order,
+  // from a consistent snapshot.
+  void scan(std::string_view family, std::string_view prefix,
+            const std::function<void(std::string_view key,
+                                     std::string_view value)>& fn) const;
+
+  // Writes all memtables out and waits for compaction to settle.
+  void flush();
+
+  struct FamilyStats {
+    std::size_t tables = 0;
+    std::uint64_t table_bytes = 0;
+    std::size_t memtable_bytes = 0;
+    std::uint64_t bloom_skips = 0;  // Table reads avoided.
+    std::uint64_t compactions = 0;
+  };
+  FamilyStats stats(std::string_view family) const;
+
+ private:
+  using Memtable =
+      std::map<std::string, std::optional<std::string>, std::less<>>;
+
+  struct Table {
+    std::uint64_t number;
+    std::shared_ptr<const SSTable> table;
+  };
+  using TableList = std::vector<Table>;  // Newest first.
+
+  struct Family {
+    ColumnFamilyOptions options;
+    std::shared_ptr<Memtable> active = std::make_shared<Memtable>();
+    std::size_t active_bytes = 0;
+    std::shared_ptr<const Memtable> frozen;
+    std::shared_ptr<const TableList> tables = std::make_shared<TableList>();
+    mutable std::atomic<std::uint64_t> bloom_skips{0};
+    std::uint64_t compactions = 0;
+  };
+
+  struct Compaction {
+    Family* family;
+    TableList inputs;
+    bool drop_tombstones;  // Inputs include the oldest table.
+  };
+
+  Family* find_family(std::string_view name);
+  const Family* find_family(std::string_view name) const;
+  void apply_locked(std::string_view rep);
+  void rotate_locked();
+  bool has_frozen_locked() const;
+  std::optional<Compaction> pick_compaction_locked();
+  void write_manifest_locked();
+  void remove_obsolete_logs(std::uint64_t floor);
+  std::filesystem::path file_path(std::uint64_t number,
+                                  std::string_view ext) const;
+
+  void background();
+  void flush_frozen(std::unique_lock<std::mutex>& lock);
+  void compact(Compaction job, std::unique_lock<std::mutex>& lock);
+
+  std::filesystem::path directory_;
+  LsmOptions options_;
+
+  std::mutex write_mu_;  // Serializes writers; guards wal_.
+  std::unique_ptr<WriteAheadLog> wal_;
+
+  mutable std::mutex mu_;
+  std::condition_variable work_;  // Wakes the background thread.
+  std::condition_variable idle_;  // Signals flush/compaction progress.
+  std::map<std::string, Family, std::less<>> families_;
+  std::uint64_t next_file_ = 1;
+  std::uint64_t wal_number_ = 0;
+  std::uint64_t log_floor_ = 0;     // Logs below this are in tables.
+  std::uint64_t frozen_floor_ = 0;  // log_floor_ once frozen are flushed.
+  std::exception_ptr background_error_;
+  bool stop_ = false;
+  std::thread background_;
+};
+
+}  // namespace codecoach::storage
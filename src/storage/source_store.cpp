@@ -0,0 +1,378 @@
+#include "storage/source_store.h"
+
+#include <zdict.h>
+#include <zstd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "storage/coding.h"
+
+namespace codecoach::storage {
+
+namespace {
+
+enum Format : std::uint8_t { kRaw = 0, kZstd = 1 };
+
+constexpr std::string_view kScopePrefix = "scope\t";
+constexpr std::string_view kSamplePrefix = "sample\t";
+constexpr std::string_view kDictionaryPrefix = "dict\t";
+
+struct CctxDeleter {
+  void operator()(ZSTD_CCtx* ctx) const { ZSTD_freeCCtx(ctx); }
+};
+struct DctxDeleter {
+  void operator()(ZSTD_DCtx* ctx) const { ZSTD_freeDCtx(ctx); }
+};
+
+ZSTD_CCtx* thread_cctx() {
+  thread_local std::unique_ptr<ZSTD_CCtx, CctxDeleter> ctx(ZSTD_createCCtx());
+  return ctx.get();
+}
+
+ZSTD_DCtx* thread_dctx() {
+  thread_local std::unique_ptr<ZSTD_DCtx, DctxDeleter> ctx(ZSTD_createDCtx());
+  return ctx.get();
+}
+
+std::string scope_name(std::string_view problem, std::string_view language) {
+  std::string name(problem);
+  name += '\t';
+  name += language;
+  return name;
+}
+
+std::string dictionary_key(std::uint32_t id) {
+  char hex[9];
+  std::snprintf(hex, sizeof(hex), "%08x", id);
+  return std::string(kDictionaryPrefix) + hex;
+}
+
+std::string sample_prefix(std::string_view scope) {
+  std::string prefix(kSamplePrefix);
+  prefix += scope;
+  prefix += '\t';
+  return prefix;
+}
+
+std::string sample_key(std::string_view scope, std::uint64_t slot) {
+  char number[24];
+  std::snprintf(number, sizeof(number), "%08llu",
+                static_cast<unsigned long long>(slot));
+  return sample_prefix(scope) + number;
+}
+
+}  // namespace
+
+struct SourceStore::Dictionary {
+  ZSTD_CDict* cdict = nullptr;
+  ZSTD_DDict* ddict = nullptr;
+
+  Dictionary(std::string_view bytes, int level)
+      : cdict(ZSTD_createCDict(bytes.data(), bytes.size(), level)),
+        ddict(ZSTD_createDDict(bytes.data(), bytes.size())) {
+    if (cdict == nullptr || ddict == nullptr) {
+      ZSTD_freeCDict(cdict);
+      ZSTD_freeDDict(ddict);
+      throw CorruptionError("unusable compression dictionary");
+    }
+  }
+  ~Dictionary() {
+    ZSTD_freeCDict(cdict);
+    ZSTD_freeDDict(ddict);
+  }
+  Dictionary(const Dictionary&) = delete;
+  Dictionary& operator=(const Dictionary&) = delete;
+};
+
+LsmStore::Families SourceStore::families() {
+  // Sources are append-only and rarely read back in bulk: fewer, larger
+  // merges.
+  ColumnFamilyOptions sources;
+  sources.memtable_bytes = 16u << 20;
+  sources.compaction_trigger = 8;
+  return {{std::string(kSourcesFamily), sources},
+          {std::string(kDictionariesFamily), ColumnFamilyOptions{}}};
+}
+
+SourceStore::SourceStore(LsmStore& store, SourceStoreOptions options)
+    : store_(store), options_(options) {
+  store_.scan(kDictionariesFamily, kDictionaryPrefix,
+              [&](std::string_view key, std::string_view) {
+                const std::string hex(key.substr(kDictionaryPrefix.size()));
+                const auto id =
+                    static_cast<std::uint32_t>(std::stoul(hex, nullptr, 16));
+                if (id >= next_dictionary_) next_dictionary_ = id + 1;
+              });
+}
+
+SourceStore::~SourceStore() = default;
+
+std::string SourceStore::scope_record(const Scope& scope) {
+  std::string out;
+  coding::put_u32(out, scope.dictionary);
+  coding::put_u64(out, scope.puts);
+  coding::put_u64(out, scope.samples);
+  coding::put_u64(out, scope.since_training);
+  return out;
+}
+
+SourceStore::Scope& SourceStore::scope_locked(const std::string& name) {
+  const auto it = scopes_.find(name);
+  if (it != scopes_.end()) return it->second;
+  Scope scope;
+  if (const auto value = store_.get(kDictionariesFamily,
+                                    std::string(kScopePrefix) + name)) {
+    coding::Reader in(*value);
+    if (!in.u32(scope.dictionary) || !in.u64(scope.puts) ||
+        !in.u64(scope.samples) || !in.u64(scope.since_training)) {
+      throw CorruptionError("bad source scope record for " + name);
+    }
+  }
+  return scopes_.emplace(name, scope).first->second;
+}
+
+void SourceStore::sample_locked(const std::string& name, Scope& scope,
+                                std::string_view record, WriteBatch& batch) {
+  ++scope.puts;
+  ++scope.since_training;
+  if (scope.puts <= options_.sample_slots ||
+      scope.puts % options_.sample_every == 0) {
+    batch.put(kDictionariesFamily,
+              sample_key(name, scope.samples++ % options_.sample_slots),
+              record);
+  }
+  // A scope that failed to train waits for min_samples fresh texts.
+  const bool due =
+      scope.dictionary == 0
+          ? scope.samples >= options_.min_samples &&
+                scope.since_training >= options_.min_samples
+          : scope.since_training >= options_.retrain_interval;
+  if (due) due_.insert(name);
+
+  // Concurrent batches may land out of order, so the persisted counters
+  // are approximate; they only schedule training.
+  batch.put(kDictionariesFamily, std::string(kScopePrefix) + name,
+            scope_record(scope));
+}
+
+void SourceStore::stage(WriteBatch& batch, std::string_view problem,
+                        std::string_view language, std::string_view key,
+                        std::string_view text) {
+  if (text.size() > options_.max_text_bytes) {
+    throw std::invalid_argument("source text of " +
+                                std::to_string(text.size()) +
+                                " bytes is over max_text_bytes");
+  }
+  const std::string primary = scope_name(problem, language);
+  const std::string fallback = scope_name({}, language);
+  std::uint32_t id;
+  bool borrowed;
+  {
+    std::lock_guard lock(mu_);
+    id = scope_locked(primary).dictionary;
+    borrowed = id == 0;
+    if (borrowed) id = scope_locked(fallback).dictionary;
+  }
+  const auto dict = id != 0 ? dictionary(id) : nullptr;
+  const std::string record = encode(text, id, dict.get());
+  {
+    std::lock_guard lock(mu_);
+    sample_locked(primary, scopes_.at(primary), record, batch);
+    // Texts without a problem dictionary also train the language one,
+    // which is what the next new problem will borrow.
+    if (borrowed) sample_locked(fallback, scopes_.at(fallback), record, batch);
+    stats_.raw_bytes += text.size();
+    stats_.stored_bytes += record.size();
+  }
+  std::string full_key = primary;
+  full_key += '\t';
+  full_key += key;
+  batch.put(kSourcesFamily, full_key, record);
+}
+
+void SourceStore::put(std::string_view problem, std::string_view language,
+                      std::string_view key, std::string_view text) {
+  WriteBatch batch;
+  stage(batch, problem, language, key, text);
+  store_.write(batch);
+}
+
+std::optional<std::string> SourceStore::get(std::string_view problem,
+                                            std::string_view language,
+                                            std::string_view key) const {
+  std::string full_key = scope_name(problem, language);
+  full_key += '\t';
+  full_key += key;
+  const auto record = store_.get(kSourcesFamily, full_key);
+  if (!record) return std::nullopt;
+  return decode(*record);
+}
+
+void SourceStore::scan(
+    std::string_view problem, std::string_view language,
+    const std::function<void(std::string_view key, std::string_view text)>&
+        fn) const {
+  const std::string prefix = scope_name(problem, language) + '\t';
+  std::string text;
+  store_.scan(kSourcesFamily, prefix,
+              [&](std::string_view key, std::string_view record) {
+                text = decode(record);
+                fn(key.substr(prefix.size()), text);
+              });
+}
+
+std::shared_ptr<const SourceStore::Dictionary> SourceStore::dictionary(
+    std::uint32_t id) const {
+  {
+    std::lock_guard lock(mu_);
+    const auto it = dictionaries_.find(id);
+    if (it != dictionaries_.end()) return it->second;
+  }
+  const auto value = store_.get(kDictionariesFamily, dictionary_key(id));
+  coding::Reader in(value ? std::string_view(*value) : std::string_view());
+  std::string_view scope, bytes;
+  if (!value || !in.bytes(scope) || !in.bytes(bytes)) {
+    throw CorruptionError("missing source dictionary " + dictionary_key(id));
+  }
+  // Digesting takes milliseconds; do it unlocked and let a racing loader
+  // win.
+  auto loaded = std::make_shared<const Dictionary>(bytes, options_.level);
+  std::lock_guard lock(mu_);
+  return dictionaries_.emplace(id, std::move(loaded)).first->second;
+}
+
+std::string SourceStore::encode(std::string_view text, std::uint32_t id,
+                                const Dictionary* dict) const {
+  std::string record;
+  coding::put_u8(record, kRaw);
+  coding::put_u32(record, 0);
+  coding::put_u32(record, static_cast<std::uint32_t>(text.size()));
+  const std::size_t header = record.size();
+  if (text.size() >= options_.min_compress_bytes) {
+    record.resize(header + ZSTD_compressBound(text.size()));
+    char* out = record.data() + header;
+    const std::size_t capacity = record.size() - header;
+    const std::size_t n =
+        dict != nullptr
+            ? ZSTD_compress_usingCDict(thread_cctx(), out, capacity,
+                                       text.data(), text.size(), dict->cdict)
+            : ZSTD_compressCCtx(thread_cctx(), out, capacity, text.data(),
+                                text.size(), options_.level);
+    if (!ZSTD_isError(n) && n < text.size()) {
+      record.resize(header + n);
+      record[0] = static_cast<char>(kZstd);
+      if (dict != nullptr) std::memcpy(record.data() + 1, &id, sizeof(id));
+      return record;
+    }
+    record.resize(header);
+  }
+  record += text;
+  return record;
+}
+
+std::string SourceStore::decode(std::string_view record) const {
+  coding::Reader in(record);
+  std::uint8_t format;
+  std::uint32_t id, size;
+  if (!in.u8(format) || !in.u32(id) || !in.u32(size)) {
+    throw CorruptionError("truncated source record");
+  }
+  if (size > options_.max_text_bytes) {
+    throw CorruptionError("source record claims " + std::to_string(size) +
+                          " bytes");
+  }
+  const std::string_view payload = in.rest();
+  if (format == kRaw) {
+    if (payload.size() != size) throw CorruptionError("bad raw source");
+    return std::string(payload);
+  }
+  if (format != kZstd) throw CorruptionError("unknown source format");
+  // Frames record their content size; a mismatch is damage, caught before
+  // allocating.
+  if (ZSTD_getFrameContentSize(payload.data(), payload.size()) != size) {
+    throw CorruptionError("bad compressed source");
+  }
+  std::string text(size, '\0');
+  const std::size_t n =
+      id != 0 ? ZSTD_decompress_usingDDict(thread_dctx(), text.data(), size,
+                                           payload.data(), payload.size(),
+                                           dictionary(id)->ddict)
+              : ZSTD_decompressDCtx(thread_dctx(), text.data(), size,
+                                    payload.data(), payload.size());
+  if (ZSTD_isError(n) || n != size) {
+    throw CorruptionError("bad compressed source");
+  }
+  return text;
+}
+
+bool SourceStore::train(const std::string& name) {
+  std::string samples;
+  std::vector<std::size_t> sizes;
+  store_.scan(kDictionariesFamily, sample_prefix(name),
+              [&](std::string_view, std::string_view record) {
+                const std::string text = decode(record);
+                samples += text;
+                sizes.push_back(text.size());
+              });
+
+  std::string bytes(options_.dictionary_bytes, '\0');
+  const std::size_t n = ZDICT_trainFromBuffer(
+      bytes.data(), bytes.size(), samples.data(), sizes.data(),
+      static_cast<unsigned>(sizes.size()));
+
+  std::uint32_t id;
+  Scope trained;
+  {
+    std::lock_guard lock(mu_);
+    Scope& scope = scope_locked(name);
+    scope.since_training = 0;
+    if (ZDICT_isError(n)) {
+      // Too few or too uniform samples; try again after more arrive.
+      ++stats_.training_failures;
+      return false;
+    }
+    id = next_dictionary_++;
+    trained = scope;
+    trained.dictionary = id;
+  }
+  bytes.resize(n);
+  WriteBatch batch;
+  std::string value;
+  coding::put_bytes(value, name);
+  coding::put_bytes(value, bytes);
+  batch.put(kDictionariesFamily, dictionary_key(id), value);
+  batch.put(kDictionariesFamily, std::string(kScopePrefix) + name,
+            scope_record(trained));
+  // Written before the scope switches to it, so the dictionary is durable
+  // before any text compressed with it; puts meanwhile keep compressing
+  // with the old one.
+  store_.write(batch);
+  std::lock_guard lock(mu_);
+  Scope& scope = scope_locked(name);
+  // A concurrent maintain() may have trained a newer one meanwhile.
+  if (id > scope.dictionary) scope.dictionary = id;
+  ++stats_.dictionaries_trained;
+  return true;
+}
+
+std::size_t SourceStore::maintain() {
+  std::set<std::string, std::less<>> due;
+  {
+    std::lock_guard lock(mu_);
+    due.swap(due_);
+  }
+  std::size_t trained = 0;
+  for (const auto& name : due) trained += train(name) ? 1 : 0;
+  return trained;
+}
+
+SourceStoreStats SourceStore::stats() const {
+  std::lock_guard lock(mu_);
+  return stats_;
+}
+
+}  // namespace codecoach::storage
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+
+#include "storage/lsm_store.h"
+
+namespace codecoach::storage {
+
+struct SourceStoreOptions {
+  int level = 3;
+  std::size_t dictionary_bytes = 64u << 10;
+  // Texts shorter than this are stored raw; a frame header would eat
+  // the savings.
+  std::size_t min_compress_bytes = 64;
+  // Longest text put() accepts. Decoding trusts no stored size above it,
+  // so a damaged record cannot demand a huge allocation.
+  std::size_t max_text_bytes = 64u << 20;
+  // A scope's first dictionary is trained once it has this many samples,
+  // and retrained after every `retrain_interval` further texts.
+  std::size_t min_samples = 256;
+  std::uint64_t retrain_interval = 20'000;
+  // Training samples kept per scope: the first `sample_slots` texts, then
+  // every `sample_every`-th, overwriting the oldest.
+  std::size_t sample_slots = 2048;
+  std::uint64_t sample_every = 16;
+};
+
+struct SourceStoreStats {
+  std::uint64_t raw_bytes = 0;
+  std::uint64_t stored_bytes = 0;
+  std::uint64_t dictionaries_trained = 0;
+  std::uint64_t training_failures = 0;
+
+  double ratio() const {
+    return stored_bytes == 0 ? 0.0
+                             : static_cast<double>(raw_bytes) / stored_bytes;
+  }
+};
+
+// Submission sources and captured outputs, zstd-compressed with
+// dictionaries trained per (problem, language) scope. Accepted solutions
+// to one problem share most of their tokens, so a dictionary built from
+// that problem's own submissions compresses a typical 2 KB source several
+// times better than plain zstd. A problem too new to have a dictionary
+// borrows its language's cross-problem one.
+//
+// Data lives in two column families of an LsmStore: kSourcesFamily keyed
+// by problem, language and caller key (so a scan walks one problem's
+// submissions), and kDictionariesFamily with the dictionaries, a bounded
+// ring of training samples and a small state record per scope. Each text
+// names the dictionary it was compressed with, and dictionaries are never
+// deleted, so retraining only affects new writes.
+//
+// Training is not done on the write path: put() marks scopes as due and
+// maintain(), run periodically by the owner, trains them.
+//
+// Thread-safe. Decompression contexts are per thread and dictionaries are
+// digested once, so reads are a hash lookup plus one zstd call.
+class SourceStore {
+ public:
+  static constexpr std::string_view kSourcesFamily = "sources";
+  static constexpr std::string_view kDictionariesFamily = "source_dicts";
+  // `language` for captured program output.
+  static constexpr std::string_view kOutputLanguage = "output";
+
+  // Families to open the LsmStore with.
+  static LsmStore::Families families();
+
+  explicit SourceStore(LsmStore& store, SourceStoreOptions options = {});
+  ~SourceStore();
+  SourceStore(const SourceStore&) = delete;
+  SourceStore& operator=(const SourceStore&) = delete;
+
+  // Adds the compressed text (and any sample and scope updates) to
+  // `batch`, e.g. next to the verdict written through an AsyncWriter.
+  // Throws std::invalid_argument for a text over max_text_bytes.
+  void stage(WriteBatch& batch, std::string_view problem,
+             std::string_view language, std::string_view key,
+             std::string_view text);
+  void put(std::string_view problem, std::string_view language,
+           std::string_view key, std::string_view text);
+
+  // Throws CorruptionError if the stored record cannot be decoded.
+  std::optional<std::string> get(std::string_view problem,
+                                 std::string_view language,
+                                 std::string_view key) const;
+  // Every text of one problem and language in key order, decompressed.
+  void scan(std::string_view problem, std::string_view language,
+            const std::function<void(std::string_view key,
+                                     std::string_view text)>& fn) const;
+
+  // Trains dictionaries for the scopes that are due; returns how many
+  // were replaced. Safe to call concurrently with reads and writes.
+  std::size_t maintain();
+
+  SourceStoreStats stats() const;
+
+ private:
+  struct Dictionary;
+  struct Scope {
+    std::uint32_t dictionary = 0;  // 0: plain zstd
+    std::uint64_t puts = 0;
+    std::uint64_t samples = 0;
+    std::uint64_t since_training = 0;
+  };
+
+  static std::string scope_record(const Scope& scope);
+  Scope& scope_locked(const std::string& name);
+  void sample_locked(const std::string& name, Scope& scope,
+                     std::string_view record, WriteBatch& batch);
+  std::shared_ptr<const Dictionary> dictionary(std::uint32_t id) const;
+  // `dict` is dictionary `id`, or null for plain zstd.
+  std::string encode(std::string_view text, std::uint32_t id,
+                     const Dictionary* dict) const;
+  std::string decode(std::string_view record) const;
+  bool train(const std::string& name);
+
+  LsmStore& store_;
+  SourceStoreOptions options_;
+
+  mutable std::mutex mu_;
+  std::map<std::string, Scope, std::less<>> scopes_;
+  std::set<std::string, std::less<>> due_;
+  mutable std::map<std::uint32_t, std::shared_ptr<const Dictionary>>
+      dictionaries_;
+  std::uint32_t next_dictionary_ = 1;
+  SourceStoreStats stats_;
+};
+
+}  // namespace codecoach::storage
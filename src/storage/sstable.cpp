@@ -0,0 +1,211 @@
+#include "storage/sstable.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+
+#include "storage/bloom_filter.h"
+#include "storage/coding.h"
+
+namespace codecoach::storage {
+
+namespace {
+
+constexpr std::string_view kMagic{"CCSSTBL1", 8};
+constexpr std::size_t kFooterSize = 5 * 8 + kMagic.size();
+constexpr std::uint8_t kTombstone = 1;
+
+[[noreturn]] void throw_errno(const std::string& what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Decodes the entry at `offset` in `block`; false if it runs past the end.
+bool decode_entry(std::string_view block, std::size_t& offset,
+                  std::string_view& key, std::string_view& value,
+                  bool& tombstone) {
+  coding::Reader in(block.substr(offset));
+  std::uint8_t flags = 0;
+  std::uint32_t key_size = 0;
+  std::uint32_t value_size = 0;
+  if (!in.u8(flags) || !in.u32(key_size) || !in.u32(value_size)) return false;
+  const auto rest = in.rest();
+  if (rest.size() < std::uint64_t{key_size} + value_size) return false;
+  key = rest.substr(0, key_size);
+  value = rest.substr(key_size, value_size);
+  tombstone = (flags & kTombstone) != 0;
+  offset += 9 + key_size + value_size;
+  return true;
+}
+
+}  // namespace
+
+SSTableWriter::SSTableWriter(std::filesystem::path path,
+                             std::size_t bits_per_key,
+                             std::size_t block_bytes)
+    : path_(std::move(path)),
+      tmp_(path_.string() + ".tmp"),
+      bits_per_key_(bits_per_key),
+      block_bytes_(std::max<std::size_t>(block_bytes, 256)) {
+  fd_ = ::open(tmp_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) throw_errno("create " + tmp_.string());
+}
+
+SSTableWriter::~SSTableWriter() {
+  if (fd_ >= 0) ::close(fd_);
+  if (!finished_) ::unlink(tmp_.c_str());
+}
+
+void SSTableWriter::add(std::string_view key, std::string_view value,
+                        bool tombstone) {
+  coding::put_u8(block_, tombstone ? kTombstone : 0);
+  coding::put_u32(block_, static_cast<std::uint32_t>(key.size()));
+  coding::put_u32(block_, static_cast<std::uint32_t>(value.size()));
+  block_.append(key);
+  block_.append(value);
+  last_key_.assign(key);
+  hashes_.push_back(bloom_hash(key));
+  ++entries_;
+  if (block_.size() >= block_bytes_) flush_block();
+}
+
+void SSTableWriter::flush_block() {
+  if (block_.empty()) return;
+  coding::put_bytes(index_, last_key_);
+  coding::put_u64(index_, offset_);
+  coding::put_u32(index_, static_cast<std::uint32_t>(block_.size()));
+  write_out(block_);
+  block_.clear();
+}
+
+void SSTableWriter::write_out(std::string_view data) {
+  std::size_t written = 0;
+  while (written < data.size()) {
+    const ssize_t n =
+        ::write(fd_, data.data() + written, data.size() - written);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) throw_errno("write " + tmp_.string());
+    written += static_cast<std::size_t>(n);
+  }
+  offset_ += data.size();
+}
+
+std::uint64_t SSTableWriter::finish() {
+  flush_block();
+  const std::uint64_t index_offset = offset_;
+  const std::uint64_t index_size = index_.size();
+  write_out(index_);
+  const std::string filter = build_bloom_filter(hashes_, bits_per_key_);
+  const std::uint64_t filter_offset = offset_;
+  write_out(filter);
+  std::string footer;
+  coding::put_u64(footer, index_offset);
+  coding::put_u64(footer, index_size);
+  coding::put_u64(footer, filter_offset);
+  coding::put_u64(footer, filter.size());
+  coding::put_u64(footer, entries_);
+  footer.append(kMagic);
+  write_out(footer);
+  if (::fsync(fd_) != 0) throw_errno("sync " + tmp_.string());
+  ::close(fd_);
+  fd_ = -1;
+  std::filesystem::rename(tmp_, path_);
+  finished_ = true;
+  return offset_;
+}
+
+std::shared_ptr<const SSTable> SSTable::open(
+    const std::filesystem::path& path) {
+  std::shared_ptr<SSTable> table(new SSTable());
+  table->path_ = path;
+  table->file_ = MappedFile::open(path);
+  const std::string_view bytes = table->file_.bytes();
+  const auto fail = [&](const char* what) {
+    return CorruptionError(path.string() + ": " + what);
+  };
+  if (bytes.size() < kFooterSize ||
+      bytes.substr(bytes.size() - kMagic.size()) != kMagic) {
+    throw fail("not a table");
+  }
+  coding::Reader footer(bytes.substr(bytes.size() - kFooterSize));
+  std::uint64_t index_offset = 0, index_size = 0, filter_offset = 0,
+                filter_size = 0;
+  footer.u64(index_offset);
+  footer.u64(index_size);
+  footer.u64(filter_offset);
+  footer.u64(filter_size);
+  footer.u64(table->entries_);
+  const std::uint64_t body = bytes.size() - kFooterSize;
+  if (index_offset > body || index_size > body - index_offset ||
+      filter_offset > body || filter_size > body - filter_offset) {
+    throw fail("footer out of range");
+  }
+  table->filter_ = bytes.substr(filter_offset, filter_size);
+
+  coding::Reader index(bytes.substr(index_offset, index_size));
+  while (!index.empty()) {
+    BlockRef ref{};
+    if (!index.bytes(ref.last_key) || !index.u64(ref.offset) ||
+        !index.u32(ref.size) || ref.offset > index_offset ||
+        ref.size > index_offset - ref.offset) {
+      throw fail("bad index");
+    }
+    table->index_.push_back(ref);
+  }
+  return table;
+}
+
+bool SSTable::may_contain(std::uint64_t hash) const {
+  return bloom_may_contain(filter_, hash);
+}
+
+SSTable::Found SSTable::get(std::string_view key,
+                            std::string_view& value) const {
+  // First block whose last key is >= key: the only one that can hold it.
+  const auto it = std::lower_bound(
+      index_.begin(), index_.end(), key,
+      [](const BlockRef& ref, std::string_view k) { return ref.last_key < k; });
+  if (it == index_.end()) return Found::kAbsent;
+  const std::string_view data =
+      block(static_cast<std::size_t>(it - index_.begin()));
+  std::size_t offset = 0;
+  std::string_view k, v;
+  bool tombstone = false;
+  while (offset < data.size() && decode_entry(data, offset, k, v, tombstone)) {
+    if (k < key) continue;
+    if (k > key) break;
+    if (tombstone) return Found::kTombstone;
+    value = v;
+    return Found::kValue;
+  }
+  return Found::kAbsent;
+}
+
+SSTable::Iterator SSTable::seek(std::string_view key) const {
+  Iterator it(this);
+  const auto ref = std::lower_bound(
+      index_.begin(), index_.end(), key,
+      [](const BlockRef& r, std::string_view k) { return r.last_key < k; });
+  it.block_ = static_cast<std::size_t>(ref - index_.begin());
+  it.load();
+  while (it.valid() && it.key() < key) it.next();
+  return it;
+}
+
+void SSTable::Iterator::load() {
+  while (valid()) {
+    const std::string_view data = table_->block(block_);
+    if (offset_ < data.size() &&
+        decode_entry(data, offset_, key_, value_, tombstone_)) {
+      return;
+    }
+    ++block_;
+    offset_ = 0;
+  }
+}
+
+void SSTable::Iterator::next() { load(); }
+
+}  // namespace codecoach::storage
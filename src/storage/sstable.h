@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/mapped_file.h"
+
+namespace codecoach::storage {
+
+class CorruptionError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Immutable sorted table file of the LSM store:
+//
+//   data blocks   entries [u8 flags][u32 key size][u32 value size][key][value]
+//   index         per block: [u32 size][last key][u64 offset][u32 size]
+//   bloom filter  over all keys (storage/bloom_filter.h)
+//   footer        index offset/size, filter offset/size, entry count, magic
+//
+// Tombstones (flag 1) record deletions until compaction drops them.
+
+// Streams sorted entries into a new table. The file is written under a
+// temporary name and renamed into place by finish(), after an fsync, so a
+// table path either does not exist or holds a complete table. Memory use
+// is one block plus the index and 8 bytes per key.
+class SSTableWriter {
+ public:
+  SSTableWriter(std::filesystem::path path, std::size_t bits_per_key,
+                std::size_t block_bytes);
+  // Removes the temporary file if finish() was not reached.
+  ~SSTableWriter();
+  SSTableWriter(const SSTableWriter&) = delete;
+  SSTableWriter& operator=(const SSTableWriter&) = delete;
+
+  // Keys must be strictly increasing.
+  void add(std::string_view key, std::string_view value, bool tombstone);
+  // Returns the table's size in bytes.
+  std::uint64_t finish();
+
+  std::uint64_t entries() const { return entries_; }
+
+ private:
+  void flush_block();
+  void write_out(std::string_view data);
+
+  std::filesystem::path path_;
+  std::filesystem::path tmp_;
+  std::size_t bits_per_key_;
+  std::size_t block_bytes_;
+  int fd_ = -1;
+  std::uint64_t offset_ = 0;
+  std::uint64_t entries_ = 0;
+  std::string block_;
+  std::string last_key_;
+  std::string index_;
+  std::vector<std::uint64_t> hashes_;
+  bool finished_ = false;
+};
+
+class SSTable {
+ public:
+  enum class Found { kAbsent, kValue, kTombstone };
+
+  // Maps the table and reads its index. Throws CorruptionError for a file
+  // that is not a complete table.
+  static std::shared_ptr<const SSTable> open(const std::filesystem::path& path);
+
+  // Bloom filter probe with `hash` = bloom_hash(key); false means the key
+  // is certainly absent.
+  bool may_contain(std::uint64_t hash) const;
+  // Reads the block that may hold `key`; does not consult the filter. On
+  // kValue, `value` views the mapping, valid while this table is alive.
+  Found get(std::string_view key, std::string_view& value) const;
+
+  // Forward iterator over entries in key order, tombstones included.
+  class Iterator {
+   public:
+    bool valid() const { return block_ < table_->index_.size(); }
+    std::string_view key() const { return key_; }
+    std::string_view value() const { return value_; }
+    bool tombstone() const { return tombstone_; }
+    void next();
+
+   private:
+    friend class SSTable;
+    explicit Iterator(const SSTable* table) : table_(table) {}
+    void load();
+
+    const SSTable* table_;
+    std::size_t block_ = 0;
+    std::size_t offset_ = 0;  // Of the next entry within the block.
+    std::string_view key_;
+    std::string_view value_;
+    bool tombstone_ = false;
+  };
+
+  // Positioned at the first entry with key >= `key`.
+  Iterator seek(std::string_view key) const;
+  Iterator begin() const { return seek({}); }
+
+  std::uint64_t entries() const { return entries_; }
+  std::uint64_t file_size() const { return file_.size(); }
+  const std::filesystem::path& path() const { return path_; }
+
+ private:
+  struct BlockRef {
+    std::string_view last_key;
+    std::uint64_t offset;
+    std::uint32_t size;
+  };
+
+  SSTable() = default;
+  std::string_view block(std::size_t i) const {
+    return file_.bytes().substr(index_[i].offset, index_[i].size);
+  }
+
+  std::filesystem::path path_;
+  MappedFile file_;
+  std::vector<BlockRef> index_;
+  std::string_view filter_;
+  std::uint64_t entries_ = 0;
+};
+
+}  // namespace codecoach::storage
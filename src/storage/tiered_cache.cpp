@@ -0,0 +1,157 @@
+#include "storage/tiered_cache.h"
+
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace codecoach::storage {
+
+TieredCache::TieredCache(TieredCacheOptions options, BlobStore& shared)
+    : options_(std::move(options)),
+      shared_(shared),
+      sketch_(options_.expected_entries),
+      memory_policy_(options_.memory_bytes, sketch_),
+      local_policy_(
+          options_.local_directory.empty() ? 0 : options_.local_bytes,
+          sketch_) {
+  if (options_.local_directory.empty()) return;
+  local_ = std::make_unique<BlobStore>(options_.local_directory);
+  // The local tier survives restarts; its popularity does not, so every
+  // blob comes back on probation and the first newcomers decide the rest.
+  local_->for_each([&](const Digest128& digest, std::uint64_t size) {
+    for (const auto& evicted : local_policy_.restore(digest, size)) {
+      local_->remove(evicted);
+    }
+  });
+}
+
+Digest128 TieredCache::put(std::string_view data) {
+  const Digest128 digest = shared_.put(data);
+  Pending pending;
+  {
+    std::lock_guard lock(mu_);
+    sketch_.increment(digest);
+    if (memory_.count(digest) != 0) {
+      memory_policy_.touch(digest);
+    } else {
+      admit_to_memory(digest, std::make_shared<const std::string>(data),
+                      pending);
+    }
+  }
+  apply(pending);
+  return digest;
+}
+
+std::shared_ptr<const std::string> TieredCache::get(const Digest128& digest) {
+  bool on_local;
+  {
+    std::lock_guard lock(mu_);
+    sketch_.increment(digest);
+    const auto it = memory_.find(digest);
+    if (it != memory_.end()) {
+      memory_policy_.touch(digest);
+      ++stats_.memory_hits;
+      return it->second;
+    }
+    on_local = local_policy_.contains(digest) && !writing_.contains(digest);
+  }
+
+  std::optional<std::string> bytes;
+  if (on_local) bytes = local_->get(digest);
+  const bool local_hit = bytes.has_value();
+  if (!local_hit) bytes = shared_.get(digest);
+
+  Pending pending;
+  std::shared_ptr<const std::string> data;
+  {
+    std::lock_guard lock(mu_);
+    if (on_local && !local_hit && !writing_.contains(digest)) {
+      // Lost a race with a local eviction; forget the stale entry, unless
+      // it was admitted again since and its file is on the way.
+      local_policy_.erase(digest);
+    }
+    if (!bytes) {
+      ++stats_.misses;
+      return nullptr;
+    }
+    if (local_hit) {
+      ++stats_.local_hits;
+      local_policy_.touch(digest);
+    } else {
+      ++stats_.shared_hits;
+    }
+    const auto it = memory_.find(digest);
+    if (it != memory_.end()) return it->second;
+    data = std::make_shared<const std::string>(std::move(*bytes));
+    admit_to_memory(digest, data, pending);
+  }
+  apply(pending);
+  return data;
+}
+
+TieredCacheStats TieredCache::stats() const {
+  std::lock_guard lock(mu_);
+  TieredCacheStats stats = stats_;
+  stats.memory_bytes = memory_policy_.bytes();
+  stats.local_bytes = local_policy_.bytes();
+  return stats;
+}
+
+void TieredCache::admit_to_memory(const Digest128& digest,
+                                  std::shared_ptr<const std::string> data,
+                                  Pending& pending) {
+  const auto size = static_cast<std::uint64_t>(data->size());
+  memory_.emplace(digest, std::move(data));
+  for (const auto& evicted : memory_policy_.insert(digest, size)) {
+    const auto it = memory_.find(evicted);
+    auto evicted_data = std::move(it->second);
+    memory_.erase(it);
+    admit_to_local(evicted, std::move(evicted_data), pending);
+  }
+}
+
+void TieredCache::admit_to_local(const Digest128& digest,
+                                 std::shared_ptr<const std::string> data,
+                                 Pending& pending) {
+  if (!local_ || local_policy_.contains(digest)) return;
+  bool kept = true;
+  for (const auto& evicted : local_policy_.insert(digest, data->size())) {
+    if (evicted == digest) {
+      kept = false;
+    } else {
+      pending.removals.push_back(evicted);
+      ++stats_.local_evictions;
+    }
+  }
+  if (kept) {
+    pending.writes.push_back({digest, std::move(data)});
+    ++writing_[digest];
+    ++stats_.demotions;
+  }
+}
+
+void TieredCache::apply(Pending& pending) {
+  for (const auto& digest : pending.removals) local_->remove(digest);
+  for (const auto& write : pending.writes) {
+    bool written = true;
+    try {
+      local_->put(*write.data);
+    } catch (const std::exception&) {
+      // A full or failing local disk only costs hit rate.
+      written = false;
+    }
+    bool orphaned;
+    {
+      std::lock_guard lock(mu_);
+      const auto it = writing_.find(write.digest);
+      const bool last = --it->second == 0;
+      if (last) writing_.erase(it);
+      if (!written && last) local_policy_.erase(write.digest);
+      // Evicted while being written: its removal may have run first.
+      orphaned = written && last && !local_policy_.contains(write.digest);
+    }
+    if (orphaned) local_->remove(write.digest);
+  }
+}
+
+}  // namespace codecoach::storage
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "common/hash.h"
+#include "storage/blob_store.h"
+#include "storage/tiny_lfu.h"
+
+namespace codecoach::storage {
+
+struct TieredCacheOptions {
+  std::uint64_t memory_bytes = 512ull << 20;
+  // Node-local SSD directory; empty disables the local tier.
+  std::filesystem::path local_directory;
+  std::uint64_t local_bytes = 16ull << 30;
+  // Sizes the frequency sketch; roughly the number of distinct blobs the
+  // node is expected to see between agings.
+  std::size_t expected_entries = 200'000;
+};
+
+struct TieredCacheStats {
+  std::uint64_t memory_hits = 0;
+  std::uint64_t local_hits = 0;
+  std::uint64_t shared_hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t demotions = 0;  // RAM evictions written to the local tier
+  std::uint64_t local_evictions = 0;
+  std::uint64_t memory_bytes = 0;
+  std::uint64_t local_bytes = 0;
+};
+
+// Three-tier cache for compile artifacts and test bundles: RAM, a
+// node-local SSD directory and the fleet-wide shared blob store (a
+// directory, which may be a mounted object-store gateway). The shared
+// store is the source of truth and holds everything; the upper tiers hold
+// what this node reads often, as judged by one access-frequency sketch
+// feeding a W-TinyLFU policy per tier. A hit on a lower tier is offered to
+// RAM; what RAM evicts is offered to the local tier, which keeps it only
+// if it is more popular than the local victim. Tiers are inclusive, so a
+// RAM eviction of a blob already on SSD costs no write.
+//
+// Thread-safe. File I/O happens outside the lock; a local file evicted
+// under a concurrent reader just turns that read into a shared-tier hit.
+// An admitted local entry counts as present only once its file is
+// written; readers in between go to the shared tier.
+class TieredCache {
+ public:
+  TieredCache(TieredCacheOptions options, BlobStore& shared);
+
+  // Writes through to the shared store and caches in RAM.
+  Digest128 put(std::string_view data);
+  // Reads from the fastest tier holding `digest`; nullptr if no tier has
+  // it.
+  std::shared_ptr<const std::string> get(const Digest128& digest);
+
+  TieredCacheStats stats() const;
+
+ private:
+  struct LocalWrite {
+    Digest128 digest;
+    std::shared_ptr<const std::string> data;
+  };
+  struct Pending {
+    std::vector<LocalWrite> writes;
+    std::vector<Digest128> removals;
+  };
+
+  // Both require mu_. Queued local writes are marked in writing_ until
+  // apply() finishes them.
+  void admit_to_memory(const Digest128& digest,
+                       std::shared_ptr<const std::string> data,
+                       Pending& pending);
+  void admit_to_local(const Digest128& digest,
+                      std::shared_ptr<const std::string> data,
+                      Pending& pending);
+  void apply(Pending& pending);
+
+  TieredCacheOptions options_;
+  BlobStore& shared_;
+  std::unique_ptr<BlobStore> local_;
+
+  mutable std::mutex mu_;
+  FrequencySketch sketch_;
+  WTinyLfu memory_policy_;
+  WTinyLfu local_policy_;
+  std::unordered_map<Digest128, std::shared_ptr<const std::string>,
+                     Digest128Hash>
+      memory_;
+  // Local entries whose file write is queued or running, with the number
+  // of such writes.
+  std::unordered_map<Digest128, std::size_t, Digest128Hash> writing_;
+  TieredCacheStats stats_;
+};
+
+}  // namespace codecoach::storage
@@ -0,0 +1,205 @@
+#include "storage/tiny_lfu.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace codecoach::storage {
+
+namespace {
+
+constexpr int kRows = 4;
+constexpr std::uint64_t kRowSeeds[kRows] = {
+    0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL, 0x165667b19e3779f9ULL,
+    0xd6e8feb86659fd93ULL};
+constexpr std::uint64_t kNibbleMask = 0xf;
+// Keeps the low three bits of every nibble: halves 16 counters at once.
+constexpr std::uint64_t kHalveMask = 0x7777777777777777ULL;
+
+std::uint64_t mix(std::uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  return x;
+}
+
+}  // namespace
+
+FrequencySketch::FrequencySketch(std::size_t expected_entries) {
+  const std::size_t width = std::bit_ceil(std::max<std::size_t>(
+      expected_entries, 64));
+  mask_ = width - 1;
+  table_.assign(kRows * width / 16, 0);
+  doorkeeper_.assign(width / 64, 0);
+  sample_size_ = 10 * static_cast<std::uint64_t>(width);
+}
+
+std::size_t FrequencySketch::index(const Digest128& key, int row) const {
+  return static_cast<std::size_t>(mix(key.lo ^ kRowSeeds[row]) + key.hi) &
+         mask_;
+}
+
+bool FrequencySketch::doorkeeper_test(const Digest128& key) const {
+  const std::size_t a = index(key, 0);
+  const std::size_t b = index(key, 1);
+  return (doorkeeper_[a / 64] >> (a % 64) & 1) != 0 &&
+         (doorkeeper_[b / 64] >> (b % 64) & 1) != 0;
+}
+
+void FrequencySketch::increment(const Digest128& key) {
+  if (!doorkeeper_test(key)) {
+    const std::size_t a = index(key, 0);
+    const std::size_t b = index(key, 1);
+    doorkeeper_[a / 64] |= std::uint64_t{1} << (a % 64);
+    doorkeeper_[b / 64] |= std::uint64_t{1} << (b % 64);
+  } else {
+    const std::size_t row_words = (mask_ + 1) / 16;
+    for (int row = 0; row < kRows; ++row) {
+      const std::size_t i = index(key, row);
+      std::uint64_t& word = table_[row * row_words + i / 16];
+      const unsigned shift = static_cast<unsigned>(i % 16) * 4;
+      if ((word >> shift & kNibbleMask) != kNibbleMask) {
+        word += std::uint64_t{1} << shift;
+      }
+    }
+  }
+  if (++additions_ >= sample_size_) reset();
+}
+
+std::uint32_t FrequencySketch::estimate(const Digest128& key) const {
+  const std::size_t row_words = (mask_ + 1) / 16;
+  std::uint64_t count = kNibbleMask;
+  for (int row = 0; row < kRows; ++row) {
+    const std::size_t i = index(key, row);
+    const std::uint64_t word = table_[row * row_words + i / 16];
+    count = std::min(count, word >> (i % 16 * 4) & kNibbleMask);
+  }
+  return static_cast<std::uint32_t>(count) + (doorkeeper_test(key) ? 1 : 0);
+}
+
+void FrequencySketch::reset() {
+  for (auto& word : table_) word = (word >> 1) & kHalveMask;
+  std::fill(doorkeeper_.begin(), doorkeeper_.end(), 0);
+  additions_ /= 2;
+  ++resets_;
+}
+
+WTinyLfu::WTinyLfu(std::uint64_t capacity_bytes,
+                   const FrequencySketch& sketch, double window_fraction,
+                   double protected_fraction)
+    : sketch_(sketch), capacity_(capacity_bytes) {
+  window_capacity_ = std::max<std::uint64_t>(
+      1, static_cast<std::uint64_t>(capacity_ * window_fraction));
+  window_capacity_ = std::min(window_capacity_, capacity_);
+  protected_capacity_ = static_cast<std::uint64_t>(
+      (capacity_ - window_capacity_) * protected_fraction);
+}
+
+bool WTinyLfu::contains(const Digest128& key) const {
+  return entries_.count(key) != 0;
+}
+
+std::uint64_t WTinyLfu::bytes() const {
+  return segment_bytes_[kWindow] + segment_bytes_[kProbation] +
+         segment_bytes_[kProtected];
+}
+
+void WTinyLfu::place(const Digest128& key, Entry& entry, Segment segment) {
+  lists_[segment].push_front(key);
+  entry.segment = segment;
+  entry.position = lists_[segment].begin();
+  segment_bytes_[segment] += entry.bytes;
+}
+
+void WTinyLfu::unlink(Entry& entry) {
+  lists_[entry.segment].erase(entry.position);
+  segment_bytes_[entry.segment] -= entry.bytes;
+}
+
+void WTinyLfu::touch(const Digest128& key) {
+  const auto it = entries_.find(key);
+  if (it == entries_.end()) return;
+  Entry& entry = it->second;
+  const Segment from = entry.segment;
+  unlink(entry);
+  place(key, entry, from == kWindow ? kWindow : kProtected);
+  if (from == kProbation) shrink_protected();
+}
+
+void WTinyLfu::shrink_protected() {
+  while (segment_bytes_[kProtected] > protected_capacity_) {
+    const Digest128 demoted = lists_[kProtected].back();
+    Entry& entry = entries_.at(demoted);
+    unlink(entry);
+    place(demoted, entry, kProbation);
+  }
+}
+
+std::vector<Digest128> WTinyLfu::insert(const Digest128& key,
+                                        std::uint64_t bytes) {
+  if (contains(key)) {
+    touch(key);
+    return {};
+  }
+  if (bytes > capacity_ - window_capacity_) return {key};
+  auto& entry = entries_.emplace(key, Entry{kWindow, {}, bytes}).first->second;
+  place(key, entry, kWindow);
+  std::vector<Digest128> evicted;
+  while (segment_bytes_[kWindow] > window_capacity_) {
+    const Digest128 candidate = lists_[kWindow].back();
+    admit_to_main(candidate, evicted);
+  }
+  return evicted;
+}
+
+std::vector<Digest128> WTinyLfu::restore(const Digest128& key,
+                                         std::uint64_t bytes) {
+  if (contains(key)) return {};
+  if (bytes > capacity_ - window_capacity_) return {key};
+  auto& entry = entries_.emplace(key, Entry{kWindow, {}, bytes}).first->second;
+  place(key, entry, kWindow);
+  std::vector<Digest128> evicted;
+  admit_to_main(key, evicted);
+  return evicted;
+}
+
+void WTinyLfu::erase(const Digest128& key) {
+  const auto it = entries_.find(key);
+  if (it == entries_.end()) return;
+  unlink(it->second);
+  entries_.erase(it);
+}
+
+void WTinyLfu::admit_to_main(const Digest128& candidate,
+                             std::vector<Digest128>& evicted) {
+  Entry& entry = entries_.at(candidate);
+  unlink(entry);
+  const std::uint64_t main_capacity = capacity_ - window_capacity_;
+  const std::uint64_t main_bytes =
+      segment_bytes_[kProbation] + segment_bytes_[kProtected];
+  if (main_bytes + entry.bytes > main_capacity) {
+    // The candidate must beat every victim it would displace; ties go to
+    // the incumbent so a scan cannot flush an established working set.
+    const std::uint32_t frequency = sketch_.estimate(candidate);
+    std::uint64_t needed = main_bytes + entry.bytes - main_capacity;
+    std::vector<Digest128> victims;
+    for (const Segment segment : {kProbation, kProtected}) {
+      for (auto it = lists_[segment].rbegin();
+           needed > 0 && it != lists_[segment].rend(); ++it) {
+        if (sketch_.estimate(*it) >= frequency) {
+          entries_.erase(candidate);
+          evicted.push_back(candidate);
+          return;
+        }
+        needed -= std::min(needed, entries_.at(*it).bytes);
+        victims.push_back(*it);
+      }
+    }
+    for (const auto& victim : victims) {
+      erase(victim);
+      evicted.push_back(victim);
+    }
+  }
+  place(candidate, entry, kProbation);
+}
+
+}  // namespace codecoach::storage
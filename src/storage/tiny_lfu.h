@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "common/hash.h"
+
+namespace codecoach::storage {
+
+// Approximate access counts for a much larger key population than a cache
+// holds: a 4-row count-min sketch of saturating 4-bit counters. Every
+// `sample_size` increments all counters are halved, so popularity decays
+// and yesterday's hot problem does not squat in the cache forever. A
+// doorkeeper bit set absorbs the first touch of each key, keeping one-hit
+// wonders out of the counters.
+class FrequencySketch {
+ public:
+  explicit FrequencySketch(std::size_t expected_entries);
+
+  void increment(const Digest128& key);
+  // Estimated accesses since the last aging, capped at 16.
+  std::uint32_t estimate(const Digest128& key) const;
+
+  std::uint64_t resets() const { return resets_; }
+
+ private:
+  std::size_t index(const Digest128& key, int row) const;
+  bool doorkeeper_test(const Digest128& key) const;
+  void reset();
+
+  std::vector<std::uint64_t> table_;  // 16 nibble counters per word
+  std::vector<std::uint64_t> doorkeeper_;
+  std::size_t mask_;  // counter index mask per row
+  std::uint64_t sample_size_;
+  std::uint64_t additions_ = 0;
+  std::uint64_t resets_ = 0;
+};
+
+// Size-aware W-TinyLFU eviction policy over byte-weighted keys. New keys
+// land in a small LRU window; what falls out of the window competes with
+// the main region's LRU victim and only enters if the sketch says it is
+// accessed more often. The main region is a segmented LRU: a key touched
+// twice moves from probation to protected. The policy tracks keys only;
+// callers own the data and act on the evictions it reports.
+class WTinyLfu {
+ public:
+  WTinyLfu(std::uint64_t capacity_bytes, const FrequencySketch& sketch,
+           double window_fraction = 0.01, double protected_fraction = 0.8);
+
+  bool contains(const Digest128& key) const;
+  // Records a hit on a resident key.
+  void touch(const Digest128& key);
+  // Adds a key (an existing one is touched instead) and returns the keys
+  // that no longer fit, which may include `key` itself if it lost
+  // admission or is larger than the main region.
+  std::vector<Digest128> insert(const Digest128& key, std::uint64_t bytes);
+  // Adds a key straight into probation, bypassing the window; used to
+  // rebuild state from a tier that survived a restart.
+  std::vector<Digest128> restore(const Digest128& key, std::uint64_t bytes);
+  void erase(const Digest128& key);
+
+  std::uint64_t bytes() const;
+  std::size_t size() const { return entries_.size(); }
+  std::uint64_t capacity() const { return capacity_; }
+
+ private:
+  enum Segment : int { kWindow, kProbation, kProtected };
+  struct Entry {
+    Segment segment;
+    std::list<Digest128>::iterator position;
+    std::uint64_t bytes;
+  };
+
+  void place(const Digest128& key, Entry& entry, Segment segment);
+  void unlink(Entry& entry);
+  void admit_to_main(const Digest128& candidate,
+                     std::vector<Digest128>& evicted);
+  void shrink_protected();
+
+  const FrequencySketch& sketch_;
+  std::uint64_t capacity_;
+  std::uint64_t window_capacity_;
+  std::uint64_t protected_capacity_;
+  std::list<Digest128> lists_[3];  // front is most recently used
+  std::uint64_t segment_bytes_[3] = {0, 0, 0};
+  std::unordered_map<Digest128, Entry, Digest128Hash> entries_;
+};
+
+}  // namespace codecoach::storage
@@ -0,0 +1,102 @@
+#include "storage/write_ahead_log.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <string>
+#include <system_error>
+
+#include "common/hash.h"
+#include "common/mapped_file.h"
+#include "storage/coding.h"
+
+namespace codecoach::storage {
+
+namespace {
+
+constexpr std::size_t kRecordHeader = 12;
+constexpr std::uint64_t kRecordSeed = 0x57a1'0c0d'e5ULL;
+
+[[noreturn]] void throw_errno(const std::string& what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Length of the intact prefix of `log`, calling `fn` for each record.
+std::size_t scan(std::string_view log,
+                 const std::function<void(std::string_view)>& fn,
+                 std::size_t& records) {
+  std::size_t offset = 0;
+  records = 0;
+  while (log.size() - offset >= kRecordHeader) {
+    const std::uint32_t size = coding::load_u32(log.data() + offset);
+    const std::uint64_t hash = coding::load_u64(log.data() + offset + 4);
+    if (log.size() - offset - kRecordHeader < size) break;
+    const auto payload = log.substr(offset + kRecordHeader, size);
+    if (hash64(payload, kRecordSeed) != hash) break;
+    if (fn) fn(payload);
+    ++records;
+    offset += kRecordHeader + size;
+  }
+  return offset;
+}
+
+}  // namespace
+
+WriteAheadLog::WriteAheadLog(const std::filesystem::path& path) {
+  std::size_t intact = 0;
+  std::error_code ec;
+  if (std::filesystem::file_size(path, ec) > 0 && !ec) {
+    const auto file = MappedFile::open(path);
+    std::size_t records = 0;
+    intact = scan(file.bytes(), {}, records);
+  }
+  fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+  if (fd_ < 0) throw_errno("open " + path.string());
+  // Drop a torn tail so new records follow the last intact one.
+  if (::ftruncate(fd_, static_cast<off_t>(intact)) != 0 ||
+      ::lseek(fd_, 0, SEEK_END) < 0) {
+    const int e = errno;
+    ::close(fd_);
+    throw std::system_error(e, std::generic_category(),
+                            "truncate " + path.string());
+  }
+}
+
+WriteAheadLog::~WriteAheadLog() {
+  if (fd_ >= 0) ::close(fd_);
+}
+
+void WriteAheadLog::append(std::string_view payload, bool sync_now) {
+  std::string record;
+  record.reserve(kRecordHeader + payload.size());
+  coding::put_u32(record, static_cast<std::uint32_t>(payload.size()));
+  coding::put_u64(record, hash64(payload, kRecordSeed));
+  record.append(payload);
+  std::size_t written = 0;
+  while (written < record.size()) {
+    const ssize_t n =
+        ::write(fd_, record.data() + written, record.size() - written);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) throw_errno("write-ahead log append");
+    written += static_cast<std::size_t>(n);
+  }
+  if (sync_now) sync();
+}
+
+void WriteAheadLog::sync() {
+  if (::fdatasync(fd_) != 0) throw_errno("write-ahead log sync");
+}
+
+std::size_t WriteAheadLog::replay(
+    const std::filesystem::path& path,
+    const std::function<void(std::string_view)>& fn) {
+  std::error_code ec;
+  if (std::filesystem::file_size(path, ec) == 0 || ec) return 0;
+  const auto file = MappedFile::open(path);
+  std::size_t records = 0;
+  scan(file.bytes(), fn, records);
+  return records;
+}
+
+}  // namespace codecoach::storage
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string_view>
+
+namespace codecoach::storage {
+
+// Append-only record log. Each record is [u32 size][u64 hash][payload],
+// written with a single write(2); on reopen, a torn or corrupt tail (a
+// crash mid-append) is cut off and everything before it is kept.
+//
+// Throws std::system_error on I/O failure.
+class WriteAheadLog {
+ public:
+  // Opens `path` for appending, creating it if needed. Existing records are
+  // kept; call replay() first to read them.
+  explicit WriteAheadLog(const std::filesystem::path& path);
+  ~WriteAheadLog();
+  WriteAheadLog(const WriteAheadLog&) = delete;
+  WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+  // With `sync`, returns only once the record is on stable storage.
+  void append(std::string_view payload, bool sync);
+  void sync();
+
+  // Calls `fn` for each intact record in order and returns how many there
+  // were. A missing file has none.
+  static std::size_t replay(const std::filesystem::path& path,
+                            const std::function<void(std::string_view)>& fn);
+
+ private:
+  int fd_ = -1;
+};
+
+}  // namespace codecoach::storage
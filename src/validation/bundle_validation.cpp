@@ -0,0 +1,40 @@
+#include "validation/bundle_validation.h"
+
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "common/parallel.h"
+#include "validation/schema.h"
+
+namespace codecoach::validation {
+
+void validate_bundle_inputs(const catalog::ProblemBundle& bundle,
+                            std::size_t parallelism) {
+  const auto text = bundle.section(catalog::format::SectionKind::kInputSchema);
+  if (!text) return;
+  const Schema schema = Schema::parse(*text);
+
+  // Keep the lowest failing index so the report is deterministic.
+  std::mutex mu;
+  std::optional<std::size_t> first_bad;
+  std::string message;
+  parallel_for(bundle.test_count(), parallelism, [&](std::size_t t) {
+    try {
+      schema.validate(bundle.test(t).input);
+    } catch (const ValidationError& e) {
+      std::lock_guard lock(mu);
+      if (!first_bad || t < *first_bad) {
+        first_bad = t;
+        message = e.what();
+      }
+    }
+  });
+  if (first_bad) {
+    throw ValidationError(std::string(bundle.problem_id()) + " test " +
+                          std::to_string(*first_bad) + ": " + message);
+  }
+}
+
+}  // namespace codecoach::validation
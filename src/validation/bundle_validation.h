@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+#include "catalog/problem_bundle.h"
+
+namespace codecoach::validation {
+
+// Validates every test input of `bundle` against the schema in its
+// kInputSchema section, `parallelism` tests at a time. Bundles without a
+// schema pass. Throws SchemaError or ValidationError (naming the first
+// failing test). Suitable as a Catalog::BundleCheck.
+void validate_bundle_inputs(const catalog::ProblemBundle& bundle,
+                            std::size_t parallelism);
+
+}  // namespace codecoach::validation
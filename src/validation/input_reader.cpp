@@ -0,0 +1,151 @@
+#include "validation/input_reader.h"
+
+#include <algorithm>
+
+#include "validation/simd_range.h"
+
+namespace codecoach::validation {
+
+void InputReader::fail(const std::string& message) const {
+  const auto consumed = input_.substr(0, pos_);
+  const auto line = std::count(consumed.begin(), consumed.end(), '\n') + 1;
+  const auto line_start = consumed.rfind('\n');
+  const auto column =
+      pos_ - (line_start == std::string_view::npos ? 0 : line_start + 1) + 1;
+  throw ValidationError(std::to_string(line) + ":" + std::to_string(column) +
+                        ": " + message);
+}
+
+std::int64_t InputReader::parse_int(std::string_view name) {
+  const std::size_t start = pos_;
+  const bool negative = pos_ < input_.size() && input_[pos_] == '-';
+  if (negative) ++pos_;
+  const std::size_t digits_start = pos_;
+  // Accumulate as a negative number so INT64_MIN parses without overflow.
+  std::int64_t value = 0;
+  while (pos_ < input_.size() && input_[pos_] >= '0' && input_[pos_] <= '9') {
+    const int digit = input_[pos_] - '0';
+    if (value < (INT64_MIN + digit) / 10) {
+      pos_ = start;
+      fail(std::string(name) + ": integer overflows 64 bits");
+    }
+    value = value * 10 - digit;
+    ++pos_;
+  }
+  const std::size_t digits = pos_ - digits_start;
+  if (digits == 0) {
+    pos_ = start;
+    fail(std::string(name) + ": expected an integer");
+  }
+  if ((digits > 1 && input_[digits_start] == '0') ||
+      (negative && value == 0)) {
+    pos_ = start;
+    fail(std::string(name) + ": non-canonical integer");
+  }
+  if (!negative) {
+    if (value == INT64_MIN) {
+      pos_ = start;
+      fail(std::string(name) + ": integer overflows 64 bits");
+    }
+    value = -value;
+  }
+  return value;
+}
+
+std::int64_t InputReader::read_int(std::int64_t lo, std::int64_t hi,
+                                   std::string_view name) {
+  const std::size_t start = pos_;
+  const std::int64_t value = parse_int(name);
+  if (value < lo || value > hi) {
+    pos_ = start;
+    fail(std::string(name) + " = " + std::to_string(value) +
+         " is outside [" + std::to_string(lo) + ", " + std::to_string(hi) +
+         "]");
+  }
+  return value;
+}
+
+std::vector<std::int64_t> InputReader::read_ints(std::size_t count,
+                                                 std::int64_t lo,
+                                                 std::int64_t hi,
+                                                 std::string_view name) {
+  std::vector<std::int64_t> values(count);
+  const std::size_t start = pos_;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (i != 0) read_space();
+    values[i] = parse_int(name);
+  }
+  if (const auto bad = find_out_of_range(values, lo, hi)) {
+    // Re-scan to point the error at the offending token.
+    pos_ = start;
+    for (std::size_t i = 0; i < *bad; ++i) {
+      parse_int(name);
+      read_space();
+    }
+    fail(std::string(name) + "[" + std::to_string(*bad) +
+         "] = " + std::to_string(values[*bad]) + " is outside [" +
+         std::to_string(lo) + ", " + std::to_string(hi) + "]");
+  }
+  return values;
+}
+
+std::vector<std::int64_t> InputReader::read_int_pairs(std::size_t count,
+                                                      std::int64_t lo,
+                                                      std::int64_t hi,
+                                                      std::string_view name) {
+  std::vector<std::int64_t> values(2 * count);
+  const std::size_t start = pos_;
+  for (std::size_t i = 0; i < count; ++i) {
+    values[2 * i] = parse_int(name);
+    read_space();
+    values[2 * i + 1] = parse_int(name);
+    read_eoln();
+  }
+  if (const auto bad = find_out_of_range(values, lo, hi)) {
+    pos_ = start;
+    for (std::size_t i = 0; i < *bad; ++i) {
+      parse_int(name);
+      ++pos_;  // The separator was validated on the first pass.
+    }
+    fail(std::string(name) + "[" + std::to_string(*bad / 2) +
+         "] endpoint " + std::to_string(values[*bad]) + " is outside [" +
+         std::to_string(lo) + ", " + std::to_string(hi) + "]");
+  }
+  return values;
+}
+
+std::string_view InputReader::read_token(std::size_t min_len,
+                                         std::size_t max_len,
+                                         std::string_view name) {
+  const std::size_t start = pos_;
+  while (pos_ < input_.size() && input_[pos_] != ' ' && input_[pos_] != '\n' &&
+         input_[pos_] != '\r' && input_[pos_] != '\t') {
+    ++pos_;
+  }
+  const std::size_t len = pos_ - start;
+  if (len < min_len || len > max_len) {
+    pos_ = start;
+    fail(std::string(name) + ": token length " + std::to_string(len) +
+         " is outside [" + std::to_string(min_len) + ", " +
+         std::to_string(max_len) + "]");
+  }
+  return input_.substr(start, len);
+}
+
+void InputReader::read_space() {
+  if (pos_ >= input_.size() || input_[pos_] != ' ') fail("expected a space");
+  ++pos_;
+}
+
+void InputReader::read_eoln() {
+  if (pos_ >= input_.size() || input_[pos_] != '\n') {
+    fail("expected end of line");
+  }
+  ++pos_;
+}
+
+void InputReader::read_eof() {
+  if (pos_ != input_.size()) fail("expected end of file");
+}
+
+}  // namespace codecoach::validation
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace codecoach::validation {
+
+class ValidationError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Strict reader for test inputs. Unlike a solution's reader it accepts
+// exactly one canonical layout: single spaces between tokens, '\n' line
+// ends, no leading zeros, no "-0", nothing after the last line. Every read
+// throws ValidationError (with line and column) on a mismatch.
+class InputReader {
+ public:
+  explicit InputReader(std::string_view input) : input_(input) {}
+
+  std::int64_t read_int(std::int64_t lo, std::int64_t hi,
+                        std::string_view name);
+
+  // Reads `count` integers separated by single spaces. The range check runs
+  // as one vectorized scan over the whole array (see simd_range.h).
+  std::vector<std::int64_t> read_ints(std::size_t count, std::int64_t lo,
+                                      std::int64_t hi, std::string_view name);
+
+  // Reads `count` lines of "a b", returned flattened as a0 b0 a1 b1 ...
+  // Both values of every pair must lie in [lo, hi].
+  std::vector<std::int64_t> read_int_pairs(std::size_t count,
+                                           std::int64_t lo, std::int64_t hi,
+                                           std::string_view name);
+
+  // A token of non-whitespace characters, `min_len` to `max_len` long.
+  std::string_view read_token(std::size_t min_len, std::size_t max_len,
+                              std::string_view name);
+
+  void read_space();
+  void read_eoln();
+  void read_eof();
+
+  [[noreturn]] void fail(const std::string& message) const;
+
+ private:
+  std::int64_t parse_int(std::string_view name);
+
+  std::string_view input_;
+  std::size_t pos_ = 0;
+};
+
+}  // namespace codecoach::validation
@@ -0,0 +1,290 @@
+#include "validation/schema.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <unordered_map>
+
+#include "validation/union_find.h"
+
+namespace codecoach::validation {
+
+namespace {
+
+std::vector<std::string_view> split_words(std::string_view line) {
+  std::vector<std::string_view> words;
+  std::size_t i = 0;
+  while (i < line.size()) {
+    while (i < line.size() &&
+           std::isspace(static_cast<unsigned char>(line[i]))) {
+      ++i;
+    }
+    const std::size_t start = i;
+    while (i < line.size() &&
+           !std::isspace(static_cast<unsigned char>(line[i]))) {
+      ++i;
+    }
+    if (i > start) words.push_back(line.substr(start, i - start));
+  }
+  return words;
+}
+
+bool parse_decimal(std::string_view text, std::int64_t& out) {
+  const auto result = std::from_chars(text.data(), text.data() + text.size(),
+                                      out);
+  return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// [-]B[^E][(+|-)K], e.g. 100000, 10^5, -2^31, 2^31-1.
+bool parse_bound(std::string_view text, std::int64_t& out) {
+  const bool negative = !text.empty() && text.front() == '-';
+  if (negative) text.remove_prefix(1);
+
+  const auto caret = text.find('^');
+  if (caret == std::string_view::npos) {
+    if (!parse_decimal(text, out)) return false;
+    if (negative) out = -out;
+    return true;
+  }
+
+  std::int64_t base = 0;
+  if (!parse_decimal(text.substr(0, caret), base)) return false;
+  text.remove_prefix(caret + 1);
+  const auto sign = text.find_first_of("+-");
+  std::int64_t exponent = 0;
+  std::int64_t adjust = 0;
+  if (!parse_decimal(text.substr(0, sign), exponent) || exponent < 0) {
+    return false;
+  }
+  if (sign != std::string_view::npos &&
+      !parse_decimal(text.substr(sign + 1), adjust)) {
+    return false;
+  }
+  if (sign != std::string_view::npos && text[sign] == '-') adjust = -adjust;
+
+  std::int64_t value = 1;
+  for (std::int64_t e = 0; e < exponent; ++e) {
+    if (__builtin_mul_overflow(value, base, &value)) return false;
+  }
+  if (negative) value = -value;
+  return !__builtin_add_overflow(value, adjust, &out);
+}
+
+bool is_identifier(std::string_view text) {
+  return !text.empty() &&
+         (std::isalpha(static_cast<unsigned char>(text.front())) ||
+          text.front() == '_') &&
+         std::all_of(text.begin(), text.end(), [](char c) {
+           return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+         });
+}
+
+}  // namespace
+
+Schema Schema::parse(std::string_view text) {
+  Schema schema;
+  std::unordered_map<std::string, Op> declared;
+  std::size_t line_no = 0;
+
+  while (!text.empty()) {
+    ++line_no;
+    const auto newline = text.find('\n');
+    auto line = text.substr(0, newline);
+    text.remove_prefix(newline == std::string_view::npos ? text.size()
+                                                         : newline + 1);
+    line = line.substr(0, line.find('#'));
+    const auto words = split_words(line);
+    if (words.empty()) continue;
+
+    const auto fail = [&](const std::string& what) {
+      return SchemaError("schema line " + std::to_string(line_no) + ": " +
+                         what);
+    };
+    const auto expect_args = [&](std::size_t n) {
+      if (words.size() != n + 1) {
+        throw fail(std::string(words[0]) + " takes " + std::to_string(n) +
+                   " arguments");
+      }
+    };
+    const auto bound = [&](std::string_view word) {
+      std::int64_t value = 0;
+      if (!parse_bound(word, value)) {
+        throw fail("bad bound '" + std::string(word) + "'");
+      }
+      return value;
+    };
+    const auto count = [&](std::string_view word) {
+      Count c;
+      if (parse_decimal(word, c.offset)) return c;
+      const auto sign = word.find_first_of("+-");
+      c.var = std::string(word.substr(0, sign));
+      const auto it = declared.find(c.var);
+      if (it == declared.end() || it->second != Op::kInt) {
+        throw fail("count '" + std::string(word) +
+                   "' must be a literal or an int variable");
+      }
+      if (sign != std::string_view::npos) {
+        if (!parse_decimal(word.substr(sign + 1), c.offset)) {
+          throw fail("bad count offset in '" + std::string(word) + "'");
+        }
+        if (word[sign] == '-') c.offset = -c.offset;
+      }
+      return c;
+    };
+    const auto declare = [&](std::string_view name, Op op) {
+      if (!is_identifier(name)) {
+        throw fail("bad name '" + std::string(name) + "'");
+      }
+      if (!declared.emplace(std::string(name), op).second) {
+        throw fail("'" + std::string(name) + "' declared twice");
+      }
+      return std::string(name);
+    };
+    const auto reference = [&](std::string_view name, Op op) {
+      const auto it = declared.find(std::string(name));
+      if (it == declared.end() || it->second != op) {
+        throw fail("'" + std::string(name) + "' is not a declared " +
+                   (op == Op::kEdges ? "edge list" : "int array"));
+      }
+      return std::string(name);
+    };
+
+    const auto keyword = words[0];
+    Step step{};
+    if (keyword == "int") {
+      expect_args(3);
+      step = {Op::kInt, declare(words[1], Op::kInt), {}, {}, bound(words[2]),
+              bound(words[3])};
+    } else if (keyword == "ints") {
+      expect_args(4);
+      step = {Op::kInts, declare(words[1], Op::kInts), count(words[2]), {},
+              bound(words[3]), bound(words[4])};
+    } else if (keyword == "token") {
+      expect_args(3);
+      step = {Op::kToken, declare(words[1], Op::kToken), {}, {},
+              bound(words[2]), bound(words[3])};
+    } else if (keyword == "edges") {
+      expect_args(3);
+      step = {Op::kEdges, declare(words[1], Op::kEdges), count(words[2]),
+              count(words[3]), 0, 0};
+    } else if (keyword == "space" || keyword == "eoln" || keyword == "eof") {
+      expect_args(0);
+      step.op = keyword == "space" ? Op::kSpace
+                : keyword == "eoln" ? Op::kEoln
+                                    : Op::kEof;
+    } else if (keyword == "tree" || keyword == "connected") {
+      expect_args(1);
+      step.op = keyword == "tree" ? Op::kTree : Op::kConnected;
+      step.name = reference(words[1], Op::kEdges);
+    } else if (keyword == "distinct") {
+      expect_args(1);
+      step.op = Op::kDistinct;
+      step.name = reference(words[1], Op::kInts);
+    } else {
+      throw fail("unknown statement '" + std::string(keyword) + "'");
+    }
+    schema.steps_.push_back(std::move(step));
+  }
+  return schema;
+}
+
+void Schema::validate(std::string_view input) const {
+  InputReader in(input);
+  std::unordered_map<std::string, std::int64_t> ints;
+  std::unordered_map<std::string, std::vector<std::int64_t>> arrays;
+  struct EdgeList {
+    std::vector<std::int64_t> endpoints;  // Flattened u0 v0 u1 v1 ...
+    std::int64_t vertices = 0;
+  };
+  std::unordered_map<std::string, EdgeList> edge_lists;
+
+  const auto value_of = [&](const Count& c) {
+    return (c.var.empty() ? 0 : ints.at(c.var)) + c.offset;
+  };
+  const auto resolve = [&](const Count& c, std::string_view what) {
+    const std::int64_t value = value_of(c);
+    // Every element takes at least one byte, which bounds any honest count
+    // and keeps a corrupt one from triggering a huge allocation.
+    if (value < 0 || static_cast<std::uint64_t>(value) > input.size()) {
+      in.fail(std::string(what) + " count " + std::to_string(value) +
+              " is out of range");
+    }
+    return value;
+  };
+
+  for (const Step& step : steps_) {
+    switch (step.op) {
+      case Op::kInt:
+        ints[step.name] = in.read_int(step.lo, step.hi, step.name);
+        break;
+      case Op::kInts:
+        arrays[step.name] = in.read_ints(
+            static_cast<std::size_t>(resolve(step.count, step.name)), step.lo,
+            step.hi, step.name);
+        break;
+      case Op::kToken:
+        in.read_token(static_cast<std::size_t>(step.lo),
+                      static_cast<std::size_t>(step.hi), step.name);
+        break;
+      case Op::kEdges: {
+        EdgeList edges;
+        // Vertices need not appear in the input (isolated ones), so only
+        // the schema's own bounds on the variable limit this.
+        edges.vertices = value_of(step.vertices);
+        if (edges.vertices < 0 || edges.vertices > UINT32_MAX) {
+          in.fail(step.name + ": vertex count out of range");
+        }
+        edges.endpoints = in.read_int_pairs(
+            static_cast<std::size_t>(resolve(step.count, step.name)), 1,
+            edges.vertices, step.name);
+        edge_lists[step.name] = std::move(edges);
+        break;
+      }
+      case Op::kSpace: in.read_space(); break;
+      case Op::kEoln: in.read_eoln(); break;
+      case Op::kEof: in.read_eof(); break;
+      case Op::kTree:
+      case Op::kConnected: {
+        const EdgeList& edges = edge_lists.at(step.name);
+        const auto m = edges.endpoints.size() / 2;
+        if (step.op == Op::kTree &&
+            static_cast<std::int64_t>(m) != edges.vertices - 1) {
+          throw ValidationError(step.name + ": a tree on " +
+                                std::to_string(edges.vertices) +
+                                " vertices needs " +
+                                std::to_string(edges.vertices - 1) +
+                                " edges, got " + std::to_string(m));
+        }
+        UnionFind uf(static_cast<std::size_t>(edges.vertices));
+        for (std::size_t e = 0; e < m; ++e) {
+          const auto u =
+              static_cast<std::uint32_t>(edges.endpoints[2 * e] - 1);
+          const auto v =
+              static_cast<std::uint32_t>(edges.endpoints[2 * e + 1] - 1);
+          if (!uf.unite(u, v) && step.op == Op::kTree) {
+            throw ValidationError(step.name + ": edge " + std::to_string(e) +
+                                  " closes a cycle");
+          }
+        }
+        if (edges.vertices > 0 && uf.components() != 1) {
+          throw ValidationError(step.name + ": graph has " +
+                                std::to_string(uf.components()) +
+                                " components");
+        }
+        break;
+      }
+      case Op::kDistinct: {
+        auto sorted = arrays.at(step.name);
+        std::sort(sorted.begin(), sorted.end());
+        const auto dup = std::adjacent_find(sorted.begin(), sorted.end());
+        if (dup != sorted.end()) {
+          throw ValidationError(step.name + ": value " +
+                                std::to_string(*dup) + " repeats");
+        }
+        break;
+      }
+    }
+  }
+}
+
+}  // namespace codecoach::validation
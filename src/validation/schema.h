@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "validation/input_reader.h"
+
+namespace codecoach::validation {
+
+class SchemaError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Typed description of a problem's input, checked against every test.
+//
+// Schemas are written in a small line-oriented language and stored in the
+// problem bundle, so inputs are re-validated whenever a bundle is built or
+// hot-reloaded. One statement per line, '#' starts a comment:
+//
+//   int n 1 10^5              # 1 <= n <= 10^5
+//   eoln
+//   ints a n -2^31 2^31-1     # n values that fit in int32
+//   eoln
+//   edges e n-1 n             # n-1 lines "u v" with 1 <= u, v <= n
+//   tree e                    # ... that form a tree
+//   eof
+//
+// Statements: int NAME LO HI | ints NAME COUNT LO HI | token NAME MIN MAX |
+// edges NAME COUNT VERTICES | space | eoln | eof | tree EDGES |
+// connected EDGES | distinct INTS. COUNT and VERTICES are a literal, a
+// variable, or VAR+K / VAR-K. Bounds accept decimal, B^E and B^E+K / B^E-K.
+class Schema {
+ public:
+  // Throws SchemaError with the offending line on a syntax error.
+  static Schema parse(std::string_view text);
+
+  // Throws ValidationError describing the first violation.
+  void validate(std::string_view input) const;
+
+ private:
+  enum class Op {
+    kInt,
+    kInts,
+    kToken,
+    kEdges,
+    kSpace,
+    kEoln,
+    kEof,
+    kTree,
+    kConnected,
+    kDistinct,
+  };
+
+  // A count that may refer to an earlier integer: var + offset.
+  struct Count {
+    std::string var;  // Empty for a literal.
+    std::int64_t offset = 0;
+  };
+
+  struct Step {
+    Op op;
+    std::string name;
+    Count count;
+    Count vertices;
+    std::int64_t lo = 0;
+    std::int64_t hi = 0;
+  };
+
+  std::vector<Step> steps_;
+};
+
+}  // namespace codecoach::validation
@@ -0,0 +1,68 @@
+#include "validation/simd_range.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace codecoach::validation {
+
+namespace {
+
+bool all_in_range_portable(const std::int64_t* v, std::size_t n,
+                           std::int64_t lo, std::int64_t hi) {
+  // Branch-free accumulation, so the loop vectorizes.
+  bool ok = true;
+  for (std::size_t i = 0; i < n; ++i) ok &= (v[i] >= lo) & (v[i] <= hi);
+  return ok;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2"))) bool all_in_range_avx2(const std::int64_t* v,
+                                                       std::size_t n,
+                                                       std::int64_t lo,
+                                                       std::int64_t hi) {
+  const __m256i vlo = _mm256_set1_epi64x(lo);
+  const __m256i vhi = _mm256_set1_epi64x(hi);
+  __m256i bad = _mm256_setzero_si256();
+  std::size_t i = 0;
+  // Two vectors per iteration to keep both compare ports busy.
+  for (; i + 8 <= n; i += 8) {
+    const __m256i a =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+    const __m256i b =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i + 4));
+    bad = _mm256_or_si256(bad, _mm256_cmpgt_epi64(a, vhi));
+    bad = _mm256_or_si256(bad, _mm256_cmpgt_epi64(vlo, a));
+    bad = _mm256_or_si256(bad, _mm256_cmpgt_epi64(b, vhi));
+    bad = _mm256_or_si256(bad, _mm256_cmpgt_epi64(vlo, b));
+  }
+  return _mm256_testz_si256(bad, bad) &&
+         all_in_range_portable(v + i, n - i, lo, hi);
+}
+
+bool have_avx2() {
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+}
+#endif
+
+}  // namespace
+
+std::optional<std::size_t> find_out_of_range(
+    std::span<const std::int64_t> values, std::int64_t lo, std::int64_t hi) {
+  bool ok;
+#if defined(__x86_64__)
+  ok = have_avx2()
+           ? all_in_range_avx2(values.data(), values.size(), lo, hi)
+           : all_in_range_portable(values.data(), values.size(), lo, hi);
+#else
+  ok = all_in_range_portable(values.data(), values.size(), lo, hi);
+#endif
+  if (ok) return std::nullopt;
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    if (values[i] < lo || values[i] > hi) return i;
+  }
+  return std::nullopt;
+}
+
+}  // namespace codecoach::validation
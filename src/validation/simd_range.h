@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace codecoach::validation {
+
+// Index of the first value outside [lo, hi], or nullopt if all are inside.
+//
+// The common case (everything valid) is decided by a vectorized scan with
+// no per-element branches: AVX2 when the CPU has it, chosen at run time,
+// otherwise a portable loop. Only a failing array pays for the scalar
+// search that finds the offending index.
+std::optional<std::size_t> find_out_of_range(
+    std::span<const std::int64_t> values, std::int64_t lo, std::int64_t hi);
+
+}  // namespace codecoach::validation
@@ -0,0 +1,49 @@
+#include "warmup/hot_problems.h"
+
+#include <algorithm>
+
+namespace codecoach::warmup {
+
+void HotProblemTracker::record(std::string_view problem,
+                               std::uint64_t count) {
+  std::lock_guard lock(mu_);
+  auto it = counts_.find(std::string(problem));
+  if (it == counts_.end()) {
+    counts_.emplace(problem, count);
+  } else {
+    it->second += count;
+  }
+}
+
+std::vector<std::string> HotProblemTracker::top(std::size_t limit) const {
+  std::vector<std::pair<std::uint64_t, std::string>> ranked;
+  {
+    std::lock_guard lock(mu_);
+    ranked.reserve(counts_.size());
+    for (const auto& [problem, count] : counts_) {
+      ranked.emplace_back(count, problem);
+    }
+  }
+  limit = std::min(limit, ranked.size());
+  std::partial_sort(ranked.begin(), ranked.begin() + limit, ranked.end(),
+                    [](const auto& a, const auto& b) {
+                      return a.first != b.first ? a.first > b.first
+                                                : a.second < b.second;
+                    });
+  std::vector<std::string> out;
+  out.reserve(limit);
+  for (std::size_t i = 0; i < limit; ++i) {
+    out.push_back(std::move(ranked[i].second));
+  }
+  return out;
+}
+
+void HotProblemTracker::decay() {
+  std::lock_guard lock(mu_);
+  for (auto it = counts_.begin(); it != counts_.end();) {
+    it->second /= 2;
+    it = it->second == 0 ? counts_.erase(it) : std::next(it);
+  }
+}
+
+}  // namespace codecoach::warmup
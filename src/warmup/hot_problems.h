@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace codecoach::warmup {
+
+// Counts submissions per problem so the hottest ones can be prefetched after
+// a restart. The counts follow recent traffic only as long as decay() is
+// called periodically (judge::Evaluator does, every hot_half_life).
+class HotProblemTracker {
+ public:
+  void record(std::string_view problem, std::uint64_t count = 1);
+
+  // The `limit` most submitted problems, hottest first.
+  std::vector<std::string> top(std::size_t limit) const;
+
+  // Halves every count so the ranking follows recent traffic.
+  void decay();
+
+ private:
+  mutable std::mutex mu_;
+  std::unordered_map<std::string, std::uint64_t> counts_;
+};
+
+}  // namespace codecoach::warmup
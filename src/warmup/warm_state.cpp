@@ -0,0 +1,137 @@
+#include "warmup/warm_state.h"
+
+#include <fstream>
+#include <future>
+#include <sstream>
+
+#include "catalog/catalog.h"
+#include "common/durable_file.h"
+#include "sandbox/sandbox_pool.h"
+#include "warmup/hot_problems.h"
+
+namespace codecoach::warmup {
+
+namespace {
+
+// Line-oriented, tab-separated text: trivially inspectable and diffable.
+//   codecoach-warm-state <version>
+//   cache <key-hex> <artifact>
+//   pch <config> <artifact>
+//   hot <problem>
+constexpr std::string_view kMagic = "codecoach-warm-state";
+constexpr int kVersion = 1;
+
+std::vector<std::string_view> split_tabs(std::string_view line) {
+  std::vector<std::string_view> fields;
+  for (;;) {
+    const auto tab = line.find('\t');
+    fields.push_back(line.substr(0, tab));
+    if (tab == std::string_view::npos) return fields;
+    line.remove_prefix(tab + 1);
+  }
+}
+
+}  // namespace
+
+void save_warm_state(const WarmState& state,
+                     const std::filesystem::path& path) {
+  std::ostringstream out;
+  out << kMagic << '\t' << kVersion << '\n';
+  for (const auto& entry : state.compile_cache) {
+    out << "cache\t" << entry.key.hex() << '\t' << entry.artifact.string()
+        << '\n';
+  }
+  for (const auto& entry : state.pch) {
+    out << "pch\t" << entry.config << '\t' << entry.artifact.string() << '\n';
+  }
+  for (const auto& problem : state.hot_problems) {
+    out << "hot\t" << problem << '\n';
+  }
+  replace_file_synced(path, out.str());
+}
+
+std::optional<WarmState> load_warm_state(const std::filesystem::path& path) {
+  std::ifstream in(path);
+  if (!in) return std::nullopt;
+
+  std::string line;
+  if (!std::getline(in, line)) return std::nullopt;
+  const auto header = split_tabs(line);
+  if (header.size() != 2 || header[0] != kMagic ||
+      header[1] != std::to_string(kVersion)) {
+    return std::nullopt;
+  }
+
+  WarmState state;
+  while (std::getline(in, line)) {
+    const auto fields = split_tabs(line);
+    if (fields[0] == "cache" && fields.size() == 3) {
+      if (auto key = Digest128::from_hex(fields[1])) {
+        state.compile_cache.push_back({*key, std::string(fields[2])});
+      }
+    } else if (fields[0] == "pch" && fields.size() == 3) {
+      state.pch.push_back({std::string(fields[1]), std::string(fields[2])});
+    } else if (fields[0] == "hot" && fields.size() == 2) {
+      state.hot_problems.emplace_back(fields[1]);
+    }
+  }
+  return state;
+}
+
+WarmState capture_warm_state(const compile::CompileCache& cache,
+                             const compile::PchRegistry& pch,
+                             const HotProblemTracker& hot,
+                             std::size_t hot_limit) {
+  return WarmState{
+      .compile_cache = cache.snapshot(),
+      .pch = pch.snapshot(),
+      .hot_problems = hot.top(hot_limit),
+  };
+}
+
+WarmStartReport warm_start(const WarmState& state,
+                           const WarmStartTargets& targets) {
+  const auto start = std::chrono::steady_clock::now();
+  WarmStartReport report;
+  const std::size_t parallelism = std::max<std::size_t>(targets.parallelism, 1);
+
+  // Sandbox creation is the slowest step; start it first.
+  std::future<std::size_t> sandboxes;
+  if (targets.sandboxes != nullptr) {
+    sandboxes = std::async(std::launch::async, [&] {
+      return targets.sandboxes->prewarm(targets.sandbox_count, parallelism);
+    });
+  }
+  std::future<std::size_t> cache;
+  if (targets.compile_cache != nullptr) {
+    cache = std::async(std::launch::async, [&] {
+      return targets.compile_cache->restore(state.compile_cache, parallelism);
+    });
+  }
+
+  if (targets.pch != nullptr) {
+    report.pch_restored = targets.pch->restore(state.pch);
+    for (const auto& entry : state.pch) {
+      if (!targets.pch->find(entry.config)) {
+        report.pch_missing.push_back(entry.config);
+      }
+    }
+  }
+  if (targets.catalog != nullptr) {
+    const auto snapshot = targets.catalog->snapshot();
+    for (const auto& problem : state.hot_problems) {
+      if (const auto bundle = snapshot->find(problem)) {
+        bundle->prefetch();
+        ++report.problems_prefetched;
+      }
+    }
+  }
+
+  if (cache.valid()) report.compile_cache_entries = cache.get();
+  if (sandboxes.valid()) report.sandboxes_created = sandboxes.get();
+  report.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  return report;
+}
+
+}  // namespace codecoach::warmup
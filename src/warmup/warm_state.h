@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "compile/compile_cache.h"
+#include "compile/pch_registry.h"
+
+namespace codecoach::catalog {
+class Catalog;
+}
+namespace codecoach::sandbox {
+class SandboxPool;
+}
+
+namespace codecoach::warmup {
+
+class HotProblemTracker;
+
+// Everything a freshly started evaluator needs to reach full throughput
+// without re-learning it from traffic. Artifacts themselves stay where they
+// are on disk; only the indexes that point at them are persisted.
+struct WarmState {
+  std::vector<compile::CompileCache::Entry> compile_cache;
+  std::vector<compile::PchRegistry::Entry> pch;
+  std::vector<std::string> hot_problems;  // Hottest first.
+};
+
+// Writes `state` to `path` atomically and durably (replace_file_synced), so
+// a crash while saving never leaves a truncated snapshot behind. Throws
+// std::system_error on I/O failure.
+void save_warm_state(const WarmState& state, const std::filesystem::path& path);
+
+// Reads a snapshot written by save_warm_state(). Returns nullopt if the file
+// is missing or was written by an incompatible version; malformed lines are
+// skipped rather than failing the whole restore.
+std::optional<WarmState> load_warm_state(const std::filesystem::path& path);
+
+WarmState capture_warm_state(const compile::CompileCache& cache,
+                             const compile::PchRegistry& pch,
+                             const HotProblemTracker& hot,
+                             std::size_t hot_limit);
+
+struct WarmStartTargets {
+  catalog::Catalog* catalog = nullptr;  // Already reload()ed.
+  compile::CompileCache* compile_cache = nullptr;
+  compile::PchRegistry* pch = nullptr;
+  sandbox::SandboxPool* sandboxes = nullptr;
+  std::size_t sandbox_count = 0;
+  std::size_t parallelism = 1;
+};
+
+struct WarmStartReport {
+  std::size_t compile_cache_entries = 0;
+  std::size_t pch_restored = 0;
+  // Configs whose PCH is gone, to rebuild in the background
+  // (judge::Evaluator::warm_start does for its compiler's).
+  std::vector<std::string> pch_missing;
+  std::size_t problems_prefetched = 0;
+  std::size_t sandboxes_created = 0;
+  std::chrono::milliseconds elapsed{0};
+};
+
+// Applies a saved snapshot to a starting evaluator. Index restores, bundle
+// prefetch and sandbox creation are independent and run concurrently; any
+// null target is skipped.
+WarmStartReport warm_start(const WarmState& state,
+                           const WarmStartTargets& targets);
+
+}  // namespace codecoach::warmup
@@ -0,0 +1,232 @@
+// bundler::ProblemBuilder end to end with the host's g++: a problem with
+// hand-written and generated tests is built, rebuilt unchanged and rebuilt
+// after each kind of source edit, checking which steps rerun, that equal
+// test data is stored once, and that bad sources fail the build. Also
+// validation::validate_bundle_inputs on bundles with and without
+// violations.
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "bundler/build_cache.h"
+#include "bundler/problem_builder.h"
+#include "catalog/bundle_writer.h"
+#include "catalog/problem_bundle.h"
+#include "compile/compile_cache.h"
+#include "compile/compiler.h"
+#include "compile/pch_registry.h"
+#include "storage/blob_store.h"
+#include "validation/bundle_validation.h"
+#include "validation/input_reader.h"
+#include "check.h"
+
+using namespace codecoach;
+
+namespace {
+
+namespace fs = std::filesystem;
+
+void write(const fs::path& path, const std::string& text) {
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+}
+
+// Prints twice its input; the generator prints its argument plus an
+// offset from a local header.
+void write_problem(const fs::path& dir) {
+  fs::create_directories(dir);
+  write(dir / "problem.conf", "id = doubler\ntime_limit_ms = 2000\n");
+  write(dir / "reference.cpp",
+        "#include <cstdio>\n"
+        "int main() { long n; std::scanf(\"%ld\", &n);"
+        " std::printf(\"%ld\\n\", 2 * n); }\n");
+  write(dir / "gen.h", "constexpr long kOffset = 0;\n");
+  write(dir / "gen.cpp",
+        "#include <cstdio>\n#include <cstdlib>\n#include \"gen.h\"\n"
+        "int main(int, char** argv) {"
+        " std::printf(\"%ld\\n\", std::atol(argv[1]) + kOffset); }\n");
+  write(dir / "a.txt", "3\n");
+  write(dir / "b.txt", "3\n");  // Same bytes as a.txt.
+  write(dir / "tests.txt",
+        "sample a.txt\nfile b.txt\ngen gen.cpp 5\ngen gen.cpp 5\n"
+        "gen gen.cpp 7\n");
+  write(dir / "schema.txt", "int n 1 100\neoln\neof\n");
+  write(dir / "statement.md", "Double it.\n");
+}
+
+std::size_t blob_count(const storage::BlobStore& blobs) {
+  std::size_t count = 0;
+  blobs.for_each([&](const Digest128&, std::uint64_t) { ++count; });
+  return count;
+}
+
+struct Fixture {
+  explicit Fixture(const fs::path& root)
+      : cache(root / "compile"),
+        compiler({.executable = "g++", .flags = {"-std=c++20", "-O0"},
+                  .pch_header = ""},
+                 cache, pch),
+        blobs(root / "blobs"),
+        steps(root / "steps.log"),
+        builder(compiler, blobs, steps, {.parallelism = 1}) {}
+
+  compile::CompileCache cache;
+  compile::PchRegistry pch;
+  compile::Compiler compiler;
+  storage::BlobStore blobs;
+  bundler::BuildCache steps;
+  bundler::ProblemBuilder builder;
+};
+
+bool build_fails(Fixture& f, const fs::path& problem, const fs::path& out) {
+  try {
+    f.builder.build(problem, out);
+    return false;
+  } catch (const bundler::BuildError&) {
+    return true;
+  }
+}
+
+void build_and_rebuild(const fs::path& root) {
+  const fs::path problem = root / "problem";
+  const fs::path out = root / "bundles";
+  write_problem(problem);
+  Fixture f(root);
+
+  auto stats = f.builder.build(problem, out);
+  CHECK(stats.tests == 5);
+  CHECK(stats.generated == 2);      // gen 5 runs once for both tests.
+  CHECK(stats.inputs_reused == 1);
+  CHECK(stats.validated == 3);      // One per distinct input.
+  CHECK(stats.solved == 3);
+  CHECK(stats.outputs_reused == 2);
+  CHECK(stats.written && stats.version == 1);
+  CHECK(stats.shared_bytes > 0);    // Duplicate tests stored once.
+  // Inputs 3, 5, 7 and outputs 6, 10, 14, each stored once.
+  CHECK(blob_count(f.blobs) == 6);
+
+  auto bundle = catalog::ProblemBundle::open(out / "doubler.ccb");
+  CHECK(bundle->test_count() == 5);
+  CHECK(bundle->test(0).input == "3\n");
+  CHECK(bundle->test(0).expected_output == "6\n");
+  CHECK(bundle->test(0).flags & catalog::format::kTestSample);
+  CHECK(!(bundle->test(1).flags & catalog::format::kTestSample));
+  CHECK(bundle->test(4).expected_output == "14\n");
+  validation::validate_bundle_inputs(*bundle, 2);
+  const auto stamp = bundle->stamp();
+  bundle.reset();
+
+  // Unchanged: every step is a cache hit and the bundle is left alone.
+  stats = f.builder.build(problem, out);
+  CHECK(stats.generated == 0 && stats.validated == 0 && stats.solved == 0);
+  CHECK(!stats.written && stats.version == 1);
+  CHECK(catalog::ProblemBundle::open(out / "doubler.ccb")->stamp() == stamp);
+
+  // A new statement: a new bundle version, no test work.
+  write(problem / "statement.md", "Double the number.\n");
+  stats = f.builder.build(problem, out);
+  CHECK(stats.generated == 0 && stats.solved == 0);
+  CHECK(stats.written && stats.version == 2);
+
+  // A generator's local header is part of its step key.
+  write(problem / "gen.h", "constexpr long kOffset = 10;\n");
+  stats = f.builder.build(problem, out);
+  CHECK(stats.generated == 2 && stats.solved == 2);
+  CHECK(stats.version == 3);
+  CHECK(catalog::ProblemBundle::open(out / "doubler.ccb")
+            ->test(4)
+            .expected_output == "34\n");
+
+  // A new reference reruns every solve step, but no generator.
+  write(problem / "reference.cpp",
+        "#include <cstdio>\n"
+        "int main() { long n; std::scanf(\"%ld\", &n);"
+        " std::printf(\"%ld\\n\", n + n); }\n");
+  stats = f.builder.build(problem, out);
+  CHECK(stats.generated == 0 && stats.solved == 3);
+  CHECK(stats.written == false);  // Same outputs: same bundle content.
+
+  // The step log survives a restart.
+  Fixture again(root);
+  stats = again.builder.build(problem, out);
+  CHECK(stats.generated == 0 && stats.solved == 0 && !stats.written);
+}
+
+void bad_sources(const fs::path& root) {
+  const fs::path problem = root / "problem";
+  const fs::path out = root / "bundles";
+  write_problem(problem);
+  Fixture f(root);
+  const auto restore = [&] { write_problem(problem); };
+
+  write(problem / "schema.txt", "int n 1 4\neoln\neof\n");  // 5 and 7 fail.
+  CHECK(build_fails(f, problem, out));
+  write(problem / "schema.txt", "int n 1\n");
+  CHECK(build_fails(f, problem, out));
+  restore();
+
+  write(problem / "tests.txt", "sample\n");
+  CHECK(build_fails(f, problem, out));
+  write(problem / "tests.txt", "# nothing\n");
+  CHECK(build_fails(f, problem, out));
+  restore();
+
+  write(problem / "reference.cpp", "int main() { return 1; }\n");
+  CHECK(build_fails(f, problem, out));
+  write(problem / "reference.cpp", "not C++\n");
+  CHECK(build_fails(f, problem, out));
+  restore();
+
+  write(problem / "problem.conf", "id = ../x\n");
+  CHECK(build_fails(f, problem, out));
+  write(problem / "problem.conf", "id = x\ntime_limit_ms = 0\n");
+  CHECK(build_fails(f, problem, out));
+  restore();
+
+  CHECK(!fs::exists(out / "doubler.ccb"));
+  f.builder.build(problem, out);
+  CHECK(fs::exists(out / "doubler.ccb"));
+}
+
+void bundle_validation(const fs::path& root) {
+  const auto make = [&](const char* name, const char* second_input) {
+    catalog::BundleSpec spec;
+    spec.problem_id = name;
+    spec.tests = {{"3\n", "6\n", 0}, {second_input, "0\n", 0}};
+    spec.sections.emplace_back(catalog::format::SectionKind::kInputSchema,
+                               "int n 1 100\neoln\neof\n");
+    catalog::write_bundle(spec, root / (std::string(name) + ".ccb"));
+    return catalog::ProblemBundle::open(root / (std::string(name) + ".ccb"));
+  };
+  validation::validate_bundle_inputs(*make("good", "100\n"), 2);
+  try {
+    validation::validate_bundle_inputs(*make("bad", "0100\n"), 2);
+    CHECK(false);
+  } catch (const validation::ValidationError& e) {
+    CHECK(std::string_view(e.what()).starts_with("bad test 1: "));
+  }
+  catalog::BundleSpec spec;
+  spec.problem_id = "schemaless";
+  spec.tests = {{"anything at all", "", 0}};
+  catalog::write_bundle(spec, root / "schemaless.ccb");
+  validation::validate_bundle_inputs(
+      *catalog::ProblemBundle::open(root / "schemaless.ccb"), 1);
+}
+
+}  // namespace
+
+int main() {
+  const auto root = fs::temp_directory_path() /
+                    ("bundle_build_test." + std::to_string(::getpid()));
+  fs::remove_all(root);
+  build_and_rebuild(root / "build");
+  bad_sources(root / "bad");
+  fs::create_directories(root / "validate");
+  bundle_validation(root / "validate");
+  fs::remove_all(root);
+  std::printf("ok\n");
+  return 0;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Aborts the test with the failing condition and its location. The tests
+// are plain executables run by ctest; any non-zero exit is a failure.
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,     \
+                   __LINE__, #cond);                                  \
+      std::exit(1);                                                   \
+    }                                                                 \
+  } while (0)
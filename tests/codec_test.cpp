@@ -0,0 +1,222 @@
+// api::binary_codec and api::json_codec: messages round-trip exactly, and
+// every truncation, corruption or misaligned buffer is a DecodeError rather
+// than a read out of bounds or a silently wrapped field.
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "api/binary_codec.h"
+#include "api/json_codec.h"
+#include "check.h"
+
+using namespace codecoach;
+using namespace codecoach::api;
+
+namespace {
+
+SubmitRequest submit() {
+  return {.job_id = 0x1234'5678'9abcULL,
+          .tenant = 42,
+          .priority = Priority::kInteractive,
+          .problem = "two-sum",
+          .language = "cpp",
+          .source = std::string("int main() {}\n\0\xff\"\\", 18)};
+}
+
+VerdictResponse verdict(std::size_t tests) {
+  VerdictResponse response;
+  response.job_id = 77;
+  response.verdict.overall = judge::Outcome::kWrongAnswer;
+  for (std::size_t i = 0; i < tests; ++i) {
+    response.verdict.tests.push_back(
+        {static_cast<judge::Outcome>(i % judge::kOutcomeCount),
+         static_cast<std::uint32_t>(i * 3), static_cast<std::uint32_t>(i)});
+  }
+  response.verdict.compile_log = "warning: \"x\"\n\ttab";
+  response.failure_cluster = 5;
+  return response;
+}
+
+template <typename Fn>
+bool rejects(Fn&& fn) {
+  try {
+    fn();
+    return false;
+  } catch (const DecodeError&) {
+    return true;
+  }
+}
+
+// A copy of `bytes` starting `offset` bytes past an 8-byte boundary.
+class Buffer {
+ public:
+  Buffer(std::string_view bytes, std::size_t offset)
+      : storage_(new std::uint64_t[bytes.size() / 8 + 2]),
+        data_(reinterpret_cast<char*>(storage_.get()) + offset),
+        size_(bytes.size()) {
+    std::memcpy(data_, bytes.data(), bytes.size());
+  }
+  std::string_view view() const { return {data_, size_}; }
+
+ private:
+  std::unique_ptr<std::uint64_t[]> storage_;
+  char* data_;
+  std::size_t size_;
+};
+
+void binary_round_trip() {
+  std::string wire;
+  binary_codec::encode(submit(), wire);
+  const std::size_t first = wire.size();
+  CHECK(first % 8 == 0);
+  binary_codec::encode(verdict(5), wire);
+  binary_codec::encode(verdict(0), wire);
+
+  // Split the batch back into frames, as a stream reader would.
+  const Buffer buffer(wire, 0);
+  std::string_view rest = buffer.view();
+  const auto take = [&] {
+    const auto size = binary_codec::frame_size(rest);
+    CHECK(size.has_value());
+    const auto frame = rest.substr(0, *size);
+    rest.remove_prefix(*size);
+    return frame;
+  };
+  const auto a = take();
+  CHECK(binary_codec::frame_type(a) ==
+        binary_codec::MessageType::kSubmitRequest);
+  CHECK(binary_codec::decode_submit(a).to_owned() == submit());
+  CHECK(binary_codec::decode_verdict(take()).to_owned() == verdict(5));
+  const auto empty = binary_codec::decode_verdict(take());
+  CHECK(empty.test_count() == 0 && empty.to_owned() == verdict(0));
+  CHECK(rest.empty());
+}
+
+void binary_truncation() {
+  std::string wire;
+  binary_codec::encode(verdict(9), wire);
+  const Buffer buffer(wire, 0);
+  const auto frame = buffer.view();
+  // A stream reader waits for more bytes at every prefix...
+  for (std::size_t n = 0; n < frame.size(); ++n) {
+    CHECK(!binary_codec::frame_size(frame.substr(0, n)));
+    CHECK(rejects([&] { binary_codec::decode_verdict(frame.substr(0, n)); }));
+  }
+  // ...and a payload too short for the counts it declares is rejected,
+  // whatever the header claims.
+  for (std::size_t cut = 8; cut <= frame.size() - 16; cut += 8) {
+    std::string shortened(frame.substr(0, frame.size() - cut));
+    binary_codec::FrameHeader header;
+    std::memcpy(&header, shortened.data(), sizeof(header));
+    header.payload_size -= static_cast<std::uint32_t>(cut);
+    std::memcpy(shortened.data(), &header, sizeof(header));
+    const Buffer copy(shortened, 0);
+    CHECK(rejects([&] { binary_codec::decode_verdict(copy.view()); }));
+  }
+}
+
+void binary_corruption() {
+  std::string wire;
+  binary_codec::encode(verdict(3), wire);
+  const auto corrupt = [&](std::size_t at, char value) {
+    std::string bad = wire;
+    bad[at] = value;
+    const Buffer copy(bad, 0);
+    return rejects([&] { binary_codec::decode_verdict(copy.view()); });
+  };
+  CHECK(corrupt(0, 'X'));            // Magic.
+  CHECK(corrupt(4, 9));              // Version.
+  CHECK(corrupt(6, 1));              // Type: a submit, not a verdict.
+  CHECK(corrupt(16 + 16, 8));        // Overall outcome.
+  CHECK(corrupt(16 + 24 + 24, 99));  // A test's outcome.
+  CHECK(corrupt(16 + 8, 100));       // Test count beyond the payload.
+
+  std::string submit_wire;
+  binary_codec::encode(submit(), submit_wire);
+  submit_wire[16 + 12] = 2;  // Priority.
+  const Buffer copy(submit_wire, 0);
+  CHECK(rejects([&] { binary_codec::decode_submit(copy.view()); }));
+  const Buffer verdict_frame(wire, 0);
+  CHECK(rejects([&] { binary_codec::decode_submit(verdict_frame.view()); }));
+}
+
+void binary_alignment() {
+  std::string wire;
+  binary_codec::encode(verdict(4), wire);
+  CHECK(binary_codec::decode_verdict(Buffer(wire, 0).view()).to_owned() ==
+        verdict(4));
+  for (std::size_t offset : {1u, 2u, 3u, 5u}) {
+    const Buffer misaligned(wire, offset);
+    CHECK(rejects([&] { binary_codec::decode_verdict(misaligned.view()); }));
+  }
+  // Submits have no arrays; any alignment will do.
+  std::string submit_wire;
+  binary_codec::encode(submit(), submit_wire);
+  const Buffer odd(submit_wire, 3);
+  CHECK(binary_codec::decode_submit(odd.view()).to_owned() == submit());
+}
+
+void json_round_trip() {
+  CHECK(json_codec::decode_submit(json_codec::encode(submit())) == submit());
+  CHECK(json_codec::decode_verdict(json_codec::encode(verdict(6))) ==
+        verdict(6));
+  VerdictResponse bare = verdict(0);
+  bare.failure_cluster.reset();
+  bare.verdict.compile_log.clear();
+  CHECK(json_codec::decode_verdict(json_codec::encode(bare)) == bare);
+}
+
+void json_rejects() {
+  const std::string text = json_codec::encode(verdict(2));
+  for (std::size_t n = 0; n < text.size(); ++n) {
+    CHECK(rejects([&] { json_codec::decode_verdict(text.substr(0, n)); }));
+  }
+  const std::string request = json_codec::encode(submit());
+  for (std::size_t n = 0; n < request.size(); ++n) {
+    CHECK(rejects([&] { json_codec::decode_submit(request.substr(0, n)); }));
+  }
+  const char* const bad_submits[] = {
+      R"({"job_id":1,"tenant":1,"priority":"urgent","problem":"p",)"
+      R"("language":"cpp","source":""})",
+      R"({"job_id":1,"tenant":1,"priority":"batch","problem":"p",)"
+      R"("language":"cpp"})",
+      R"({"job_id":"1","tenant":1,"priority":"batch","problem":"p",)"
+      R"("language":"cpp","source":""})",
+      R"({"job_id":-1,"tenant":1,"priority":"batch","problem":"p",)"
+      R"("language":"cpp","source":""})",
+      R"({"job_id":1,"tenant":4294967296,"priority":"batch","problem":"p",)"
+      R"("language":"cpp","source":""})",
+      R"([1, 2])",
+  };
+  for (const char* bad : bad_submits) {
+    CHECK(rejects([&] { json_codec::decode_submit(bad); }));
+  }
+  const char* const bad_verdicts[] = {
+      R"({"job_id":1,"overall":"XX","tests":[]})",
+      R"({"job_id":1,"overall":"AC","tests":{}})",
+      R"({"job_id":1,"overall":"AC","tests":[{"outcome":"AC","time_ms":1}]})",
+      R"({"job_id":1,"overall":"AC","tests":[{"outcome":"AC","time_ms":-1,)"
+      R"("memory_kb":1}]})",
+      R"({"job_id":1,"overall":"AC","tests":[],"failure_cluster":-3})",
+      R"({"job_id":1,"overall":"AC","tests":[],"compile_log":7})",
+  };
+  for (const char* bad : bad_verdicts) {
+    CHECK(rejects([&] { json_codec::decode_verdict(bad); }));
+  }
+}
+
+}  // namespace
+
+int main() {
+  binary_round_trip();
+  binary_truncation();
+  binary_corruption();
+  binary_alignment();
+  json_round_trip();
+  json_rejects();
+  std::printf("ok\n");
+  return 0;
+}
@@ -0,0 +1,114 @@
+// harness/harness.h string and char encoding, through a harness built into
+// this binary: run with --echo it judges Echo::echo on stdin, which hands
+// back its string and the bytes it decoded. Tokens round-trip exactly;
+// malformed ones exit with kMalformedInput.
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/subprocess.h"
+#include "harness/harness.h"
+#include "check.h"
+
+namespace harness = codecoach::harness;
+
+namespace {
+
+struct Echo {
+  std::pair<std::string, std::vector<int>> echo(const std::string& text,
+                                                char c) {
+    std::vector<int> bytes;
+    for (const char b : text) bytes.push_back(static_cast<unsigned char>(b));
+    bytes.push_back(static_cast<unsigned char>(c));
+    return {text, bytes};
+  }
+};
+
+std::string self;
+
+codecoach::ProcessResult echo(const std::string& input) {
+  return codecoach::run_process({self, "--echo"}, input,
+                                {.wall_time = std::chrono::seconds(10)});
+}
+
+// Byte list as the harness writes it: count, then the elements.
+std::string bytes_of(const std::string& text, char c) {
+  std::string out = std::to_string(text.size() + 1);
+  for (const char b : text) {
+    out += " " + std::to_string(static_cast<unsigned char>(b));
+  }
+  return out + " " + std::to_string(static_cast<unsigned char>(c));
+}
+
+void round_trip() {
+  struct Case {
+    std::string token;  // Canonical encoding of `text`.
+    std::string text;
+  };
+  const Case cases[] = {
+      {R"("")", ""},
+      {R"("a\x20b")", "a b"},
+      {R"("\"")", "\""},
+      {R"("\\")", "\\"},
+      {R"("\x7f\x80\xff")", "\x7f\x80\xff"},
+      {R"("tab\x09nl\x0a\x00")", std::string("tab\tnl\n\0", 8)},
+      {R"("x\"y\\z")", "x\"y\\z"},
+  };
+  std::string input = std::to_string(std::size(cases)) + "\n";
+  std::string expected;
+  for (const auto& c : cases) {
+    input += c.token + " \"q\"\n";
+    expected += c.token + " " + bytes_of(c.text, 'q') + "\n";
+  }
+  const auto result = echo(input);
+  CHECK(result.ok());
+  CHECK(result.stdout_data == expected);
+
+  // Escapes the writer would not use still decode, and chars take the
+  // same escapes.
+  const auto lenient = echo(R"(1 "\x41\x62" "\x20")");
+  CHECK(lenient.ok());
+  CHECK(lenient.stdout_data == "\"Ab\" " + bytes_of("Ab", ' ') + "\n");
+}
+
+void malformed_tokens() {
+  const char* const strings[] = {
+      "abc",      // Bare token: the format before quoting.
+      "\"abc",    // Unterminated.
+      "abc\"",
+      "\"",
+      "\"a\"b\"",  // Unescaped quote inside.
+      "\"a\\\"",   // The escape eats the closing quote.
+      "\"\\q\"",   // Unknown escape.
+      "\"\\x4\"",  // Short hex escape.
+      "\"\\xzz\"",
+  };
+  for (const char* token : strings) {
+    const auto result = echo(std::string("1 ") + token + " \"c\"\n");
+    CHECK(result.signal == 0);
+    CHECK(result.exit_code == harness::kMalformedInput);
+  }
+  const char* const chars[] = {"\"\"", "\"ab\"", "c", "\"\\x41\\x42\""};
+  for (const char* token : chars) {
+    const auto result = echo(std::string("1 \"s\" ") + token + "\n");
+    CHECK(result.exit_code == harness::kMalformedInput);
+  }
+  // Running out of input mid-case.
+  CHECK(echo("2 \"a\" \"b\"\n").exit_code == harness::kMalformedInput);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 1 && std::string(argv[1]) == "--echo") {
+    return harness::run<&Echo::echo>();
+  }
+  self = std::filesystem::read_symlink("/proc/self/exe").string();
+  round_trip();
+  malformed_tokens();
+  std::printf("ok\n");
+  return 0;
+}
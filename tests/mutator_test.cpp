@@ -0,0 +1,78 @@
+// analysis::generate_mutants on small programs: comparison operators are
+// mutated unless they are template brackets, and literals only when they
+// are decimal.
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "analysis/mutator.h"
+#include "check.h"
+
+using namespace codecoach::analysis;
+
+namespace {
+
+std::size_t count(const std::vector<Mutant>& mutants, std::string_view from,
+                  std::string_view to) {
+  return std::count_if(mutants.begin(), mutants.end(), [&](const Mutant& m) {
+    return m.original == from && m.replacement == to;
+  });
+}
+
+void greater_than_is_mutated() {
+  const auto mutants = generate_mutants(
+      "int f(int a, int b) {\n"
+      "  if (a > b) return 1;\n"
+      "  while (a > g(b)) --a;\n"
+      "  if (a < b) return 2;\n"
+      "  return 0;\n"
+      "}\n");
+  CHECK(count(mutants, ">", ">=") == 2);
+  CHECK(count(mutants, "<", "<=") == 1);
+  for (const auto& m : mutants) {
+    if (m.original == ">") CHECK(m.source.find(">=") != std::string::npos);
+  }
+}
+
+void template_brackets_are_not_mutated() {
+  const auto mutants = generate_mutants(
+      "std::vector<std::pair<int, int>> v;\n"
+      "std::map<int, std::vector<int> > m;\n"
+      "auto x = static_cast<long>(y) > z;\n"
+      "template <typename T> bool h(T a, T b) { return a > b; }\n");
+  // Only the two real comparisons: after static_cast and in h.
+  CHECK(count(mutants, ">", ">=") == 2);
+  CHECK(count(mutants, "<", "<=") == 0);
+  CHECK(count(mutants, ">>", ">=") == 0);
+}
+
+void comparison_after_closed_bracket() {
+  // Brackets closed on an earlier statement do not swallow this `>`.
+  const auto mutants = generate_mutants(
+      "std::vector<int> v; if (n > k) return;\n");
+  CHECK(count(mutants, ">", ">=") == 1);
+}
+
+void octal_literals_are_left_alone() {
+  const auto mutants = generate_mutants(
+      "if (x < 010) return; if (x < 10) return; if (x < 0) return;\n");
+  CHECK(count(mutants, "010", "011") == 0);
+  CHECK(count(mutants, "010", "9") == 0);
+  CHECK(count(mutants, "10", "11") == 1);
+  CHECK(count(mutants, "10", "9") == 1);
+  CHECK(count(mutants, "0", "1") == 1);
+}
+
+}  // namespace
+
+int main() {
+  greater_than_is_mutated();
+  template_brackets_are_not_mutated();
+  comparison_after_closed_bracket();
+  octal_literals_are_left_alone();
+  std::printf("ok\n");
+  return 0;
+}
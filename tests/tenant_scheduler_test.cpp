@@ -0,0 +1,158 @@
+// scheduler::TenantScheduler dispatch rules: quota exhaustion and window
+// rolls, reserved workers and lending, priority across tenants and fair
+// share within a priority.
+
+#include <cstdio>
+#include <optional>
+
+#include "scheduler/tenant_scheduler.h"
+#include "check.h"
+
+using namespace codecoach;
+using namespace codecoach::scheduler;
+
+namespace {
+
+constexpr TenantId kA = 1;
+constexpr TenantId kB = 2;
+
+JobTicket ticket(JobId id, TenantId tenant, Priority priority,
+                 std::int64_t estimate = 1000) {
+  return {id, tenant, priority, estimate};
+}
+
+// FIFO within a queue, so tests can name the order they expect.
+QueuePolicy fifo() { return {.shortest_first = false, .aging = 0}; }
+
+void quota_exhaustion_and_window_roll() {
+  TenantScheduler s(1, fifo());
+  s.configure_tenant(kA, {.cpu_budget_us = 100, .borrow_idle = false});
+  for (JobId id = 1; id <= 3; ++id) {
+    s.submit(ticket(id, kA, Priority::kBatch, 60));
+  }
+  // A reservation that starts under budget is admitted, even past it.
+  const auto first = s.next_for(0);
+  CHECK(first && first->id == 1);
+  const auto second = s.next_for(0);
+  CHECK(second && second->id == 2);
+  CHECK(s.quota(kA)->exhausted());
+  CHECK(!s.next_for(0));  // Over quota and not allowed to borrow.
+  s.complete(*first, 60);
+  s.complete(*second, 60);
+  CHECK(!s.next_for(0));  // Settling does not refund the window.
+  s.roll_window();
+  CHECK(!s.quota(kA)->exhausted());
+  const auto third = s.next_for(0);
+  CHECK(third && third->id == 3);
+  CHECK(s.queued() == 0);
+}
+
+void over_quota_tenant_borrows_idle_capacity_only() {
+  TenantScheduler s(1, fifo());
+  s.configure_tenant(kA, {.cpu_budget_us = 10});
+  s.submit(ticket(1, kA, Priority::kBatch));
+  CHECK(s.next_for(0)->id == 1);
+  CHECK(s.quota(kA)->exhausted());
+  s.submit(ticket(2, kA, Priority::kBatch));
+  s.submit(ticket(3, kB, Priority::kBatch));
+  CHECK(s.next_for(0)->id == 3);  // B is under quota: it goes first.
+  CHECK(s.next_for(0)->id == 2);  // Then A borrows the idle worker.
+}
+
+void reserved_workers_and_lending() {
+  TenantScheduler s(2, fifo());
+  s.reserve_workers(kA, {0});
+  s.submit(ticket(1, kB, Priority::kInteractive));
+  CHECK(!s.next_for(0));  // A's worker is not lent by default.
+  s.submit(ticket(2, kA, Priority::kBatch));
+  CHECK(s.next_for(0)->id == 2);  // The owner first, even its batch work.
+  CHECK(s.next_for(1)->id == 1);
+
+  s.configure_tenant(kA, {.lend_reserved_workers = true});
+  s.submit(ticket(3, kB, Priority::kBatch));
+  CHECK(s.next_for(0)->id == 3);  // Lent while A has nothing queued.
+  s.submit(ticket(4, kB, Priority::kBatch));
+  s.submit(ticket(5, kA, Priority::kBatch));
+  CHECK(s.next_for(0)->id == 5);  // Back to the owner once it has work.
+
+  // Reserved workers are charged, never refused.
+  s.configure_tenant(kA, {.cpu_budget_us = 1, .borrow_idle = false,
+                          .lend_reserved_workers = true});
+  s.submit(ticket(6, kA, Priority::kBatch));
+  s.submit(ticket(7, kA, Priority::kBatch));
+  CHECK(s.next_for(0)->id == 6);
+  CHECK(s.next_for(0)->id == 7);
+  CHECK(s.next_for(1)->id == 4);
+}
+
+void interactive_never_waits_behind_batch() {
+  TenantScheduler s(1, fifo());
+  for (JobId id = 1; id <= 100; ++id) {
+    s.submit(ticket(id, kA, Priority::kBatch));
+  }
+  CHECK(s.next_for(0)->id == 1);
+  s.submit(ticket(1000, kB, Priority::kInteractive));
+  CHECK(s.next_for(0)->id == 1000);
+  // The same holds for A's own interactive work.
+  s.submit(ticket(1001, kA, Priority::kInteractive));
+  CHECK(s.next_for(0)->id == 1001);
+}
+
+void fair_share_within_a_priority() {
+  TenantScheduler s(1, fifo());
+  for (JobId id = 1; id <= 50; ++id) {
+    s.submit(ticket(id, kA, Priority::kInteractive));
+  }
+  CHECK(s.next_for(0)->id == 1);
+  CHECK(s.next_for(0)->id == 2);
+  // B arrives late but does not queue behind A's remaining 48 jobs, nor
+  // catch up on the share it did not use while idle.
+  s.submit(ticket(100, kB, Priority::kInteractive));
+  s.submit(ticket(101, kB, Priority::kInteractive));
+  int a = 0;
+  int b = 0;
+  for (int i = 0; i < 4; ++i) {
+    const auto job = s.next_for(0);
+    (job->tenant == kA ? a : b) += 1;
+  }
+  CHECK(a == 2 && b == 2);
+
+  // Weights split the pool by CPU cost.
+  TenantScheduler w(1, fifo());
+  w.configure_tenant(kA, {.weight = 3});
+  for (JobId id = 1; id <= 40; ++id) {
+    w.submit(ticket(id, kA, Priority::kBatch));
+    w.submit(ticket(100 + id, kB, Priority::kBatch));
+  }
+  a = 0;
+  for (int i = 0; i < 40; ++i) a += w.next_for(0)->tenant == kA;
+  CHECK(a == 30);
+}
+
+void shortest_first_with_aging() {
+  TenantScheduler s(1, {.shortest_first = true, .aging = 0});
+  s.submit(ticket(1, kA, Priority::kBatch, 5000));
+  s.submit(ticket(2, kA, Priority::kBatch, 100));
+  s.submit(ticket(3, kA, Priority::kBatch, 100));
+  s.submit(ticket(4, kA, Priority::kBatch, 2000));
+  CHECK(s.next_for(0)->id == 2);
+  CHECK(s.next_for(0)->id == 3);  // Ties go in submission order.
+  CHECK(s.next_for(0)->id == 4);
+  CHECK(s.next_for(0)->id == 1);
+  const Backlog backlog = s.backlog();
+  CHECK(backlog.queued_jobs == 0 && backlog.running_jobs == 4);
+  CHECK(backlog.running_cpu_us == 7200);
+}
+
+}  // namespace
+
+int main() {
+  quota_exhaustion_and_window_roll();
+  over_quota_tenant_borrows_idle_capacity_only();
+  reserved_workers_and_lending();
+  interactive_never_waits_behind_batch();
+  fair_share_within_a_priority();
+  shortest_first_with_aging();
+  std::printf("ok\n");
+  return 0;
+}
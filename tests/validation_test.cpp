@@ -0,0 +1,168 @@
+// validation::Schema and InputReader on well-formed and damaged inputs:
+// the canonical layout is enforced byte for byte, bounds and counts are
+// checked, graph and distinctness constraints hold, and the vectorized
+// range scan agrees with a plain loop on every failing position.
+
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "validation/input_reader.h"
+#include "validation/schema.h"
+#include "validation/simd_range.h"
+#include "check.h"
+
+using namespace codecoach::validation;
+
+namespace {
+
+bool valid(const Schema& schema, std::string_view input) {
+  try {
+    schema.validate(input);
+    return true;
+  } catch (const ValidationError&) {
+    return false;
+  }
+}
+
+bool parses(std::string_view text) {
+  try {
+    Schema::parse(text);
+    return true;
+  } catch (const SchemaError&) {
+    return false;
+  }
+}
+
+void canonical_layout() {
+  const Schema schema = Schema::parse(
+      "int n 1 10^5   # count\n"
+      "eoln\n"
+      "ints a n -2^31 2^31-1\n"
+      "eoln\n"
+      "eof\n");
+  CHECK(valid(schema, "3\n1 -2 3\n"));
+  CHECK(valid(schema, "1\n-2147483648\n"));
+  CHECK(!valid(schema, "3\n1 -2 3"));         // No final line end.
+  CHECK(!valid(schema, "3\n1 -2 3\n\n"));     // Something after it.
+  CHECK(!valid(schema, "3\n1  -2 3\n"));      // Double space.
+  CHECK(!valid(schema, "3\n1 -2 3 \n"));      // Trailing space.
+  CHECK(!valid(schema, "3\r\n1 -2 3\r\n"));   // CRLF.
+  CHECK(!valid(schema, "03\n1 -2 3\n"));      // Leading zero.
+  CHECK(!valid(schema, "3\n1 -0 3\n"));       // Negative zero.
+  CHECK(!valid(schema, "3\n1 +2 3\n"));
+  CHECK(!valid(schema, "3\n1 -2\n"));         // Too few values.
+  CHECK(!valid(schema, "3\n1 -2 3 4\n"));     // Too many.
+  CHECK(!valid(schema, "0\n\n"));             // n below its bound.
+  CHECK(!valid(schema, "1\n2147483648\n"));   // Value above its bound.
+  CHECK(!valid(schema, "1\n99999999999999999999\n"));  // Overflows int64.
+  CHECK(!valid(schema, ""));
+}
+
+void counts_cannot_force_huge_allocations() {
+  const Schema schema = Schema::parse("int n 0 10^18\neoln\nints a n 0 9\n");
+  CHECK(!valid(schema, "1000000000000000000\n1\n"));
+}
+
+void tokens() {
+  const Schema schema = Schema::parse("token s 2 4\neoln\neof\n");
+  CHECK(valid(schema, "ab\n"));
+  CHECK(valid(schema, "abcd\n"));
+  CHECK(!valid(schema, "a\n"));
+  CHECK(!valid(schema, "abcde\n"));
+  CHECK(!valid(schema, "a b\n"));
+}
+
+void graphs() {
+  const Schema tree = Schema::parse(
+      "int n 1 100\neoln\nedges e n-1 n\ntree e\neof\n");
+  CHECK(valid(tree, "1\n"));
+  CHECK(valid(tree, "4\n1 2\n2 3\n2 4\n"));
+  CHECK(!valid(tree, "4\n1 2\n2 3\n3 1\n"));  // A cycle, 4 isolated.
+  CHECK(!valid(tree, "3\n1 2\n2 4\n"));       // Vertex out of range.
+  CHECK(!valid(tree, "3\n1 2\n2 0\n"));
+  CHECK(!valid(tree, "3\n1 2 2 3\n"));        // Not one edge per line.
+
+  const Schema connected = Schema::parse(
+      "int n 1 100\nspace\nint m 0 100\neoln\nedges e m n\nconnected e\n"
+      "eof\n");
+  CHECK(valid(connected, "3 3\n1 2\n2 3\n3 1\n"));
+  CHECK(valid(connected, "3 3\n1 2\n1 2\n2 3\n"));  // Multi-edges are fine.
+  CHECK(!valid(connected, "4 2\n1 2\n3 4\n"));
+}
+
+void distinct() {
+  const Schema schema =
+      Schema::parse("int n 1 10\neoln\nints a n 1 100\neoln\ndistinct a\n");
+  CHECK(valid(schema, "3\n3 1 2\n"));
+  CHECK(!valid(schema, "3\n3 1 3\n"));
+}
+
+void schema_syntax() {
+  CHECK(parses("# only a comment\n\n"));
+  CHECK(parses("int n 1 2^20+5\nints a n+1 -10^9 10^9\n"));
+  CHECK(!parses("integer n 1 2\n"));          // Unknown statement.
+  CHECK(!parses("int n 1\n"));                // Missing bound.
+  CHECK(!parses("int n 1 x\n"));              // Bad bound.
+  CHECK(!parses("int n 1 2\nint n 1 2\n"));   // Declared twice.
+  CHECK(!parses("ints a m 1 2\n"));           // Undeclared count.
+  CHECK(!parses("int n 1 2\ntree n\n"));      // Not an edge list.
+  CHECK(!parses("int n 1 2\ndistinct n\n"));  // Not an int array.
+  CHECK(!parses("int 9n 1 2\n"));             // Bad name.
+}
+
+void range_scan_matches_scalar() {
+  std::mt19937_64 rng(7);
+  for (std::size_t size : {0u, 1u, 3u, 4u, 5u, 7u, 8u, 31u, 64u, 1000u}) {
+    std::vector<std::int64_t> values(size);
+    for (auto& v : values) v = static_cast<std::int64_t>(rng() % 2001) - 1000;
+    CHECK(!find_out_of_range(values, -1000, 1000));
+    for (std::size_t bad = 0; bad < size; ++bad) {
+      auto damaged = values;
+      damaged[bad] = bad % 2 == 0 ? 1001 : -1001;
+      const auto found = find_out_of_range(damaged, -1000, 1000);
+      CHECK(found && *found == bad);
+    }
+  }
+  // The extremes of int64, where a biased comparison could wrap.
+  constexpr auto kMin = std::numeric_limits<std::int64_t>::min();
+  constexpr auto kMax = std::numeric_limits<std::int64_t>::max();
+  const std::vector<std::int64_t> extremes = {kMin, kMax, 0, -1, 1, kMin};
+  CHECK(!find_out_of_range(extremes, kMin, kMax));
+  CHECK(find_out_of_range(extremes, kMin + 1, kMax) == 0u);
+  CHECK(find_out_of_range(extremes, kMin, kMax - 1) == 1u);
+}
+
+void reader_reports_position() {
+  InputReader in("1 2\n3 x\n");
+  CHECK(in.read_int(0, 9, "a") == 1);
+  in.read_space();
+  CHECK(in.read_int(0, 9, "b") == 2);
+  in.read_eoln();
+  CHECK(in.read_int(0, 9, "c") == 3);
+  in.read_space();
+  try {
+    in.read_int(0, 9, "d");
+    CHECK(false);
+  } catch (const ValidationError& e) {
+    CHECK(std::string_view(e.what()).starts_with("2:3: "));  // Line:column.
+  }
+}
+
+}  // namespace
+
+int main() {
+  canonical_layout();
+  counts_cannot_force_huge_allocations();
+  tokens();
+  graphs();
+  distinct();
+  schema_syntax();
+  range_scan_matches_scalar();
+  reader_reports_position();
+  std::printf("ok\n");
+  return 0;
+}
@@ -0,0 +1,85 @@
+// Builds problem bundles from source directories (layout documented in
+// src/bundler/problem_builder.h).
+//
+//   bundle_builder <out-dir> <cache-dir> <problem-dir>... [--jobs N]
+//                  [--harness harness.h]
+//
+// <cache-dir> holds the compile cache, the content-addressed blob store and
+// the build-step log; keep it between runs so rebuilds only redo what
+// changed. --harness locates src/harness/harness.h for problems with a
+// signature when not run from the source root. Exits non-zero if any
+// problem fails to build.
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "bundler/problem_builder.h"
+#include "common/parallel.h"
+
+using namespace codecoach;
+
+int main(int argc, char** argv) {
+  bundler::BuildOptions options;
+  options.parallelism = default_parallelism();
+  std::vector<std::filesystem::path> positional;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--jobs" && i + 1 < argc) {
+      options.parallelism = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--harness" && i + 1 < argc) {
+      options.harness_header = argv[++i];
+    } else {
+      positional.emplace_back(arg);
+    }
+  }
+  if (positional.size() < 3) {
+    std::fprintf(stderr,
+                 "usage: bundle_builder <out-dir> <cache-dir> "
+                 "<problem-dir>... [--jobs N] [--harness harness.h]\n");
+    return 2;
+  }
+  const auto& out_dir = positional[0];
+  const auto& cache_dir = positional[1];
+
+  int failures = 0;
+  try {
+    compile::CompileCache compile_cache(cache_dir / "compile");
+    compile::PchRegistry pch;
+    compile::Compiler compiler({}, compile_cache, pch);
+    storage::BlobStore blobs(cache_dir / "blobs");
+    bundler::BuildCache steps(cache_dir / "build-steps.log");
+    bundler::ProblemBuilder builder(compiler, blobs, steps, options);
+
+    for (std::size_t p = 2; p < positional.size(); ++p) {
+      const auto& dir = positional[p];
+      try {
+        const auto stats = builder.build(dir, out_dir);
+        std::printf(
+            "%s: %zu tests, %zu generated (%zu cached), %zu solved "
+            "(%zu cached), %zu validated, %zu bytes shared, v%llu %s, "
+            "%lld ms\n",
+            dir.string().c_str(), stats.tests, stats.generated,
+            stats.inputs_reused, stats.solved, stats.outputs_reused,
+            stats.validated, stats.shared_bytes,
+            static_cast<unsigned long long>(stats.version),
+            stats.written ? "written" : "unchanged",
+            static_cast<long long>(stats.elapsed.count()));
+        if (stats.max_reference_ms > 0) {
+          std::printf("  slowest fresh reference run: %u ms\n",
+                      stats.max_reference_ms);
+        }
+      } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s: %s\n", dir.string().c_str(), e.what());
+        ++failures;
+      }
+    }
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "bundle_builder: %s\n", e.what());
+    return 1;
+  }
+  return failures == 0 ? 0 : 1;
+}
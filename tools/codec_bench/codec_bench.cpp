@@ -0,0 +1,130 @@
+// Measures per-call serialization cost of the JSON and binary API codecs on
+// representative payloads: a submission carrying a few KB of source and a
+// verdict with a per-test result array.
+//
+//   codec_bench [iterations] [source_bytes] [tests]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "api/binary_codec.h"
+#include "api/json_codec.h"
+
+using namespace codecoach;
+
+namespace {
+
+template <typename Fn>
+double ns_per_call(std::size_t iterations, Fn&& fn) {
+  // One untimed pass to fault in buffers.
+  fn();
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < iterations; ++i) fn();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+         static_cast<double>(iterations);
+}
+
+// Keeps the optimizer from discarding benchmark results.
+template <typename T>
+void keep(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+api::SubmitRequest make_submit(std::size_t source_bytes) {
+  api::SubmitRequest request;
+  request.job_id = 123456789;
+  request.tenant = 42;
+  request.priority = Priority::kInteractive;
+  request.problem = "two-sum";
+  request.language = "cpp20";
+  // Quotes and backslashes so the JSON path pays for escaping.
+  const std::string line = "  for (int i = 0; i < n; ++i) s += \"a\\b\"[i];\n";
+  while (request.source.size() < source_bytes) request.source += line;
+  request.source.resize(source_bytes);
+  return request;
+}
+
+api::VerdictResponse make_verdict(std::size_t tests) {
+  api::VerdictResponse response;
+  response.job_id = 123456789;
+  response.verdict.overall = judge::Outcome::kWrongAnswer;
+  for (std::size_t i = 0; i < tests; ++i) {
+    response.verdict.tests.push_back(
+        {i % 7 == 3 ? judge::Outcome::kWrongAnswer : judge::Outcome::kAccepted,
+         static_cast<std::uint32_t>(i * 3 % 1000),
+         static_cast<std::uint32_t>(1024 + i)});
+  }
+  return response;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                          : 100000;
+  const std::size_t source_bytes =
+      argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4096;
+  const std::size_t tests = argc > 3 ? std::strtoul(argv[3], nullptr, 10)
+                                     : 100;
+
+  const auto submit = make_submit(source_bytes);
+  const auto verdict = make_verdict(tests);
+
+  const std::string submit_json = api::json_codec::encode(submit);
+  const std::string verdict_json = api::json_codec::encode(verdict);
+  std::string submit_bin;
+  api::binary_codec::encode(submit, submit_bin);
+  std::string verdict_bin;
+  api::binary_codec::encode(verdict, verdict_bin);
+
+  // Sanity: both paths must round-trip before their speed means anything.
+  if (api::json_codec::decode_submit(submit_json) != submit ||
+      api::json_codec::decode_verdict(verdict_json) != verdict ||
+      api::binary_codec::decode_submit(submit_bin).to_owned() != submit ||
+      api::binary_codec::decode_verdict(verdict_bin).to_owned() != verdict) {
+    std::fprintf(stderr, "codec round-trip mismatch\n");
+    return 1;
+  }
+
+  std::printf("payload: %zu source bytes, %zu tests, %zu iterations\n",
+              source_bytes, tests, iterations);
+  std::printf("%-16s %10s %10s %10s %10s\n", "", "json B", "binary B",
+              "json ns", "binary ns");
+  const auto row = [&](const char* name, std::size_t json_bytes,
+                       std::size_t binary_bytes, auto&& json_fn,
+                       auto&& binary_fn) {
+    std::printf("%-16s %10zu %10zu %10.0f %10.0f\n", name, json_bytes,
+                binary_bytes, ns_per_call(iterations, json_fn),
+                ns_per_call(iterations, binary_fn));
+  };
+
+  std::string buffer;
+  row(
+      "encode submit", submit_json.size(), submit_bin.size(),
+      [&] { keep(api::json_codec::encode(submit)); },
+      [&] {
+        buffer.clear();
+        api::binary_codec::encode(submit, buffer);
+        keep(buffer);
+      });
+  row(
+      "decode submit", submit_json.size(), submit_bin.size(),
+      [&] { keep(api::json_codec::decode_submit(submit_json)); },
+      [&] { keep(api::binary_codec::decode_submit(submit_bin)); });
+  row(
+      "encode verdict", verdict_json.size(), verdict_bin.size(),
+      [&] { keep(api::json_codec::encode(verdict)); },
+      [&] {
+        buffer.clear();
+        api::binary_codec::encode(verdict, buffer);
+        keep(buffer);
+      });
+  row(
+      "decode verdict", verdict_json.size(), verdict_bin.size(),
+      [&] { keep(api::json_codec::decode_verdict(verdict_json)); },
+      [&] { keep(api::binary_codec::decode_verdict(verdict_bin)); });
+  return 0;
+}
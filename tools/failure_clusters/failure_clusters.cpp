@@ -0,0 +1,205 @@
+// Clusters a problem's wrong submissions by failure signature and code
+// similarity, and optionally stores the signature -> cluster table in the
+// bundle so verdicts carry their cluster id.
+//
+//   failure_clusters <bundle.ccb> <corpus-dir> <cache-dir> [--apply]
+//                    [--jobs N] [--threshold X] [--signatures FILE]
+//
+// <corpus-dir> holds the sources (*.cpp) of historical wrong submissions.
+// They are compiled through the compile cache in <cache-dir> and judged on
+// every test (full audit). Sources that do not compile or pass every test
+// are left out.
+//
+// The verdicts are packed into an analysis::SignatureStore, which also
+// gives the pairs of tests that most often fail together; --signatures
+// saves it for test_pruner.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "analysis/failure_clusters.h"
+#include "analysis/signature_store.h"
+#include "catalog/bundle_edit.h"
+#include "catalog/problem_bundle.h"
+#include "common/parallel.h"
+#include "compile/compiler.h"
+#include "harness/driver.h"
+#include "judge/failure_cluster.h"
+#include "judge/local_runner.h"
+
+using namespace codecoach;
+
+namespace {
+
+constexpr double kFailTogether = 0.9;  // Correlation worth reporting.
+constexpr std::size_t kPairsShown = 10;
+
+int usage() {
+  std::fprintf(stderr,
+               "usage: failure_clusters <bundle.ccb> <corpus-dir> "
+               "<cache-dir> [--apply] [--jobs N] [--threshold X] "
+               "[--signatures FILE]\n");
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 4) return usage();
+  const std::filesystem::path bundle_path = argv[1];
+  const std::filesystem::path corpus_dir = argv[2];
+  const std::filesystem::path cache_dir = argv[3];
+  bool apply = false;
+  std::filesystem::path signatures_path;
+  analysis::ClusterOptions options;
+  options.parallelism = default_parallelism();
+  for (int i = 4; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--apply") {
+      apply = true;
+    } else if (arg == "--jobs" && i + 1 < argc) {
+      options.parallelism = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--threshold" && i + 1 < argc) {
+      options.threshold = std::strtod(argv[++i], nullptr);
+    } else if (arg == "--signatures" && i + 1 < argc) {
+      signatures_path = argv[++i];
+    } else {
+      return usage();
+    }
+  }
+
+  try {
+    const auto bundle = catalog::ProblemBundle::open(bundle_path);
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry :
+         std::filesystem::directory_iterator(corpus_dir)) {
+      if (entry.is_regular_file() && entry.path().extension() == ".cpp") {
+        files.push_back(entry.path());
+      }
+    }
+    std::sort(files.begin(), files.end());
+
+    compile::CompileCache cache(cache_dir);
+    compile::PchRegistry pch;
+    compile::Compiler compiler({}, cache, pch);
+    compiler.ensure_pch();
+    std::vector<std::string> sources(files.size());
+    std::vector<compile::CompileResult> builds(files.size());
+    parallel_for(files.size(), options.parallelism, [&](std::size_t i) {
+      std::ifstream in(files[i]);
+      sources[i].assign(std::istreambuf_iterator<char>(in), {});
+      builds[i] =
+          compiler.compile(harness::program_source(*bundle, sources[i]));
+    });
+    std::vector<std::size_t> compiled;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+      if (builds[i].ok) compiled.push_back(i);
+    }
+
+    const auto limits = judge::RunLimits::of(*bundle);
+    const std::size_t tests = bundle->test_count();
+    std::vector<judge::Verdict> verdicts(compiled.size());
+    for (auto& verdict : verdicts) verdict.tests.resize(tests);
+    parallel_for(compiled.size() * tests, options.parallelism,
+                 [&](std::size_t i) {
+                   const std::size_t s = i / tests, t = i % tests;
+                   verdicts[s].tests[t] = judge::run_test_locally(
+                       builds[compiled[s]].artifact, bundle->test(t), limits);
+                 });
+    analysis::SignatureStore store(tests);
+    for (auto& verdict : verdicts) {
+      verdict.overall = judge::Outcome::kAccepted;
+      for (const auto& test : verdict.tests) {
+        if (test.outcome == judge::Outcome::kAccepted) continue;
+        verdict.overall = test.outcome;
+        break;
+      }
+      store.append(verdict, limits);
+    }
+
+    std::vector<analysis::WrongSubmission> wrong;
+    std::vector<std::size_t> wrong_files;
+    for (std::size_t s = 0; s < compiled.size(); ++s) {
+      Bitset failed = store.failure_signature(s);
+      if (!failed.any()) continue;
+      wrong.push_back({std::move(failed),
+                       analysis::code_fingerprint(sources[compiled[s]])});
+      wrong_files.push_back(compiled[s]);
+    }
+
+    const auto clustering = analysis::cluster_failures(wrong, options);
+    std::printf("%s: %zu sources, %zu compiled, %zu wrong, %zu clusters\n",
+                std::string(bundle->problem_id()).c_str(), files.size(),
+                compiled.size(), wrong.size(), clustering.clusters.size());
+    for (std::size_t c = 0; c < clustering.clusters.size(); ++c) {
+      const auto& cluster = clustering.clusters[c];
+      std::string tests;
+      for (std::size_t t = 0; t < cluster.center.size(); ++t) {
+        if (!cluster.center.test(t)) continue;
+        if (!tests.empty()) tests += ',';
+        tests += std::to_string(t + 1);
+      }
+      const auto example = std::find(clustering.cluster_of.begin(),
+                                     clustering.cluster_of.end(), c) -
+                           clustering.cluster_of.begin();
+      std::printf("cluster %zu: %zu submissions, %zu signatures, fails %s "
+                  "(e.g. %s)\n",
+                  c, cluster.submissions, cluster.signatures, tests.c_str(),
+                  files[wrong_files[example]].filename().c_str());
+    }
+
+    // Strongly correlated tests are candidates for test_pruner.
+    struct TestPair {
+      std::size_t a, b;
+      analysis::SignatureStore::PairStats stats;
+    };
+    std::vector<TestPair> together;
+    const auto pair_stats = store.all_pair_stats(options.parallelism);
+    for (std::size_t a = 0; a < tests; ++a) {
+      for (std::size_t b = a + 1; b < tests; ++b) {
+        const auto& stats = pair_stats[a * tests + b];
+        if (stats.both_failed > 0 &&
+            stats.correlation() >= kFailTogether) {
+          together.push_back({a, b, stats});
+        }
+      }
+    }
+    std::stable_sort(together.begin(), together.end(),
+                     [](const TestPair& x, const TestPair& y) {
+                       return x.stats.both_failed > y.stats.both_failed;
+                     });
+    if (together.size() > kPairsShown) together.resize(kPairsShown);
+    for (const TestPair& pair : together) {
+      std::printf("tests %zu and %zu fail together: %llu of %llu "
+                  "submissions, correlation %.2f\n",
+                  pair.a + 1, pair.b + 1,
+                  static_cast<unsigned long long>(pair.stats.both_failed),
+                  static_cast<unsigned long long>(pair.stats.both_ran),
+                  pair.stats.correlation());
+    }
+    if (!signatures_path.empty()) {
+      store.save(signatures_path);
+      std::printf("saved %zu signatures to %s\n", store.size(),
+                  signatures_path.c_str());
+    }
+
+    if (apply) {
+      catalog::replace_section(
+          bundle_path, catalog::format::SectionKind::kFailureClusters,
+          judge::encode_cluster_table(*bundle,
+                                      clustering.signature_clusters));
+      std::printf("rewrote %s\n", bundle_path.c_str());
+    }
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "failure_clusters: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,74 @@
+// Measures how well a problem's tests tell wrong solutions from right ones
+// by mutating the reference solution and reporting surviving mutants.
+//
+//   mutation_bench <bundle.ccb> <reference.cpp> <cache-dir> [--jobs N]
+//                  [--standard]
+//
+// --standard judges with audit-only tests skipped, to check that pruning
+// (tools/test_pruner) did not weaken the suite.
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "analysis/mutation_benchmark.h"
+#include "common/parallel.h"
+
+using namespace codecoach;
+
+int main(int argc, char** argv) {
+  if (argc < 4) {
+    std::fprintf(stderr,
+                 "usage: mutation_bench <bundle.ccb> <reference.cpp> "
+                 "<cache-dir> [--jobs N] [--standard]\n");
+    return 2;
+  }
+  analysis::MutationOptions options;
+  options.parallelism = default_parallelism();
+  for (int i = 4; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--jobs" && i + 1 < argc) {
+      options.parallelism = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--standard") {
+      options.mode = catalog::JudgeMode::kStandard;
+    }
+  }
+
+  try {
+    const auto bundle = catalog::ProblemBundle::open(argv[1]);
+    std::ifstream in(argv[2]);
+    const std::string reference(std::istreambuf_iterator<char>(in), {});
+
+    compile::CompileCache cache(argv[3]);
+    compile::PchRegistry pch;
+    compile::Compiler compiler({}, cache, pch);
+    const auto report =
+        analysis::run_mutation_benchmark(*bundle, reference, compiler,
+                                         options);
+
+    std::printf("%zu mutants: %zu killed, %zu survived, %zu stillborn\n",
+                report.mutants.size(), report.killed, report.survived,
+                report.stillborn);
+    std::printf("mutation score %.1f%%\n", 100 * report.score());
+    std::printf("compile %lld ms (%zu cache hits), run %lld ms\n",
+                static_cast<long long>(report.compile_time.count()),
+                report.cache_hits,
+                static_cast<long long>(report.run_time.count()));
+    for (std::size_t i = 0; i < report.mutants.size(); ++i) {
+      if (report.results[i].status != analysis::MutantStatus::kSurvived) {
+        continue;
+      }
+      const auto& m = report.mutants[i];
+      std::printf("survived: line %zu %s: '%s' -> '%s'\n", m.line,
+                  std::string(analysis::to_string(m.op)).c_str(),
+                  m.original.c_str(), m.replacement.c_str());
+    }
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "mutation_bench: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
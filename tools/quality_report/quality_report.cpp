@@ -0,0 +1,101 @@
+// Profiles an accepted solution with hardware counters and prints the
+// structured quality report the coach reads (see judge/quality_report).
+//
+//   quality_report <bundle.ccb> <solution.cpp> <cache-dir>
+//                  [--reference ref.cpp] [--audit]
+//
+// Sources are compiled through the compile cache in <cache-dir>. With
+// --reference, a second solution (usually the fastest accepted one) is
+// profiled on the same node and the report compares against it. Hosts
+// without usable counters still produce a report, with null metrics.
+
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include "catalog/problem_bundle.h"
+#include "common/json.h"
+#include "compile/compiler.h"
+#include "harness/driver.h"
+#include "judge/quality_report.h"
+
+using namespace codecoach;
+
+namespace {
+
+int usage() {
+  std::fprintf(stderr,
+               "usage: quality_report <bundle.ccb> <solution.cpp> "
+               "<cache-dir> [--reference ref.cpp] [--audit]\n");
+  return 2;
+}
+
+std::filesystem::path build(compile::Compiler& compiler,
+                            const catalog::ProblemBundle& bundle,
+                            const std::filesystem::path& file) {
+  std::ifstream in(file);
+  if (!in) throw std::runtime_error("cannot read " + file.string());
+  const std::string source(std::istreambuf_iterator<char>(in), {});
+  auto result = compiler.compile(harness::program_source(bundle, source));
+  if (!result.ok) {
+    throw std::runtime_error(file.string() + " does not compile:\n" +
+                             result.log);
+  }
+  return result.artifact;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 4) return usage();
+  const std::filesystem::path bundle_path = argv[1];
+  const std::filesystem::path solution = argv[2];
+  const std::filesystem::path cache_dir = argv[3];
+  std::optional<std::filesystem::path> reference;
+  auto mode = catalog::JudgeMode::kStandard;
+  for (int i = 4; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--reference" && i + 1 < argc) {
+      reference = argv[++i];
+    } else if (arg == "--audit") {
+      mode = catalog::JudgeMode::kFullAudit;
+    } else {
+      return usage();
+    }
+  }
+
+  try {
+    const auto bundle = catalog::ProblemBundle::open(bundle_path);
+    compile::CompileCache cache(cache_dir);
+    compile::PchRegistry pch;
+    compile::Compiler compiler({}, cache, pch);
+    compiler.ensure_pch();
+
+    const auto calibration = sandbox::NodeCalibration::measure();
+    const auto report = judge::profile_solution(
+        *bundle, build(compiler, *bundle, solution), calibration, mode);
+    std::optional<judge::QualityReport> baseline;
+    if (reference) {
+      baseline = judge::profile_solution(
+          *bundle, build(compiler, *bundle, *reference), calibration, mode);
+    }
+    if (!report.counters_available()) {
+      std::fprintf(stderr,
+                   "quality_report: no hardware counters on this host "
+                   "(no PMU, or perf_event_paranoid > 2)\n");
+    }
+    std::printf("%s\n",
+                json::serialize(judge::report_json(
+                                    report, baseline ? &*baseline : nullptr))
+                    .c_str());
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "quality_report: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
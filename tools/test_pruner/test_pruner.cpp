@@ -0,0 +1,131 @@
+// Finds hidden tests that are redundant for catching known wrong
+// submissions and marks them audit-only.
+//
+//   test_pruner <bundle.ccb> <corpus-dir | signatures> [--apply]
+//               [--jobs N]
+//
+// <corpus-dir> holds compiled executables of historical wrong submissions
+// for the problem; every (submission, test) pair is judged in parallel.
+// Alternatively, a saved analysis::SignatureStore of full-audit verdicts
+// (failure_clusters --signatures) supplies the failures without judging
+// anything. A greedy set cover then picks the tests that catch every
+// submission any test catches. With --apply the bundle is rewritten so the
+// rest carry kTestAuditOnly and only run in full-audit mode. Sample tests
+// are always kept.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "analysis/signature_store.h"
+#include "analysis/test_coverage.h"
+#include "catalog/bundle_edit.h"
+#include "catalog/problem_bundle.h"
+#include "common/parallel.h"
+#include "judge/local_runner.h"
+
+using namespace codecoach;
+
+namespace {
+
+int usage() {
+  std::fprintf(stderr,
+               "usage: test_pruner <bundle.ccb> <corpus-dir | signatures> "
+               "[--apply] [--jobs N]\n");
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) return usage();
+  const std::filesystem::path bundle_path = argv[1];
+  const std::filesystem::path corpus_dir = argv[2];
+  bool apply = false;
+  std::size_t jobs = default_parallelism();
+  for (int i = 3; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--apply") {
+      apply = true;
+    } else if (arg == "--jobs" && i + 1 < argc) {
+      jobs = std::strtoul(argv[++i], nullptr, 10);
+    } else {
+      return usage();
+    }
+  }
+
+  try {
+    const auto bundle = catalog::ProblemBundle::open(bundle_path);
+    std::vector<std::filesystem::path> corpus;
+    analysis::DetectionMatrix detections;
+    std::size_t submissions = 0;
+    if (std::filesystem::is_directory(corpus_dir)) {
+      for (const auto& entry :
+           std::filesystem::directory_iterator(corpus_dir)) {
+        if (entry.is_regular_file()) corpus.push_back(entry.path());
+      }
+      std::sort(corpus.begin(), corpus.end());
+      submissions = corpus.size();
+
+      const auto limits = judge::RunLimits::of(*bundle);
+      detections = analysis::build_detection_matrix(
+          corpus.size(), bundle->test_count(),
+          [&](std::size_t s, std::size_t t) {
+            return judge::run_test_locally(corpus[s], bundle->test(t),
+                                           limits)
+                       .outcome != judge::Outcome::kAccepted;
+          },
+          jobs);
+    } else {
+      const auto store = analysis::SignatureStore::load(corpus_dir);
+      if (store.test_count() != bundle->test_count()) {
+        throw analysis::SignatureError(
+            "signatures are for a different test set");
+      }
+      submissions = store.size();
+      detections = store.detection_matrix();
+    }
+
+    std::vector<std::size_t> samples;
+    for (std::size_t t = 0; t < bundle->test_count(); ++t) {
+      if (bundle->test(t).flags & catalog::format::kTestSample) {
+        samples.push_back(t);
+      }
+    }
+    const auto cover = analysis::greedy_cover(detections, samples);
+
+    std::printf("%s: %zu tests, %zu wrong submissions\n",
+                std::string(bundle->problem_id()).c_str(),
+                bundle->test_count(), submissions);
+    std::printf("kept %zu tests, %zu redundant\n", cover.kept.size(),
+                cover.redundant.size());
+    // A signature store may hold accepted submissions too, which are
+    // indistinguishable from undetected ones here, so only corpora list
+    // them.
+    for (std::size_t s = 0; s < corpus.size(); ++s) {
+      if (cover.undetected.test(s)) {
+        std::printf("undetected: %s\n", corpus[s].filename().c_str());
+      }
+    }
+
+    if (apply) {
+      std::vector<std::uint32_t> flags(bundle->test_count());
+      for (std::size_t t = 0; t < flags.size(); ++t) {
+        flags[t] = bundle->test(t).flags & ~catalog::format::kTestAuditOnly;
+      }
+      for (const std::size_t t : cover.redundant) {
+        flags[t] |= catalog::format::kTestAuditOnly;
+      }
+      catalog::rewrite_test_flags(bundle_path, flags);
+      std::printf("rewrote %s\n", bundle_path.c_str());
+    }
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "test_pruner: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,544 @@
+// Replays a recorded submission log against an in-process evaluator and
+// reports end-to-end latency per action and verdict agreement with what
+// production returned. Fully offline: the coach's live model is a stub.
+//
+//   traffic_replay <log.jsonl> <catalog-dir> <cache-dir> [--speed X]
+//                  [--workers N] [--no-hints] [--slo-ms X]
+//                  [--fault NAME=P[:MS]]... [--seed N]
+//                  [--crash-detect-ms N] [--restart-ms N] [--fifo]
+//                  [--warm-state FILE] [--records DIR]
+//
+// One JSON object per log line:
+//
+//   {"t_ms": 1250, "job_id": 7, "tenant": 3, "user": 42,
+//    "priority": "interactive", "action": "submit", "problem": "two-sum",
+//    "language": "cpp", "source": "...",
+//    "expected": {"overall": "WA", "tests": ["AC", "WA", "SKIP"]}}
+//
+// t_ms is the arrival offset from the start of the log; --speed 4 replays
+// it four times faster. "user" and "expected" are optional; when "tests"
+// is present, per-test outcomes are compared too. Submissions in a language
+// the compiler does not build are skipped and counted, not compared. Use
+// this to check scheduler and cache changes against real traffic before
+// they ship.
+// Exits 1 when any replayed verdict disagrees with the log.
+//
+// --fault arms an injected failure with probability P per opportunity
+// (common/fault_injection.h): worker-crash, compile-delay (stalls MS),
+// disk-full or coach-drop (times out after MS). Under faults the report
+// adds how often each fired, the time crashed jobs lost to recovery and,
+// with --slo-ms, the share of submissions over the latency target.
+//
+// --slo-ms also sets a p95 target for every action and problem class in the
+// evaluator's judge::SloTracker (10 s windows), which sheds hints under
+// pressure as in the service; the report shows per-class percentiles, burn
+// rates and how often hints were shed.
+//
+// The report also shows the evaluator's autoscaling signal at its peaks:
+// queued and running work by estimated CPU (scheduler::Backlog), and the
+// workers that would drain it in 10 s. --fifo turns off the scheduler's
+// shortest-expected-job-first ordering, for comparison.
+//
+// --warm-state restores the evaluator from FILE before replaying, when it
+// exists, and saves a fresh snapshot there afterwards, as the service does
+// across restarts (warmup/warm_state.h).
+//
+// --records keeps a judge::RecordStore in DIR, as the service does:
+// submissions, verdicts and hints are recorded off the verdict path, and
+// the compile cache's index persists there. The report shows each column
+// family's tables and the lookups its bloom filters answered.
+//
+// As in the service, a bundle whose test inputs fail its input schema is
+// rejected at load (validation/bundle_validation.h).
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "coach/coach.h"
+#include "common/fault_injection.h"
+#include "common/histogram.h"
+#include "common/json.h"
+#include "compile/compiler.h"
+#include "judge/evaluator.h"
+#include "judge/record_store.h"
+#include "judge/slo_tracker.h"
+#include "validation/bundle_validation.h"
+#include "warmup/warm_state.h"
+
+using namespace codecoach;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kMismatchesShown = 10;
+// Drain target for the reported worker count.
+constexpr std::chrono::microseconds kDrain = std::chrono::seconds(10);
+constexpr std::size_t kHotProblems = 100;  // Kept in warm-state snapshots.
+
+struct Expected {
+  judge::Outcome overall = judge::Outcome::kInternalError;
+  std::vector<judge::Outcome> tests;  // Empty: overall only.
+};
+
+struct Entry {
+  std::chrono::microseconds at{0};
+  judge::EvaluationRequest request;
+  std::optional<Expected> expected;
+};
+
+class OfflineCoach : public coach::CoachClient {
+ public:
+  std::string hint(const coach::HintContext& context) override {
+    return "Re-read the statement for " + std::string(context.problem_id) +
+           " and check your edge cases.";
+  }
+};
+
+int usage() {
+  std::fprintf(stderr,
+               "usage: traffic_replay <log.jsonl> <catalog-dir> <cache-dir> "
+               "[--speed X] [--workers N] [--no-hints] [--slo-ms X] "
+               "[--fault NAME=P[:MS]]... [--seed N] [--crash-detect-ms N] "
+               "[--restart-ms N] [--fifo] [--warm-state FILE] "
+               "[--records DIR]\n");
+  return 2;
+}
+
+// NAME=P[:MS], e.g. "compile-delay=0.1:500".
+bool parse_fault(std::string_view arg,
+                 std::vector<std::pair<Fault, FaultSpec>>& out) {
+  const auto eq = arg.find('=');
+  if (eq == std::string_view::npos) return false;
+  const auto fault = fault_from_string(arg.substr(0, eq));
+  if (!fault) return false;
+  const std::string value(arg.substr(eq + 1));
+  char* end = nullptr;
+  FaultSpec spec;
+  spec.probability = std::strtod(value.c_str(), &end);
+  if (*end == ':') {
+    spec.delay = std::chrono::milliseconds(std::strtoll(end + 1, &end, 10));
+  }
+  if (*end != '\0' || !(spec.probability >= 0 && spec.probability <= 1)) {
+    return false;
+  }
+  out.emplace_back(*fault, spec);
+  return true;
+}
+
+const json::Value& field(const json::Value& object, std::string_view key) {
+  const json::Value* value = object.find(key);
+  if (value == nullptr) {
+    throw std::runtime_error("missing \"" + std::string(key) + "\"");
+  }
+  return *value;
+}
+
+judge::Outcome outcome(const json::Value& value) {
+  const auto parsed = judge::outcome_from_string(value.as_string());
+  if (!parsed) throw std::runtime_error("bad outcome " + value.as_string());
+  return *parsed;
+}
+
+Entry parse_entry(const json::Value& line) {
+  Entry entry;
+  entry.at = std::chrono::microseconds(
+      static_cast<std::int64_t>(field(line, "t_ms").as_double() * 1000));
+  auto& submission = entry.request.submission;
+  submission.job_id = static_cast<JobId>(field(line, "job_id").as_int());
+  submission.tenant = static_cast<TenantId>(field(line, "tenant").as_int());
+  if (const auto* user = line.find("user")) {
+    entry.request.user = static_cast<std::uint64_t>(user->as_int());
+  }
+  if (const auto* priority = line.find("priority")) {
+    submission.priority = priority->as_string() == "batch"
+                              ? Priority::kBatch
+                              : Priority::kInteractive;
+  }
+  submission.problem = field(line, "problem").as_string();
+  submission.language = field(line, "language").as_string();
+  submission.source = field(line, "source").as_string();
+  const auto action =
+      judge::action_from_string(field(line, "action").as_string());
+  if (!action) throw std::runtime_error("bad action");
+  entry.request.action = *action;
+  if (const auto* expected = line.find("expected")) {
+    Expected e;
+    e.overall = outcome(field(*expected, "overall"));
+    if (const auto* tests = expected->find("tests")) {
+      for (const auto& test : tests->as_array()) {
+        e.tests.push_back(outcome(test));
+      }
+    }
+    entry.expected = std::move(e);
+  }
+  return entry;
+}
+
+std::vector<Entry> read_log(const std::filesystem::path& path) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("cannot open " + path.string());
+  std::vector<Entry> entries;
+  std::string line;
+  for (std::size_t number = 1; std::getline(in, line); ++number) {
+    if (line.empty()) continue;
+    try {
+      entries.push_back(parse_entry(json::parse(line)));
+    } catch (const std::exception& e) {
+      throw std::runtime_error(path.string() + ":" + std::to_string(number) +
+                               ": " + e.what());
+    }
+  }
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const Entry& a, const Entry& b) { return a.at < b.at; });
+  return entries;
+}
+
+// Empty when the replayed verdict agrees with the recorded one.
+std::string mismatch(const Expected& expected, const judge::Evaluation& got) {
+  const judge::Verdict& verdict = got.response.verdict;
+  std::string what;
+  if (verdict.overall != expected.overall) {
+    what = "overall " + std::string(to_string(expected.overall)) + " -> " +
+           std::string(to_string(verdict.overall));
+  } else if (!expected.tests.empty() &&
+             expected.tests.size() != verdict.tests.size()) {
+    what = std::to_string(expected.tests.size()) + " tests -> " +
+           std::to_string(verdict.tests.size());
+  } else {
+    for (std::size_t t = 0; t < expected.tests.size(); ++t) {
+      if (expected.tests[t] == verdict.tests[t].outcome) continue;
+      what = "test " + std::to_string(t + 1) + " " +
+             std::string(to_string(expected.tests[t])) + " -> " +
+             std::string(to_string(verdict.tests[t].outcome));
+      break;
+    }
+  }
+  if (!what.empty() && !got.error.empty()) what += " (" + got.error + ")";
+  return what;
+}
+
+struct ActionStats {
+  LatencyHistogram total;
+  LatencyHistogram queued;
+  LatencyHistogram compile;
+  LatencyHistogram run;
+  LatencyHistogram coach;
+  std::size_t cache_hits = 0;
+  std::size_t over_slo = 0;
+};
+
+void print_latency(const char* name, const LatencyHistogram& h) {
+  std::printf("  %-8s p50 %8.1f  p95 %8.1f  p99 %8.1f  max %8.1f ms\n", name,
+              h.percentile(0.50) / 1000.0, h.percentile(0.95) / 1000.0,
+              h.percentile(0.99) / 1000.0, h.max() / 1000.0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 4) return usage();
+  const std::filesystem::path log_path = argv[1];
+  const std::filesystem::path catalog_dir = argv[2];
+  const std::filesystem::path cache_dir = argv[3];
+  double speed = 1.0;
+  judge::EvaluatorOptions options;
+  std::vector<std::pair<Fault, FaultSpec>> faults;
+  std::uint64_t seed = 1;
+  std::uint64_t slo_us = 0;
+  std::optional<FaultInjector> injector;
+  std::filesystem::path warm_path;
+  std::filesystem::path records_dir;
+  for (int i = 4; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--fault" && i + 1 < argc) {
+      if (!parse_fault(argv[++i], faults)) return usage();
+    } else if (arg == "--seed" && i + 1 < argc) {
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--slo-ms" && i + 1 < argc) {
+      slo_us = static_cast<std::uint64_t>(
+          std::strtod(argv[++i], nullptr) * 1000);
+    } else if (arg == "--crash-detect-ms" && i + 1 < argc) {
+      options.crash_detection =
+          std::chrono::milliseconds(std::strtoll(argv[++i], nullptr, 10));
+    } else if (arg == "--restart-ms" && i + 1 < argc) {
+      options.worker_restart =
+          std::chrono::milliseconds(std::strtoll(argv[++i], nullptr, 10));
+    } else if (arg == "--speed" && i + 1 < argc) {
+      speed = std::strtod(argv[++i], nullptr);
+    } else if (arg == "--workers" && i + 1 < argc) {
+      options.workers = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--warm-state" && i + 1 < argc) {
+      warm_path = argv[++i];
+    } else if (arg == "--records" && i + 1 < argc) {
+      records_dir = argv[++i];
+    } else if (arg == "--fifo") {
+      options.queue.shortest_first = false;
+    } else if (arg == "--no-hints") {
+      options.hints = false;
+    } else {
+      return usage();
+    }
+  }
+  if (!(speed > 0)) return usage();
+  if (!faults.empty()) {
+    injector.emplace(seed);
+    for (const auto& [fault, spec] : faults) injector->arm(fault, spec);
+    options.faults = &*injector;
+  }
+
+  try {
+    const auto entries = read_log(log_path);
+    catalog::Catalog catalog(catalog_dir);
+    catalog.set_bundle_check([&](const catalog::ProblemBundle& bundle) {
+      validation::validate_bundle_inputs(bundle, options.workers);
+    });
+    const auto loaded = catalog.reload();
+    for (const auto& error : loaded.errors) {
+      std::fprintf(stderr, "traffic_replay: %s\n", error.c_str());
+    }
+    compile::CompileCache cache(cache_dir);
+    std::optional<judge::RecordStore> records;
+    if (!records_dir.empty()) {
+      records.emplace(records_dir);
+      records->index(cache);
+      options.records = &*records;
+    }
+    compile::PchRegistry pch;
+    compile::Compiler compiler({}, cache, pch);
+    compiler.set_fault_injector(options.faults);
+    OfflineCoach live;
+    coach::Coach coach(live);
+
+    std::mutex mu;
+    std::condition_variable finished;
+    std::size_t completed = 0, compared = 0, errors = 0, crashes = 0;
+    std::size_t skipped = 0;  // Languages the compiler does not build.
+    std::uint64_t coalesced = 0;
+    std::vector<std::string> mismatches;
+    ActionStats stats[judge::kActionCount];
+    LatencyHistogram slip;
+    LatencyHistogram recovery;  // Jobs that survived a worker crash.
+    std::size_t recovered_over_slo = 0;
+    // Sampled at each dispatch: the biggest queue by length and by
+    // estimated CPU are rarely the same moment.
+    scheduler::Backlog longest, costliest;
+    if (slo_us != 0) {
+      judge::SloOptions& slo = options.slo.emplace();
+      for (auto& by_class : slo.targets) {
+        by_class.fill({0.95, std::chrono::milliseconds(slo_us / 1000)});
+      }
+      slo.window = std::chrono::seconds(10);
+      slo.windows = 6;
+    }
+    // The evaluator's SLO report, taken before it shuts down.
+    std::optional<judge::Pressure> slo_pressure;
+    std::vector<judge::SloStatus> slo_status;
+    std::vector<std::pair<std::string, std::uint64_t>> slo_knobs;
+
+    Clock::time_point start;
+    {
+      judge::Evaluator evaluator(options, catalog, compiler, coach);
+      // Also on a cold start, for the background PCH build and prewarm.
+      std::optional<warmup::WarmState> state;
+      if (!warm_path.empty()) state = warmup::load_warm_state(warm_path);
+      const auto warm =
+          evaluator.warm_start(state ? *state : warmup::WarmState{});
+      if (state) {
+        std::printf("warm start: %zu cache entries, %zu PCH, %zu problems "
+                    "prefetched in %lld ms\n",
+                    warm.compile_cache_entries, warm.pch_restored,
+                    warm.problems_prefetched,
+                    static_cast<long long>(warm.elapsed.count()));
+      }
+      start = Clock::now();
+      for (const auto& entry : entries) {
+        const auto due =
+            start + std::chrono::duration_cast<Clock::duration>(
+                        entry.at / speed);
+        std::this_thread::sleep_until(due);
+        slip.record(static_cast<std::uint64_t>(std::max<std::int64_t>(
+            0, std::chrono::duration_cast<std::chrono::microseconds>(
+                   Clock::now() - due)
+                   .count())));
+        const std::size_t action = static_cast<std::size_t>(
+            entry.request.action);
+        const Expected* expected =
+            entry.expected ? &*entry.expected : nullptr;
+        const JobId job = entry.request.submission.job_id;
+        evaluator.submit(entry.request, [&, action, expected,
+                                         job](judge::Evaluation result) {
+          std::lock_guard lock(mu);
+          ++completed;
+          finished.notify_all();
+          if (result.unsupported_language) {
+            ++skipped;
+            return;
+          }
+          ActionStats& s = stats[action];
+          const auto& times = result.times;
+          s.total.record(static_cast<std::uint64_t>(times.total.count()));
+          s.queued.record(static_cast<std::uint64_t>(times.queued.count()));
+          s.compile.record(static_cast<std::uint64_t>(times.compile.count()));
+          s.run.record(static_cast<std::uint64_t>(times.run.count()));
+          s.coach.record(static_cast<std::uint64_t>(times.coach.count()));
+          if (result.compile_cache_hit) ++s.cache_hits;
+          const auto total_us =
+              static_cast<std::uint64_t>(times.total.count());
+          const bool late = slo_us != 0 && total_us > slo_us;
+          if (late) ++s.over_slo;
+          if (result.attempts > 1) {
+            recovery.record(
+                static_cast<std::uint64_t>(times.recovery.count()));
+            if (late) ++recovered_over_slo;
+          }
+          if (!result.error.empty()) ++errors;
+          if (expected != nullptr) {
+            ++compared;
+            if (auto what = mismatch(*expected, result); !what.empty()) {
+              mismatches.push_back("job " + std::to_string(job) + ": " +
+                                   what);
+            }
+          }
+        });
+        const auto backlog = evaluator.backlog();
+        if (backlog.queued_jobs > longest.queued_jobs) longest = backlog;
+        if (backlog.cpu_us() > costliest.cpu_us()) costliest = backlog;
+      }
+      std::unique_lock lock(mu);
+      finished.wait(lock, [&] { return completed == entries.size(); });
+      crashes = evaluator.crashes();
+      coalesced = evaluator.coalesced();
+      if (const judge::SloTracker* slo = evaluator.slo()) {
+        slo_pressure = slo->pressure();
+        slo_status = slo->status(Clock::now());
+        slo_knobs = slo->knob_engagements();
+      }
+      if (!warm_path.empty()) {
+        warmup::save_warm_state(evaluator.warm_state(kHotProblems),
+                                warm_path);
+      }
+    }
+    const double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::printf("%zu submissions in %.1f s (%.1f/s) at %gx, %zu workers\n",
+                completed, seconds, seconds > 0 ? completed / seconds : 0.0,
+                speed, options.workers);
+    std::printf("dispatch slip p50 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+                slip.percentile(0.50) / 1000.0, slip.percentile(0.99) / 1000.0,
+                slip.max() / 1000.0);
+    for (const auto* peak : {&longest, &costliest}) {
+      std::printf("%s backlog: %zu queued + %zu running, %.1f CPU-s; "
+                  "%zu workers to drain in %lld s\n",
+                  peak == &longest ? "longest" : "costliest",
+                  peak->queued_jobs, peak->running_jobs,
+                  peak->cpu_us() / 1e6, peak->workers_to_drain(kDrain),
+                  static_cast<long long>(
+                      std::chrono::duration_cast<std::chrono::seconds>(kDrain)
+                          .count()));
+    }
+    for (std::size_t a = 0; a < judge::kActionCount; ++a) {
+      const ActionStats& s = stats[a];
+      if (s.total.count() == 0) continue;
+      std::printf("%s: %llu, compile cache hits %.1f%%\n",
+                  std::string(to_string(static_cast<judge::Action>(a)))
+                      .c_str(),
+                  static_cast<unsigned long long>(s.total.count()),
+                  100.0 * s.cache_hits / s.total.count());
+      print_latency("total", s.total);
+      print_latency("queued", s.queued);
+      print_latency("compile", s.compile);
+      print_latency("run", s.run);
+      print_latency("coach", s.coach);
+      if (slo_us != 0) {
+        std::printf("  over the %.0f ms SLO: %zu (%.2f%%)\n", slo_us / 1000.0,
+                    s.over_slo, 100.0 * s.over_slo / s.total.count());
+      }
+    }
+    if (options.faults != nullptr) {
+      std::printf("faults:");
+      for (const auto& [fault, spec] : faults) {
+        std::printf(" %s fired %llu", std::string(to_string(fault)).c_str(),
+                    static_cast<unsigned long long>(
+                        options.faults->fired(fault)));
+      }
+      std::printf("\n");
+    }
+    if (coalesced != 0) {
+      std::printf("coalesced into in-flight duplicates: %llu\n",
+                  static_cast<unsigned long long>(coalesced));
+    }
+    if (crashes != 0) {
+      std::printf("worker crashes %zu, %llu jobs recovered", crashes,
+                  static_cast<unsigned long long>(recovery.count()));
+      if (slo_us != 0) std::printf(" (%zu over SLO)", recovered_over_slo);
+      std::printf("\n");
+      print_latency("recovery", recovery);
+    }
+    if (slo_pressure) {
+      std::printf("SLO pressure %s\n",
+                  std::string(to_string(*slo_pressure)).c_str());
+      for (const auto& status : slo_status) {
+        std::printf(
+            "  %s/%s: %llu, p50 %.1f p95 %.1f p99 %.1f ms, burn short "
+            "%.1f long %.1f\n",
+            std::string(to_string(status.action)).c_str(),
+            std::string(to_string(status.problem_class)).c_str(),
+            static_cast<unsigned long long>(status.count),
+            status.p50.count() / 1000.0, status.p95.count() / 1000.0,
+            status.p99.count() / 1000.0, status.short_burn,
+            status.long_burn);
+      }
+      for (const auto& [name, engaged] : slo_knobs) {
+        std::printf("  knob %s engaged %llu times\n", name.c_str(),
+                    static_cast<unsigned long long>(engaged));
+      }
+    }
+    if (records) {
+      records->drain();
+      std::printf("records: %zu dropped, %zu failed\n",
+                  records->writer().rejected(), records->writer().failed());
+      for (const auto family :
+           {judge::RecordStore::kSubmissions, judge::RecordStore::kVerdicts,
+            judge::RecordStore::kCoach, judge::RecordStore::kArtifacts}) {
+        const auto s = records->store().stats(family);
+        std::printf("  %s: %zu tables, %llu bytes, %zu in memtable, "
+                    "%llu bloom skips\n",
+                    std::string(family).c_str(), s.tables,
+                    static_cast<unsigned long long>(s.table_bytes),
+                    s.memtable_bytes,
+                    static_cast<unsigned long long>(s.bloom_skips));
+      }
+    }
+    std::printf("verdicts: %zu compared, %zu mismatched, %zu errors\n",
+                compared, mismatches.size(), errors);
+    if (skipped > 0) {
+      std::printf("skipped: %zu in languages the compiler does not build\n",
+                  skipped);
+    }
+    for (std::size_t i = 0;
+         i < std::min(mismatches.size(), kMismatchesShown); ++i) {
+      std::printf("  %s\n", mismatches[i].c_str());
+    }
+    return mismatches.empty() ? 0 : 1;
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "traffic_replay: %s\n", e.what());
+    return 1;
+  }
+}